@@ -0,0 +1,905 @@
+//
+//	PDFReaderBench.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/*
+ *  Headless benchmark and regression harness for the PDFReaderCore* code.
+ *
+ *  Runs cache churn, scheduler throughput, layout math, name lookup, PDF
+ *  structure reader and pipeline tracing workloads (synthetic, or a recorded
+ *  thumb cache trace), checks results against simple reference models and
+ *  prints one line per benchmark:
+ *
+ *      bench <name> <ns per op> <ops> <detail>
+ *
+ *  A previous run's output can be passed with -b to fail the run (exit 2)
+ *  when any benchmark is slower than its baseline by more than -t percent.
+ *  Correctness failures exit 1.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "PDFReaderCoreGeometry.h"
+#include "PDFReaderCoreGrid.h"
+#include "PDFReaderCoreHash.h"
+#include "PDFReaderCoreLRU.h"
+#include "PDFReaderCoreNameTable.h"
+#include "PDFReaderCoreScheduler.h"
+#include "PDFReaderCoreStructure.h"
+#include "PDFReaderCoreTrace.h"
+#include "PDFReaderSamples.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma mark Constants
+
+#define DEFAULT_SCALE 1.0
+
+#define DEFAULT_TOLERANCE 10.0
+
+#define MAXIMUM_RESULTS 32
+
+#define THUMB_COST (160 * 200 * 4)
+
+#define CACHE_BUDGET 8388608 // kPDFReaderDefaultThumbCacheSize
+
+#define CACHE_STRIPES 8 // PDFReaderThumbCache STRIPE_COUNT
+
+#define STRUCTURE_PAGES 10000
+
+#define TRACE_THREADS 4
+
+#pragma mark Types
+
+typedef struct
+{
+	char name[64]; double nsPerOp; size_t ops;
+} BenchResult;
+
+static BenchResult results[MAXIMUM_RESULTS]; static size_t resultCount = 0;
+
+static int failures = 0; static double scale = DEFAULT_SCALE;
+
+#pragma mark Support functions
+
+static double Now(void)
+{
+	struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec + (ts.tv_nsec / 1000000000.0));
+}
+
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t Random(void) // xorshift64*
+{
+	randomState ^= (randomState >> 12); randomState ^= (randomState << 25); randomState ^= (randomState >> 27);
+
+	return (randomState * 0x2545F4914F6CDD1DULL);
+}
+
+static double RandomUnit(void)
+{
+	return ((Random() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+static void Seed(uint64_t seed)
+{
+	randomState = ((seed != 0) ? seed : 0x9E3779B97F4A7C15ULL);
+}
+
+static size_t Scaled(size_t count)
+{
+	size_t scaled = (size_t)(count * scale); return ((scaled > 0) ? scaled : 1);
+}
+
+static void Check(int condition, const char *bench, const char *message)
+{
+	if (condition == 0) { fprintf(stderr, "FAIL %s: %s\n", bench, message); failures++; }
+}
+
+static void Report(const char *name, double seconds, size_t ops, const char *detail)
+{
+	double nsPerOp = ((ops > 0) ? ((seconds * 1000000000.0) / ops) : 0.0);
+
+	printf("bench %-24s %10.1f %10zu %s\n", name, nsPerOp, ops, ((detail != NULL) ? detail : "")); fflush(stdout);
+
+	if (resultCount < MAXIMUM_RESULTS) // Keep it for the baseline comparison
+	{
+		BenchResult *result = &results[resultCount++]; snprintf(result->name, sizeof(result->name), "%s", name);
+
+		result->nsPerOp = nsPerOp; result->ops = ops;
+	}
+}
+
+#pragma mark Cache churn
+
+typedef struct
+{
+	uint64_t *keys; size_t *costs; size_t count;
+} CacheTrace;
+
+static size_t *ZipfTable(size_t keys, size_t samples, double skew)
+{
+	double *cdf = malloc(keys * sizeof(double)); size_t *table = malloc(samples * sizeof(size_t));
+
+	double sum = 0.0; for (size_t k = 0; k < keys; k++) { sum += (1.0 / pow((double)(k + 1), skew)); cdf[k] = sum; }
+
+	for (size_t i = 0; i < samples; i++) // Inverse CDF sampling
+	{
+		double u = (RandomUnit() * sum); size_t lower = 0; size_t upper = (keys - 1);
+
+		while (lower < upper) { size_t middle = ((lower + upper) / 2); if (cdf[middle] < u) lower = (middle + 1); else upper = middle; }
+
+		table[i] = lower;
+	}
+
+	free(cdf); return table;
+}
+
+static CacheTrace SyntheticCacheTrace(size_t ops, size_t documents, size_t pages)
+{
+	CacheTrace trace; trace.count = ops; trace.keys = malloc(ops * sizeof(uint64_t)); trace.costs = malloc(ops * sizeof(size_t));
+
+	size_t *ranks = ZipfTable((documents * pages), ops, 1.1); char key[96]; char guid[40];
+
+	for (size_t i = 0; i < ops; i++) // Thumb cache keys of popular pages across documents
+	{
+		size_t document = (ranks[i] % documents); size_t page = ((ranks[i] / documents) + 1);
+
+		snprintf(guid, sizeof(guid), "%032zX", (document * 0x9E3779B1U));
+
+		long w = ((i % 7) == 0) ? 64 : 160; long h = ((i % 7) == 0) ? 80 : 200; // Pagebar and grid sizes
+
+		PDFReaderCoreThumbCacheKey(key, sizeof(key), (long)page, w, h, guid);
+
+		trace.keys[i] = PDFReaderCoreHashString(key); trace.costs[i] = (size_t)(w * h * 4);
+	}
+
+	free(ranks); return trace;
+}
+
+static int RecordedCacheTrace(const char *path, CacheTrace *trace)
+{
+	FILE *file = fopen(path, "r"); if (file == NULL) return 0;
+
+	size_t capacity = 4096; trace->count = 0; // Lines of "<cache key> <cost>"
+
+	trace->keys = malloc(capacity * sizeof(uint64_t)); trace->costs = malloc(capacity * sizeof(size_t));
+
+	char line[512]; char key[400]; unsigned long long cost = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		if ((line[0] == '#') || (sscanf(line, "%399s %llu", key, &cost) < 1)) continue; // Comment or blank
+
+		if (sscanf(line, "%*s %llu", &cost) != 1) cost = THUMB_COST; // Default thumb cost
+
+		if (trace->count == capacity) // Grow the trace
+		{
+			capacity *= 2; trace->keys = realloc(trace->keys, (capacity * sizeof(uint64_t)));
+
+			trace->costs = realloc(trace->costs, (capacity * sizeof(size_t)));
+		}
+
+		trace->keys[trace->count] = PDFReaderCoreHashString(key); trace->costs[trace->count] = (size_t)cost; trace->count++;
+	}
+
+	fclose(file); return 1;
+}
+
+typedef struct
+{
+	uint64_t *keys; size_t *costs; size_t count; size_t bytes;
+} ReferenceLRU; // Array ordered oldest first
+
+static int ReferenceAccess(ReferenceLRU *reference, uint64_t key, size_t cost, size_t limit)
+{
+	int hit = 0; // Linear model of the same policy
+
+	for (size_t i = 0; i < reference->count; i++)
+	{
+		if (reference->keys[i] != key) continue; // Not this one
+
+		hit = 1; reference->bytes -= reference->costs[i];
+
+		memmove(&reference->keys[i], &reference->keys[i + 1], ((reference->count - i - 1) * sizeof(uint64_t)));
+
+		memmove(&reference->costs[i], &reference->costs[i + 1], ((reference->count - i - 1) * sizeof(size_t)));
+
+		reference->count--; break;
+	}
+
+	reference->keys[reference->count] = key; reference->costs[reference->count] = cost; reference->count++; reference->bytes += cost;
+
+	while (reference->bytes > limit) // Evict the oldest
+	{
+		reference->bytes -= reference->costs[0]; reference->count--;
+
+		memmove(&reference->keys[0], &reference->keys[1], (reference->count * sizeof(uint64_t)));
+
+		memmove(&reference->costs[0], &reference->costs[1], (reference->count * sizeof(size_t)));
+	}
+
+	return hit;
+}
+
+static void CacheVerify(const CacheTrace *trace, size_t limit)
+{
+	size_t ops = ((trace->count < 20000) ? trace->count : 20000); // Reference model is O(n) per op
+
+	ReferenceLRU reference; memset(&reference, 0x00, sizeof(reference));
+
+	reference.keys = malloc((ops + 1) * sizeof(uint64_t)); reference.costs = malloc((ops + 1) * sizeof(size_t));
+
+	PDFReaderCoreLRURef lru = PDFReaderCoreLRUCreate(0); size_t mismatches = 0;
+
+	for (size_t i = 0; i < ops; i++)
+	{
+		int hit = (PDFReaderCoreLRUTouch(lru, trace->keys[i]) != NULL);
+
+		PDFReaderCoreLRUSet(lru, trace->keys[i], trace->costs[i], (void *)(uintptr_t)(i + 1));
+
+		PDFReaderCoreLRUTrim(lru, limit, NULL, NULL);
+
+		if (hit != ReferenceAccess(&reference, trace->keys[i], trace->costs[i], limit)) mismatches++;
+
+		if ((PDFReaderCoreLRUBytes(lru) != reference.bytes) || (PDFReaderCoreLRUCount(lru) != reference.count)) mismatches++;
+	}
+
+	Check((mismatches == 0), "cache", "LRU disagrees with the reference model");
+
+	for (size_t i = 0; i < reference.count; i++) // Every resident reference key is resident
+	{
+		if (PDFReaderCoreLRUPeek(lru, reference.keys[i]) == NULL) { Check(0, "cache", "resident key missing"); break; }
+	}
+
+	PDFReaderCoreLRUDestroy(lru); free(reference.keys); free(reference.costs);
+}
+
+static void EvictCounter(uint64_t key, size_t cost, void *value, void *context)
+{
+	(void)key; (void)cost; (void)value; (*(size_t *)context)++;
+}
+
+static void BenchCache(const char *tracePath)
+{
+	CacheTrace trace; const char *name = "cache-churn"; // Synthetic unless a trace is given
+
+	if (tracePath != NULL)
+	{
+		if (RecordedCacheTrace(tracePath, &trace) == 0) { fprintf(stderr, "Unable to read trace '%s'\n", tracePath); failures++; return; }
+
+		name = "cache-churn-trace";
+	}
+	else // Zipf distributed thumb requests
+	{
+		Seed(2014); trace = SyntheticCacheTrace(Scaled(1000000), 8, 250);
+	}
+
+	size_t limit = (CACHE_BUDGET / CACHE_STRIPES); // Default stripe budget
+
+	CacheVerify(&trace, limit);
+
+	PDFReaderCoreLRURef stripes[CACHE_STRIPES]; size_t hits = 0; size_t evictions = 0; size_t resident = 0;
+
+	for (size_t stripe = 0; stripe < CACHE_STRIPES; stripe++) stripes[stripe] = PDFReaderCoreLRUCreate(0);
+
+	double start = Now(); // Timed run over the striped cache
+
+	for (size_t i = 0; i < trace.count; i++)
+	{
+		PDFReaderCoreLRURef lru = stripes[(trace.keys[i] % CACHE_STRIPES)];
+
+		if (PDFReaderCoreLRUTouch(lru, trace.keys[i]) != NULL) { hits++; continue; }
+
+		PDFReaderCoreLRUSet(lru, trace.keys[i], trace.costs[i], (void *)(uintptr_t)(i + 1));
+
+		PDFReaderCoreLRUTrim(lru, limit, EvictCounter, &evictions);
+	}
+
+	double seconds = (Now() - start); char detail[128];
+
+	for (size_t stripe = 0; stripe < CACHE_STRIPES; stripe++) // Check and release the stripes
+	{
+		Check((PDFReaderCoreLRUBytes(stripes[stripe]) <= limit), name, "resident bytes over the budget");
+
+		resident += PDFReaderCoreLRUCount(stripes[stripe]); PDFReaderCoreLRUDestroy(stripes[stripe]);
+	}
+
+	snprintf(detail, sizeof(detail), "hit %.1f%%, evictions %zu, resident %zu", ((trace.count > 0) ? (hits * 100.0 / trace.count) : 0.0), evictions, resident);
+
+	Report(name, seconds, trace.count, detail);
+
+	free(trace.keys); free(trace.costs);
+}
+
+#pragma mark Scheduler throughput
+
+static void CancelCounter(uint64_t key, void *value, void *context)
+{
+	(void)key; (void)value; (*(size_t *)context)++;
+}
+
+static void BenchScheduler(void)
+{
+	size_t items = Scaled(200000); size_t groups = 16; Seed(2015);
+
+	PDFReaderCoreSchedulerRef scheduler = PDFReaderCoreSchedulerCreate(0);
+
+	int *classes = malloc(items * sizeof(int)); // Expected class of each item
+
+	size_t ops = 0; double start = Now(); // Push with duplicates, promote some, cancel one group, drain
+
+	for (size_t i = 0; i < items; i++)
+	{
+		int priorityClass = (int)(Random() % PDFREADER_CORE_PRIORITY_CLASSES); classes[i] = priorityClass;
+
+		uint64_t group[PDFReaderCoreSchedulerGroups] = { (i % groups), i, (i % 64) }; // Document, page, target
+
+		PDFReaderCoreSchedulerPush(scheduler, (uint64_t)i, group, priorityClass, (void *)(uintptr_t)(i + 1)); ops++;
+
+		if ((i % 10) == 9) // Promote a recent item (a thumb scrolled into view)
+		{
+			size_t target = (i - (Random() % 10)); if (classes[target] > 0) classes[target] = 0;
+
+			PDFReaderCoreSchedulerPromote(scheduler, (uint64_t)target, 0); ops++;
+		}
+
+		if ((i % 100) == 99) { PDFReaderCoreSchedulerPush(scheduler, (uint64_t)(i - 50), group, PDFREADER_CORE_PRIORITY_CLASSES - 1, NULL); ops++; }
+	}
+
+	size_t cancelled = PDFReaderCoreSchedulerCancelGroup(scheduler, PDFReaderCoreSchedulerDocument, 3, CancelCounter, &(size_t){0}); ops++;
+
+	size_t popped = 0; int lastClass = -1; size_t lastIndex = 0; size_t orderErrors = 0; uint64_t key = 0; void *value = NULL;
+
+	while (PDFReaderCoreSchedulerPop(scheduler, &key, &value) == 1) // Drain in priority order
+	{
+		size_t index = (size_t)key; int priorityClass = classes[index]; popped++; ops++;
+
+		if ((priorityClass < lastClass) || ((index % groups) == 3) || (value != (void *)(uintptr_t)(index + 1))) orderErrors++;
+
+		if ((priorityClass == lastClass) && (priorityClass != 0) && (index < lastIndex)) orderErrors++; // FIFO (unpromoted)
+
+		lastClass = priorityClass; lastIndex = index;
+	}
+
+	double seconds = (Now() - start); char detail[128];
+
+	Check((orderErrors == 0), "scheduler", "items dequeued out of priority or FIFO order");
+
+	Check(((popped + cancelled) == items), "scheduler", "items lost or duplicated");
+
+	snprintf(detail, sizeof(detail), "items %zu, cancelled %zu", items, cancelled);
+
+	Report("scheduler-throughput", seconds, ops, detail);
+
+	size_t documents = Scaled(2000); size_t perDocument = 100; size_t removed = 0; size_t keyErrors = 0; // Many documents queued
+
+	size_t targets = 256; size_t pageErrors = 0; // Reused thumb views
+
+	for (size_t i = 0; i < (documents * perDocument); i++) // Two sizes (items) of every page
+	{
+		size_t document = (i % documents); size_t page = ((i / documents) % (perDocument / 2));
+
+		uint64_t group[PDFReaderCoreSchedulerGroups] = { document, ((document * perDocument) + page), (1 + (i % targets)) };
+
+		PDFReaderCoreSchedulerPush(scheduler, (uint64_t)i, group, (int)(i % PDFREADER_CORE_PRIORITY_CLASSES), NULL);
+	}
+
+	start = Now(); // Cancel one key, one page and one target per document, then every document one at a time
+
+	for (size_t document = 0; document < documents; document++)
+	{
+		if (PDFReaderCoreSchedulerCancel(scheduler, (uint64_t)(document + documents), CancelCounter, &removed) != 1) keyErrors++;
+
+		size_t pageRemoved = 0; PDFReaderCoreSchedulerCancelGroup(scheduler, PDFReaderCoreSchedulerPage, ((document * perDocument) + 2), CancelCounter, &pageRemoved);
+
+		if (pageRemoved != 2) pageErrors++; // Both sizes of the page
+
+		removed += pageRemoved;
+	}
+
+	for (size_t target = 1; target <= targets; target++) PDFReaderCoreSchedulerCancelGroup(scheduler, PDFReaderCoreSchedulerTarget, target, CancelCounter, &removed);
+
+	size_t remaining = PDFReaderCoreSchedulerCount(scheduler); // Target cancel removes everything
+
+	for (size_t document = 0; document < documents; document++) PDFReaderCoreSchedulerCancelGroup(scheduler, PDFReaderCoreSchedulerDocument, document, CancelCounter, &removed);
+
+	seconds = (Now() - start); Check(((keyErrors == 0) && (pageErrors == 0)), "scheduler", "key or page cancel missed a queued item");
+
+	Check(((removed == (documents * perDocument)) && (remaining == 0)), "scheduler", "group cancel left items queued");
+
+	snprintf(detail, sizeof(detail), "documents %zu, queued %zu", documents, (documents * perDocument));
+
+	Report("scheduler-cancel", seconds, ((documents * 3) + targets), detail);
+
+	PDFReaderCoreLaneState lane; memset(&lane, 0x00, sizeof(lane)); double throughput = 0.0; double wait = 0.0;
+
+	PDFReaderCoreLaneEnqueued(&lane, 1.0); PDFReaderCoreLaneEnqueued(&lane, 1.5);
+
+	PDFReaderCoreLaneFinished(&lane, 1.0, 2.0, 0, 3.0); PDFReaderCoreLaneFinished(&lane, 1.5, 0.0, 1, 5.0);
+
+	PDFReaderCoreLaneSummary(&lane, 6.0, &throughput, &wait);
+
+	Check(((lane.completed == 1) && (lane.cancelled == 1) && (throughput == 0.25) && (wait == 1.0)), "scheduler", "lane accounting");
+
+	PDFReaderCoreSchedulerDestroy(scheduler); free(classes);
+}
+
+#pragma mark Layout math
+
+static void BenchLayout(void)
+{
+	size_t pages = Scaled(1000000); Seed(2016); long checksum = 0; size_t errors = 0;
+
+	long angles[4] = { 0, 90, 180, 270 };
+
+	double start = Now(); // Page geometry and view rects
+
+	for (size_t i = 0; i < pages; i++)
+	{
+		double w = (200.0 + (Random() % 1200)); double h = (200.0 + (Random() % 1200));
+
+		PDFReaderCoreRect mediaBox = PDFReaderCoreRectMake(0.0, 0.0, w, h);
+
+		PDFReaderCoreRect cropBox = PDFReaderCoreRectMake(18.0, 18.0, (w - 36.0), (h - 36.0));
+
+		PDFReaderCoreGeometry geometry = PDFReaderCoreGeometryMake(cropBox, mediaBox, angles[i & 3]);
+
+		long viewW = 0; long viewH = 0; PDFReaderCoreGeometryViewSize(&geometry, &viewW, &viewH);
+
+		PDFReaderCoreRect pageRect = PDFReaderCoreRectMake((18.0 + (Random() % 100)), (18.0 + (Random() % 100)), 50.0, 20.0);
+
+		PDFReaderCoreRect viewRect = PDFReaderCoreGeometryViewRect(&geometry, pageRect);
+
+		if ((viewW % 2) || (viewH % 2) || (viewW > (long)geometry.width)) errors++;
+
+		if ((geometry.angle != 180) && ((viewRect.x < -1.0) || (viewRect.x > (viewW + 1.0)))) errors++;
+
+		checksum += (long)(viewRect.x + viewRect.y);
+	}
+
+	double seconds = (Now() - start); char detail[128];
+
+	Check((errors == 0), "layout", "page geometry out of bounds");
+
+	snprintf(detail, sizeof(detail), "checksum %ld", checksum); Report("layout-page-geometry", seconds, pages, detail);
+
+	size_t frames = Scaled(1000000); size_t count = 2000; errors = 0; checksum = 0;
+
+	start = Now(); // Thumb grid visible ranges and cell frames
+
+	for (size_t i = 0; i < frames; i++)
+	{
+		double boundsWidth = (((i & 1) == 0) ? 768.0 : 1024.0); double boundsHeight = (((i & 1) == 0) ? 1004.0 : 748.0);
+
+		PDFReaderCoreGrid grid = PDFReaderCoreGridMake(count, boundsWidth, 160.0, 200.0);
+
+		double offsetY = (RandomUnit() * (grid.contentHeight + 400.0)) - 200.0; long first = 0; long last = 0;
+
+		if (PDFReaderCoreGridVisibleRange(&grid, count, offsetY, boundsHeight, &first, &last) == 1)
+		{
+			PDFReaderCoreRect firstFrame = PDFReaderCoreGridCellFrame(&grid, first);
+
+			PDFReaderCoreRect lastFrame = PDFReaderCoreGridCellFrame(&grid, last);
+
+			if ((first < 0) || (last >= (long)count) || (first > last)) errors++;
+
+			if (((firstFrame.y + firstFrame.height) <= offsetY) || (lastFrame.y >= (offsetY + boundsHeight))) errors++;
+
+			checksum += (last - first);
+		}
+	}
+
+	seconds = (Now() - start);
+
+	Check((errors == 0), "layout", "thumb grid visible range");
+
+	snprintf(detail, sizeof(detail), "checksum %ld", checksum); Report("layout-thumb-grid", seconds, frames, detail);
+}
+
+#pragma mark Name lookups
+
+static void BenchNames(void)
+{
+	size_t names = Scaled(50000); size_t lookups = Scaled(200000); Seed(2017); char name[32];
+
+	PDFReaderCoreNameTableRef table = PDFReaderCoreNameTableCreate(names);
+
+	char (*linear)[16] = malloc(names * sizeof(*linear)); // Baseline flattened leaf order
+
+	double start = Now(); // Flatten (reverse order, as kids arrays often are not)
+
+	for (size_t i = names; i > 0; i--)
+	{
+		snprintf(name, sizeof(name), "dest%07zu", (i - 1)); memcpy(linear[i - 1], name, 12);
+
+		PDFReaderCoreNameTableAdd(table, name, strlen(name), (const void *)(uintptr_t)i);
+	}
+
+	PDFReaderCoreNameTableAdd(table, "dest0000000", 11, (const void *)(uintptr_t)0xDEAD); // Later duplicate loses
+
+	PDFReaderCoreNameTableFinish(table); double seconds = (Now() - start); char detail[128];
+
+	Check((PDFReaderCoreNameTableCount(table) == names), "names", "duplicate names kept");
+
+	Check((PDFReaderCoreNameTableLookup(table, "dest0000000", 11) == (const void *)(uintptr_t)1), "names", "first value does not win");
+
+	snprintf(detail, sizeof(detail), "names %zu", names); Report("names-build", seconds, names, detail);
+
+	size_t misses = 0; uint64_t *targets = malloc(lookups * sizeof(uint64_t)); char (*targetNames)[32] = malloc(lookups * sizeof(*targetNames));
+
+	for (size_t i = 0; i < lookups; i++) // 10% misses
+	{
+		targets[i] = (Random() % (names + (names / 10))); snprintf(targetNames[i], sizeof(targetNames[i]), "dest%07zu", (size_t)targets[i]);
+	}
+
+	start = Now(); // Binary search lookups
+
+	for (size_t i = 0; i < lookups; i++)
+	{
+		const void *value = PDFReaderCoreNameTableLookup(table, targetNames[i], 11);
+
+		if (value != ((targets[i] < names) ? (const void *)(uintptr_t)(targets[i] + 1) : NULL)) misses++;
+	}
+
+	seconds = (Now() - start); Check((misses == 0), "names", "lookup returned the wrong value");
+
+	snprintf(detail, sizeof(detail), "names %zu", names); Report("names-lookup", seconds, lookups, detail);
+
+	size_t baselineLookups = ((lookups < 2000) ? lookups : 2000); size_t found = 0;
+
+	start = Now(); // Linear leaf scan baseline
+
+	for (size_t i = 0; i < baselineLookups; i++)
+	{
+		for (size_t j = 0; j < names; j++) if (memcmp(linear[j], targetNames[i], 11) == 0) { found++; break; }
+	}
+
+	seconds = (Now() - start); snprintf(detail, sizeof(detail), "names %zu, found %zu", names, found);
+
+	Report("names-linear-baseline", seconds, baselineLookups, detail);
+
+	PDFReaderCoreNameTableDestroy(table); free(linear); free(targets); free(targetNames);
+}
+
+#pragma mark Structure reader
+
+static int CountPage(const PDFReaderCoreStructurePage *page, void *context)
+{
+	long *rotations = (long *)context; *rotations += (page->rotate / 90); return 1;
+}
+
+static long OpenStructure(const char *path, long *pages)
+{
+	PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithPath(path, NULL); if (structure == NULL) return 0;
+
+	*pages = PDFReaderCoreStructurePageCount(structure); PDFReaderCoreStructureDestroy(structure); return 1;
+}
+
+static void BenchStructure(void)
+{
+	SampleKind kinds[3] = { SampleClassic, SampleXrefStream, SampleBroken }; // Broken forces a parse of every object
+
+	const char *openNames[3] = { "structure-open-classic", "structure-open-xrefstm", "structure-open-scan-baseline" };
+
+	const char *visitNames[3] = { "structure-visit-classic", "structure-visit-xrefstm", NULL };
+
+	SampleBuffer buffer = { NULL, 0, 0 }; SampleInfo info; char detail[128]; Seed(2022);
+
+	for (int kind = 0; kind < 3; kind++)
+	{
+		if (SampleGenerate(kinds[kind], STRUCTURE_PAGES, &buffer, &info) == 0) { Check(0, "structure", "unable to generate a sample"); break; }
+
+		char path[] = "/tmp/pdfreader-bench-XXXXXX"; int file = mkstemp(path); // Time the mmap() path
+
+		if ((file < 0) || (write(file, buffer.bytes, buffer.length) != (ssize_t)buffer.length)) { Check(0, "structure", "unable to write a sample"); if (file >= 0) close(file); break; }
+
+		close(file); size_t opens = Scaled((kinds[kind] == SampleBroken) ? 20 : 200); long pages = 0; size_t errors = 0;
+
+		double start = Now(); // Time to page count
+
+		for (size_t i = 0; i < opens; i++) if ((OpenStructure(path, &pages) == 0) || (pages != STRUCTURE_PAGES)) errors++;
+
+		double seconds = (Now() - start); Check((errors == 0), "structure", "wrong page count");
+
+		snprintf(detail, sizeof(detail), "pages %d, bytes %zu", STRUCTURE_PAGES, buffer.length); Report(openNames[kind], seconds, opens, detail);
+
+		PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithPath(path, NULL); unlink(path);
+
+		if ((structure == NULL) || (visitNames[kind] == NULL)) { PDFReaderCoreStructureDestroy(structure); continue; }
+
+		size_t visits = Scaled(20); long rotations = 0; errors = 0;
+
+		start = Now(); // Every page's boxes and rotation
+
+		for (size_t i = 0; i < visits; i++) if (PDFReaderCoreStructureVisitPages(structure, CountPage, &rotations) != STRUCTURE_PAGES) errors++;
+
+		seconds = (Now() - start); Check((errors == 0), "structure", "visited the wrong number of pages");
+
+		snprintf(detail, sizeof(detail), "pages %d, rotations %ld", STRUCTURE_PAGES, rotations); Report(visitNames[kind], seconds, (visits * STRUCTURE_PAGES), detail);
+
+		if (kinds[kind] == SampleClassic) // Random single page lookups (tree descent by /Count)
+		{
+			size_t lookups = Scaled(100000); PDFReaderCoreStructurePage page; PDFReaderCoreStructurePage expected; errors = 0;
+
+			start = Now();
+
+			for (size_t i = 0; i < lookups; i++)
+			{
+				long number = (long)(1 + (Random() % STRUCTURE_PAGES));
+
+				if (PDFReaderCoreStructureGetPage(structure, number, &page) == 0) { errors++; continue; }
+
+				SampleExpectedPage(kinds[kind], number, &expected); if (page.rotate != expected.rotate) errors++;
+			}
+
+			seconds = (Now() - start); Check((errors == 0), "structure", "page lookup failed");
+
+			snprintf(detail, sizeof(detail), "pages %d", STRUCTURE_PAGES); Report("structure-page-lookup", seconds, lookups, detail);
+		}
+
+		PDFReaderCoreStructureDestroy(structure);
+	}
+
+	SampleFree(&buffer);
+}
+
+#pragma mark Pipeline tracing
+
+typedef struct
+{
+	uint32_t thread; size_t events; // Writer number and events to record
+} TraceWriter;
+
+static uint32_t TraceChecksum(int32_t page)
+{
+	return ((uint32_t)page * 2654435761u); // Torn events fail it
+}
+
+static void *TraceWriterMain(void *context)
+{
+	TraceWriter *writer = context; // Thread workload
+
+	for (size_t index = 0; index < writer->events; index++)
+	{
+		int32_t page = (int32_t)((writer->thread << 24) | (uint32_t)index); // Unique per event
+
+		PDFReaderCoreTraceRecord(PDFReaderCoreTraceRender, TraceChecksum(page), page, PDFReaderCoreTraceNow(), ((uint64_t)page * 3), (uint32_t)page);
+	}
+
+	return NULL;
+}
+
+static size_t TracePipeline(size_t thumbs) // Synthetic thumb requests through every stage
+{
+	size_t events = 0; uint64_t now = PDFReaderCoreTraceNow();
+
+	for (size_t thumb = 0; thumb < thumbs; thumb++)
+	{
+		uint32_t key = (uint32_t)Random(); long page = (long)(1 + (Random() % 500)); // Cache key hash and page
+
+		if ((Random() % 100) < 60) { PDFReaderCoreTraceRecord(PDFReaderCoreTraceThumbHit, key, page, now, 0, 0); events++; continue; }
+
+		PDFReaderCoreTraceRecord(PDFReaderCoreTraceThumbMiss, key, page, now, 0, 0);
+
+		uint64_t wait = (50000 + (Random() % 2000000)); PDFReaderCoreTraceRecord(PDFReaderCoreTraceFetchWait, key, -1, now, wait, 0);
+
+		uint64_t fetch = (20000 + (Random() % 400000)); PDFReaderCoreTraceRecord(PDFReaderCoreTraceFetch, key, page, (now + wait), fetch, 0);
+
+		uint64_t shown = (now + wait + fetch); events += 3;
+
+		if ((Random() % 100) < 50) // Not in the pack - render and encode it
+		{
+			uint64_t renderWait = (Random() % 4000000); uint64_t open = (100000 + (Random() % 900000)); uint64_t draw = (2000000 + (Random() % 30000000));
+
+			PDFReaderCoreTraceRecord(PDFReaderCoreTraceRenderWait, key, -1, shown, renderWait, 0); shown += renderWait;
+
+			PDFReaderCoreTraceRecord(PDFReaderCoreTraceRenderOpen, key, page, shown, open, 0);
+
+			PDFReaderCoreTraceRecord(PDFReaderCoreTraceRenderDraw, key, page, (shown + open), draw, 0);
+
+			PDFReaderCoreTraceRecord(PDFReaderCoreTraceRender, key, page, shown, (open + draw), 0); shown += (open + draw);
+
+			PDFReaderCoreTraceRecord(PDFReaderCoreTraceEncodeWait, key, -1, shown, (Random() % 1000000), 0);
+
+			PDFReaderCoreTraceRecord(PDFReaderCoreTraceEncode, key, page, shown, (500000 + (Random() % 3000000)), THUMB_COST); events += 6;
+		}
+
+		PDFReaderCoreTraceRecord(PDFReaderCoreTraceDisplay, key, page, shown, (Random() % 16000000), 0); events++;
+
+		now += (Random() % 1000000); // Next request
+	}
+
+	return events;
+}
+
+static void BenchTrace(void)
+{
+	char detail[128]; size_t points = Scaled(20000000); size_t recorded = 0; Seed(2023);
+
+	PDFReaderCoreTraceDisable(); // Trace points cost when recording is off
+
+	double start = Now();
+
+	for (size_t index = 0; index < points; index++)
+	{
+		if (PDFReaderCoreTraceIsEnabled()) { PDFReaderCoreTraceRecord(PDFReaderCoreTraceFetch, 0, (long)index, 0, 0, 0); recorded++; }
+	}
+
+	double seconds = (Now() - start); Check((recorded == 0), "trace", "recorded while disabled");
+
+	Report("trace-point-off", seconds, points, "recording disabled");
+
+	if (PDFReaderCoreTraceEnable(0) == 0) { Check(0, "trace", "unable to enable"); return; }
+
+	PDFReaderCoreTraceReset(); size_t records = Scaled(2000000);
+
+	start = Now(); // One thread, with a clock read per event
+
+	for (size_t index = 0; index < records; index++)
+	{
+		PDFReaderCoreTraceRecord(PDFReaderCoreTraceFetch, (uint32_t)index, (long)index, PDFReaderCoreTraceNow(), index, 0);
+	}
+
+	seconds = (Now() - start); PDFReaderCoreTraceHistogram histogram; uint64_t bytes = 0;
+
+	PDFReaderCoreTraceGetHistogram(PDFReaderCoreTraceFetch, &histogram, &bytes); Check((histogram.count == records), "trace", "histogram count");
+
+	snprintf(detail, sizeof(detail), "ring %d events", PDFREADER_CORE_TRACE_CAPACITY); Report("trace-record", seconds, records, detail);
+
+	PDFReaderCoreTraceReset(); pthread_t threads[TRACE_THREADS]; TraceWriter writers[TRACE_THREADS]; size_t perThread = Scaled(500000);
+
+	start = Now(); // Concurrent writers into the one ring
+
+	for (uint32_t thread = 0; thread < TRACE_THREADS; thread++)
+	{
+		writers[thread].thread = thread; writers[thread].events = perThread;
+
+		if (pthread_create(&threads[thread], NULL, TraceWriterMain, &writers[thread]) != 0) { writers[thread].events = 0; TraceWriterMain(&writers[thread]); }
+	}
+
+	for (uint32_t thread = 0; thread < TRACE_THREADS; thread++) if (writers[thread].events > 0) pthread_join(threads[thread], NULL);
+
+	seconds = (Now() - start); PDFReaderCoreTraceGetHistogram(PDFReaderCoreTraceRender, &histogram, &bytes);
+
+	Check((histogram.count == (perThread * TRACE_THREADS)), "trace", "lost histogram counts");
+
+	PDFReaderCoreTraceEvent *events = malloc(PDFREADER_CORE_TRACE_CAPACITY * sizeof(PDFReaderCoreTraceEvent)); uint64_t dropped = 0;
+
+	size_t copied = ((events != NULL) ? PDFReaderCoreTraceCopyEvents(events, PDFREADER_CORE_TRACE_CAPACITY, &dropped) : 0); size_t torn = 0;
+
+	for (size_t index = 0; index < copied; index++) // Every event must be whole
+	{
+		PDFReaderCoreTraceEvent *event = &events[index];
+
+		if ((event->identifier != TraceChecksum(event->page)) || (event->duration != ((uint64_t)event->page * 3)) || (event->bytes != (uint32_t)event->page)) torn++;
+	}
+
+	Check((copied == PDFREADER_CORE_TRACE_CAPACITY), "trace", "ring not full after the concurrent run"); Check((torn == 0), "trace", "torn events");
+
+	Check((dropped == ((perThread * TRACE_THREADS) - PDFREADER_CORE_TRACE_CAPACITY)), "trace", "wrong dropped count");
+
+	snprintf(detail, sizeof(detail), "threads %d, copied %zu, torn %zu", TRACE_THREADS, copied, torn);
+
+	Report("trace-record-threads", seconds, (perThread * TRACE_THREADS), detail);
+
+	PDFReaderCoreTraceReset(); size_t pipeline = TracePipeline(1000); // Round trip through a trace file
+
+	char path[] = "/tmp/pdfreader-trace-XXXXXX"; int file = mkstemp(path); size_t count = 0;
+
+	if (file >= 0) close(file);
+
+	Check(((file >= 0) && (PDFReaderCoreTraceWriteFile(path) == 0)), "trace", "unable to write a trace file");
+
+	PDFReaderCoreTraceEvent *readBack = PDFReaderCoreTraceReadFile(path, &count, &dropped); unlink(path);
+
+	Check(((readBack != NULL) && (count == pipeline) && (dropped == 0)), "trace", "trace file round trip");
+
+	if ((readBack != NULL) && (events != NULL) && (count == pipeline)) // Same events, same order
+	{
+		PDFReaderCoreTraceCopyEvents(events, PDFREADER_CORE_TRACE_CAPACITY, NULL);
+
+		Check((memcmp(events, readBack, (count * sizeof(PDFReaderCoreTraceEvent))) == 0), "trace", "trace file contents");
+	}
+
+	free(readBack); free(events); PDFReaderCoreTraceReset(); PDFReaderCoreTraceDisable();
+}
+
+#pragma mark Baseline gate
+
+static int CompareBaseline(const char *path, double tolerance)
+{
+	FILE *file = fopen(path, "r"); if (file == NULL) { fprintf(stderr, "Unable to read baseline '%s'\n", path); return 1; }
+
+	char line[512]; char name[64]; double nsPerOp = 0.0; int regressions = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		if (sscanf(line, "bench %63s %lf", name, &nsPerOp) != 2) continue;
+
+		if (strstr(name, "baseline") != NULL) continue; // Reference implementations are not gated
+
+		for (size_t i = 0; i < resultCount; i++)
+		{
+			if ((strcmp(results[i].name, name) != 0) || (nsPerOp <= 0.0)) continue;
+
+			double change = (((results[i].nsPerOp - nsPerOp) / nsPerOp) * 100.0);
+
+			if (change > tolerance) { fprintf(stderr, "REGRESSION %s: %.1f ns/op vs %.1f baseline (+%.1f%%)\n", name, results[i].nsPerOp, nsPerOp, change); regressions++; }
+		}
+	}
+
+	fclose(file); return regressions;
+}
+
+#pragma mark Main
+
+static void Usage(const char *tool)
+{
+	fprintf(stderr, "usage: %s [-s scale] [-r cache-trace] [-b baseline] [-t tolerance%%] [cache|scheduler|layout|names|structure|trace ...]\n", tool);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *tracePath = NULL; const char *baselinePath = NULL; double tolerance = DEFAULT_TOLERANCE; int option = 0;
+
+	while ((option = getopt(argc, argv, "s:r:b:t:h")) != -1)
+	{
+		switch (option)
+		{
+			case 's': scale = atof(optarg); if (scale <= 0.0) scale = DEFAULT_SCALE; break;
+			case 'r': tracePath = optarg; break;
+			case 'b': baselinePath = optarg; break;
+			case 't': tolerance = atof(optarg); break;
+			default: Usage(argv[0]); return ((option == 'h') ? 0 : 1);
+		}
+	}
+
+	int all = (optind >= argc); // No names - run everything
+
+	for (int index = (all ? 0 : optind); (all ? (index < 1) : (index < argc)); index++)
+	{
+		const char *bench = (all ? NULL : argv[index]);
+
+		if ((bench == NULL) || (strcmp(bench, "cache") == 0)) BenchCache(tracePath);
+		if ((bench == NULL) || (strcmp(bench, "scheduler") == 0)) BenchScheduler();
+		if ((bench == NULL) || (strcmp(bench, "layout") == 0)) BenchLayout();
+		if ((bench == NULL) || (strcmp(bench, "names") == 0)) BenchNames();
+		if ((bench == NULL) || (strcmp(bench, "structure") == 0)) BenchStructure();
+		if ((bench == NULL) || (strcmp(bench, "trace") == 0)) BenchTrace();
+	}
+
+	if (failures > 0) { fprintf(stderr, "%d check(s) failed\n", failures); return 1; }
+
+	if ((baselinePath != NULL) && (CompareBaseline(baselinePath, tolerance) > 0)) return 2;
+
+	return 0;
+}
@@ -0,0 +1,456 @@
+//
+//	PDFReaderFuzz.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/*
+ *  Fuzz harness for the PDFReaderCoreStructure reader.
+ *
+ *  First checks every generated sample layout (see PDFReaderSamples.h)
+ *  against its expected page boxes, rotation, outline and destinations,
+ *  then mutates the samples (bit flips, interesting bytes, PDF tokens,
+ *  chunk deletion, duplication and truncation) and runs every reader API
+ *  on each mutant. Build it with -fsanitize=address,undefined (make fuzz)
+ *  so that memory errors and undefined behaviour abort the run.
+ *
+ *  Files given as arguments are run as-is and then mutated too, so a
+ *  saved crasher or a real document corpus can be replayed. The mutation
+ *  sequence depends only on -s, so a failing run can be reproduced.
+ *
+ *  Built with -DPDFREADER_LIBFUZZER it instead provides
+ *  LLVMFuzzerTestOneInput() for clang's -fsanitize=fuzzer.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "PDFReaderCoreStructure.h"
+#include "PDFReaderSamples.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#pragma mark Constants
+
+#define DEFAULT_ITERATIONS 4000 // Mutants per seed
+
+#define SEED_PAGES 40
+
+#define MAXIMUM_INPUT 16777216
+
+#pragma mark Support functions
+
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+static int failures = 0;
+
+static uint64_t Random(void) // xorshift64*
+{
+	randomState ^= (randomState >> 12); randomState ^= (randomState << 25); randomState ^= (randomState >> 27);
+
+	return (randomState * 0x2545F4914F6CDD1DULL);
+}
+
+static void Check(int condition, const char *sample, const char *message)
+{
+	if (condition == 0) { fprintf(stderr, "FAIL %s: %s\n", sample, message); failures++; }
+}
+
+static int SameRect(PDFReaderCoreRect a, PDFReaderCoreRect b)
+{
+	double e = 0.001; // Printed reals
+
+	return ((a.x > (b.x - e)) && (a.x < (b.x + e)) && (a.y > (b.y - e)) && (a.y < (b.y + e)) &&
+			(a.width > (b.width - e)) && (a.width < (b.width + e)) && (a.height > (b.height - e)) && (a.height < (b.height + e)));
+}
+
+#pragma mark Exercise
+
+typedef struct
+{
+	long pages; long rotations; // Visited pages
+	long items; size_t titleBytes; // Visited outline items
+	char title[512]; // Converted title
+} ExerciseState;
+
+static int ExercisePage(const PDFReaderCoreStructurePage *page, void *context)
+{
+	ExerciseState *state = (ExerciseState *)context; state->pages++;
+
+	if ((page->rotate % 90) == 0) state->rotations += (page->rotate / 90); // Always true - touches every field
+
+	return (page->mediaBox.width >= 0.0) && (page->cropBox.height >= 0.0);
+}
+
+static int ExerciseOutline(const PDFReaderCoreOutlineItem *item, void *context)
+{
+	ExerciseState *state = (ExerciseState *)context; state->items++;
+
+	size_t length = PDFReaderCoreTextStringToUTF8(item->title, item->titleLength, state->title, sizeof(state->title));
+
+	state->titleBytes += length; char tiny[5]; PDFReaderCoreTextStringToUTF8(item->title, item->titleLength, tiny, sizeof(tiny));
+
+	if (item->uri != NULL) state->titleBytes += item->uriLength; // Touch the URI bytes
+
+	for (size_t index = 0; index < item->uriLength; index++) state->titleBytes += (item->uri[index] == '/');
+
+	return 1;
+}
+
+static void Exercise(const uint8_t *bytes, size_t length)
+{
+	PDFReaderCoreStructureStatus status = PDFReaderCoreStructureOK;
+
+	PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithBytes(bytes, length, &status);
+
+	if (structure == NULL) return; // Rejected
+
+	ExerciseState state; memset(&state, 0x00, sizeof(state)); PDFReaderCoreStructurePage page;
+
+	long count = PDFReaderCoreStructurePageCount(structure);
+
+	for (long index = 0; (index <= count) && (index < 48); index++) PDFReaderCoreStructureGetPage(structure, index, &page);
+
+	PDFReaderCoreStructureGetPage(structure, (count + 1), &page); PDFReaderCoreStructureGetPage(structure, count, &page);
+
+	PDFReaderCoreStructureVisitPages(structure, ExercisePage, &state);
+
+	for (uint32_t object = 0; object < 96; object++) PDFReaderCoreStructurePageNumberForObject(structure, object);
+
+	PDFReaderCoreStructureDestinationPage(structure, "chapter1", 8, 1); PDFReaderCoreStructureDestinationPage(structure, "legacy3", 7, 0);
+
+	PDFReaderCoreStructureDestinationPage(structure, "", 0, 1); PDFReaderCoreStructureVisitOutline(structure, ExerciseOutline, &state);
+
+	PDFReaderCoreStructureDestroy(structure);
+}
+
+#pragma mark Sample checks
+
+typedef struct
+{
+	const SampleInfo *info; SampleKind kind; const char *name; // Sample
+	long index; int mismatches; // Progress
+	char titles[SAMPLE_OUTLINE_ITEMS][64]; // Converted titles
+	char uri[64]; // Converted URI
+} CheckState;
+
+static int CheckPage(const PDFReaderCoreStructurePage *page, void *context)
+{
+	CheckState *state = (CheckState *)context; PDFReaderCoreStructurePage expected;
+
+	SampleExpectedPage(state->kind, ++state->index, &expected);
+
+	if ((page->page != expected.page) || (page->rotate != expected.rotate) || (SameRect(page->mediaBox, expected.mediaBox) == 0) ||
+		(SameRect(page->cropBox, expected.cropBox) == 0) || (page->object == 0)) state->mismatches++;
+
+	return 1;
+}
+
+static int CheckOutline(const PDFReaderCoreOutlineItem *item, void *context)
+{
+	CheckState *state = (CheckState *)context; long index = state->index++;
+
+	if (index >= state->info->outlineCount) { state->mismatches++; return 0; }
+
+	const SampleOutlineItem *expected = &state->info->outline[index];
+
+	if ((item->level != expected->level) || (item->target != expected->target) || (item->page != expected->page)) state->mismatches++;
+
+	PDFReaderCoreTextStringToUTF8(item->title, item->titleLength, state->titles[index], sizeof(state->titles[index]));
+
+	if (item->target == PDFReaderCoreOutlineTargetURI) PDFReaderCoreTextStringToUTF8(item->uri, item->uriLength, state->uri, sizeof(state->uri));
+
+	return 1;
+}
+
+static void CheckSample(SampleKind kind, const uint8_t *bytes, size_t length, const SampleInfo *info, const char *path)
+{
+	const char *name = SampleName(kind); PDFReaderCoreStructureStatus status = PDFReaderCoreStructureOK;
+
+	PDFReaderCoreStructureRef structure = ((path != NULL) ? PDFReaderCoreStructureCreateWithPath(path, &status) :
+		PDFReaderCoreStructureCreateWithBytes(bytes, length, &status));
+
+	if (kind == SampleEncrypted) // Refused so the caller falls back
+	{
+		Check(((structure == NULL) && (status == PDFReaderCoreStructureEncrypted)), name, "encrypted document opened");
+
+		PDFReaderCoreStructureDestroy(structure); return;
+	}
+
+	Check((structure != NULL), name, "unable to open"); if (structure == NULL) return;
+
+	Check((PDFReaderCoreStructurePageCount(structure) == info->pages), name, "wrong page count");
+
+	CheckState state; memset(&state, 0x00, sizeof(state)); state.info = info; state.kind = kind; state.name = name;
+
+	Check((PDFReaderCoreStructureVisitPages(structure, CheckPage, &state) == info->pages), name, "visited the wrong number of pages");
+
+	Check((state.mismatches == 0), name, "page boxes or rotation differ");
+
+	long probes[5] = { 1, 2, (info->pages / 2), (info->pages - 1), info->pages }; // Lazy descent agrees with the visit
+
+	for (int probe = 0; probe < 5; probe++)
+	{
+		PDFReaderCoreStructurePage page, expected; if ((probes[probe] < 1) || (probes[probe] > info->pages)) continue;
+
+		SampleExpectedPage(kind, probes[probe], &expected);
+
+		int found = PDFReaderCoreStructureGetPage(structure, probes[probe], &page);
+
+		Check((found && (page.rotate == expected.rotate) && SameRect(page.cropBox, expected.cropBox)), name, "page lookup differs");
+
+		Check((found && (PDFReaderCoreStructurePageNumberForObject(structure, page.object) == probes[probe])), name, "page map differs");
+	}
+
+	Check((PDFReaderCoreStructureGetPage(structure, (info->pages + 1), &(PDFReaderCoreStructurePage){ 0 }) == 0), name, "found a page past the end");
+
+	Check((PDFReaderCoreStructureDestinationPage(structure, "chapter2", 8, 1) == info->chapterPages[2]), name, "name tree destination");
+
+	Check((PDFReaderCoreStructureDestinationPage(structure, "legacy 5", 8, 0) == info->chapterPages[5]), name, "catalog /Dests destination");
+
+	Check((PDFReaderCoreStructureDestinationPage(structure, "chapter9", 8, 1) == 0), name, "missing destination found");
+
+	state.index = 0; state.mismatches = 0;
+
+	Check((PDFReaderCoreStructureVisitOutline(structure, CheckOutline, &state) == info->outlineCount), name, "wrong outline item count");
+
+	Check((state.mismatches == 0), name, "outline levels or targets differ");
+
+	Check((strcmp(state.titles[0], "Chapter (0)\tA") == 0), name, "literal title escapes");
+
+	Check((strcmp(state.titles[1], "Secti\xC3\xB6n\xF0\x9F\x98\x80") == 0), name, "UTF-16BE title");
+
+	Check((strcmp(state.uri, "https://example.com/a(b)") == 0), name, "URI target");
+
+	PDFReaderCoreStructureDestroy(structure);
+}
+
+static void CheckTextStrings(void)
+{
+	char buffer[64]; // PDFDocEncoding, UTF-8 and UTF-16BE conversions
+
+	PDFReaderCoreTextStringToUTF8((const uint8_t *)"\x8DQuote\x8E \x80 caf\xE9", 14, buffer, sizeof(buffer));
+
+	Check((strcmp(buffer, "\xE2\x80\x9CQuote\xE2\x80\x9D \xE2\x80\xA2 caf\xC3\xA9") == 0), "text", "PDFDocEncoding");
+
+	PDFReaderCoreTextStringToUTF8((const uint8_t *)"\xEF\xBB\xBFplain", 8, buffer, sizeof(buffer));
+
+	Check((strcmp(buffer, "plain") == 0), "text", "UTF-8 BOM");
+
+	size_t length = PDFReaderCoreTextStringToUTF8((const uint8_t *)"\xFE\xFF\x00\x41\xD8\x3D", 6, buffer, 3);
+
+	Check(((length == 4) && (strcmp(buffer, "A") == 0)), "text", "unpaired surrogate or truncation");
+
+	for (int round = 0; round < 20000; round++) // Random strings - the length contract holds
+	{
+		uint8_t bytes[32]; size_t count = (Random() % sizeof(bytes)); char small[7];
+
+		for (size_t index = 0; index < count; index++) bytes[index] = (uint8_t)Random();
+
+		if ((round % 3) == 0) { bytes[0] = 0xFE; bytes[1] = 0xFF; if (count < 2) count = 2; }
+
+		size_t needed = PDFReaderCoreTextStringToUTF8(bytes, count, NULL, 0);
+
+		Check((PDFReaderCoreTextStringToUTF8(bytes, count, small, sizeof(small)) == needed), "text", "length depends on the buffer");
+
+		Check((strlen(small) < sizeof(small)), "text", "unterminated output");
+	}
+}
+
+#pragma mark Mutation
+
+static const char *Tokens[] =
+{
+	"obj", "endobj", "stream", "endstream", "xref", "trailer", "startxref", " 0 R", "<<", ">>", "[", "]", "(", ")", "\\", "<", ">",
+	"/Kids", "/Count 99999999", "/Count -1", "/Prev 0", "/Length 1 0 R", "/Filter /FlateDecode", "/W [1 4 2]", "/W [8 8 8]",
+	"/Index [0 999999]", "/Type /ObjStm", "/N 1000000", "/First 0", "/Rotate 45", "/MediaBox [0 0 1e400 -3]", "999999999 0 R",
+	"2 0 R", "/Parent 2 0 R", "/Next 3 0 R", "/First 3 0 R", "/D (chapter1)", "/DecodeParms << /Predictor 15 /Columns 0 >>", "#", "%", "\r\n"
+};
+
+static const uint8_t Interesting[] = { 0x00, 0xFF, 0x7F, 0x80, '(', ')', '<', '>', '[', ']', '/', ' ', '\n', '\r', '%', '0', '9', 'R', '-', '.' };
+
+static size_t Mutate(uint8_t *bytes, size_t length, size_t capacity)
+{
+	int mutations = (int)(1 + (Random() % 4)); // Stacked mutations
+
+	for (int round = 0; (round < mutations) && (length > 0); round++)
+	{
+		size_t position = (Random() % length); size_t span = (1 + (Random() % 64));
+
+		switch (Random() % 8)
+		{
+			case 0: // Bit flip
+				bytes[position] ^= (uint8_t)(1 << (Random() % 8)); break;
+
+			case 1: // Interesting byte
+				bytes[position] = Interesting[Random() % sizeof(Interesting)]; break;
+
+			case 2: // Digit change (offsets, counts and lengths)
+				for (size_t index = position; index < length; index++) if ((bytes[index] >= '0') && (bytes[index] <= '9')) { bytes[index] = (uint8_t)('0' + (Random() % 10)); break; }
+				break;
+
+			case 3: // Delete a chunk
+				if (span > (length - position)) span = (length - position);
+				memmove((bytes + position), (bytes + position + span), (length - position - span)); length -= span; break;
+
+			case 4: // Duplicate a chunk
+			{
+				size_t source = (Random() % length); if (span > (length - source)) span = (length - source);
+				if ((length + span) > capacity) break;
+				memmove((bytes + position + span), (bytes + position), (length - position)); memmove((bytes + position), (bytes + source + ((source >= position) ? span : 0)), span); length += span; break;
+			}
+
+			case 5: // Insert a token
+			{
+				const char *token = Tokens[Random() % (sizeof(Tokens) / sizeof(Tokens[0]))]; size_t size = strlen(token);
+				if ((length + size) > capacity) break;
+				memmove((bytes + position + size), (bytes + position), (length - position)); memcpy((bytes + position), token, size); length += size; break;
+			}
+
+			case 6: // Truncate (usually near the end, where the cross-reference data is)
+				length = (((Random() % 4) == 0) ? position : (length - (Random() % ((length < 4096) ? length : 4096)))); break;
+
+			default: // Overwrite with another chunk
+			{
+				size_t source = (Random() % length); if (span > (length - position)) span = (length - position);
+				if (span > (length - source)) span = (length - source);
+				memmove((bytes + position), (bytes + source), span); break;
+			}
+		}
+	}
+
+	return length;
+}
+
+static void FuzzSeed(const char *name, const uint8_t *seed, size_t length, long iterations)
+{
+	size_t capacity = ((length * 2) + 4096); uint8_t *work = malloc(capacity); long opened = 0;
+
+	if (work == NULL) { Check(0, name, "out of memory"); return; }
+
+	Exercise(seed, length); // The seed itself
+
+	for (long iteration = 0; iteration < iterations; iteration++)
+	{
+		memcpy(work, seed, length); size_t size = Mutate(work, length, capacity);
+
+		uint8_t *exact = malloc((size > 0) ? size : 1); if (exact == NULL) break; // Exact size so overreads are caught
+
+		memcpy(exact, work, size); Exercise(exact, size);
+
+		PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithBytes(exact, size, NULL);
+
+		if (structure != NULL) { opened++; PDFReaderCoreStructureDestroy(structure); }
+
+		free(exact);
+	}
+
+	printf("fuzz %-16s %8ld mutants %8ld opened\n", name, iterations, opened); fflush(stdout); free(work);
+}
+
+static int ReadFile(const char *path, uint8_t **bytes, size_t *length)
+{
+	FILE *file = fopen(path, "rb"); if (file == NULL) return 0;
+
+	uint8_t *buffer = malloc(MAXIMUM_INPUT); size_t size = ((buffer != NULL) ? fread(buffer, 1, MAXIMUM_INPUT, file) : 0);
+
+	fclose(file); if ((buffer == NULL) || (size == 0)) { free(buffer); return 0; }
+
+	*bytes = realloc(buffer, size); if (*bytes == NULL) *bytes = buffer;
+
+	*length = size; return 1;
+}
+
+#pragma mark Main
+
+#ifdef PDFREADER_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size > 0) Exercise(data, size);
+
+	return 0;
+}
+
+#else
+
+static void Usage(const char *tool)
+{
+	fprintf(stderr, "usage: %s [-n mutants-per-seed] [-s random-seed] [file.pdf ...]\n", tool);
+}
+
+int main(int argc, char *argv[])
+{
+	long iterations = DEFAULT_ITERATIONS; uint64_t seed = 2022; int option = 0;
+
+	while ((option = getopt(argc, argv, "n:s:h")) != -1)
+	{
+		switch (option)
+		{
+			case 'n': iterations = atol(optarg); break;
+			case 's': seed = strtoull(optarg, NULL, 10); break;
+			default: Usage(argv[0]); return ((option == 'h') ? 0 : 1);
+		}
+	}
+
+	randomState = ((seed != 0) ? seed : randomState); printf("fuzz seed %llu\n", (unsigned long long)seed);
+
+	CheckTextStrings(); SampleBuffer buffer = { NULL, 0, 0 }; SampleInfo info;
+
+	for (int kind = 0; kind < SampleKinds; kind++) // Correctness of every layout, then mutants of it
+	{
+		long pageCounts[3] = { 1, SEED_PAGES, 1000 };
+
+		for (int size = 0; size < 3; size++)
+		{
+			if (SampleGenerate((SampleKind)kind, pageCounts[size], &buffer, &info) == 0) { Check(0, SampleName((SampleKind)kind), "unable to generate"); continue; }
+
+			CheckSample((SampleKind)kind, buffer.bytes, buffer.length, &info, NULL);
+		}
+
+		char path[] = "/tmp/pdfreader-fuzz-XXXXXX"; int file = mkstemp(path); // The mmap() path too
+
+		if ((file >= 0) && (write(file, buffer.bytes, buffer.length) == (ssize_t)buffer.length)) CheckSample((SampleKind)kind, NULL, 0, &info, path);
+
+		if (file >= 0) { close(file); unlink(path); }
+
+		if (SampleGenerate((SampleKind)kind, SEED_PAGES, &buffer, &info) != 0) FuzzSeed(SampleName((SampleKind)kind), buffer.bytes, buffer.length, iterations);
+	}
+
+	for (int index = optind; index < argc; index++) // Corpus files
+	{
+		uint8_t *bytes = NULL; size_t length = 0;
+
+		if (ReadFile(argv[index], &bytes, &length) == 0) { fprintf(stderr, "Unable to read '%s'\n", argv[index]); failures++; continue; }
+
+		FuzzSeed(argv[index], bytes, length, iterations); free(bytes);
+	}
+
+	SampleFree(&buffer);
+
+	if (failures > 0) { fprintf(stderr, "%d check(s) failed\n", failures); return 1; }
+
+	return 0;
+}
+
+#endif // PDFREADER_LIBFUZZER
@@ -0,0 +1,424 @@
+//
+//	PDFReaderSamples.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderSamples.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#pragma mark Constants
+
+#define NODE_FANOUT 32 // Pages per intermediate page tree node
+
+#define OBJECT_STREAM_SIZE 100 // Objects per object stream
+
+#define OUTLINE_TOP 8 // Top level outline items
+
+#define CATALOG 1
+#define PAGES 2
+#define OUTLINES 3
+#define NAME_TREE 4
+#define NAME_LEAF_A 5
+#define NAME_LEAF_B 6
+#define LEGACY_DESTS 7
+#define ENCRYPT 8
+#define FIRST_NODE 10
+
+#pragma mark Types
+
+typedef struct
+{
+	SampleKind kind; long pages; // Sample
+	long nodes, firstPage, firstOutline, lastObject; // Object numbers
+} SampleLayout;
+
+#pragma mark Buffer functions
+
+static int Reserve(SampleBuffer *buffer, size_t length)
+{
+	if ((buffer->length + length) <= buffer->capacity) return 1;
+
+	size_t capacity = ((buffer->capacity > 0) ? buffer->capacity : 65536);
+
+	while (capacity < (buffer->length + length)) capacity *= 2;
+
+	uint8_t *bytes = realloc(buffer->bytes, capacity); if (bytes == NULL) return 0;
+
+	buffer->bytes = bytes; buffer->capacity = capacity;
+
+	return 1;
+}
+
+static int AppendBytes(SampleBuffer *buffer, const void *bytes, size_t length)
+{
+	if (Reserve(buffer, length) == 0) return 0;
+
+	memcpy((buffer->bytes + buffer->length), bytes, length); buffer->length += length;
+
+	return 1;
+}
+
+static int Append(SampleBuffer *buffer, const char *format, ...)
+{
+	va_list arguments; va_start(arguments, format); int length = vsnprintf(NULL, 0, format, arguments); va_end(arguments);
+
+	if ((length < 0) || (Reserve(buffer, ((size_t)length + 1)) == 0)) return 0;
+
+	va_start(arguments, format); vsnprintf((char *)(buffer->bytes + buffer->length), ((size_t)length + 1), format, arguments); va_end(arguments);
+
+	buffer->length += (size_t)length;
+
+	return 1;
+}
+
+static int AppendCompressed(SampleBuffer *buffer, const SampleBuffer *data)
+{
+	uLongf length = compressBound((uLong)data->length); if (Reserve(buffer, length) == 0) return 0;
+
+	if (compress((buffer->bytes + buffer->length), &length, data->bytes, (uLong)data->length) != Z_OK) return 0;
+
+	buffer->length += length;
+
+	return 1;
+}
+
+#pragma mark Sample layout
+
+static long ChapterPage(long pages, long chapter)
+{
+	return (1 + ((chapter * pages) / OUTLINE_TOP));
+}
+
+static long PageObject(const SampleLayout *layout, long page)
+{
+	return (layout->firstPage + page - 1);
+}
+
+static int IsObjectUsed(const SampleLayout *layout, long number)
+{
+	if (number == ENCRYPT) return (layout->kind == SampleEncrypted);
+
+	return ((number >= CATALOG) && (number <= layout->lastObject) && (number != 9)); // 9 is free
+}
+
+static int ObjectBody(const SampleLayout *layout, long number, SampleBuffer *out)
+{
+	long pages = layout->pages; long chapter[OUTLINE_TOP]; int ok = 1;
+
+	for (long index = 0; index < OUTLINE_TOP; index++) chapter[index] = PageObject(layout, ChapterPage(pages, index));
+
+	switch (number)
+	{
+		case CATALOG:
+			return Append(out, "<< /Type /Catalog /Pages %d 0 R /Outlines %d 0 R /Names << /Dests %d 0 R >> /Dests %d 0 R >>", PAGES, OUTLINES, NAME_TREE, LEGACY_DESTS);
+
+		case PAGES:
+			ok = Append(out, "<< /Type /Pages /MediaBox [0 0 612 792] /Count %ld /Kids [", pages);
+
+			for (long node = 0; node < layout->nodes; node++) ok = (ok && Append(out, "%ld 0 R ", (FIRST_NODE + node)));
+
+			return (ok && Append(out, "] >>"));
+
+		case OUTLINES:
+			return Append(out, "<< /Type /Outlines /First %ld 0 R /Last %ld 0 R /Count %d >>", layout->firstOutline, (layout->firstOutline + ((OUTLINE_TOP - 1) * 2)), OUTLINE_TOP);
+
+		case NAME_TREE:
+			return Append(out, "<< /Kids [%d 0 R %d 0 R] >>", NAME_LEAF_A, NAME_LEAF_B);
+
+		case NAME_LEAF_A:
+			return Append(out, "<< /Limits [(chapter0) (chapter1)] /Names [(chapter0) [%ld 0 R /Fit] (chapter1) << /D [%ld 0 R /XYZ 0 792 0] >>] >>", chapter[0], chapter[1]);
+
+		case NAME_LEAF_B:
+			return Append(out, "<< /Limits [(chapter2) (chapter3)] /Names [(chapter2) [%ld 0 R /Fit] (chapter3) [%ld 0 R /FitH 0]] >>", chapter[2], chapter[3]);
+
+		case LEGACY_DESTS:
+			return Append(out, "<< /legacy3 [%ld 0 R /Fit] /legacy#205 [%ld 0 R /Fit] >>", chapter[3], chapter[5]);
+
+		case ENCRYPT:
+			return Append(out, "<< /Filter /Standard /V 1 /R 2 /O <00112233445566778899AABBCCDDEEFF00112233445566778899AABBCCDDEEFF> /U <00112233445566778899AABBCCDDEEFF00112233445566778899AABBCCDDEEFF> /P -4 >>");
+
+		default:
+			break;
+	}
+
+	if ((number >= FIRST_NODE) && (number < layout->firstPage)) // Intermediate node
+	{
+		long node = (number - FIRST_NODE); long first = ((node * NODE_FANOUT) + 1); long last = (first + NODE_FANOUT - 1);
+
+		if (last > pages) last = pages;
+
+		ok = Append(out, "<< /Type /Pages /Parent %d 0 R /Count %ld%s /Kids [", PAGES, (last - first + 1), (((node % 4) == 3) ? " /Rotate 270" : ""));
+
+		for (long page = first; page <= last; page++) ok = (ok && Append(out, "%ld 0 R ", PageObject(layout, page)));
+
+		return (ok && Append(out, "] >>"));
+	}
+
+	if ((number >= layout->firstPage) && (number < layout->firstOutline)) // Page
+	{
+		long page = (number - layout->firstPage + 1); long node = ((page - 1) / NODE_FANOUT);
+
+		ok = Append(out, "<< /Type /Page /Parent %ld 0 R", (FIRST_NODE + node));
+
+		if ((page % 7) == 0) ok = (ok && Append(out, " /Rotate 90"));
+
+		if ((page % 5) == 0) ok = (ok && Append(out, " /MediaBox [0 0 595.276 841.89]"));
+
+		if ((page % 11) == 0) ok = (ok && Append(out, " /CropBox [400 500 10 10]"));
+
+		return (ok && Append(out, " >>"));
+	}
+
+	long item = (number - layout->firstOutline); long index = (item / 2); // Outline items (top, child) pairs
+
+	if ((item % 2) == 1) // Child with a UTF-16BE title
+	{
+		return Append(out, "<< /Title <FEFF0053006500630074006900F6006E D83DDE00> /Parent %ld 0 R /Dest [%ld 0 R /Fit] >>", (number - 1), chapter[index]);
+	}
+
+	ok = Append(out, "<< /Parent %d 0 R /First %ld 0 R /Last %ld 0 R /Count 1", OUTLINES, (number + 1), (number + 1));
+
+	if (index > 0) ok = (ok && Append(out, " /Prev %ld 0 R", (number - 2)));
+
+	if (index < (OUTLINE_TOP - 1)) ok = (ok && Append(out, " /Next %ld 0 R", (number + 2)));
+
+	if (index != 4) ok = (ok && Append(out, " /Title (Chapter \\(%ld\\)\\t\\101)", index)); // Item 4 is untitled
+
+	switch (index)
+	{
+		case 0: return (ok && Append(out, " /Dest [%ld 0 R /Fit] >>", chapter[0]));
+		case 1: return (ok && Append(out, " /A << /S /GoTo /D (chapter1) >> >>"));
+		case 2: return (ok && Append(out, " /A << /S /URI /URI (https://example.com/a\\(b\\)) >> >>"));
+		case 3: return (ok && Append(out, " /Dest /legacy3 >>"));
+		case 5: return (ok && Append(out, " /A << /S /GoTo /D /legacy#205 >> >>"));
+		default: return (ok && Append(out, " /Dest [%ld /XYZ null null null] >>", (ChapterPage(pages, index) - 1)));
+	}
+}
+
+static void SampleExpectations(const SampleLayout *layout, SampleInfo *info)
+{
+	memset(info, 0x00, sizeof(SampleInfo)); info->pages = layout->pages;
+
+	for (long index = 0; index < OUTLINE_TOP; index++)
+	{
+		long page = ChapterPage(layout->pages, index); info->chapterPages[index] = page;
+
+		if (index == 4) continue; // Untitled - skipped with its child
+
+		SampleOutlineItem *item = &info->outline[info->outlineCount++]; item->level = 0;
+
+		item->target = ((index == 2) ? PDFReaderCoreOutlineTargetURI : PDFReaderCoreOutlineTargetPage); item->page = ((index == 2) ? 0 : page);
+
+		item = &info->outline[info->outlineCount++]; item->level = 1; item->target = PDFReaderCoreOutlineTargetPage; item->page = page;
+	}
+}
+
+#pragma mark File layouts
+
+static int WriteClassic(const SampleLayout *layout, SampleBuffer *buffer)
+{
+	size_t *offsets = calloc((size_t)(layout->lastObject + 1), sizeof(size_t)); if (offsets == NULL) return 0;
+
+	int ok = Append(buffer, "%%PDF-1.7\n%%\xE2\xE3\xCF\xD3\n");
+
+	for (long number = CATALOG; ok && (number <= layout->lastObject); number++)
+	{
+		if (IsObjectUsed(layout, number) == 0) continue;
+
+		offsets[number] = buffer->length; ok = (Append(buffer, "%ld 0 obj\n", number) && ObjectBody(layout, number, buffer) && Append(buffer, "\nendobj\n"));
+	}
+
+	size_t xref = buffer->length; ok = (ok && Append(buffer, "xref\n0 %ld\n0000000000 65535 f \n", (layout->lastObject + 1)));
+
+	for (long number = CATALOG; ok && (number <= layout->lastObject); number++)
+	{
+		if (offsets[number] != 0)
+			ok = Append(buffer, "%010zu 00000 n \n", offsets[number]);
+		else
+			ok = Append(buffer, "0000000000 00001 f \n");
+	}
+
+	ok = (ok && Append(buffer, "trailer\n<< /Size %ld /Root %d 0 R", (layout->lastObject + 1), CATALOG));
+
+	if (layout->kind == SampleEncrypted) ok = (ok && Append(buffer, " /Encrypt %d 0 R /ID [<0123456789ABCDEF0123456789ABCDEF> <0123456789ABCDEF0123456789ABCDEF>]", ENCRYPT));
+
+	ok = (ok && Append(buffer, " >>\nstartxref\n%zu\n%%%%EOF\n", xref));
+
+	if (ok && (layout->kind == SampleIncremental)) // Rotate page 1 in an update section
+	{
+		size_t offset = buffer->length; long number = layout->firstPage;
+
+		ok = Append(buffer, "%ld 0 obj\n<< /Type /Page /Parent %d 0 R /Rotate -180 >>\nendobj\n", number, FIRST_NODE);
+
+		size_t update = buffer->length;
+
+		ok = (ok && Append(buffer, "xref\n0 1\n0000000000 65535 f \n%ld 1\n%010zu 00000 n \n", number, offset));
+
+		ok = (ok && Append(buffer, "trailer\n<< /Size %ld /Root %d 0 R /Prev %zu >>\nstartxref\n%zu\n%%%%EOF\n", (layout->lastObject + 1), CATALOG, xref, update));
+	}
+
+	free(offsets); return ok;
+}
+
+static int WriteBroken(const SampleLayout *layout, SampleBuffer *buffer)
+{
+	int ok = Append(buffer, "%%PDF-1.4\n"); // Objects only - no xref, no trailer
+
+	for (long number = layout->lastObject; ok && (number >= CATALOG); number--) // Reverse order
+	{
+		if (IsObjectUsed(layout, number) == 0) continue;
+
+		ok = (Append(buffer, "%ld 0 obj\r", number) && ObjectBody(layout, number, buffer) && Append(buffer, "\rendobj\r"));
+	}
+
+	return (ok && Append(buffer, "startxref\n0\n%%%%EOF\n"));
+}
+
+static int WriteXrefStream(const SampleLayout *layout, SampleBuffer *buffer)
+{
+	long members = 0; for (long number = PAGES; number <= layout->lastObject; number++) if (IsObjectUsed(layout, number)) members++;
+
+	long streams = ((members + OBJECT_STREAM_SIZE - 1) / OBJECT_STREAM_SIZE); long firstStream = (layout->lastObject + 1);
+
+	long xrefNumber = (firstStream + streams); long size = (xrefNumber + 1); // Entries
+
+	uint8_t *types = calloc((size_t)size, 1); uint64_t *fields = calloc((size_t)size, sizeof(uint64_t)); uint32_t *indexes = calloc((size_t)size, sizeof(uint32_t));
+
+	SampleBuffer header = { NULL, 0, 0 }; SampleBuffer body = { NULL, 0, 0 }; SampleBuffer data = { NULL, 0, 0 };
+
+	int ok = ((types != NULL) && (fields != NULL) && (indexes != NULL) && Append(buffer, "%%PDF-1.7\n%%\xE2\xE3\xCF\xD3\n"));
+
+	types[CATALOG] = 1; fields[CATALOG] = buffer->length; // The catalog stays in the file
+
+	ok = (ok && Append(buffer, "%d 0 obj\n", CATALOG) && ObjectBody(layout, CATALOG, buffer) && Append(buffer, "\nendobj\n"));
+
+	long number = PAGES; // Next member
+
+	for (long stream = 0; ok && (stream < streams); stream++)
+	{
+		header.length = 0; body.length = 0; data.length = 0; uint32_t count = 0;
+
+		for (; ok && (number <= layout->lastObject) && (count < OBJECT_STREAM_SIZE); number++)
+		{
+			if (IsObjectUsed(layout, number) == 0) continue;
+
+			types[number] = 2; fields[number] = (uint64_t)(firstStream + stream); indexes[number] = count++;
+
+			ok = (Append(&header, "%ld %zu ", number, body.length) && ObjectBody(layout, number, &body) && Append(&body, "\n"));
+		}
+
+		ok = (ok && AppendBytes(&data, header.bytes, header.length) && AppendBytes(&data, body.bytes, body.length));
+
+		SampleBuffer compressed = { NULL, 0, 0 }; ok = (ok && AppendCompressed(&compressed, &data));
+
+		types[firstStream + stream] = 1; fields[firstStream + stream] = buffer->length;
+
+		ok = (ok && Append(buffer, "%ld 0 obj\n<< /Type /ObjStm /N %u /First %zu /Filter /FlateDecode /Length %zu >>\nstream\n", (firstStream + stream), count, header.length, compressed.length));
+
+		ok = (ok && AppendBytes(buffer, compressed.bytes, compressed.length) && Append(buffer, "\nendstream\nendobj\n")); SampleFree(&compressed);
+	}
+
+	types[xrefNumber] = 1; fields[xrefNumber] = buffer->length; data.length = 0; // PNG Up predicted rows of W [1 4 2]
+
+	uint8_t previous[7] = { 0, 0, 0, 0, 0, 0, 0 };
+
+	for (long entry = 0; ok && (entry < size); entry++)
+	{
+		uint8_t row[8] = { 2, types[entry], (uint8_t)(fields[entry] >> 24), (uint8_t)(fields[entry] >> 16), (uint8_t)(fields[entry] >> 8), (uint8_t)fields[entry],
+			(uint8_t)(indexes[entry] >> 8), (uint8_t)indexes[entry] };
+
+		if (entry == 0) { row[6] = 0xFF; row[7] = 0xFF; } // Free list head generation
+
+		uint8_t encoded[8]; encoded[0] = 2; for (int index = 0; index < 7; index++) encoded[index + 1] = (uint8_t)(row[index + 1] - previous[index]);
+
+		memcpy(previous, (row + 1), 7); ok = AppendBytes(&data, encoded, 8);
+	}
+
+	SampleBuffer compressed = { NULL, 0, 0 }; ok = (ok && AppendCompressed(&compressed, &data));
+
+	ok = (ok && Append(buffer, "%ld 0 obj\n<< /Type /XRef /Size %ld /W [1 4 2] /Root %d 0 R /Filter /FlateDecode /DecodeParms << /Columns 7 /Predictor 12 >> /Length %zu >>\nstream\n",
+		xrefNumber, size, CATALOG, compressed.length));
+
+	ok = (ok && AppendBytes(buffer, compressed.bytes, compressed.length) && Append(buffer, "\nendstream\nendobj\nstartxref\n%zu\n%%%%EOF\n", (size_t)fields[xrefNumber]));
+
+	SampleFree(&compressed); SampleFree(&header); SampleFree(&body); SampleFree(&data); free(types); free(fields); free(indexes);
+
+	return ok;
+}
+
+#pragma mark Sample functions
+
+const char *SampleName(SampleKind kind)
+{
+	switch (kind)
+	{
+		case SampleClassic: return "classic";
+		case SampleXrefStream: return "xref-stream";
+		case SampleIncremental: return "incremental";
+		case SampleBroken: return "broken";
+		case SampleEncrypted: return "encrypted";
+		default: return "unknown";
+	}
+}
+
+int SampleGenerate(SampleKind kind, long pages, SampleBuffer *buffer, SampleInfo *info)
+{
+	SampleLayout layout; layout.kind = kind; layout.pages = ((pages > 0) ? pages : 1);
+
+	layout.nodes = ((layout.pages + NODE_FANOUT - 1) / NODE_FANOUT); layout.firstPage = (FIRST_NODE + layout.nodes);
+
+	layout.firstOutline = (layout.firstPage + layout.pages); layout.lastObject = (layout.firstOutline + (OUTLINE_TOP * 2) - 1);
+
+	if (info != NULL) SampleExpectations(&layout, info);
+
+	buffer->length = 0; // Reuse the buffer
+
+	switch (kind)
+	{
+		case SampleXrefStream: return WriteXrefStream(&layout, buffer);
+		case SampleBroken: return WriteBroken(&layout, buffer);
+		default: return WriteClassic(&layout, buffer);
+	}
+}
+
+void SampleFree(SampleBuffer *buffer)
+{
+	free(buffer->bytes); buffer->bytes = NULL; buffer->length = 0; buffer->capacity = 0;
+}
+
+void SampleExpectedPage(SampleKind kind, long page, PDFReaderCoreStructurePage *expected)
+{
+	long node = ((page - 1) / NODE_FANOUT); memset(expected, 0x00, sizeof(PDFReaderCoreStructurePage));
+
+	expected->page = page; expected->rotate = (((page % 7) == 0) ? 90 : (((node % 4) == 3) ? 270 : 0));
+
+	if ((kind == SampleIncremental) && (page == 1)) expected->rotate = 180; // -180 normalized
+
+	expected->mediaBox = (((page % 5) == 0) ? PDFReaderCoreRectMake(0.0, 0.0, 595.276, 841.89) : PDFReaderCoreRectMake(0.0, 0.0, 612.0, 792.0));
+
+	expected->cropBox = (((page % 11) == 0) ? PDFReaderCoreRectMake(10.0, 10.0, 390.0, 490.0) : expected->mediaBox);
+}
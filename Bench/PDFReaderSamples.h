@@ -0,0 +1,81 @@
+//
+//	PDFReaderSamples.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/*
+ *  Synthetic PDF generator for the structure reader benchmark and fuzz
+ *  harness. Every sample has a two level page tree with inherited and
+ *  overridden boxes and rotation, an outline, a /Dests name tree and a
+ *  catalog /Dests dictionary, written in one of several file layouts.
+ */
+
+#ifndef PDFREADER_SAMPLES_H
+#define PDFREADER_SAMPLES_H
+
+#include "PDFReaderCoreStructure.h"
+
+#define SAMPLE_OUTLINE_ITEMS 16
+
+typedef enum
+{
+	SampleClassic = 0, // Cross-reference table
+	SampleXrefStream, // Object streams and a PNG predicted cross-reference stream
+	SampleIncremental, // Classic plus an update that rotates page 1 (/Prev chain)
+	SampleBroken, // No cross-reference data at all (reconstructed)
+	SampleEncrypted, // Classic with an /Encrypt trailer entry
+	SampleKinds
+} SampleKind;
+
+typedef struct
+{
+	uint8_t *bytes; size_t length, capacity; // Generated file
+} SampleBuffer;
+
+typedef struct
+{
+	long level; PDFReaderCoreOutlineTarget target; long page; // Expected item
+} SampleOutlineItem;
+
+typedef struct
+{
+	long pages; // Page count
+	long chapterPages[8]; // Target page of each top level outline item
+	SampleOutlineItem outline[SAMPLE_OUTLINE_ITEMS]; long outlineCount; // Expected outline (pre-order)
+} SampleInfo;
+
+const char *SampleName(SampleKind kind);
+
+/*
+ *  Generates a sample with the given page count into buffer (which is
+ *  reset first). Returns 0 when out of memory.
+ */
+int SampleGenerate(SampleKind kind, long pages, SampleBuffer *buffer, SampleInfo *info);
+
+void SampleFree(SampleBuffer *buffer);
+
+/*
+ *  Expected boxes and rotation of a page (the object number is not set).
+ */
+void SampleExpectedPage(SampleKind kind, long page, PDFReaderCoreStructurePage *expected);
+
+#endif // PDFREADER_SAMPLES_H
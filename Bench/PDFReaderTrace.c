@@ -0,0 +1,167 @@
+//
+//	PDFReaderTrace.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/*
+ *  Summarizes a binary pipeline trace written by PDFReaderCoreTraceWriteFile()
+ *  (on device: +[PDFReaderTrace writeTraceToURL:]).
+ *
+ *  Prints one line per stage with its count, duration percentiles and bytes
+ *  written, the thumb cache hit ratio, and the end-to-end thumb latency: for
+ *  every display event, from the first fetch lane enqueue of the same cache
+ *  key since its previous display. With -e every event is printed as well.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "PDFReaderCoreTrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#pragma mark Support functions
+
+static int CompareEvents(const void *a, const void *b) // By identifier, then start
+{
+	const PDFReaderCoreTraceEvent *x = a; const PDFReaderCoreTraceEvent *y = b;
+
+	if (x->identifier != y->identifier) return ((x->identifier < y->identifier) ? -1 : 1);
+
+	if (x->start != y->start) return ((x->start < y->start) ? -1 : 1);
+
+	return ((x->stage < y->stage) ? -1 : ((x->stage > y->stage) ? 1 : 0));
+}
+
+static void PrintHistogram(const char *name, const PDFReaderCoreTraceHistogram *histogram, uint64_t bytes)
+{
+	double mean = ((histogram->count > 0) ? ((double)histogram->sum / histogram->count) : 0.0);
+
+	printf("%-16s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f %12llu\n", name, (unsigned long long)histogram->count, (mean / 1000000.0),
+		(PDFReaderCoreTraceHistogramQuantile(histogram, 0.50) / 1000000.0), (PDFReaderCoreTraceHistogramQuantile(histogram, 0.90) / 1000000.0),
+		(PDFReaderCoreTraceHistogramQuantile(histogram, 0.99) / 1000000.0), (histogram->maximum / 1000000.0), (unsigned long long)bytes);
+}
+
+static void Summarize(PDFReaderCoreTraceEvent *events, size_t count, uint64_t dropped, int printEvents)
+{
+	PDFReaderCoreTraceHistogram histograms[PDFReaderCoreTraceStages]; uint64_t bytes[PDFReaderCoreTraceStages];
+
+	memset(histograms, 0x00, sizeof(histograms)); memset(bytes, 0x00, sizeof(bytes));
+
+	uint64_t first = UINT64_MAX; uint64_t last = 0; // Trace span
+
+	for (size_t index = 0; index < count; index++)
+	{
+		PDFReaderCoreTraceEvent *event = &events[index]; if (event->stage >= PDFReaderCoreTraceStages) continue;
+
+		PDFReaderCoreTraceHistogramAdd(&histograms[event->stage], event->duration); bytes[event->stage] += event->bytes;
+
+		if (event->start < first) first = event->start;
+
+		if ((event->start + event->duration) > last) last = (event->start + event->duration);
+	}
+
+	qsort(events, count, sizeof(PDFReaderCoreTraceEvent), CompareEvents); // Group the stages of each cache key
+
+	PDFReaderCoreTraceHistogram latency; memset(&latency, 0x00, sizeof(latency));
+
+	uint32_t identifier = 0; uint64_t requestStart = 0; // Current key and its first enqueue
+
+	for (size_t index = 0; index < count; index++)
+	{
+		PDFReaderCoreTraceEvent *event = &events[index];
+
+		if ((index == 0) || (event->identifier != identifier)) { identifier = event->identifier; requestStart = 0; }
+
+		if ((event->stage == PDFReaderCoreTraceFetchWait) && (requestStart == 0)) requestStart = event->start;
+
+		if ((event->stage == PDFReaderCoreTraceDisplay) && (requestStart != 0)) // Shown - enqueue to on screen
+		{
+			PDFReaderCoreTraceHistogramAdd(&latency, ((event->start + event->duration) - requestStart)); requestStart = 0;
+		}
+
+		if (printEvents != 0) // One line per event
+		{
+			printf("event %-12s id %08x page %6d thread %04x start %14.6fms duration %10.3fms bytes %u\n",
+				PDFReaderCoreTraceStageName((PDFReaderCoreTraceStage)event->stage), (unsigned)event->identifier, (int)event->page,
+				(unsigned)event->thread, ((event->start - first) / 1000000.0), (event->duration / 1000000.0), (unsigned)event->bytes);
+		}
+	}
+
+	double span = ((last > first) ? ((last - first) / 1000000.0) : 0.0);
+
+	printf("events %zu, dropped %llu, span %.3fms\n\n", count, (unsigned long long)dropped, span);
+
+	printf("%-16s %8s %10s %10s %10s %10s %10s %12s\n", "stage", "count", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "bytes");
+
+	for (int stage = 0; stage < PDFReaderCoreTraceStages; stage++)
+	{
+		if (histograms[stage].count > 0) PrintHistogram(PDFReaderCoreTraceStageName((PDFReaderCoreTraceStage)stage), &histograms[stage], bytes[stage]);
+	}
+
+	if (latency.count > 0) PrintHistogram("thumb-latency", &latency, 0);
+
+	uint64_t hits = histograms[PDFReaderCoreTraceThumbHit].count; uint64_t misses = histograms[PDFReaderCoreTraceThumbMiss].count;
+
+	if ((hits + misses) > 0) printf("\nthumb cache hit ratio %.1f%% (%llu hits, %llu misses)\n", ((hits * 100.0) / (hits + misses)), (unsigned long long)hits, (unsigned long long)misses);
+}
+
+#pragma mark Main
+
+static void Usage(const char *tool)
+{
+	fprintf(stderr, "usage: %s [-e] trace-file ...\n", tool);
+}
+
+int main(int argc, char *argv[])
+{
+	int printEvents = 0; int option = 0;
+
+	while ((option = getopt(argc, argv, "eh")) != -1)
+	{
+		switch (option)
+		{
+			case 'e': printEvents = 1; break;
+			default: Usage(argv[0]); return ((option == 'h') ? 0 : 1);
+		}
+	}
+
+	if (optind >= argc) { Usage(argv[0]); return 1; }
+
+	int status = 0; // Unreadable files
+
+	for (int index = optind; index < argc; index++)
+	{
+		size_t count = 0; uint64_t dropped = 0;
+
+		PDFReaderCoreTraceEvent *events = PDFReaderCoreTraceReadFile(argv[index], &count, &dropped);
+
+		if (events == NULL) { fprintf(stderr, "Unable to read trace '%s'\n", argv[index]); status = 1; continue; }
+
+		if ((argc - optind) > 1) printf("%s%s\n", ((index > optind) ? "\n" : ""), argv[index]);
+
+		Summarize(events, count, dropped, printEvents); free(events);
+	}
+
+	return status;
+}
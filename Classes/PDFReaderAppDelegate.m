@@ -25,6 +25,7 @@
 #import "PDFReaderAppDelegate.h"
 #import "PDFReaderConfig.h"
 #import "PDFReaderDemoController.h"
+#import "PDFReaderBenchmark.h"
 
 @implementation PDFReaderAppDelegate
 {
@@ -64,6 +65,10 @@
 
 	[mainWindow makeKeyAndVisible];
 
+#ifdef DEBUG
+	if ([[NSUserDefaults standardUserDefaults] boolForKey:@"PDFReaderBenchmarks"] == YES) PDFReaderBenchmarkRunAll(); // Launch argument
+#endif
+
 	return YES;
 }
 
@@ -0,0 +1,141 @@
+//
+//	PDFReaderCoreGeometry.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreGeometry.h"
+
+#include <string.h>
+
+#pragma mark PDFReaderCoreGeometry functions
+
+static PDFReaderCoreRect RectStandardize(PDFReaderCoreRect rect)
+{
+	if (rect.width < 0.0) { rect.x += rect.width; rect.width = -rect.width; }
+
+	if (rect.height < 0.0) { rect.y += rect.height; rect.height = -rect.height; }
+
+	return rect;
+}
+
+static PDFReaderCoreRect RectIntersection(PDFReaderCoreRect a, PDFReaderCoreRect b)
+{
+	a = RectStandardize(a); b = RectStandardize(b); // Positive sizes
+
+	double minX = ((a.x > b.x) ? a.x : b.x); double maxX = (((a.x + a.width) < (b.x + b.width)) ? (a.x + a.width) : (b.x + b.width));
+	double minY = ((a.y > b.y) ? a.y : b.y); double maxY = (((a.y + a.height) < (b.y + b.height)) ? (a.y + a.height) : (b.y + b.height));
+
+	if ((maxX < minX) || (maxY < minY)) return PDFReaderCoreRectMake(0.0, 0.0, 0.0, 0.0); // Disjoint
+
+	return PDFReaderCoreRectMake(minX, minY, (maxX - minX), (maxY - minY));
+}
+
+PDFReaderCoreGeometry PDFReaderCoreGeometryMake(PDFReaderCoreRect cropBox, PDFReaderCoreRect mediaBox, long angle)
+{
+	PDFReaderCoreGeometry geometry; memset(&geometry, 0x00, sizeof(geometry));
+
+	PDFReaderCoreRect effectiveRect = RectIntersection(cropBox, mediaBox);
+
+	geometry.angle = angle; // Angle
+
+	switch (geometry.angle) // Page rotation angle (in degrees)
+	{
+		default: // Default case
+		case 0: case 180: // 0 and 180 degrees
+		{
+			geometry.width = effectiveRect.width;
+			geometry.height = effectiveRect.height;
+			geometry.offsetX = effectiveRect.x;
+			geometry.offsetY = effectiveRect.y;
+			break;
+		}
+
+		case 90: case 270: // 90 and 270 degrees
+		{
+			geometry.width = effectiveRect.height;
+			geometry.height = effectiveRect.width;
+			geometry.offsetX = effectiveRect.y;
+			geometry.offsetY = effectiveRect.x;
+			break;
+		}
+	}
+
+	return geometry;
+}
+
+void PDFReaderCoreGeometryViewSize(const PDFReaderCoreGeometry *geometry, long *width, long *height)
+{
+	long page_w = (long)geometry->width; // Integer width
+	long page_h = (long)geometry->height; // Integer height
+
+	if (page_w % 2) page_w--; // Even width
+
+	if (page_h % 2) page_h--; // Even height
+
+	if (width != NULL) *width = page_w;
+
+	if (height != NULL) *height = page_h;
+}
+
+PDFReaderCoreRect PDFReaderCoreGeometryViewRect(const PDFReaderCoreGeometry *geometry, PDFReaderCoreRect pageRect)
+{
+	pageRect = RectStandardize(pageRect); // Min and max co-ordinates
+
+	double ll_x = pageRect.x; double ll_y = pageRect.y; // PDFRect lower-left X and Y
+	double ur_x = (pageRect.x + pageRect.width); double ur_y = (pageRect.y + pageRect.height); // PDFRect upper-right X and Y
+
+	ll_x -= geometry->offsetX; ll_y -= geometry->offsetY; // Offset lower-left co-ordinate
+	ur_x -= geometry->offsetX; ur_y -= geometry->offsetY; // Offset upper-right co-ordinate
+
+	switch (geometry->angle) // Page rotation angle (in degrees)
+	{
+		case 90: // 90 degree page rotation
+		{
+			double swap;
+			swap = ll_y; ll_y = ll_x; ll_x = swap;
+			swap = ur_y; ur_y = ur_x; ur_x = swap;
+			break;
+		}
+
+		case 270: // 270 degree page rotation
+		{
+			double swap;
+			swap = ll_y; ll_y = ll_x; ll_x = swap;
+			swap = ur_y; ur_y = ur_x; ur_x = swap;
+			ll_x = ((0.0 - ll_x) + geometry->width);
+			ur_x = ((0.0 - ur_x) + geometry->width);
+			break;
+		}
+
+		case 0: // 0 degree page rotation
+		{
+			ll_y = ((0.0 - ll_y) + geometry->height);
+			ur_y = ((0.0 - ur_y) + geometry->height);
+			break;
+		}
+	}
+
+	long vr_x = (long)ll_x; long vr_w = (long)(ur_x - ll_x); // Integer X and width
+	long vr_y = (long)ll_y; long vr_h = (long)(ur_y - ll_y); // Integer Y and height
+
+	return PDFReaderCoreRectMake(vr_x, vr_y, vr_w, vr_h); // View rect from PDFRect
+}
@@ -0,0 +1,57 @@
+//
+//	PDFReaderCoreGeometry.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_GEOMETRY_H
+#define PDFREADER_CORE_GEOMETRY_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+typedef struct
+{
+	long angle; // Page rotation angle (in degrees)
+	double width, height; // Rotated effective page size
+	double offsetX, offsetY; // Rotated effective page origin
+} PDFReaderCoreGeometry;
+
+/*
+ *  Effective page geometry from the page crop and media boxes (their
+ *  intersection) and the page rotation angle (0, 90, 180 or 270).
+ */
+PDFReaderCoreGeometry PDFReaderCoreGeometryMake(PDFReaderCoreRect cropBox, PDFReaderCoreRect mediaBox, long angle);
+
+/*
+ *  Integer page view size, rounded down to even width and height.
+ */
+void PDFReaderCoreGeometryViewSize(const PDFReaderCoreGeometry *geometry, long *width, long *height);
+
+/*
+ *  Converts a normalized page space rect to an integer view space rect.
+ */
+PDFReaderCoreRect PDFReaderCoreGeometryViewRect(const PDFReaderCoreGeometry *geometry, PDFReaderCoreRect pageRect);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_GEOMETRY_H
@@ -0,0 +1,100 @@
+//
+//	PDFReaderCoreGrid.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreGrid.h"
+
+#include <string.h>
+
+#pragma mark PDFReaderCoreGrid functions
+
+PDFReaderCoreGrid PDFReaderCoreGridMake(size_t count, double boundsWidth, double cellWidth, double cellHeight)
+{
+	PDFReaderCoreGrid grid; memset(&grid, 0x00, sizeof(grid));
+
+	grid.cellWidth = cellWidth; grid.cellHeight = cellHeight; // Cell size
+
+	grid.columns = ((cellWidth > 0.0) ? (long)(boundsWidth / cellWidth) : 1);
+
+	if (grid.columns < 1) grid.columns = 1; // At least one column
+
+	if (count > 0) // Have some cells
+	{
+		grid.rows = ((long)count / grid.columns);
+
+		if ((grid.columns * grid.rows) < (long)count) grid.rows++;
+
+		double tw = (grid.columns * cellWidth);
+		double th = (grid.rows * cellHeight);
+
+		if (tw < boundsWidth)
+			grid.insetX = (long)((boundsWidth - tw) / 2.0);
+		else
+			grid.insetX = 0; // Reset
+
+		if (tw < boundsWidth) tw = boundsWidth; // Limit
+
+		grid.contentWidth = tw; grid.contentHeight = th;
+	}
+
+	return grid;
+}
+
+int PDFReaderCoreGridVisibleRange(const PDFReaderCoreGrid *grid, size_t count, double offsetY, double boundsHeight, long *first, long *last)
+{
+	if ((count == 0) || (grid->cellHeight <= 0.0)) return 0; // Nothing visible
+
+	double minY = offsetY; // Content offset
+	double maxY = (minY + boundsHeight - 1.0);
+
+	long startRow = (long)(minY / grid->cellHeight); // Start row
+	long finalRow = (long)(maxY / grid->cellHeight); // Final row
+
+	long startIndex = (startRow * grid->columns); // Start index
+	long finalIndex = (finalRow * grid->columns); // Final index
+
+	finalIndex += (grid->columns - 1); // Last index value in last row
+
+	long maximumIndex = ((long)count - 1); // Maximum index value
+
+	if (startIndex < 0) startIndex = 0; // Limit it (bounce above the top)
+
+	if (finalIndex > maximumIndex) finalIndex = maximumIndex; // Limit it
+
+	if (finalIndex < startIndex) return 0; // Scrolled past the end
+
+	if (first != NULL) *first = startIndex;
+
+	if (last != NULL) *last = finalIndex;
+
+	return 1;
+}
+
+PDFReaderCoreRect PDFReaderCoreGridCellFrame(const PDFReaderCoreGrid *grid, long index)
+{
+	long thumbY = (long)((index / grid->columns) * grid->cellHeight); // X, Y
+
+	long thumbX = (long)(((index % grid->columns) * grid->cellWidth) + grid->insetX);
+
+	return PDFReaderCoreRectMake(thumbX, thumbY, grid->cellWidth, grid->cellHeight);
+}
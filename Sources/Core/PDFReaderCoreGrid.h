@@ -0,0 +1,59 @@
+//
+//	PDFReaderCoreGrid.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_GRID_H
+#define PDFREADER_CORE_GRID_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+typedef struct
+{
+	long columns, rows; // Grid cells across and down
+	long insetX; // Centering inset of the first column
+	double cellWidth, cellHeight; // Grid cell size
+	double contentWidth, contentHeight; // Scroll view content size
+} PDFReaderCoreGrid;
+
+/*
+ *  Lays out count fixed size cells in rows that fit boundsWidth (at least one
+ *  column), centered horizontally when narrower than the bounds.
+ */
+PDFReaderCoreGrid PDFReaderCoreGridMake(size_t count, double boundsWidth, double cellWidth, double cellHeight);
+
+/*
+ *  First and last cell index of the rows visible between offsetY and
+ *  (offsetY + boundsHeight). Returns 0 when no cell is visible.
+ */
+int PDFReaderCoreGridVisibleRange(const PDFReaderCoreGrid *grid, size_t count, double offsetY, double boundsHeight, long *first, long *last);
+
+/*
+ *  Integer frame of the cell at index.
+ */
+PDFReaderCoreRect PDFReaderCoreGridCellFrame(const PDFReaderCoreGrid *grid, long index);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_GRID_H
@@ -0,0 +1,62 @@
+//
+//	PDFReaderCoreHash.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreHash.h"
+
+#include <stdio.h>
+
+#pragma mark Constants
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x00000100000001B3ULL
+
+#pragma mark PDFReaderCoreHash functions
+
+uint64_t PDFReaderCoreHashBytes(const void *bytes, size_t length)
+{
+	const uint8_t *byte = (const uint8_t *)bytes; uint64_t hash = FNV_OFFSET_BASIS;
+
+	for (size_t index = 0; index < length; index++) { hash ^= byte[index]; hash *= FNV_PRIME; }
+
+	return hash;
+}
+
+uint64_t PDFReaderCoreHashString(const char *string)
+{
+	uint64_t hash = FNV_OFFSET_BASIS; if (string == NULL) return hash;
+
+	for (const uint8_t *byte = (const uint8_t *)string; *byte != 0; byte++) { hash ^= *byte; hash *= FNV_PRIME; }
+
+	return hash;
+}
+
+int PDFReaderCoreThumbName(char *buffer, size_t size, long page, long width, long height)
+{
+	return snprintf(buffer, size, "%07d-%04dx%04d", (int)page, (int)width, (int)height);
+}
+
+int PDFReaderCoreThumbCacheKey(char *buffer, size_t size, long page, long width, long height, const char *guid)
+{
+	return snprintf(buffer, size, "%07d-%04dx%04d+%s", (int)page, (int)width, (int)height, ((guid != NULL) ? guid : "(null)"));
+}
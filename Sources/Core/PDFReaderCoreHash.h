@@ -0,0 +1,56 @@
+//
+//	PDFReaderCoreHash.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_HASH_H
+#define PDFREADER_CORE_HASH_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+/*
+ *  64-bit FNV-1a hash of a byte range.
+ */
+uint64_t PDFReaderCoreHashBytes(const void *bytes, size_t length);
+
+/*
+ *  64-bit FNV-1a hash of a NUL terminated string.
+ */
+uint64_t PDFReaderCoreHashString(const char *string);
+
+/*
+ *  Formats the thumb name for a page and thumb size ("0000001-0160x0200")
+ *  into buffer. Returns the length snprintf() would have written.
+ */
+int PDFReaderCoreThumbName(char *buffer, size_t size, long page, long width, long height);
+
+/*
+ *  Formats the thumb cache key ("<thumb name>+<guid>") into buffer.
+ *  Returns the length snprintf() would have written.
+ */
+int PDFReaderCoreThumbCacheKey(char *buffer, size_t size, long page, long width, long height, const char *guid);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_HASH_H
@@ -0,0 +1,219 @@
+//
+//	PDFReaderCoreLRU.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreLRU.h"
+#include "PDFReaderCoreTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Constants
+
+#define NIL_NODE UINT32_MAX
+
+#define MINIMUM_NODES 64
+
+#pragma mark PDFReaderCoreLRU types
+
+typedef struct
+{
+	uint64_t key; // Key hash
+	size_t cost; // Cost in bytes
+	void *value; // Caller value
+	uint32_t prev, next; // List links (or free list link)
+} LRUNode;
+
+struct PDFReaderCoreLRU
+{
+	PDFReaderCoreTable table; // Key to node index
+	LRUNode *nodes; uint32_t capacity; // Node storage
+	uint32_t head, tail, free; // Most, least recently used and free list
+	uint32_t count; size_t bytes; // Totals
+};
+
+#pragma mark PDFReaderCoreLRU functions
+
+static void LRUUnlink(PDFReaderCoreLRURef lru, uint32_t index)
+{
+	LRUNode *node = &lru->nodes[index];
+
+	if (node->prev != NIL_NODE) lru->nodes[node->prev].next = node->next; else lru->head = node->next;
+
+	if (node->next != NIL_NODE) lru->nodes[node->next].prev = node->prev; else lru->tail = node->prev;
+
+	node->prev = NIL_NODE; node->next = NIL_NODE;
+}
+
+static void LRULink(PDFReaderCoreLRURef lru, uint32_t index)
+{
+	LRUNode *node = &lru->nodes[index]; node->next = lru->head; node->prev = NIL_NODE; // Most recently used
+
+	if (lru->head != NIL_NODE) lru->nodes[lru->head].prev = index; else lru->tail = index;
+
+	lru->head = index;
+}
+
+static int LRUGrow(PDFReaderCoreLRURef lru, uint32_t capacity)
+{
+	LRUNode *nodes = realloc(lru->nodes, (capacity * sizeof(LRUNode))); if (nodes == NULL) return 0;
+
+	for (uint32_t index = lru->capacity; index < capacity; index++) // Chain the new nodes onto the free list
+	{
+		nodes[index].next = (((index + 1) < capacity) ? (index + 1) : lru->free);
+	}
+
+	lru->free = lru->capacity; lru->nodes = nodes; lru->capacity = capacity;
+
+	return 1;
+}
+
+PDFReaderCoreLRURef PDFReaderCoreLRUCreate(size_t capacity)
+{
+	PDFReaderCoreLRURef lru = calloc(1, sizeof(struct PDFReaderCoreLRU)); if (lru == NULL) return NULL;
+
+	if (capacity < MINIMUM_NODES) capacity = MINIMUM_NODES; // Minimum
+
+	if (capacity > (NIL_NODE / 2)) capacity = (NIL_NODE / 2); // Maximum
+
+	lru->head = NIL_NODE; lru->tail = NIL_NODE; lru->free = NIL_NODE;
+
+	if ((PDFReaderCoreTableInit(&lru->table, (uint32_t)capacity) == 0) || (LRUGrow(lru, (uint32_t)capacity) == 0))
+	{
+		PDFReaderCoreLRUDestroy(lru); lru = NULL;
+	}
+
+	return lru;
+}
+
+void PDFReaderCoreLRUDestroy(PDFReaderCoreLRURef lru)
+{
+	if (lru == NULL) return; // Nothing to destroy
+
+	PDFReaderCoreTableFree(&lru->table); free(lru->nodes); free(lru);
+}
+
+void *PDFReaderCoreLRUTouch(PDFReaderCoreLRURef lru, uint64_t key)
+{
+	uint32_t index = NIL_NODE; if (PDFReaderCoreTableGet(&lru->table, key, &index) == 0) return NULL;
+
+	if (lru->head != index) { LRUUnlink(lru, index); LRULink(lru, index); }
+
+	return lru->nodes[index].value;
+}
+
+void *PDFReaderCoreLRUPeek(PDFReaderCoreLRURef lru, uint64_t key)
+{
+	uint32_t index = NIL_NODE; if (PDFReaderCoreTableGet(&lru->table, key, &index) == 0) return NULL;
+
+	return lru->nodes[index].value;
+}
+
+int PDFReaderCoreLRUSet(PDFReaderCoreLRURef lru, uint64_t key, size_t cost, void *value)
+{
+	uint32_t index = NIL_NODE; // Node index
+
+	if (PDFReaderCoreTableGet(&lru->table, key, &index) == 1) // Replace an existing entry
+	{
+		LRUNode *node = &lru->nodes[index]; lru->bytes -= node->cost;
+
+		node->cost = cost; node->value = value; lru->bytes += cost;
+
+		if (lru->head != index) { LRUUnlink(lru, index); LRULink(lru, index); }
+
+		return 1;
+	}
+
+	if (lru->free == NIL_NODE) // Out of nodes - double the storage
+	{
+		if ((lru->capacity >= (NIL_NODE / 2)) || (LRUGrow(lru, (lru->capacity * 2)) == 0)) return 0;
+	}
+
+	index = lru->free; // Take a free node
+
+	if (PDFReaderCoreTableSet(&lru->table, key, index) == 0) return 0;
+
+	LRUNode *node = &lru->nodes[index]; lru->free = node->next;
+
+	node->key = key; node->cost = cost; node->value = value; LRULink(lru, index);
+
+	lru->bytes += cost; lru->count++;
+
+	return 1;
+}
+
+static void LRURemoveNode(PDFReaderCoreLRURef lru, uint32_t index)
+{
+	LRUNode *node = &lru->nodes[index]; PDFReaderCoreTableRemove(&lru->table, node->key);
+
+	LRUUnlink(lru, index); lru->bytes -= node->cost; lru->count--;
+
+	node->value = NULL; node->next = lru->free; lru->free = index; // Back onto the free list
+}
+
+int PDFReaderCoreLRURemove(PDFReaderCoreLRURef lru, uint64_t key)
+{
+	uint32_t index = NIL_NODE; if (PDFReaderCoreTableGet(&lru->table, key, &index) == 0) return 0;
+
+	LRURemoveNode(lru, index);
+
+	return 1;
+}
+
+size_t PDFReaderCoreLRUTrim(PDFReaderCoreLRURef lru, size_t limit, PDFReaderCoreLRUEvictFunction evict, void *context)
+{
+	size_t evicted = 0; // Evicted entry count
+
+	while ((lru->bytes > limit) && (lru->tail != NIL_NODE)) // Evict least recently used entries
+	{
+		uint32_t index = lru->tail; LRUNode node = lru->nodes[index];
+
+		LRURemoveNode(lru, index); evicted++;
+
+		if (evict != NULL) evict(node.key, node.cost, node.value, context);
+	}
+
+	return evicted;
+}
+
+void PDFReaderCoreLRURemoveAll(PDFReaderCoreLRURef lru)
+{
+	PDFReaderCoreTableClear(&lru->table); lru->head = NIL_NODE; lru->tail = NIL_NODE; lru->free = NIL_NODE;
+
+	for (uint32_t index = lru->capacity; index > 0; index--) // Every node back onto the free list
+	{
+		lru->nodes[index - 1].value = NULL; lru->nodes[index - 1].next = lru->free; lru->free = (index - 1);
+	}
+
+	lru->count = 0; lru->bytes = 0;
+}
+
+size_t PDFReaderCoreLRUBytes(PDFReaderCoreLRURef lru)
+{
+	return lru->bytes;
+}
+
+size_t PDFReaderCoreLRUCount(PDFReaderCoreLRURef lru)
+{
+	return lru->count;
+}
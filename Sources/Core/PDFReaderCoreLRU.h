@@ -0,0 +1,78 @@
+//
+//	PDFReaderCoreLRU.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_LRU_H
+#define PDFREADER_CORE_LRU_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+/*
+ *  Byte budget LRU list keyed by 64-bit key hashes. Each entry carries a
+ *  cost (in bytes) and an opaque value pointer that the list never owns.
+ *  Not thread safe - callers serialize access (the thumb cache stripe lock).
+ */
+typedef struct PDFReaderCoreLRU *PDFReaderCoreLRURef;
+
+typedef void (*PDFReaderCoreLRUEvictFunction)(uint64_t key, size_t cost, void *value, void *context);
+
+PDFReaderCoreLRURef PDFReaderCoreLRUCreate(size_t capacity);
+
+void PDFReaderCoreLRUDestroy(PDFReaderCoreLRURef lru);
+
+/*
+ *  Returns the value of key (or NULL) and makes it the most recently used.
+ */
+void *PDFReaderCoreLRUTouch(PDFReaderCoreLRURef lru, uint64_t key);
+
+/*
+ *  Returns the value of key (or NULL) without changing the LRU order.
+ */
+void *PDFReaderCoreLRUPeek(PDFReaderCoreLRURef lru, uint64_t key);
+
+/*
+ *  Adds key or replaces its cost and value, and makes it the most recently
+ *  used. Returns 0 when out of memory.
+ */
+int PDFReaderCoreLRUSet(PDFReaderCoreLRURef lru, uint64_t key, size_t cost, void *value);
+
+int PDFReaderCoreLRURemove(PDFReaderCoreLRURef lru, uint64_t key);
+
+/*
+ *  Evicts least recently used entries until the total cost is at or below
+ *  limit, calling evict (if not NULL) for each one after it is removed.
+ *  Returns the number of evicted entries.
+ */
+size_t PDFReaderCoreLRUTrim(PDFReaderCoreLRURef lru, size_t limit, PDFReaderCoreLRUEvictFunction evict, void *context);
+
+void PDFReaderCoreLRURemoveAll(PDFReaderCoreLRURef lru);
+
+size_t PDFReaderCoreLRUBytes(PDFReaderCoreLRURef lru);
+
+size_t PDFReaderCoreLRUCount(PDFReaderCoreLRURef lru);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_LRU_H
@@ -0,0 +1,188 @@
+//
+//	PDFReaderCoreNameTable.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreNameTable.h"
+#include "PDFReaderCoreHash.h"
+#include "PDFReaderCoreTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Constants
+
+#define MINIMUM_ENTRIES 16
+
+#define MINIMUM_ARENA 1024
+
+#pragma mark PDFReaderCoreNameTable types
+
+typedef struct
+{
+	size_t offset, length; // Name bytes in the arena
+	const uint8_t *name; // Name bytes (set when finished)
+	uint64_t hash; // Name bytes hash
+	const void *value; // Caller value
+	size_t order; // Add order (first value wins)
+} NameEntry;
+
+struct PDFReaderCoreNameTable
+{
+	NameEntry *entries; size_t count, capacity; // Entries
+	uint8_t *arena; size_t arenaUsed, arenaSize; // Name bytes
+	PDFReaderCoreTable index; // Hash to first entry with that hash
+	int sorted; // Finished
+};
+
+#pragma mark PDFReaderCoreNameTable functions
+
+static int CompareBytes(const uint8_t *a, size_t aLength, const uint8_t *b, size_t bLength)
+{
+	int result = memcmp(a, b, ((aLength < bLength) ? aLength : bLength));
+
+	return ((result != 0) ? result : ((aLength < bLength) ? -1 : ((aLength > bLength) ? 1 : 0)));
+}
+
+static int CompareEntries(const void *a, const void *b)
+{
+	const NameEntry *entryA = (const NameEntry *)a; const NameEntry *entryB = (const NameEntry *)b;
+
+	if (entryA->hash != entryB->hash) return ((entryA->hash < entryB->hash) ? -1 : 1); // Group equal hashes
+
+	int result = CompareBytes(entryA->name, entryA->length, entryB->name, entryB->length);
+
+	return ((result != 0) ? result : ((entryA->order < entryB->order) ? -1 : 1));
+}
+
+PDFReaderCoreNameTableRef PDFReaderCoreNameTableCreate(size_t capacity)
+{
+	PDFReaderCoreNameTableRef table = calloc(1, sizeof(struct PDFReaderCoreNameTable)); if (table == NULL) return NULL;
+
+	table->capacity = ((capacity > MINIMUM_ENTRIES) ? capacity : MINIMUM_ENTRIES); table->arenaSize = MINIMUM_ARENA;
+
+	table->entries = malloc(table->capacity * sizeof(NameEntry)); table->arena = malloc(table->arenaSize);
+
+	if ((table->entries == NULL) || (table->arena == NULL)) { PDFReaderCoreNameTableDestroy(table); table = NULL; }
+
+	return table;
+}
+
+void PDFReaderCoreNameTableDestroy(PDFReaderCoreNameTableRef table)
+{
+	if (table == NULL) return; // Nothing to destroy
+
+	PDFReaderCoreTableFree(&table->index); free(table->entries); free(table->arena); free(table);
+}
+
+int PDFReaderCoreNameTableAdd(PDFReaderCoreNameTableRef table, const void *bytes, size_t length, const void *value)
+{
+	if ((bytes == NULL) && (length > 0)) return 0; // No name bytes
+
+	if (table->count == table->capacity) // Grow the entries
+	{
+		NameEntry *entries = realloc(table->entries, (table->capacity * 2 * sizeof(NameEntry))); if (entries == NULL) return 0;
+
+		table->entries = entries; table->capacity *= 2;
+	}
+
+	if ((table->arenaUsed + length) > table->arenaSize) // Grow the arena
+	{
+		size_t size = table->arenaSize; while ((table->arenaUsed + length) > size) size *= 2;
+
+		uint8_t *arena = realloc(table->arena, size); if (arena == NULL) return 0;
+
+		table->arena = arena; table->arenaSize = size;
+	}
+
+	if (length > 0) memcpy((table->arena + table->arenaUsed), bytes, length);
+
+	NameEntry *entry = &table->entries[table->count]; entry->offset = table->arenaUsed; entry->length = length;
+
+	entry->value = value; entry->order = table->count; table->arenaUsed += length; table->count++; table->sorted = 0;
+
+	return 1;
+}
+
+void PDFReaderCoreNameTableFinish(PDFReaderCoreNameTableRef table)
+{
+	if (table->sorted == 1) return; // Already finished
+
+	for (size_t index = 0; index < table->count; index++) // The arena no longer moves
+	{
+		NameEntry *entry = &table->entries[index]; entry->name = (table->arena + entry->offset);
+
+		entry->hash = PDFReaderCoreHashBytes(entry->name, entry->length);
+	}
+
+	qsort(table->entries, table->count, sizeof(NameEntry), CompareEntries); // By hash, name, then add order
+
+	size_t unique = 0; // Drop later duplicates (sorted after the first by add order)
+
+	for (size_t index = 0; index < table->count; index++)
+	{
+		NameEntry *entry = &table->entries[index];
+
+		if (unique > 0) // Compare with the previous kept entry
+		{
+			NameEntry *kept = &table->entries[unique - 1];
+
+			if ((kept->hash == entry->hash) && (CompareBytes(kept->name, kept->length, entry->name, entry->length) == 0)) continue;
+		}
+
+		table->entries[unique++] = *entry;
+	}
+
+	table->count = unique; table->sorted = 1; // Index the first entry of each hash
+
+	PDFReaderCoreTableFree(&table->index); // Rebuilt when finished again
+
+	if (PDFReaderCoreTableInit(&table->index, (uint32_t)unique) == 0) { table->count = 0; return; }
+
+	for (size_t index = unique; index > 0; index--) // Lowest index of each hash wins
+	{
+		if (PDFReaderCoreTableSet(&table->index, table->entries[index - 1].hash, (uint32_t)(index - 1)) == 0) { table->count = 0; return; }
+	}
+}
+
+const void *PDFReaderCoreNameTableLookup(PDFReaderCoreNameTableRef table, const void *bytes, size_t length)
+{
+	if ((table == NULL) || (bytes == NULL) || (table->sorted == 0)) return NULL; // Nothing to look up
+
+	uint64_t hash = PDFReaderCoreHashBytes(bytes, length); uint32_t first = 0; // First entry with the hash
+
+	if (PDFReaderCoreTableGet(&table->index, hash, &first) == 0) return NULL;
+
+	for (size_t index = first; (index < table->count) && (table->entries[index].hash == hash); index++)
+	{
+		NameEntry *entry = &table->entries[index]; // Same hash - compare the name bytes
+
+		if (CompareBytes(entry->name, entry->length, (const uint8_t *)bytes, length) == 0) return entry->value;
+	}
+
+	return NULL;
+}
+
+size_t PDFReaderCoreNameTableCount(PDFReaderCoreNameTableRef table)
+{
+	return table->count;
+}
@@ -0,0 +1,56 @@
+//
+//	PDFReaderCoreNameTable.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_NAME_TABLE_H
+#define PDFREADER_CORE_NAME_TABLE_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+/*
+ *  Flattened name (byte string) to value table for PDF name tree and
+ *  /Dests dictionary lookups. Names are copied into one arena; after
+ *  PDFReaderCoreNameTableFinish() lookups are O(1) hashed lookups of the
+ *  raw name bytes (and lookups before it find nothing). When a name is
+ *  added more than once the first value wins (matching name tree
+ *  precedence). A finished table is safe for concurrent lookups.
+ */
+typedef struct PDFReaderCoreNameTable *PDFReaderCoreNameTableRef;
+
+PDFReaderCoreNameTableRef PDFReaderCoreNameTableCreate(size_t capacity);
+
+void PDFReaderCoreNameTableDestroy(PDFReaderCoreNameTableRef table);
+
+int PDFReaderCoreNameTableAdd(PDFReaderCoreNameTableRef table, const void *bytes, size_t length, const void *value);
+
+void PDFReaderCoreNameTableFinish(PDFReaderCoreNameTableRef table);
+
+const void *PDFReaderCoreNameTableLookup(PDFReaderCoreNameTableRef table, const void *bytes, size_t length);
+
+size_t PDFReaderCoreNameTableCount(PDFReaderCoreNameTableRef table);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_NAME_TABLE_H
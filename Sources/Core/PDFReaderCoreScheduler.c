@@ -0,0 +1,342 @@
+//
+//	PDFReaderCoreScheduler.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreScheduler.h"
+#include "PDFReaderCoreTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Constants
+
+#define NIL_NODE UINT32_MAX
+
+#define MINIMUM_NODES 64
+
+#pragma mark PDFReaderCoreScheduler types
+
+typedef struct
+{
+	uint64_t key; uint64_t group[PDFReaderCoreSchedulerGroups]; // Item key and groups
+	void *value; int priorityClass; // Caller value and class
+	uint32_t prev, next; // Class list links (or free list link)
+	uint32_t groupPrev[PDFReaderCoreSchedulerGroups], groupNext[PDFReaderCoreSchedulerGroups]; // Group list links
+} SchedulerNode;
+
+struct PDFReaderCoreScheduler
+{
+	PDFReaderCoreTable table; // Key to node index
+	PDFReaderCoreTable groups[PDFReaderCoreSchedulerGroups]; // Group to its newest node index (per dimension)
+	SchedulerNode *nodes; uint32_t capacity; uint32_t free; // Node storage
+	uint32_t head[PDFREADER_CORE_PRIORITY_CLASSES]; // Oldest item per class
+	uint32_t tail[PDFREADER_CORE_PRIORITY_CLASSES]; // Newest item per class
+	size_t count; // Queued items
+};
+
+#pragma mark PDFReaderCoreScheduler functions
+
+static inline int ClampClass(int priorityClass)
+{
+	return ((priorityClass < 0) ? 0 : ((priorityClass >= PDFREADER_CORE_PRIORITY_CLASSES) ? (PDFREADER_CORE_PRIORITY_CLASSES - 1) : priorityClass));
+}
+
+static void SchedulerUnlink(PDFReaderCoreSchedulerRef scheduler, uint32_t index)
+{
+	SchedulerNode *node = &scheduler->nodes[index]; int c = node->priorityClass;
+
+	if (node->prev != NIL_NODE) scheduler->nodes[node->prev].next = node->next; else scheduler->head[c] = node->next;
+
+	if (node->next != NIL_NODE) scheduler->nodes[node->next].prev = node->prev; else scheduler->tail[c] = node->prev;
+
+	node->prev = NIL_NODE; node->next = NIL_NODE;
+}
+
+static void SchedulerAppend(PDFReaderCoreSchedulerRef scheduler, uint32_t index)
+{
+	SchedulerNode *node = &scheduler->nodes[index]; int c = node->priorityClass;
+
+	node->prev = scheduler->tail[c]; node->next = NIL_NODE; // Back of its class
+
+	if (scheduler->tail[c] != NIL_NODE) scheduler->nodes[scheduler->tail[c]].next = index; else scheduler->head[c] = index;
+
+	scheduler->tail[c] = index;
+}
+
+static void SchedulerGroupUnlink(PDFReaderCoreSchedulerRef scheduler, uint32_t index, int d)
+{
+	SchedulerNode *node = &scheduler->nodes[index]; PDFReaderCoreTable *groups = &scheduler->groups[d];
+
+	if (node->groupNext[d] != NIL_NODE) scheduler->nodes[node->groupNext[d]].groupPrev[d] = node->groupPrev[d];
+
+	if (node->groupPrev[d] != NIL_NODE) // Not the group head
+	{
+		scheduler->nodes[node->groupPrev[d]].groupNext[d] = node->groupNext[d];
+	}
+	else if (node->groupNext[d] != NIL_NODE) // New group head
+	{
+		PDFReaderCoreTableSet(groups, node->group[d], node->groupNext[d]); // Existing key
+	}
+	else // Last item of the group
+	{
+		PDFReaderCoreTableRemove(groups, node->group[d]);
+	}
+
+	node->groupPrev[d] = NIL_NODE; node->groupNext[d] = NIL_NODE;
+}
+
+static int SchedulerGroupLink(PDFReaderCoreSchedulerRef scheduler, uint32_t index)
+{
+	SchedulerNode *node = &scheduler->nodes[index];
+
+	for (int d = 0; d < PDFReaderCoreSchedulerGroups; d++) // Newest first in every dimension
+	{
+		uint32_t newest = NIL_NODE; PDFReaderCoreTableGet(&scheduler->groups[d], node->group[d], &newest); // Group list head
+
+		if (PDFReaderCoreTableSet(&scheduler->groups[d], node->group[d], index) == 0) // Out of memory - undo
+		{
+			while (d-- > 0) SchedulerGroupUnlink(scheduler, index, d);
+
+			return 0;
+		}
+
+		node->groupPrev[d] = NIL_NODE; node->groupNext[d] = newest;
+
+		if (newest != NIL_NODE) scheduler->nodes[newest].groupPrev[d] = index;
+	}
+
+	return 1;
+}
+
+static void SchedulerRelease(PDFReaderCoreSchedulerRef scheduler, uint32_t index)
+{
+	SchedulerNode *node = &scheduler->nodes[index]; PDFReaderCoreTableRemove(&scheduler->table, node->key);
+
+	for (int d = 0; d < PDFReaderCoreSchedulerGroups; d++) SchedulerGroupUnlink(scheduler, index, d);
+
+	SchedulerUnlink(scheduler, index); scheduler->count--;
+
+	node->value = NULL; node->next = scheduler->free; scheduler->free = index; // Back onto the free list
+}
+
+static int SchedulerGrow(PDFReaderCoreSchedulerRef scheduler, uint32_t capacity)
+{
+	SchedulerNode *nodes = realloc(scheduler->nodes, (capacity * sizeof(SchedulerNode))); if (nodes == NULL) return 0;
+
+	for (uint32_t index = scheduler->capacity; index < capacity; index++) // Chain the new nodes onto the free list
+	{
+		nodes[index].next = (((index + 1) < capacity) ? (index + 1) : scheduler->free);
+	}
+
+	scheduler->free = scheduler->capacity; scheduler->nodes = nodes; scheduler->capacity = capacity;
+
+	return 1;
+}
+
+PDFReaderCoreSchedulerRef PDFReaderCoreSchedulerCreate(size_t capacity)
+{
+	PDFReaderCoreSchedulerRef scheduler = calloc(1, sizeof(struct PDFReaderCoreScheduler)); if (scheduler == NULL) return NULL;
+
+	if (capacity < MINIMUM_NODES) capacity = MINIMUM_NODES; // Minimum
+
+	if (capacity > (NIL_NODE / 2)) capacity = (NIL_NODE / 2); // Maximum
+
+	for (int c = 0; c < PDFREADER_CORE_PRIORITY_CLASSES; c++) { scheduler->head[c] = NIL_NODE; scheduler->tail[c] = NIL_NODE; }
+
+	scheduler->free = NIL_NODE; // Empty free list
+
+	int status = ((PDFReaderCoreTableInit(&scheduler->table, (uint32_t)capacity) != 0) && (SchedulerGrow(scheduler, (uint32_t)capacity) != 0));
+
+	for (int d = 0; d < PDFReaderCoreSchedulerGroups; d++) // Group indexes
+	{
+		if (status != 0) status = PDFReaderCoreTableInit(&scheduler->groups[d], 16);
+	}
+
+	if (status == 0) // Out of memory
+	{
+		PDFReaderCoreSchedulerDestroy(scheduler); scheduler = NULL;
+	}
+
+	return scheduler;
+}
+
+void PDFReaderCoreSchedulerDestroy(PDFReaderCoreSchedulerRef scheduler)
+{
+	if (scheduler == NULL) return; // Nothing to destroy
+
+	PDFReaderCoreTableFree(&scheduler->table);
+
+	for (int d = 0; d < PDFReaderCoreSchedulerGroups; d++) PDFReaderCoreTableFree(&scheduler->groups[d]);
+
+	free(scheduler->nodes); free(scheduler);
+}
+
+int PDFReaderCoreSchedulerPush(PDFReaderCoreSchedulerRef scheduler, uint64_t key, const uint64_t groups[PDFReaderCoreSchedulerGroups], int priorityClass, void *value)
+{
+	if (PDFReaderCoreTableGet(&scheduler->table, key, NULL) == 1) // Coalesce into the queued item
+	{
+		PDFReaderCoreSchedulerPromote(scheduler, key, priorityClass); return 0;
+	}
+
+	if (scheduler->free == NIL_NODE) // Out of nodes - double the storage
+	{
+		if ((scheduler->capacity >= (NIL_NODE / 2)) || (SchedulerGrow(scheduler, (scheduler->capacity * 2)) == 0)) return -1;
+	}
+
+	uint32_t index = scheduler->free; // Take a free node
+
+	if (PDFReaderCoreTableSet(&scheduler->table, key, index) == 0) return -1;
+
+	SchedulerNode *node = &scheduler->nodes[index]; node->key = key; memcpy(node->group, groups, sizeof(node->group));
+
+	if (SchedulerGroupLink(scheduler, index) == 0) { PDFReaderCoreTableRemove(&scheduler->table, key); return -1; }
+
+	scheduler->free = node->next; node->value = value; node->priorityClass = ClampClass(priorityClass);
+
+	SchedulerAppend(scheduler, index); scheduler->count++;
+
+	return 1;
+}
+
+int PDFReaderCoreSchedulerPop(PDFReaderCoreSchedulerRef scheduler, uint64_t *key, void **value)
+{
+	for (int c = 0; c < PDFREADER_CORE_PRIORITY_CLASSES; c++) // Most urgent class first
+	{
+		uint32_t index = scheduler->head[c]; if (index == NIL_NODE) continue;
+
+		SchedulerNode *node = &scheduler->nodes[index]; // Oldest item of the class
+
+		if (key != NULL) *key = node->key;
+
+		if (value != NULL) *value = node->value;
+
+		SchedulerRelease(scheduler, index);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+int PDFReaderCoreSchedulerPromote(PDFReaderCoreSchedulerRef scheduler, uint64_t key, int priorityClass)
+{
+	uint32_t index = NIL_NODE; if (PDFReaderCoreTableGet(&scheduler->table, key, &index) == 0) return 0;
+
+	priorityClass = ClampClass(priorityClass); SchedulerNode *node = &scheduler->nodes[index];
+
+	if (priorityClass < node->priorityClass) // More urgent - move it to the back of the new class
+	{
+		SchedulerUnlink(scheduler, index); node->priorityClass = priorityClass; SchedulerAppend(scheduler, index);
+	}
+
+	return 1;
+}
+
+int PDFReaderCoreSchedulerDemote(PDFReaderCoreSchedulerRef scheduler, uint64_t key, int priorityClass)
+{
+	uint32_t index = NIL_NODE; if (PDFReaderCoreTableGet(&scheduler->table, key, &index) == 0) return 0;
+
+	priorityClass = ClampClass(priorityClass); SchedulerNode *node = &scheduler->nodes[index];
+
+	if (priorityClass > node->priorityClass) // Less urgent - move it to the back of the new class
+	{
+		SchedulerUnlink(scheduler, index); node->priorityClass = priorityClass; SchedulerAppend(scheduler, index);
+	}
+
+	return 1;
+}
+
+size_t PDFReaderCoreSchedulerCancelGroup(PDFReaderCoreSchedulerRef scheduler, PDFReaderCoreSchedulerGroup dimension, uint64_t group, PDFReaderCoreSchedulerCancelFunction cancel, void *context)
+{
+	size_t cancelled = 0; uint32_t index = NIL_NODE; // Removed item count
+
+	if ((dimension < 0) || (dimension >= PDFReaderCoreSchedulerGroups)) return 0; // Invalid dimension
+
+	while (PDFReaderCoreTableGet(&scheduler->groups[dimension], group, &index) == 1) // Group list only, newest first
+	{
+		SchedulerNode node = scheduler->nodes[index]; // Copy - the node is released
+
+		SchedulerRelease(scheduler, index); cancelled++;
+
+		if (cancel != NULL) cancel(node.key, node.value, context);
+	}
+
+	return cancelled;
+}
+
+int PDFReaderCoreSchedulerCancel(PDFReaderCoreSchedulerRef scheduler, uint64_t key, PDFReaderCoreSchedulerCancelFunction cancel, void *context)
+{
+	uint32_t index = NIL_NODE; if (PDFReaderCoreTableGet(&scheduler->table, key, &index) == 0) return 0;
+
+	SchedulerNode node = scheduler->nodes[index]; SchedulerRelease(scheduler, index);
+
+	if (cancel != NULL) cancel(node.key, node.value, context);
+
+	return 1;
+}
+
+size_t PDFReaderCoreSchedulerCount(PDFReaderCoreSchedulerRef scheduler)
+{
+	return scheduler->count;
+}
+
+#pragma mark PDFReaderCoreLane functions
+
+void PDFReaderCoreLaneEnqueued(PDFReaderCoreLaneState *state, double now)
+{
+	if (state->inFlight++ == 0) state->busySince = now; // Lane went busy
+
+	state->queued++; // Count it
+}
+
+void PDFReaderCoreLaneFinished(PDFReaderCoreLaneState *state, double enqueueTime, double startTime, int cancelled, double now)
+{
+	if ((startTime > 0.0) && (cancelled == 0)) // Ran to completion
+	{
+		double wait = (startTime - enqueueTime); // Queue wait time
+
+		state->completed++; state->totalWait += wait;
+
+		if (wait > state->maximumWait) state->maximumWait = wait;
+	}
+	else // Cancelled before or during execution
+	{
+		state->cancelled++;
+	}
+
+	if ((state->inFlight > 0) && (--state->inFlight == 0)) // Lane went idle
+	{
+		state->busyTime += (now - state->busySince);
+	}
+}
+
+void PDFReaderCoreLaneSummary(const PDFReaderCoreLaneState *state, double now, double *throughput, double *averageWait)
+{
+	double busyTime = state->busyTime; // Plus the current busy span
+
+	if (state->inFlight > 0) busyTime += (now - state->busySince);
+
+	if (throughput != NULL) *throughput = ((busyTime > 0.0) ? (state->completed / busyTime) : 0.0);
+
+	if (averageWait != NULL) *averageWait = ((state->completed > 0) ? (state->totalWait / state->completed) : 0.0);
+}
@@ -0,0 +1,127 @@
+//
+//	PDFReaderCoreScheduler.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_SCHEDULER_H
+#define PDFREADER_CORE_SCHEDULER_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+#define PDFREADER_CORE_PRIORITY_CLASSES 4 // PDFReaderThumbPriority values
+
+/*
+ *  Group dimensions of a queued item. Each item is a member of one group of
+ *  every dimension (group 0 of a dimension is never cancelled by the thumb
+ *  queue - it means none).
+ */
+typedef enum
+{
+	PDFReaderCoreSchedulerDocument = 0, // Document GUID hash
+	PDFReaderCoreSchedulerPage, // Document GUID hash mixed with the page number
+	PDFReaderCoreSchedulerTarget, // Target thumb view tag
+	PDFReaderCoreSchedulerGroups
+} PDFReaderCoreSchedulerGroup;
+
+/*
+ *  Thumb work ordering policy: strict priority between classes (0 is the
+ *  most urgent), FIFO within a class, promotion (or demotion) of a queued key
+ *  to another class and cancellation of a single key or of every queued item
+ *  of a group in time proportional to the items removed.
+ *  Keys are unique - pushing a queued key coalesces into it.
+ *  Each PDFReaderThumbQueue lane keeps its waiting operations in one of these
+ *  and only hands the head to its NSOperationQueue when a worker is free.
+ *  Not thread safe - callers serialize access.
+ */
+typedef struct PDFReaderCoreScheduler *PDFReaderCoreSchedulerRef;
+
+typedef void (*PDFReaderCoreSchedulerCancelFunction)(uint64_t key, void *value, void *context);
+
+PDFReaderCoreSchedulerRef PDFReaderCoreSchedulerCreate(size_t capacity);
+
+void PDFReaderCoreSchedulerDestroy(PDFReaderCoreSchedulerRef scheduler);
+
+/*
+ *  Queues value under key as a member of groups (one per dimension). Returns
+ *  1 when queued, 0 when key was already queued (it is promoted to
+ *  priorityClass if that is more urgent) and -1 when out of memory.
+ */
+int PDFReaderCoreSchedulerPush(PDFReaderCoreSchedulerRef scheduler, uint64_t key, const uint64_t groups[PDFReaderCoreSchedulerGroups], int priorityClass, void *value);
+
+/*
+ *  Dequeues the oldest item of the most urgent non-empty class. Returns 0
+ *  when the scheduler is empty.
+ */
+int PDFReaderCoreSchedulerPop(PDFReaderCoreSchedulerRef scheduler, uint64_t *key, void **value);
+
+/*
+ *  Moves a queued key to the back of priorityClass when that is more urgent
+ *  than its current class. Returns 1 when the key is queued.
+ */
+int PDFReaderCoreSchedulerPromote(PDFReaderCoreSchedulerRef scheduler, uint64_t key, int priorityClass);
+
+/*
+ *  Moves a queued key to the back of priorityClass when that is less urgent
+ *  than its current class. Returns 1 when the key is queued.
+ */
+int PDFReaderCoreSchedulerDemote(PDFReaderCoreSchedulerRef scheduler, uint64_t key, int priorityClass);
+
+/*
+ *  Removes every queued item of group in dimension, calling cancel (if not
+ *  NULL) for each. Returns the number of removed items.
+ */
+size_t PDFReaderCoreSchedulerCancelGroup(PDFReaderCoreSchedulerRef scheduler, PDFReaderCoreSchedulerGroup dimension, uint64_t group, PDFReaderCoreSchedulerCancelFunction cancel, void *context);
+
+/*
+ *  Removes the queued item with key, calling cancel (if not NULL) for it.
+ *  Returns 1 when it was queued.
+ */
+int PDFReaderCoreSchedulerCancel(PDFReaderCoreSchedulerRef scheduler, uint64_t key, PDFReaderCoreSchedulerCancelFunction cancel, void *context);
+
+size_t PDFReaderCoreSchedulerCount(PDFReaderCoreSchedulerRef scheduler);
+
+/*
+ *  Lane accounting shared by the thumb queue lanes and the benchmarks.
+ *  All times are in seconds on the caller's clock.
+ */
+typedef struct
+{
+	size_t queued, completed, cancelled, inFlight; // Counts
+	double totalWait, maximumWait; // Enqueue to start waits
+	double busySince, busyTime; // Non-idle time
+} PDFReaderCoreLaneState;
+
+void PDFReaderCoreLaneEnqueued(PDFReaderCoreLaneState *state, double now);
+
+void PDFReaderCoreLaneFinished(PDFReaderCoreLaneState *state, double enqueueTime, double startTime, int cancelled, double now);
+
+/*
+ *  Completed per busy second (including the current busy span) and the
+ *  mean wait of completed items.
+ */
+void PDFReaderCoreLaneSummary(const PDFReaderCoreLaneState *state, double now, double *throughput, double *averageWait);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_SCHEDULER_H
@@ -0,0 +1,1996 @@
+//
+//	PDFReaderCoreStructure.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // mmap() with -std=c99
+#endif
+
+#include "PDFReaderCoreStructure.h"
+#include "PDFReaderCoreNameTable.h"
+#include "PDFReaderCoreTable.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#pragma mark Constants
+
+#define ARENA_CHUNK 65536
+
+#define INLINE_ITEMS 16
+
+#define PARSE_DEPTH 64 // Nested arrays and dictionaries
+
+#define LOAD_DEPTH 32 // Nested object loads (/Length, object streams)
+
+#define RESOLVE_DEPTH 32 // Chained indirect references
+
+#define TREE_DEPTH 64 // Page tree, name tree and outline levels
+
+#define XREF_SECTIONS 256 // Longest /Prev chain
+
+#define HEADER_WINDOW 1024 // Leading bytes searched for %PDF-
+
+#define STARTXREF_WINDOW 2048 // Trailing bytes searched for startxref
+
+#define MAXIMUM_OBJECTS 8388608 // Larger object numbers are ignored
+
+#define MAXIMUM_DECODED 268435456 // Decoded stream size limit
+
+#define NOT_FOUND SIZE_MAX
+
+#pragma mark PDFReaderCoreStructure types
+
+typedef enum
+{
+	ObjectNull = 0, ObjectBoolean, ObjectInteger, ObjectReal, ObjectString, ObjectName,
+	ObjectArray, ObjectDictionary, ObjectReference, ObjectStream
+} ObjectType;
+
+typedef struct Object Object;
+
+typedef struct
+{
+	const uint8_t *key; size_t length; // Key name bytes
+	Object *value; // Value object
+} DictionaryEntry;
+
+struct Object
+{
+	ObjectType type; // Object type
+
+	union
+	{
+		int boolean; long long integer; double real; // Scalars
+		struct { const uint8_t *bytes; size_t length; } string; // String and (NUL terminated) name bytes
+		struct { Object **items; size_t count; } array; // Array items
+		struct { DictionaryEntry *entries; size_t count; } dictionary; // Dictionary entries
+		struct { uint32_t number, generation; } reference; // Indirect reference
+		struct { Object *dictionary; const uint8_t *bytes; size_t length; } stream; // Stream dictionary and raw data
+	} u;
+};
+
+typedef struct
+{
+	uint8_t defined; // Listed by the newest section that has it
+	uint8_t type; // 0 free, 1 in the file, 2 in an object stream
+	uint8_t state; // 0 not loaded, 1 loading, 2 loaded
+	uint32_t index; // Index in the object stream
+	uint64_t offset; // File offset or object stream number
+	Object *object; // Loaded object
+} XrefEntry;
+
+typedef struct
+{
+	const uint8_t *bytes; size_t length; // Decoded data (NULL when unusable)
+	size_t first; uint32_t count; // Offset of the first object and object count
+	uint32_t *numbers; size_t *offsets; // Object numbers and offsets
+} ObjStm;
+
+typedef struct ArenaChunk
+{
+	struct ArenaChunk *next; // Chunk list
+	size_t used, size; // Chunk bytes
+} ArenaChunk;
+
+typedef struct
+{
+	const uint8_t *bytes; size_t length; // Parsed bytes
+	size_t position; // Current position
+} Lexer;
+
+typedef struct
+{
+	Object **items; size_t count, capacity; // Items (inline until they outgrow it)
+	Object *inlineItems[INLINE_ITEMS]; // Inline items
+} ObjectVector;
+
+typedef struct
+{
+	PDFReaderCoreRect mediaBox, cropBox; // Inherited boxes
+	int hasMediaBox, hasCropBox; // Boxes found
+	long rotate; // Inherited rotation
+} PageAttributes;
+
+struct PDFReaderCoreStructure
+{
+	const uint8_t *bytes; size_t length; // Document bytes
+	void *mapping; // mmap()ed file (NULL for caller bytes)
+	ArenaChunk *arena; // Parsed objects
+	uint8_t **buffers; size_t bufferCount, bufferCapacity; // Decoded stream data
+	XrefEntry *entries; size_t entryCount; // Cross-reference entries by object number
+	ObjStm *objectStreams; size_t objectStreamCount, objectStreamCapacity; // Object streams
+	PDFReaderCoreTable objectStreamIndex; // Object stream number to object stream
+	Object *trailer, *root; // Newest trailer and its /Root
+	Object *catalog, *pages; uint32_t pagesNumber; // Catalog and page tree root
+	long pageCount; // Page count (-1 until known)
+	PDFReaderCoreTable pageMap; int pageMapBuilt; // Page object number to page number
+	PDFReaderCoreNameTableRef stringDestinations, nameDestinations; int destinationsBuilt; // Named destinations
+	int encrypted; int loadDepth; // State
+};
+
+static Object NullObject = { ObjectNull, { 0 } };
+
+#pragma mark PDFReaderCoreStructure arena functions
+
+#define ARENA_HEADER ((sizeof(ArenaChunk) + 7) & ~(size_t)7)
+
+static void *ArenaAllocate(PDFReaderCoreStructureRef structure, size_t size)
+{
+	if (size > (SIZE_MAX / 2)) return NULL;
+
+	size = ((size + 7) & ~(size_t)7); if (size == 0) size = 8;
+
+	ArenaChunk *chunk = structure->arena; // Current chunk
+
+	if ((chunk == NULL) || ((chunk->size - chunk->used) < size))
+	{
+		size_t capacity = ((size > (ARENA_CHUNK / 4)) ? size : ARENA_CHUNK); // Large blocks get their own chunk
+
+		ArenaChunk *block = malloc(ARENA_HEADER + capacity); if (block == NULL) return NULL;
+
+		block->used = 0; block->size = capacity;
+
+		if ((capacity != ARENA_CHUNK) && (chunk != NULL)) // Keep filling the current chunk
+		{
+			block->next = chunk->next; chunk->next = block;
+		}
+		else // New current chunk
+		{
+			block->next = chunk; structure->arena = block;
+		}
+
+		chunk = block;
+	}
+
+	void *memory = ((uint8_t *)chunk + ARENA_HEADER + chunk->used); chunk->used += size;
+
+	return memory;
+}
+
+static Object *NewObject(PDFReaderCoreStructureRef structure, ObjectType type)
+{
+	Object *object = ArenaAllocate(structure, sizeof(Object)); if (object == NULL) return NULL;
+
+	memset(object, 0x00, sizeof(Object)); object->type = type;
+
+	return object;
+}
+
+static int TrackBuffer(PDFReaderCoreStructureRef structure, uint8_t *buffer)
+{
+	if (structure->bufferCount == structure->bufferCapacity) // Grow the list
+	{
+		size_t capacity = ((structure->bufferCapacity > 0) ? (structure->bufferCapacity * 2) : 8);
+
+		uint8_t **buffers = realloc(structure->buffers, (capacity * sizeof(uint8_t *))); if (buffers == NULL) return 0;
+
+		structure->buffers = buffers; structure->bufferCapacity = capacity;
+	}
+
+	structure->buffers[structure->bufferCount++] = buffer;
+
+	return 1;
+}
+
+#pragma mark PDFReaderCoreStructure lexer functions
+
+static int IsWhitespace(uint8_t c)
+{
+	return ((c == ' ') || (c == '\n') || (c == '\r') || (c == '\t') || (c == '\f') || (c == '\0'));
+}
+
+static int IsDelimiter(uint8_t c)
+{
+	return ((c == '(') || (c == ')') || (c == '<') || (c == '>') || (c == '[') || (c == ']') || (c == '{') || (c == '}') || (c == '/') || (c == '%'));
+}
+
+static int IsRegular(uint8_t c)
+{
+	return ((IsWhitespace(c) == 0) && (IsDelimiter(c) == 0));
+}
+
+static int IsDigit(uint8_t c)
+{
+	return ((c >= '0') && (c <= '9'));
+}
+
+static int HexValue(uint8_t c)
+{
+	if ((c >= '0') && (c <= '9')) return (c - '0');
+
+	if ((c >= 'a') && (c <= 'f')) return (c - 'a' + 10);
+
+	if ((c >= 'A') && (c <= 'F')) return (c - 'A' + 10);
+
+	return -1;
+}
+
+static size_t FindBytes(const uint8_t *bytes, size_t length, size_t start, const char *pattern, size_t patternLength)
+{
+	while ((start < length) && ((length - start) >= patternLength))
+	{
+		const uint8_t *found = memchr((bytes + start), pattern[0], (length - start - patternLength + 1));
+
+		if (found == NULL) break;
+
+		size_t position = (size_t)(found - bytes);
+
+		if (memcmp(found, pattern, patternLength) == 0) return position;
+
+		start = (position + 1);
+	}
+
+	return NOT_FOUND;
+}
+
+static void SkipWhitespace(Lexer *lexer)
+{
+	while (lexer->position < lexer->length)
+	{
+		uint8_t c = lexer->bytes[lexer->position];
+
+		if (IsWhitespace(c) != 0) // Whitespace
+		{
+			lexer->position++;
+		}
+		else if (c == '%') // Comment to the end of the line
+		{
+			while ((lexer->position < lexer->length) && (lexer->bytes[lexer->position] != '\n') && (lexer->bytes[lexer->position] != '\r')) lexer->position++;
+		}
+		else break;
+	}
+}
+
+static int LexKeyword(Lexer *lexer, const char *keyword)
+{
+	SkipWhitespace(lexer); size_t length = strlen(keyword);
+
+	if ((lexer->length - lexer->position) < length) return 0;
+
+	if (memcmp((lexer->bytes + lexer->position), keyword, length) != 0) return 0;
+
+	size_t end = (lexer->position + length); // Must end the token
+
+	if ((end < lexer->length) && (IsRegular(lexer->bytes[end]) != 0)) return 0;
+
+	lexer->position = end;
+
+	return 1;
+}
+
+static int LexInteger(Lexer *lexer, long long *value)
+{
+	SkipWhitespace(lexer); size_t position = lexer->position; int negative = 0;
+
+	if ((position < lexer->length) && ((lexer->bytes[position] == '-') || (lexer->bytes[position] == '+')))
+	{
+		negative = (lexer->bytes[position] == '-'); position++;
+	}
+
+	size_t start = position; long long result = 0; // Digits
+
+	while ((position < lexer->length) && (IsDigit(lexer->bytes[position]) != 0))
+	{
+		if (result < (LLONG_MAX / 10)) result = ((result * 10) + (lexer->bytes[position] - '0'));
+
+		position++;
+	}
+
+	if (position == start) return 0; // No digits
+
+	if ((position < lexer->length) && (IsRegular(lexer->bytes[position]) != 0)) return 0; // A real or junk
+
+	lexer->position = position; *value = (negative ? -result : result);
+
+	return 1;
+}
+
+#pragma mark PDFReaderCoreStructure parser functions
+
+static Object *ParseObject(PDFReaderCoreStructureRef structure, Lexer *lexer, int depth);
+
+static void VectorInit(ObjectVector *vector)
+{
+	vector->items = vector->inlineItems; vector->count = 0; vector->capacity = INLINE_ITEMS;
+}
+
+static int VectorAppend(ObjectVector *vector, Object *object)
+{
+	if (vector->count == vector->capacity) // Grow (moving off the stack)
+	{
+		size_t capacity = (vector->capacity * 2); Object **items = NULL;
+
+		if (vector->items == vector->inlineItems) // First heap allocation
+		{
+			if ((items = malloc(capacity * sizeof(Object *))) != NULL) memcpy(items, vector->inlineItems, (vector->count * sizeof(Object *)));
+		}
+		else // Grow the heap allocation
+		{
+			items = realloc(vector->items, (capacity * sizeof(Object *)));
+		}
+
+		if (items == NULL) return 0;
+
+		vector->items = items; vector->capacity = capacity;
+	}
+
+	vector->items[vector->count++] = object;
+
+	return 1;
+}
+
+static void VectorFree(ObjectVector *vector)
+{
+	if (vector->items != vector->inlineItems) free(vector->items);
+}
+
+static Object *ParseNumber(PDFReaderCoreStructureRef structure, Lexer *lexer)
+{
+	const uint8_t *bytes = lexer->bytes; size_t position = lexer->position; int negative = 0;
+
+	while ((position < lexer->length) && ((bytes[position] == '-') || (bytes[position] == '+'))) // Tolerate repeated signs
+	{
+		if (bytes[position] == '-') negative = !negative;
+
+		position++;
+	}
+
+	long long integer = 0; double real = 0.0; int isReal = 0; int digits = 0;
+
+	while ((position < lexer->length) && (IsDigit(bytes[position]) != 0))
+	{
+		if (integer < (LLONG_MAX / 10)) integer = ((integer * 10) + (bytes[position] - '0'));
+
+		position++; digits++;
+	}
+
+	if ((position < lexer->length) && (bytes[position] == '.')) // Fraction
+	{
+		double scale = 0.1; real = (double)integer; isReal = 1; position++;
+
+		while ((position < lexer->length) && (IsDigit(bytes[position]) != 0))
+		{
+			real += ((bytes[position] - '0') * scale); scale *= 0.1; position++; digits++;
+		}
+	}
+
+	if (digits == 0) return NULL; // A lone sign or point
+
+	lexer->position = position; Object *object = NewObject(structure, (isReal ? ObjectReal : ObjectInteger));
+
+	if (object == NULL) return NULL;
+
+	if (isReal)
+		object->u.real = (negative ? -real : real);
+	else
+		object->u.integer = (negative ? -integer : integer);
+
+	return object;
+}
+
+static Object *ParseName(PDFReaderCoreStructureRef structure, Lexer *lexer)
+{
+	size_t start = ++lexer->position; size_t end = start; // Skip the /
+
+	while ((end < lexer->length) && (IsRegular(lexer->bytes[end]) != 0)) end++;
+
+	uint8_t *name = ArenaAllocate(structure, (end - start + 1)); if (name == NULL) return NULL;
+
+	size_t length = 0; // Decode #xx escapes
+
+	for (size_t index = start; index < end; index++)
+	{
+		uint8_t c = lexer->bytes[index];
+
+		if ((c == '#') && ((index + 2) < end) && (HexValue(lexer->bytes[index + 1]) >= 0) && (HexValue(lexer->bytes[index + 2]) >= 0))
+		{
+			c = (uint8_t)((HexValue(lexer->bytes[index + 1]) << 4) | HexValue(lexer->bytes[index + 2])); index += 2;
+		}
+
+		name[length++] = c;
+	}
+
+	name[length] = '\0'; lexer->position = end;
+
+	Object *object = NewObject(structure, ObjectName); if (object == NULL) return NULL;
+
+	object->u.string.bytes = name; object->u.string.length = length;
+
+	return object;
+}
+
+static Object *ParseLiteralString(PDFReaderCoreStructureRef structure, Lexer *lexer)
+{
+	const uint8_t *bytes = lexer->bytes; size_t start = (lexer->position + 1); size_t end = start; int nesting = 1;
+
+	while (end < lexer->length) // Find the closing parenthesis
+	{
+		uint8_t c = bytes[end];
+
+		if (c == '\\') { end += 2; continue; }
+
+		if (c == '(') nesting++; else if ((c == ')') && (--nesting == 0)) break;
+
+		end++;
+	}
+
+	if (end >= lexer->length) return NULL; // Unterminated
+
+	uint8_t *string = ArenaAllocate(structure, (end - start + 1)); if (string == NULL) return NULL;
+
+	size_t length = 0; // Decode escapes and line endings
+
+	for (size_t index = start; index < end; index++)
+	{
+		uint8_t c = bytes[index];
+
+		if (c == '\\') // Escape
+		{
+			c = bytes[++index];
+
+			switch (c)
+			{
+				case 'n': string[length++] = '\n'; break;
+				case 'r': string[length++] = '\r'; break;
+				case 't': string[length++] = '\t'; break;
+				case 'b': string[length++] = '\b'; break;
+				case 'f': string[length++] = '\f'; break;
+
+				case '\r': // Line continuation
+					if (((index + 1) < end) && (bytes[index + 1] == '\n')) index++;
+					break;
+
+				case '\n': // Line continuation
+					break;
+
+				default:
+					if ((c >= '0') && (c <= '7')) // Up to three octal digits
+					{
+						unsigned value = (c - '0');
+
+						for (int digit = 1; (digit < 3) && ((index + 1) < end) && (bytes[index + 1] >= '0') && (bytes[index + 1] <= '7'); digit++)
+						{
+							value = ((value << 3) | (bytes[++index] - '0'));
+						}
+
+						string[length++] = (uint8_t)value;
+					}
+					else // Including \( \) and \\ itself
+					{
+						string[length++] = c;
+					}
+					break;
+			}
+		}
+		else if (c == '\r') // End of line is always \n
+		{
+			if (((index + 1) < end) && (bytes[index + 1] == '\n')) index++;
+
+			string[length++] = '\n';
+		}
+		else // Plain byte
+		{
+			string[length++] = c;
+		}
+	}
+
+	string[length] = '\0'; lexer->position = (end + 1);
+
+	Object *object = NewObject(structure, ObjectString); if (object == NULL) return NULL;
+
+	object->u.string.bytes = string; object->u.string.length = length;
+
+	return object;
+}
+
+static Object *ParseHexString(PDFReaderCoreStructureRef structure, Lexer *lexer)
+{
+	size_t start = (lexer->position + 1); size_t end = start;
+
+	while ((end < lexer->length) && (lexer->bytes[end] != '>')) end++;
+
+	if (end >= lexer->length) return NULL; // Unterminated
+
+	uint8_t *string = ArenaAllocate(structure, ((end - start) / 2 + 2)); if (string == NULL) return NULL;
+
+	size_t length = 0; int high = -1; // Pending high nibble
+
+	for (size_t index = start; index < end; index++)
+	{
+		uint8_t c = lexer->bytes[index]; if (IsWhitespace(c) != 0) continue;
+
+		int value = HexValue(c); if (value < 0) return NULL;
+
+		if (high < 0) high = value; else { string[length++] = (uint8_t)((high << 4) | value); high = -1; }
+	}
+
+	if (high >= 0) string[length++] = (uint8_t)(high << 4); // Odd digit count
+
+	string[length] = '\0'; lexer->position = (end + 1);
+
+	Object *object = NewObject(structure, ObjectString); if (object == NULL) return NULL;
+
+	object->u.string.bytes = string; object->u.string.length = length;
+
+	return object;
+}
+
+static Object *ParseArray(PDFReaderCoreStructureRef structure, Lexer *lexer, int depth)
+{
+	ObjectVector vector; VectorInit(&vector); Object *object = NULL; lexer->position++; // Skip the [
+
+	for (;;) // Items until ]
+	{
+		SkipWhitespace(lexer); if (lexer->position >= lexer->length) goto finish;
+
+		if (lexer->bytes[lexer->position] == ']') { lexer->position++; break; }
+
+		Object *item = ParseObject(structure, lexer, (depth + 1)); if (item == NULL) goto finish;
+
+		if (VectorAppend(&vector, item) == 0) goto finish;
+	}
+
+	if ((object = NewObject(structure, ObjectArray)) == NULL) goto finish;
+
+	object->u.array.items = ArenaAllocate(structure, (vector.count * sizeof(Object *)));
+
+	if (object->u.array.items == NULL) { object = NULL; goto finish; }
+
+	memcpy(object->u.array.items, vector.items, (vector.count * sizeof(Object *))); object->u.array.count = vector.count;
+
+finish:
+	VectorFree(&vector); return object;
+}
+
+static Object *ParseDictionary(PDFReaderCoreStructureRef structure, Lexer *lexer, int depth)
+{
+	ObjectVector vector; VectorInit(&vector); Object *object = NULL; lexer->position += 2; // Skip the <<
+
+	for (;;) // Key and value pairs until >>
+	{
+		SkipWhitespace(lexer); if (lexer->position >= lexer->length) goto finish;
+
+		if (lexer->bytes[lexer->position] == '>') // End of the dictionary
+		{
+			if (((lexer->position + 1) >= lexer->length) || (lexer->bytes[lexer->position + 1] != '>')) goto finish;
+
+			lexer->position += 2; break;
+		}
+
+		if (lexer->bytes[lexer->position] != '/') goto finish; // Keys are names
+
+		Object *key = ParseName(structure, lexer); if (key == NULL) goto finish;
+
+		Object *value = ParseObject(structure, lexer, (depth + 1)); if (value == NULL) goto finish;
+
+		if ((VectorAppend(&vector, key) == 0) || (VectorAppend(&vector, value) == 0)) goto finish;
+	}
+
+	if ((object = NewObject(structure, ObjectDictionary)) == NULL) goto finish;
+
+	size_t count = (vector.count / 2); DictionaryEntry *entries = ArenaAllocate(structure, (count * sizeof(DictionaryEntry)));
+
+	if (entries == NULL) { object = NULL; goto finish; }
+
+	for (size_t index = 0; index < count; index++)
+	{
+		Object *key = vector.items[index * 2]; entries[index].value = vector.items[(index * 2) + 1];
+
+		entries[index].key = key->u.string.bytes; entries[index].length = key->u.string.length;
+	}
+
+	object->u.dictionary.entries = entries; object->u.dictionary.count = count;
+
+finish:
+	VectorFree(&vector); return object;
+}
+
+static Object *ParseObject(PDFReaderCoreStructureRef structure, Lexer *lexer, int depth)
+{
+	if (depth >= PARSE_DEPTH) return NULL; // Too deeply nested
+
+	SkipWhitespace(lexer); if (lexer->position >= lexer->length) return NULL;
+
+	uint8_t c = lexer->bytes[lexer->position];
+
+	switch (c)
+	{
+		case '/':
+			return ParseName(structure, lexer);
+
+		case '(':
+			return ParseLiteralString(structure, lexer);
+
+		case '[':
+			return ParseArray(structure, lexer, depth);
+
+		case '<':
+			if (((lexer->position + 1) < lexer->length) && (lexer->bytes[lexer->position + 1] == '<'))
+				return ParseDictionary(structure, lexer, depth);
+			else
+				return ParseHexString(structure, lexer);
+
+		default:
+			break;
+	}
+
+	if ((IsDigit(c) != 0) || (c == '-') || (c == '+') || (c == '.')) // Number or reference
+	{
+		Object *number = ParseNumber(structure, lexer); if (number == NULL) return NULL;
+
+		if ((number->type == ObjectInteger) && (number->u.integer >= 0) && (number->u.integer <= UINT32_MAX))
+		{
+			size_t position = lexer->position; long long generation = 0; // Look ahead for "G R"
+
+			if ((LexInteger(lexer, &generation) != 0) && (generation >= 0) && (generation <= UINT16_MAX) && (LexKeyword(lexer, "R") != 0))
+			{
+				uint32_t objectNumber = (uint32_t)number->u.integer; number->type = ObjectReference; // Reuse the object
+
+				number->u.reference.number = objectNumber; number->u.reference.generation = (uint32_t)generation;
+			}
+			else // Not a reference
+			{
+				lexer->position = position;
+			}
+		}
+
+		return number;
+	}
+
+	if (LexKeyword(lexer, "true") != 0) { Object *object = NewObject(structure, ObjectBoolean); if (object != NULL) object->u.boolean = 1; return object; }
+
+	if (LexKeyword(lexer, "false") != 0) return NewObject(structure, ObjectBoolean);
+
+	if (LexKeyword(lexer, "null") != 0) return &NullObject;
+
+	return NULL; // Unexpected token
+}
+
+#pragma mark PDFReaderCoreStructure object functions
+
+static Object *LoadObject(PDFReaderCoreStructureRef structure, uint32_t number);
+
+static Object *DictionaryGet(Object *dictionary, const char *key)
+{
+	if ((dictionary != NULL) && (dictionary->type == ObjectStream)) dictionary = dictionary->u.stream.dictionary;
+
+	if ((dictionary == NULL) || (dictionary->type != ObjectDictionary)) return NULL;
+
+	size_t length = strlen(key); DictionaryEntry *entries = dictionary->u.dictionary.entries;
+
+	for (size_t index = 0; index < dictionary->u.dictionary.count; index++)
+	{
+		if ((entries[index].length == length) && (memcmp(entries[index].key, key, length) == 0)) return entries[index].value;
+	}
+
+	return NULL;
+}
+
+static Object *Resolve(PDFReaderCoreStructureRef structure, Object *object)
+{
+	for (int depth = 0; (object != NULL) && (object->type == ObjectReference); depth++)
+	{
+		if (depth >= RESOLVE_DEPTH) return NULL; // Reference chain (or loop)
+
+		object = LoadObject(structure, object->u.reference.number);
+	}
+
+	return (((object != NULL) && (object->type != ObjectNull)) ? object : NULL);
+}
+
+static Object *Get(PDFReaderCoreStructureRef structure, Object *dictionary, const char *key)
+{
+	return Resolve(structure, DictionaryGet(dictionary, key));
+}
+
+static Object *GetTyped(PDFReaderCoreStructureRef structure, Object *dictionary, const char *key, ObjectType type)
+{
+	Object *object = Get(structure, dictionary, key);
+
+	return (((object != NULL) && (object->type == type)) ? object : NULL);
+}
+
+static int GetNumber(Object *object, double *value)
+{
+	if (object == NULL) return 0;
+
+	if (object->type == ObjectInteger) { *value = (double)object->u.integer; return 1; }
+
+	if ((object->type == ObjectReal) && (isfinite(object->u.real) != 0)) { *value = object->u.real; return 1; }
+
+	return 0;
+}
+
+static int IsName(Object *object, const char *name)
+{
+	return ((object != NULL) && (object->type == ObjectName) && (strcmp((const char *)object->u.string.bytes, name) == 0));
+}
+
+static uint32_t ReferenceNumber(Object *object)
+{
+	return (((object != NULL) && (object->type == ObjectReference)) ? object->u.reference.number : 0);
+}
+
+#pragma mark PDFReaderCoreStructure stream functions
+
+static uint8_t *Inflate(const uint8_t *bytes, size_t length, size_t *decodedLength)
+{
+	z_stream stream; memset(&stream, 0x00, sizeof(stream));
+
+	if (inflateInit(&stream) != Z_OK) return NULL;
+
+	size_t capacity = ((length < (MAXIMUM_DECODED / 4)) ? ((length * 4) + 1024) : MAXIMUM_DECODED);
+
+	uint8_t *buffer = malloc(capacity); size_t used = 0; size_t consumed = 0;
+
+	while (buffer != NULL)
+	{
+		if (used == capacity) // Grow the output
+		{
+			if (capacity >= MAXIMUM_DECODED) break; // Keep what fits
+
+			size_t size = (((capacity * 2) < MAXIMUM_DECODED) ? (capacity * 2) : MAXIMUM_DECODED);
+
+			uint8_t *grown = realloc(buffer, size); if (grown == NULL) break;
+
+			buffer = grown; capacity = size;
+		}
+
+		if ((stream.avail_in == 0) && (consumed < length)) // Feed the next input chunk
+		{
+			size_t chunk = (((length - consumed) < UINT_MAX) ? (length - consumed) : UINT_MAX);
+
+			stream.next_in = (Bytef *)(bytes + consumed); stream.avail_in = (uInt)chunk; consumed += chunk;
+		}
+
+		size_t space = (((capacity - used) < UINT_MAX) ? (capacity - used) : UINT_MAX);
+
+		stream.next_out = (buffer + used); stream.avail_out = (uInt)space;
+
+		int result = inflate(&stream, Z_NO_FLUSH); used += (space - stream.avail_out);
+
+		if (result != Z_OK) break; // Done, truncated or corrupt - keep the partial output
+	}
+
+	inflateEnd(&stream); *decodedLength = used;
+
+	return buffer;
+}
+
+static size_t Unpredict(uint8_t *bytes, size_t length, long predictor, long colors, long bits, long columns)
+{
+	if ((colors < 1) || (colors > 32) || (columns < 1) || (columns > 1048576)) return 0;
+
+	if ((bits != 1) && (bits != 2) && (bits != 4) && (bits != 8) && (bits != 16)) return 0;
+
+	size_t pixel = (size_t)((colors * bits + 7) / 8); size_t row = (size_t)((colors * bits * columns + 7) / 8);
+
+	if (predictor == 2) // TIFF predictor (8-bit components only)
+	{
+		if (bits != 8) return length;
+
+		for (size_t start = 0; (start + row) <= length; start += row)
+		{
+			for (size_t index = pixel; index < row; index++) bytes[start + index] += bytes[start + index - pixel];
+		}
+
+		return length;
+	}
+
+	size_t decoded = 0; // PNG predictors - rows shrink by their filter byte, in place
+
+	for (size_t start = 0; (start + 1 + row) <= length; start += (row + 1))
+	{
+		uint8_t filter = bytes[start]; const uint8_t *in = (bytes + start + 1); uint8_t *out = (bytes + decoded);
+
+		const uint8_t *up = ((decoded >= row) ? (out - row) : NULL); // Previous decoded row
+
+		for (size_t index = 0; index < row; index++)
+		{
+			unsigned a = ((index >= pixel) ? out[index - pixel] : 0); unsigned b = ((up != NULL) ? up[index] : 0);
+
+			unsigned c = (((index >= pixel) && (up != NULL)) ? up[index - pixel] : 0); unsigned value = in[index];
+
+			switch (filter)
+			{
+				case 1: value += a; break;
+				case 2: value += b; break;
+				case 3: value += ((a + b) / 2); break;
+
+				case 4: // Paeth
+				{
+					int p = (int)(a + b - c); int pa = abs(p - (int)a); int pb = abs(p - (int)b); int pc = abs(p - (int)c);
+
+					value += (((pa <= pb) && (pa <= pc)) ? a : ((pb <= pc) ? b : c)); break;
+				}
+
+				default: break;
+			}
+
+			out[index] = (uint8_t)value;
+		}
+
+		decoded += row;
+	}
+
+	return decoded;
+}
+
+static long ParameterValue(PDFReaderCoreStructureRef structure, Object *parameters, const char *key, long value)
+{
+	double number = 0.0; // Default unless a sane number
+
+	if ((GetNumber(Get(structure, parameters, key), &number) != 0) && (number >= 0.0) && (number <= 1048576.0)) value = (long)number;
+
+	return value;
+}
+
+static int DecodeStream(PDFReaderCoreStructureRef structure, Object *stream, const uint8_t **bytes, size_t *length)
+{
+	Object *filter = Get(structure, stream, "Filter"); Object *parameters = Get(structure, stream, "DecodeParms");
+
+	if ((filter != NULL) && (filter->type == ObjectArray)) // Only a single filter is supported
+	{
+		if (filter->u.array.count > 1) return 0;
+
+		filter = ((filter->u.array.count == 1) ? Resolve(structure, filter->u.array.items[0]) : NULL);
+
+		if ((parameters != NULL) && (parameters->type == ObjectArray))
+			parameters = ((parameters->u.array.count > 0) ? Resolve(structure, parameters->u.array.items[0]) : NULL);
+	}
+
+	if (filter == NULL) // Unfiltered
+	{
+		*bytes = stream->u.stream.bytes; *length = stream->u.stream.length; return 1;
+	}
+
+	if ((IsName(filter, "FlateDecode") == 0) && (IsName(filter, "Fl") == 0)) return 0;
+
+	size_t decodedLength = 0; uint8_t *decoded = Inflate(stream->u.stream.bytes, stream->u.stream.length, &decodedLength);
+
+	if (decoded == NULL) return 0;
+
+	if (TrackBuffer(structure, decoded) == 0) { free(decoded); return 0; }
+
+	long predictor = ParameterValue(structure, parameters, "Predictor", 1);
+
+	if ((predictor == 2) || (predictor >= 10)) // Undo the predictor
+	{
+		long colors = ParameterValue(structure, parameters, "Colors", 1); long bits = ParameterValue(structure, parameters, "BitsPerComponent", 8);
+
+		decodedLength = Unpredict(decoded, decodedLength, predictor, colors, bits, ParameterValue(structure, parameters, "Columns", 1));
+	}
+
+	*bytes = decoded; *length = decodedLength;
+
+	return 1;
+}
+
+static Object *ParseStream(PDFReaderCoreStructureRef structure, Lexer *lexer, Object *dictionary)
+{
+	const uint8_t *bytes = lexer->bytes; size_t start = lexer->position; // After the stream keyword
+
+	if ((start < lexer->length) && (bytes[start] == '\r')) start++;
+
+	if ((start < lexer->length) && (bytes[start] == '\n')) start++;
+
+	size_t length = NOT_FOUND; double declared = -1.0; // Trust /Length only when endstream follows it
+
+	if ((GetNumber(Get(structure, dictionary, "Length"), &declared) != 0) && (declared >= 0.0) && (declared <= (double)(lexer->length - start)))
+	{
+		Lexer check = { bytes, lexer->length, (start + (size_t)declared) };
+
+		if (LexKeyword(&check, "endstream") != 0) length = (size_t)declared;
+	}
+
+	if (length == NOT_FOUND) // Find the endstream keyword instead
+	{
+		size_t end = FindBytes(bytes, lexer->length, start, "endstream", 9); if (end == NOT_FOUND) return NULL;
+
+		if ((end > start) && (bytes[end - 1] == '\n')) end--;
+
+		if ((end > start) && (bytes[end - 1] == '\r')) end--;
+
+		length = (end - start);
+	}
+
+	Object *stream = NewObject(structure, ObjectStream); if (stream == NULL) return NULL;
+
+	stream->u.stream.dictionary = dictionary; stream->u.stream.bytes = (bytes + start); stream->u.stream.length = length;
+
+	lexer->position = (start + length);
+
+	return stream;
+}
+
+static Object *ParseIndirectObject(PDFReaderCoreStructureRef structure, uint64_t offset, uint32_t number)
+{
+	if (offset >= structure->length) return NULL; // Beyond the end of the file
+
+	Lexer lexer = { structure->bytes, structure->length, (size_t)offset }; long long objectNumber = 0; long long generation = 0;
+
+	if ((LexInteger(&lexer, &objectNumber) == 0) || (LexInteger(&lexer, &generation) == 0) || (LexKeyword(&lexer, "obj") == 0)) return NULL;
+
+	if ((number != 0) && (objectNumber != number)) return NULL; // Wrong offset
+
+	Object *object = ParseObject(structure, &lexer, 0); // The object itself
+
+	if ((object != NULL) && (object->type == ObjectDictionary) && (LexKeyword(&lexer, "stream") != 0))
+	{
+		object = ParseStream(structure, &lexer, object);
+	}
+
+	return object;
+}
+
+#pragma mark PDFReaderCoreStructure object stream functions
+
+static ObjStm *LoadObjectStream(PDFReaderCoreStructureRef structure, uint32_t number)
+{
+	uint32_t index = 0; // Object stream record
+
+	if (PDFReaderCoreTableGet(&structure->objectStreamIndex, number, &index) != 0)
+	{
+		ObjStm *objectStream = &structure->objectStreams[index];
+
+		return ((objectStream->bytes != NULL) ? objectStream : NULL);
+	}
+
+	if (structure->objectStreamCount == structure->objectStreamCapacity) // Grow the records
+	{
+		size_t capacity = ((structure->objectStreamCapacity > 0) ? (structure->objectStreamCapacity * 2) : 16);
+
+		ObjStm *objectStreams = realloc(structure->objectStreams, (capacity * sizeof(ObjStm))); if (objectStreams == NULL) return NULL;
+
+		structure->objectStreams = objectStreams; structure->objectStreamCapacity = capacity;
+	}
+
+	index = (uint32_t)structure->objectStreamCount; // An unusable record until decoded (stops recursion)
+
+	if (PDFReaderCoreTableSet(&structure->objectStreamIndex, number, index) == 0) return NULL;
+
+	memset(&structure->objectStreams[index], 0x00, sizeof(ObjStm)); structure->objectStreamCount++;
+
+	Object *stream = LoadObject(structure, number); // May load other object streams
+
+	if ((stream == NULL) || (stream->type != ObjectStream)) return NULL;
+
+	double count = 0.0; double first = 0.0; // Object count and first object offset
+
+	if ((GetNumber(Get(structure, stream, "N"), &count) == 0) || (GetNumber(Get(structure, stream, "First"), &first) == 0)) return NULL;
+
+	const uint8_t *bytes = NULL; size_t length = 0; // Decoded data
+
+	if ((count < 0.0) || (first < 0.0) || (DecodeStream(structure, stream, &bytes, &length) == 0) || (first > (double)length)) return NULL;
+
+	size_t capacity = (((size_t)count < (length / 2)) ? (size_t)count : (length / 2)); // Each pair needs bytes
+
+	uint32_t *numbers = ArenaAllocate(structure, (capacity * sizeof(uint32_t)));
+
+	size_t *offsets = ArenaAllocate(structure, (capacity * sizeof(size_t)));
+
+	if ((numbers == NULL) || (offsets == NULL)) return NULL;
+
+	Lexer lexer = { bytes, (size_t)first, 0 }; size_t parsed = 0; // Header pairs
+
+	while (parsed < capacity)
+	{
+		long long objectNumber = 0; long long offset = 0;
+
+		if ((LexInteger(&lexer, &objectNumber) == 0) || (LexInteger(&lexer, &offset) == 0)) break;
+
+		if ((objectNumber < 0) || (objectNumber > UINT32_MAX) || (offset < 0)) break;
+
+		numbers[parsed] = (uint32_t)objectNumber; offsets[parsed] = (size_t)offset; parsed++;
+	}
+
+	ObjStm *objectStream = &structure->objectStreams[index]; // Records may have moved
+
+	objectStream->bytes = bytes; objectStream->length = length; objectStream->first = (size_t)first;
+
+	objectStream->count = (uint32_t)parsed; objectStream->numbers = numbers; objectStream->offsets = offsets;
+
+	return objectStream;
+}
+
+static Object *LoadCompressedObject(PDFReaderCoreStructureRef structure, uint32_t streamNumber, uint32_t index, uint32_t number)
+{
+	ObjStm *objectStream = LoadObjectStream(structure, streamNumber); if (objectStream == NULL) return NULL;
+
+	if ((index >= objectStream->count) || (objectStream->numbers[index] != number)) // Wrong index - find the object
+	{
+		for (index = 0; index < objectStream->count; index++) if (objectStream->numbers[index] == number) break;
+
+		if (index >= objectStream->count) return NULL;
+	}
+
+	size_t offset = objectStream->offsets[index]; if (offset >= (objectStream->length - objectStream->first)) return NULL;
+
+	Lexer lexer = { objectStream->bytes, objectStream->length, (objectStream->first + offset) };
+
+	return ParseObject(structure, &lexer, 0);
+}
+
+static Object *LoadObject(PDFReaderCoreStructureRef structure, uint32_t number)
+{
+	if ((number == 0) || (number >= structure->entryCount)) return NULL;
+
+	XrefEntry *entry = &structure->entries[number];
+
+	if (entry->state == 2) return entry->object; // Loaded
+
+	if ((entry->state == 1) || (structure->loadDepth >= LOAD_DEPTH)) return NULL; // Loading (a loop) or too deep
+
+	if ((entry->defined == 0) || (entry->type == 0)) { entry->state = 2; return NULL; }
+
+	entry->state = 1; structure->loadDepth++; Object *object = NULL;
+
+	if (entry->type == 1) // In the file
+		object = ParseIndirectObject(structure, entry->offset, number);
+	else if (entry->offset <= UINT32_MAX) // In an object stream
+		object = LoadCompressedObject(structure, (uint32_t)entry->offset, entry->index, number);
+
+	structure->loadDepth--; entry = &structure->entries[number]; // Entries do not move after opening
+
+	entry->object = object; entry->state = 2;
+
+	return object;
+}
+
+#pragma mark PDFReaderCoreStructure cross-reference functions
+
+static int EnsureEntries(PDFReaderCoreStructureRef structure, size_t count)
+{
+	if (count <= structure->entryCount) return 1; // Big enough
+
+	if (count > MAXIMUM_OBJECTS) return 0; // Bogus object number
+
+	size_t capacity = ((structure->entryCount > 0) ? structure->entryCount : 1024);
+
+	while (capacity < count) capacity *= 2;
+
+	if (capacity > MAXIMUM_OBJECTS) capacity = MAXIMUM_OBJECTS;
+
+	XrefEntry *entries = realloc(structure->entries, (capacity * sizeof(XrefEntry))); if (entries == NULL) return 0;
+
+	memset((entries + structure->entryCount), 0x00, ((capacity - structure->entryCount) * sizeof(XrefEntry)));
+
+	structure->entries = entries; structure->entryCount = capacity;
+
+	return 1;
+}
+
+static void DefineEntry(PDFReaderCoreStructureRef structure, long long number, uint8_t type, uint64_t offset, uint32_t index)
+{
+	if ((number <= 0) || (EnsureEntries(structure, (size_t)number + 1) == 0)) return;
+
+	XrefEntry *entry = &structure->entries[number]; if (entry->defined != 0) return; // A newer section has it
+
+	entry->defined = 1; entry->type = type; entry->offset = offset; entry->index = index;
+}
+
+static void NoteTrailer(PDFReaderCoreStructureRef structure, Object *trailer)
+{
+	if (DictionaryGet(trailer, "Encrypt") != NULL) structure->encrypted = 1;
+
+	if (structure->trailer == NULL) structure->trailer = trailer; // The newest
+
+	if (structure->root == NULL) structure->root = DictionaryGet(trailer, "Root");
+}
+
+static Object *LoadXrefStream(PDFReaderCoreStructureRef structure, uint64_t offset)
+{
+	Object *stream = ParseIndirectObject(structure, offset, 0); // Not an entry of its own table
+
+	if ((stream == NULL) || (stream->type != ObjectStream) || (IsName(Get(structure, stream, "Type"), "XRef") == 0)) return NULL;
+
+	Object *widths = GetTyped(structure, stream, "W", ObjectArray); int width[3] = { 0, 0, 0 }; size_t size = 0;
+
+	if ((widths == NULL) || (widths->u.array.count < 3)) return NULL;
+
+	for (size_t index = 0; index < 3; index++) // Field widths
+	{
+		double value = 0.0; if ((GetNumber(Resolve(structure, widths->u.array.items[index]), &value) == 0) || (value < 0.0) || (value > 8.0)) return NULL;
+
+		width[index] = (int)value; size += (size_t)width[index];
+	}
+
+	const uint8_t *bytes = NULL; size_t length = 0; if ((size == 0) || (DecodeStream(structure, stream, &bytes, &length) == 0)) return NULL;
+
+	Object *subsections = GetTyped(structure, stream, "Index", ObjectArray); double count = 0.0;
+
+	GetNumber(Get(structure, stream, "Size"), &count); size_t position = 0; // Default /Index is [0 /Size]
+
+	if ((count > 0.0) && (count < MAXIMUM_OBJECTS) && (count <= (double)(length / size))) EnsureEntries(structure, (size_t)count);
+
+	size_t pairs = ((subsections != NULL) ? (subsections->u.array.count / 2) : 1);
+
+	for (size_t pair = 0; pair < pairs; pair++)
+	{
+		double first = 0.0; double entries = count; // Subsection
+
+		if (subsections != NULL)
+		{
+			if ((GetNumber(Resolve(structure, subsections->u.array.items[pair * 2]), &first) == 0) ||
+				(GetNumber(Resolve(structure, subsections->u.array.items[(pair * 2) + 1]), &entries) == 0)) break;
+		}
+
+		if ((first < 0.0) || (entries < 0.0) || (first > MAXIMUM_OBJECTS)) break;
+
+		for (long long index = 0; (index < (long long)entries) && ((position + size) <= length); index++)
+		{
+			uint64_t fields[3] = { 0, 0, 0 }; // Big endian fields
+
+			for (int field = 0; field < 3; field++)
+			{
+				for (int byte = 0; byte < width[field]; byte++) fields[field] = ((fields[field] << 8) | bytes[position++]);
+			}
+
+			uint64_t type = ((width[0] > 0) ? fields[0] : 1); long long number = ((long long)first + index);
+
+			if (type == 1) // In the file
+				DefineEntry(structure, number, 1, fields[1], 0);
+			else if ((type == 2) && (fields[2] <= UINT32_MAX)) // In an object stream
+				DefineEntry(structure, number, 2, fields[1], (uint32_t)fields[2]);
+			else // Free (or an unknown type, which is a null reference)
+				DefineEntry(structure, number, 0, 0, 0);
+		}
+	}
+
+	return stream->u.stream.dictionary;
+}
+
+static Object *LoadXrefTable(PDFReaderCoreStructureRef structure, Lexer *lexer)
+{
+	long long first = 0; long long count = 0; // After the xref keyword
+
+	while ((LexInteger(lexer, &first) != 0) && (LexInteger(lexer, &count) != 0)) // Subsections
+	{
+		if ((first < 0) || (count < 0)) return NULL;
+
+		if ((count <= (long long)(lexer->length / 4)) && ((first + count) < MAXIMUM_OBJECTS)) EnsureEntries(structure, (size_t)(first + count));
+
+		for (long long index = 0; index < count; index++)
+		{
+			long long offset = 0; long long generation = 0; uint8_t kind = 0; // One entry
+
+			SkipWhitespace(lexer); const uint8_t *entry = (lexer->bytes + lexer->position);
+
+			if (((lexer->length - lexer->position) >= 18) && (entry[10] == ' ') && (entry[16] == ' ')) // Usual "oooooooooo ggggg n" entry
+			{
+				int digits = 0; // Fixed width fields
+
+				for (int digit = 0; digit < 10; digit++) if (IsDigit(entry[digit]) != 0) { offset = ((offset * 10) + (entry[digit] - '0')); digits++; }
+
+				for (int digit = 11; digit < 16; digit++) if (IsDigit(entry[digit]) != 0) { generation = ((generation * 10) + (entry[digit] - '0')); digits++; }
+
+				if (digits == 15) { kind = entry[17]; lexer->position += 18; }
+			}
+
+			if (kind == 0) // Anything else
+			{
+				offset = 0; generation = 0;
+
+				if ((LexInteger(lexer, &offset) == 0) || (LexInteger(lexer, &generation) == 0)) return NULL;
+
+				SkipWhitespace(lexer); if (lexer->position >= lexer->length) return NULL;
+
+				kind = lexer->bytes[lexer->position++];
+			}
+
+			if ((kind != 'n') && (kind != 'f')) return NULL;
+
+			if ((index == 0) && (first == 1) && (kind == 'f') && (generation == 65535)) first = 0; // Off by one writer
+
+			if ((kind == 'n') && (offset > 0)) DefineEntry(structure, (first + index), 1, (uint64_t)offset, 0);
+		}
+	}
+
+	if (LexKeyword(lexer, "trailer") == 0) return NULL;
+
+	Object *trailer = ParseObject(structure, lexer, 0);
+
+	return (((trailer != NULL) && (trailer->type == ObjectDictionary)) ? trailer : NULL);
+}
+
+static int LoadXref(PDFReaderCoreStructureRef structure, uint64_t offset)
+{
+	uint64_t visited[XREF_SECTIONS]; size_t sections = 0; // Guards against /Prev loops
+
+	while ((offset < structure->length) && (sections < XREF_SECTIONS))
+	{
+		for (size_t index = 0; index < sections; index++) if (visited[index] == offset) return (sections > 0);
+
+		visited[sections++] = offset; Object *trailer = NULL; // This section's trailer
+
+		Lexer lexer = { structure->bytes, structure->length, (size_t)offset };
+
+		if (LexKeyword(&lexer, "xref") != 0) // Classic table (maybe with a hybrid /XRefStm)
+		{
+			if ((trailer = LoadXrefTable(structure, &lexer)) == NULL) return (sections > 1);
+
+			double stream = 0.0; // Hybrid file cross-reference stream
+
+			if ((GetNumber(DictionaryGet(trailer, "XRefStm"), &stream) != 0) && (stream >= 0.0)) LoadXrefStream(structure, (uint64_t)stream);
+		}
+		else if ((trailer = LoadXrefStream(structure, offset)) == NULL) // Cross-reference stream
+		{
+			return (sections > 1);
+		}
+
+		NoteTrailer(structure, trailer); double previous = -1.0; // Older section
+
+		if ((GetNumber(DictionaryGet(trailer, "Prev"), &previous) == 0) || (previous < 0.0)) break;
+
+		offset = (uint64_t)previous;
+	}
+
+	return 1;
+}
+
+static void ResetStructure(PDFReaderCoreStructureRef structure)
+{
+	if (structure->entries != NULL) memset(structure->entries, 0x00, (structure->entryCount * sizeof(XrefEntry)));
+
+	PDFReaderCoreTableClear(&structure->objectStreamIndex); structure->objectStreamCount = 0;
+
+	structure->trailer = NULL; structure->root = NULL; structure->catalog = NULL; structure->pages = NULL;
+
+	structure->pagesNumber = 0; structure->encrypted = 0;
+}
+
+static void Reconstruct(PDFReaderCoreStructureRef structure)
+{
+	ResetStructure(structure); const uint8_t *bytes = structure->bytes; size_t length = structure->length;
+
+	for (size_t position = 0; (position = FindBytes(bytes, length, position, "obj", 3)) != NOT_FOUND; position += 3)
+	{
+		if (((position + 3) < length) && (IsRegular(bytes[position + 3]) != 0)) continue; // Not the keyword
+
+		size_t index = position; // Walk back over "N G "
+
+		while ((index > 0) && (IsWhitespace(bytes[index - 1]) != 0)) index--;
+
+		size_t end = index; while ((index > 0) && (IsDigit(bytes[index - 1]) != 0)) index--;
+
+		if ((index == end) || (index == 0) || (IsWhitespace(bytes[index - 1]) == 0)) continue; // No generation
+
+		while ((index > 0) && (IsWhitespace(bytes[index - 1]) != 0)) index--;
+
+		end = index; while ((index > 0) && (IsDigit(bytes[index - 1]) != 0)) index--;
+
+		if ((index == end) || ((index > 0) && (IsRegular(bytes[index - 1]) != 0))) continue; // No object number
+
+		long long number = 0; for (size_t digit = index; (digit < end) && (number <= MAXIMUM_OBJECTS); digit++) number = ((number * 10) + (bytes[digit] - '0'));
+
+		if ((number <= 0) || (number >= MAXIMUM_OBJECTS) || (EnsureEntries(structure, (size_t)number + 1) == 0)) continue;
+
+		XrefEntry *entry = &structure->entries[number]; // Later definitions win
+
+		entry->defined = 1; entry->type = 1; entry->offset = index; entry->index = 0;
+	}
+
+	for (size_t position = 0; (position = FindBytes(bytes, length, position, "trailer", 7)) != NOT_FOUND; position += 7)
+	{
+		Lexer lexer = { bytes, length, (position + 7) }; Object *trailer = ParseObject(structure, &lexer, 0);
+
+		if ((trailer != NULL) && (trailer->type == ObjectDictionary) && (DictionaryGet(trailer, "Root") != NULL))
+		{
+			if (DictionaryGet(trailer, "Encrypt") != NULL) structure->encrypted = 1;
+
+			structure->trailer = trailer; structure->root = DictionaryGet(trailer, "Root"); // The last one
+		}
+	}
+
+	size_t count = structure->entryCount; // Register object stream members and look for a catalog
+
+	for (size_t number = 1; number < count; number++)
+	{
+		if ((structure->entries[number].defined == 0) || (structure->entries[number].type != 1)) continue;
+
+		Object *object = LoadObject(structure, (uint32_t)number); if (object == NULL) continue;
+
+		if ((object->type == ObjectStream) && (IsName(Get(structure, object, "Type"), "XRef") != 0) && (structure->trailer == NULL))
+		{
+			NoteTrailer(structure, object->u.stream.dictionary); // A cross-reference stream is a trailer too
+		}
+
+		if ((object->type == ObjectStream) && (IsName(Get(structure, object, "Type"), "ObjStm") != 0))
+		{
+			ObjStm *objectStream = LoadObjectStream(structure, (uint32_t)number); if (objectStream == NULL) continue;
+
+			for (uint32_t index = 0; index < objectStream->count; index++)
+			{
+				uint32_t member = objectStream->numbers[index]; // Objects in the file win
+
+				if ((member > 0) && (member < count) && (structure->entries[member].defined == 0))
+				{
+					XrefEntry *entry = &structure->entries[member];
+
+					entry->defined = 1; entry->type = 2; entry->offset = number; entry->index = index;
+				}
+			}
+		}
+	}
+
+	Object *root = Resolve(structure, structure->root); // Find a catalog when there is no usable trailer
+
+	if ((root != NULL) && (root->type == ObjectDictionary) && (GetTyped(structure, root, "Pages", ObjectDictionary) != NULL)) return;
+
+	for (size_t number = 1; number < count; number++)
+	{
+		Object *object = LoadObject(structure, (uint32_t)number);
+
+		if ((object != NULL) && (object->type == ObjectDictionary) && (IsName(Get(structure, object, "Type"), "Catalog") != 0) &&
+			(GetTyped(structure, object, "Pages", ObjectDictionary) != NULL))
+		{
+			Object *reference = NewObject(structure, ObjectReference); if (reference == NULL) return;
+
+			reference->u.reference.number = (uint32_t)number; structure->root = reference; return;
+		}
+	}
+}
+
+static int LoadCatalog(PDFReaderCoreStructureRef structure)
+{
+	Object *catalog = Resolve(structure, structure->root);
+
+	if ((catalog == NULL) || (catalog->type != ObjectDictionary)) return 0;
+
+	Object *pages = GetTyped(structure, catalog, "Pages", ObjectDictionary); if (pages == NULL) return 0;
+
+	structure->catalog = catalog; structure->pages = pages;
+
+	structure->pagesNumber = ReferenceNumber(DictionaryGet(catalog, "Pages"));
+
+	return 1;
+}
+
+static PDFReaderCoreStructureStatus OpenStructure(PDFReaderCoreStructureRef structure)
+{
+	size_t window = ((structure->length < HEADER_WINDOW) ? structure->length : HEADER_WINDOW);
+
+	if (FindBytes(structure->bytes, window, 0, "%PDF-", 5) == NOT_FOUND) return PDFReaderCoreStructureMalformed;
+
+	size_t start = ((structure->length > STARTXREF_WINDOW) ? (structure->length - STARTXREF_WINDOW) : 0);
+
+	size_t startxref = NOT_FOUND; // The last startxref keyword
+
+	for (size_t position = start; (position = FindBytes(structure->bytes, structure->length, position, "startxref", 9)) != NOT_FOUND; position += 9)
+	{
+		startxref = position;
+	}
+
+	int loaded = 0; // Cross-reference sections found
+
+	if (startxref != NOT_FOUND)
+	{
+		Lexer lexer = { structure->bytes, structure->length, (startxref + 9) }; long long offset = 0;
+
+		if ((LexInteger(&lexer, &offset) != 0) && (offset >= 0)) loaded = LoadXref(structure, (uint64_t)offset);
+	}
+
+	if ((loaded == 0) || ((structure->encrypted == 0) && (LoadCatalog(structure) == 0))) // Rebuild from the objects
+	{
+		Reconstruct(structure); if (structure->encrypted == 0) LoadCatalog(structure);
+	}
+
+	if (structure->encrypted != 0) return PDFReaderCoreStructureEncrypted;
+
+	return ((structure->pages != NULL) ? PDFReaderCoreStructureOK : PDFReaderCoreStructureMalformed);
+}
+
+#pragma mark PDFReaderCoreStructure page tree functions
+
+static int GetRect(PDFReaderCoreStructureRef structure, Object *array, PDFReaderCoreRect *rect)
+{
+	if ((array == NULL) || (array->type != ObjectArray) || (array->u.array.count < 4)) return 0;
+
+	double values[4]; // x1 y1 x2 y2
+
+	for (size_t index = 0; index < 4; index++)
+	{
+		if (GetNumber(Resolve(structure, array->u.array.items[index]), &values[index]) == 0) return 0;
+	}
+
+	double x = ((values[0] < values[2]) ? values[0] : values[2]); double y = ((values[1] < values[3]) ? values[1] : values[3]);
+
+	*rect = PDFReaderCoreRectMake(x, y, fabs(values[2] - values[0]), fabs(values[3] - values[1]));
+
+	return 1;
+}
+
+static void InheritAttributes(PDFReaderCoreStructureRef structure, Object *node, PageAttributes *attributes)
+{
+	if (GetRect(structure, Get(structure, node, "MediaBox"), &attributes->mediaBox) != 0) attributes->hasMediaBox = 1;
+
+	if (GetRect(structure, Get(structure, node, "CropBox"), &attributes->cropBox) != 0) attributes->hasCropBox = 1;
+
+	double rotate = 0.0; if (GetNumber(Get(structure, node, "Rotate"), &rotate) != 0) attributes->rotate = (long)fmod(rotate, 360.0);
+}
+
+static void FillPage(const PageAttributes *attributes, long page, uint32_t object, PDFReaderCoreStructurePage *info)
+{
+	info->page = page; info->object = object; // Defaults are US Letter and no crop
+
+	info->mediaBox = (attributes->hasMediaBox ? attributes->mediaBox : PDFReaderCoreRectMake(0.0, 0.0, 612.0, 792.0));
+
+	info->cropBox = (attributes->hasCropBox ? attributes->cropBox : info->mediaBox);
+
+	long rotate = (attributes->rotate % 360); if (rotate < 0) rotate += 360;
+
+	info->rotate = (rotate - (rotate % 90)); // Multiple of 90
+}
+
+static int IsPageTreeNode(PDFReaderCoreStructureRef structure, Object *node)
+{
+	Object *type = Get(structure, node, "Type"); // Type, else the presence of /Kids
+
+	if (IsName(type, "Pages") != 0) return 1;
+
+	if (IsName(type, "Page") != 0) return 0;
+
+	return (GetTyped(structure, node, "Kids", ObjectArray) != NULL);
+}
+
+typedef struct
+{
+	PDFReaderCoreStructurePageFunction function; void *context; // Caller function
+	PDFReaderCoreTable visited; int stop; // Every node once
+	long page; // Pages visited
+} PageVisit;
+
+static void VisitPageNode(PDFReaderCoreStructureRef structure, Object *node, PageAttributes attributes, PageVisit *visit, int depth)
+{
+	if (depth >= TREE_DEPTH) return; // Malformed (or cyclic) page tree
+
+	InheritAttributes(structure, node, &attributes); Object *kids = GetTyped(structure, node, "Kids", ObjectArray);
+
+	for (size_t index = 0; (kids != NULL) && (index < kids->u.array.count) && (visit->stop == 0); index++)
+	{
+		Object *kid = kids->u.array.items[index]; uint32_t number = ReferenceNumber(kid); uint32_t seen = 0;
+
+		if (number != 0) // Each object once
+		{
+			if (PDFReaderCoreTableGet(&visit->visited, number, &seen) != 0) continue;
+
+			PDFReaderCoreTableSet(&visit->visited, number, 1);
+		}
+
+		Object *child = Resolve(structure, kid); if ((child == NULL) || (child->type != ObjectDictionary)) continue;
+
+		if (IsPageTreeNode(structure, child) != 0) // Intermediate node
+		{
+			VisitPageNode(structure, child, attributes, visit, (depth + 1));
+		}
+		else // Page
+		{
+			PageAttributes pageAttributes = attributes; InheritAttributes(structure, child, &pageAttributes);
+
+			PDFReaderCoreStructurePage info; FillPage(&pageAttributes, ++visit->page, number, &info);
+
+			if ((visit->function != NULL) && (visit->function(&info, visit->context) == 0)) visit->stop = 1;
+		}
+	}
+}
+
+static long VisitPages(PDFReaderCoreStructureRef structure, Object *node, PDFReaderCoreStructurePageFunction function, void *context)
+{
+	PageVisit visit; memset(&visit, 0x00, sizeof(visit)); visit.function = function; visit.context = context;
+
+	if (PDFReaderCoreTableInit(&visit.visited, 64) == 0) return 0;
+
+	uint32_t number = ((node == structure->pages) ? structure->pagesNumber : 0); // The root is a node too
+
+	if (number != 0) PDFReaderCoreTableSet(&visit.visited, number, 1);
+
+	PageAttributes attributes; memset(&attributes, 0x00, sizeof(attributes));
+
+	VisitPageNode(structure, node, attributes, &visit, 0);
+
+	PDFReaderCoreTableFree(&visit.visited);
+
+	return visit.page;
+}
+
+static long NodeCount(PDFReaderCoreStructureRef structure, Object *node)
+{
+	double count = -1.0; // Trust /Count unless there cannot be that many page objects
+
+	if ((GetNumber(Get(structure, node, "Count"), &count) != 0) && (count >= 0.0) && (count < (double)structure->entryCount)) return (long)count;
+
+	return VisitPages(structure, node, NULL, NULL);
+}
+
+#pragma mark PDFReaderCoreStructure destination functions
+
+static void WalkNameTree(PDFReaderCoreStructureRef structure, Object *node, PDFReaderCoreTable *visited, int depth)
+{
+	if ((node == NULL) || (node->type != ObjectDictionary) || (depth >= TREE_DEPTH)) return;
+
+	Object *names = GetTyped(structure, node, "Names", ObjectArray); // Leaf [key value ...] pairs
+
+	for (size_t index = 0; (names != NULL) && ((index + 1) < names->u.array.count); index += 2)
+	{
+		Object *key = Resolve(structure, names->u.array.items[index]); Object *value = names->u.array.items[index + 1];
+
+		if ((key != NULL) && (key->type == ObjectString)) PDFReaderCoreNameTableAdd(structure->stringDestinations, key->u.string.bytes, key->u.string.length, value);
+	}
+
+	Object *kids = GetTyped(structure, node, "Kids", ObjectArray); // Intermediate nodes
+
+	for (size_t index = 0; (kids != NULL) && (index < kids->u.array.count); index++)
+	{
+		uint32_t number = ReferenceNumber(kids->u.array.items[index]); uint32_t seen = 0;
+
+		if (number != 0) // Each node once
+		{
+			if (PDFReaderCoreTableGet(visited, number, &seen) != 0) continue;
+
+			PDFReaderCoreTableSet(visited, number, 1);
+		}
+
+		WalkNameTree(structure, Resolve(structure, kids->u.array.items[index]), visited, (depth + 1));
+	}
+}
+
+static void BuildDestinations(PDFReaderCoreStructureRef structure)
+{
+	if (structure->destinationsBuilt != 0) return; // Built
+
+	structure->destinationsBuilt = 1;
+
+	structure->stringDestinations = PDFReaderCoreNameTableCreate(64); structure->nameDestinations = PDFReaderCoreNameTableCreate(16);
+
+	if ((structure->stringDestinations == NULL) || (structure->nameDestinations == NULL)) return;
+
+	PDFReaderCoreTable visited; // Name tree nodes
+
+	if (PDFReaderCoreTableInit(&visited, 64) != 0)
+	{
+		WalkNameTree(structure, Get(structure, GetTyped(structure, structure->catalog, "Names", ObjectDictionary), "Dests"), &visited, 0);
+
+		PDFReaderCoreTableFree(&visited);
+	}
+
+	Object *dests = GetTyped(structure, structure->catalog, "Dests", ObjectDictionary); // PDF 1.1 catalog /Dests
+
+	for (size_t index = 0; (dests != NULL) && (index < dests->u.dictionary.count); index++)
+	{
+		DictionaryEntry *entry = &dests->u.dictionary.entries[index];
+
+		PDFReaderCoreNameTableAdd(structure->nameDestinations, entry->key, entry->length, entry->value);
+	}
+
+	PDFReaderCoreNameTableFinish(structure->stringDestinations); PDFReaderCoreNameTableFinish(structure->nameDestinations);
+}
+
+static long DestinationTarget(PDFReaderCoreStructureRef structure, Object *destination, int depth)
+{
+	destination = Resolve(structure, destination); if ((destination == NULL) || (depth > 2)) return 0;
+
+	if ((destination->type == ObjectString) || (destination->type == ObjectName)) // Named destination
+	{
+		const void *bytes = destination->u.string.bytes; size_t length = destination->u.string.length;
+
+		return PDFReaderCoreStructureDestinationPage(structure, bytes, length, (destination->type == ObjectString));
+	}
+
+	if (destination->type == ObjectDictionary) destination = Get(structure, destination, "D"); // Name tree value
+
+	if ((destination == NULL) || (destination->type != ObjectArray) || (destination->u.array.count == 0)) return 0;
+
+	Object *target = destination->u.array.items[0]; // Page reference (or a 0-based page number)
+
+	if (target->type == ObjectReference) return PDFReaderCoreStructurePageNumberForObject(structure, target->u.reference.number);
+
+	if ((target->type == ObjectInteger) && (target->u.integer >= 0) && (target->u.integer < LONG_MAX)) return (long)(target->u.integer + 1);
+
+	return 0;
+}
+
+#pragma mark PDFReaderCoreStructure outline functions
+
+typedef struct
+{
+	PDFReaderCoreStructureOutlineFunction function; void *context; // Caller function
+	PDFReaderCoreTable visited; int stop; // Every item once
+	long count; // Items visited
+} OutlineVisit;
+
+static void OutlineItemTarget(PDFReaderCoreStructureRef structure, Object *item, PDFReaderCoreOutlineItem *info)
+{
+	Object *destination = NULL; Object *action = GetTyped(structure, item, "A", ObjectDictionary);
+
+	if (action != NULL) // Action (/Dest is ignored when there is one)
+	{
+		Object *type = Get(structure, action, "S");
+
+		if (IsName(type, "GoTo") != 0) // Go to a destination
+		{
+			destination = DictionaryGet(action, "D");
+		}
+		else if (IsName(type, "URI") != 0) // Open a URI
+		{
+			Object *uri = GetTyped(structure, action, "URI", ObjectString);
+
+			if (uri != NULL) { info->target = PDFReaderCoreOutlineTargetURI; info->uri = uri->u.string.bytes; info->uriLength = uri->u.string.length; }
+		}
+	}
+	else // Plain destination
+	{
+		destination = DictionaryGet(item, "Dest");
+	}
+
+	long page = ((destination != NULL) ? DestinationTarget(structure, destination, 0) : 0);
+
+	if (page > 0) { info->target = PDFReaderCoreOutlineTargetPage; info->page = page; }
+}
+
+static void VisitOutlineItems(PDFReaderCoreStructureRef structure, Object *item, long level, OutlineVisit *visit)
+{
+	if (level >= TREE_DEPTH) return; // Malformed (or cyclic) outline
+
+	while ((item != NULL) && (visit->stop == 0)) // This level, then each item's children (pre-order)
+	{
+		uint32_t number = ReferenceNumber(item); uint32_t seen = 0;
+
+		if (number != 0) // Each item once
+		{
+			if (PDFReaderCoreTableGet(&visit->visited, number, &seen) != 0) break;
+
+			PDFReaderCoreTableSet(&visit->visited, number, 1);
+		}
+
+		Object *dictionary = Resolve(structure, item); if ((dictionary == NULL) || (dictionary->type != ObjectDictionary)) break;
+
+		Object *title = GetTyped(structure, dictionary, "Title", ObjectString);
+
+		if (title != NULL) // Untitled items are skipped along with their children
+		{
+			PDFReaderCoreOutlineItem info; memset(&info, 0x00, sizeof(info));
+
+			info.level = level; info.title = title->u.string.bytes; info.titleLength = title->u.string.length;
+
+			OutlineItemTarget(structure, dictionary, &info); visit->count++;
+
+			if ((visit->function != NULL) && (visit->function(&info, visit->context) == 0)) { visit->stop = 1; break; }
+
+			VisitOutlineItems(structure, DictionaryGet(dictionary, "First"), (level + 1), visit);
+		}
+
+		item = DictionaryGet(dictionary, "Next");
+	}
+}
+
+#pragma mark PDFReaderCoreStructure functions
+
+static PDFReaderCoreStructureRef CreateStructure(const void *bytes, size_t length, void *mapping, PDFReaderCoreStructureStatus *status)
+{
+	PDFReaderCoreStructureStatus result = PDFReaderCoreStructureNoMemory; // Status
+
+	PDFReaderCoreStructureRef structure = calloc(1, sizeof(struct PDFReaderCoreStructure));
+
+	if ((structure != NULL) && (PDFReaderCoreTableInit(&structure->objectStreamIndex, 16) != 0))
+	{
+		structure->bytes = bytes; structure->length = length; structure->mapping = mapping; structure->pageCount = -1;
+
+		if ((result = OpenStructure(structure)) != PDFReaderCoreStructureOK) { PDFReaderCoreStructureDestroy(structure); structure = NULL; }
+	}
+	else // Out of memory
+	{
+		if (mapping != NULL) munmap(mapping, length);
+
+		free(structure); structure = NULL;
+	}
+
+	if (status != NULL) *status = result;
+
+	return structure;
+}
+
+PDFReaderCoreStructureRef PDFReaderCoreStructureCreateWithPath(const char *path, PDFReaderCoreStructureStatus *status)
+{
+	int file = open(path, O_RDONLY); struct stat info; void *mapping = MAP_FAILED;
+
+	if (file >= 0) // Map the whole file
+	{
+		if ((fstat(file, &info) == 0) && S_ISREG(info.st_mode) && (info.st_size > 0) && ((uint64_t)info.st_size <= SIZE_MAX))
+		{
+			mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		}
+
+		close(file);
+	}
+
+	if (mapping == MAP_FAILED) // Unable to open or map the file
+	{
+		if (status != NULL) *status = PDFReaderCoreStructureUnreadable;
+
+		return NULL;
+	}
+
+	return CreateStructure(mapping, (size_t)info.st_size, mapping, status);
+}
+
+PDFReaderCoreStructureRef PDFReaderCoreStructureCreateWithBytes(const void *bytes, size_t length, PDFReaderCoreStructureStatus *status)
+{
+	if ((bytes == NULL) || (length == 0)) // Nothing to read
+	{
+		if (status != NULL) *status = PDFReaderCoreStructureMalformed;
+
+		return NULL;
+	}
+
+	return CreateStructure(bytes, length, NULL, status);
+}
+
+void PDFReaderCoreStructureDestroy(PDFReaderCoreStructureRef structure)
+{
+	if (structure == NULL) return; // Nothing to destroy
+
+	while (structure->arena != NULL) { ArenaChunk *next = structure->arena->next; free(structure->arena); structure->arena = next; }
+
+	for (size_t index = 0; index < structure->bufferCount; index++) free(structure->buffers[index]);
+
+	PDFReaderCoreNameTableDestroy(structure->stringDestinations); PDFReaderCoreNameTableDestroy(structure->nameDestinations);
+
+	PDFReaderCoreTableFree(&structure->objectStreamIndex); PDFReaderCoreTableFree(&structure->pageMap);
+
+	free(structure->buffers); free(structure->entries); free(structure->objectStreams);
+
+	if (structure->mapping != NULL) munmap(structure->mapping, structure->length);
+
+	free(structure);
+}
+
+long PDFReaderCoreStructurePageCount(PDFReaderCoreStructureRef structure)
+{
+	if (structure->pageCount < 0) structure->pageCount = NodeCount(structure, structure->pages);
+
+	return structure->pageCount;
+}
+
+int PDFReaderCoreStructureGetPage(PDFReaderCoreStructureRef structure, long page, PDFReaderCoreStructurePage *info)
+{
+	if (page < 1) return 0; // Pages are 1-based
+
+	PageAttributes attributes; memset(&attributes, 0x00, sizeof(attributes)); // Along the path
+
+	Object *node = structure->pages; long remaining = page; // Descend by subtree page counts
+
+	for (int depth = 0; depth < TREE_DEPTH; depth++)
+	{
+		InheritAttributes(structure, node, &attributes); Object *kids = GetTyped(structure, node, "Kids", ObjectArray); Object *next = NULL;
+
+		for (size_t index = 0; (kids != NULL) && (index < kids->u.array.count); index++)
+		{
+			Object *kid = kids->u.array.items[index]; Object *child = Resolve(structure, kid);
+
+			if ((child == NULL) || (child->type != ObjectDictionary)) continue;
+
+			if (IsPageTreeNode(structure, child) != 0) // Intermediate node
+			{
+				long count = NodeCount(structure, child);
+
+				if (remaining <= count) { next = child; break; }
+
+				remaining -= count;
+			}
+			else if (remaining == 1) // The page
+			{
+				InheritAttributes(structure, child, &attributes); FillPage(&attributes, page, ReferenceNumber(kid), info);
+
+				return 1;
+			}
+			else // Some other page
+			{
+				remaining--;
+			}
+		}
+
+		if (next == NULL) return 0; // Fewer pages than counted
+
+		node = next;
+	}
+
+	return 0;
+}
+
+long PDFReaderCoreStructureVisitPages(PDFReaderCoreStructureRef structure, PDFReaderCoreStructurePageFunction function, void *context)
+{
+	return VisitPages(structure, structure->pages, function, context);
+}
+
+static int PageMapAdd(const PDFReaderCoreStructurePage *page, void *context)
+{
+	PDFReaderCoreTable *pageMap = (PDFReaderCoreTable *)context; uint32_t existing = 0; // First page wins
+
+	if ((page->object != 0) && (PDFReaderCoreTableGet(pageMap, page->object, &existing) == 0)) PDFReaderCoreTableSet(pageMap, page->object, (uint32_t)page->page);
+
+	return 1;
+}
+
+long PDFReaderCoreStructurePageNumberForObject(PDFReaderCoreStructureRef structure, uint32_t object)
+{
+	if (structure->pageMapBuilt == 0) // Map every page once
+	{
+		long count = PDFReaderCoreStructurePageCount(structure); structure->pageMapBuilt = 1;
+
+		if (PDFReaderCoreTableInit(&structure->pageMap, (uint32_t)((count < 65536) ? (count + 16) : 65536)) != 0)
+		{
+			VisitPages(structure, structure->pages, PageMapAdd, &structure->pageMap);
+		}
+	}
+
+	uint32_t page = 0; // Page number
+
+	if ((object == 0) || (structure->pageMap.keys == NULL) || (PDFReaderCoreTableGet(&structure->pageMap, object, &page) == 0)) return 0;
+
+	return (long)page;
+}
+
+long PDFReaderCoreStructureDestinationPage(PDFReaderCoreStructureRef structure, const void *name, size_t length, int isString)
+{
+	BuildDestinations(structure); // Once
+
+	PDFReaderCoreNameTableRef table = (isString ? structure->stringDestinations : structure->nameDestinations);
+
+	const void *value = PDFReaderCoreNameTableLookup(table, name, length); if (value == NULL) return 0;
+
+	Object *destination = (Object *)value; destination = Resolve(structure, destination);
+
+	if ((destination == NULL) || (destination->type == ObjectString) || (destination->type == ObjectName)) return 0; // No chains
+
+	return DestinationTarget(structure, destination, 1);
+}
+
+long PDFReaderCoreStructureVisitOutline(PDFReaderCoreStructureRef structure, PDFReaderCoreStructureOutlineFunction function, void *context)
+{
+	OutlineVisit visit; memset(&visit, 0x00, sizeof(visit)); visit.function = function; visit.context = context;
+
+	Object *outlines = GetTyped(structure, structure->catalog, "Outlines", ObjectDictionary); if (outlines == NULL) return 0;
+
+	if (PDFReaderCoreTableInit(&visit.visited, 64) == 0) return 0;
+
+	VisitOutlineItems(structure, DictionaryGet(outlines, "First"), 0, &visit);
+
+	PDFReaderCoreTableFree(&visit.visited);
+
+	return visit.count;
+}
+
+#pragma mark PDFReaderCoreStructure text functions
+
+static const uint16_t PDFDocEncoding[] = // 0x80 to 0x9F
+{
+	0x2022, 0x2020, 0x2021, 0x2026, 0x2014, 0x2013, 0x0192, 0x2044, 0x2039, 0x203A, 0x2212, 0x2030, 0x201E, 0x201C, 0x201D, 0x2018,
+	0x2019, 0x201A, 0x2122, 0xFB01, 0xFB02, 0x0141, 0x0152, 0x0160, 0x0178, 0x017D, 0x0131, 0x0142, 0x0153, 0x0161, 0x017E, 0xFFFD
+};
+
+static const uint16_t PDFDocAccents[] = // 0x18 to 0x1F
+{
+	0x02D8, 0x02C7, 0x02C6, 0x02D9, 0x02DD, 0x02DB, 0x02DA, 0x02DC
+};
+
+static size_t AppendUTF8(char *buffer, size_t size, size_t *filled, size_t length, uint32_t code)
+{
+	uint8_t bytes[4]; size_t count = 0; // Encoded code point
+
+	if ((code > 0x10FFFF) || ((code >= 0xD800) && (code <= 0xDFFF))) code = 0xFFFD;
+
+	if (code < 0x80) { bytes[0] = (uint8_t)code; count = 1; }
+	else if (code < 0x800) { bytes[0] = (uint8_t)(0xC0 | (code >> 6)); bytes[1] = (uint8_t)(0x80 | (code & 0x3F)); count = 2; }
+	else if (code < 0x10000) { bytes[0] = (uint8_t)(0xE0 | (code >> 12)); bytes[1] = (uint8_t)(0x80 | ((code >> 6) & 0x3F)); bytes[2] = (uint8_t)(0x80 | (code & 0x3F)); count = 3; }
+	else { bytes[0] = (uint8_t)(0xF0 | (code >> 18)); bytes[1] = (uint8_t)(0x80 | ((code >> 12) & 0x3F)); bytes[2] = (uint8_t)(0x80 | ((code >> 6) & 0x3F)); bytes[3] = (uint8_t)(0x80 | (code & 0x3F)); count = 4; }
+
+	if ((*filled == length) && ((length + count) < size)) // Whole sequences only, with room for the NUL
+	{
+		memcpy((buffer + length), bytes, count); *filled += count;
+	}
+
+	return (length + count);
+}
+
+size_t PDFReaderCoreTextStringToUTF8(const uint8_t *bytes, size_t length, char *buffer, size_t size)
+{
+	size_t written = 0; size_t filled = 0; // UTF-8 length and bytes that fit
+
+	if ((length >= 2) && (bytes[0] == 0xFE) && (bytes[1] == 0xFF)) // UTF-16BE
+	{
+		int escaped = 0; // Inside a language escape sequence
+
+		for (size_t index = 2; (index + 1) < length; index += 2)
+		{
+			uint32_t code = (((uint32_t)bytes[index] << 8) | bytes[index + 1]);
+
+			if (code == 0x001B) { escaped = !escaped; continue; }
+
+			if (escaped != 0) continue;
+
+			if ((code >= 0xD800) && (code <= 0xDBFF) && ((index + 3) < length)) // Surrogate pair
+			{
+				uint32_t low = (((uint32_t)bytes[index + 2] << 8) | bytes[index + 3]);
+
+				if ((low >= 0xDC00) && (low <= 0xDFFF)) { code = (0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00)); index += 2; }
+			}
+
+			written = AppendUTF8(buffer, size, &filled, written, code);
+		}
+	}
+	else if ((length >= 3) && (bytes[0] == 0xEF) && (bytes[1] == 0xBB) && (bytes[2] == 0xBF)) // UTF-8
+	{
+		for (size_t index = 3; index < length; index++)
+		{
+			if ((filled == written) && ((written + 1) < size)) buffer[filled++] = (char)bytes[index];
+
+			written++;
+		}
+	}
+	else // PDFDocEncoding
+	{
+		for (size_t index = 0; index < length; index++)
+		{
+			uint8_t c = bytes[index]; uint32_t code = c;
+
+			if ((c >= 0x18) && (c <= 0x1F)) code = PDFDocAccents[c - 0x18];
+			else if ((c >= 0x80) && (c <= 0x9F)) code = PDFDocEncoding[c - 0x80];
+			else if (c == 0xA0) code = 0x20AC;
+			else if ((c == 0x7F) || (c == 0xAD)) code = 0xFFFD;
+
+			written = AppendUTF8(buffer, size, &filled, written, code);
+		}
+	}
+
+	if (size > 0) buffer[filled] = '\0';
+
+	return written;
+}
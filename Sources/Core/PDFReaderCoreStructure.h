@@ -0,0 +1,140 @@
+//
+//	PDFReaderCoreStructure.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_STRUCTURE_H
+#define PDFREADER_CORE_STRUCTURE_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+/*
+ *  Lightweight PDF structure reader. It maps the file and parses only the
+ *  trailer, cross-reference tables and streams, and the objects (including
+ *  those inside object streams) that page count, page boxes and rotation,
+ *  the outline and named destinations need - no content streams, fonts or
+ *  resources. The page tree is walked lazily and cached objects live until
+ *  the structure is destroyed.
+ *
+ *  Encrypted documents are refused (PDFReaderCoreStructureEncrypted) so the
+ *  caller can fall back to CoreGraphics. A structure is not thread safe.
+ */
+typedef struct PDFReaderCoreStructure *PDFReaderCoreStructureRef;
+
+typedef enum
+{
+	PDFReaderCoreStructureOK = 0, // Opened
+	PDFReaderCoreStructureUnreadable, // Unable to open or map the file
+	PDFReaderCoreStructureMalformed, // Not a PDF or no usable catalog
+	PDFReaderCoreStructureEncrypted, // Has an /Encrypt dictionary
+	PDFReaderCoreStructureNoMemory // Out of memory
+} PDFReaderCoreStructureStatus;
+
+typedef struct
+{
+	long page; // Page number (1-based)
+	uint32_t object; // Page object number (0 for a direct page dictionary)
+	PDFReaderCoreRect mediaBox; // Normalized, inherited /MediaBox
+	PDFReaderCoreRect cropBox; // Normalized, inherited /CropBox (media box when absent)
+	long rotate; // Inherited /Rotate (0, 90, 180 or 270)
+} PDFReaderCoreStructurePage;
+
+typedef enum
+{
+	PDFReaderCoreOutlineTargetNone = 0, // No (or unresolvable) target
+	PDFReaderCoreOutlineTargetPage, // Page number
+	PDFReaderCoreOutlineTargetURI // URI action
+} PDFReaderCoreOutlineTarget;
+
+typedef struct
+{
+	long level; // Nesting level (0 is top level)
+	const uint8_t *title; size_t titleLength; // Raw PDF text string bytes
+	PDFReaderCoreOutlineTarget target; // Target kind
+	long page; // Target page number
+	const uint8_t *uri; size_t uriLength; // Target URI bytes
+} PDFReaderCoreOutlineItem;
+
+typedef int (*PDFReaderCoreStructurePageFunction)(const PDFReaderCoreStructurePage *page, void *context);
+
+typedef int (*PDFReaderCoreStructureOutlineFunction)(const PDFReaderCoreOutlineItem *item, void *context);
+
+/*
+ *  Opens and memory maps a file. Returns NULL (and sets status) on failure.
+ */
+PDFReaderCoreStructureRef PDFReaderCoreStructureCreateWithPath(const char *path, PDFReaderCoreStructureStatus *status);
+
+/*
+ *  Reads a PDF from memory. The bytes are not copied and must stay valid
+ *  until the structure is destroyed.
+ */
+PDFReaderCoreStructureRef PDFReaderCoreStructureCreateWithBytes(const void *bytes, size_t length, PDFReaderCoreStructureStatus *status);
+
+void PDFReaderCoreStructureDestroy(PDFReaderCoreStructureRef structure);
+
+/*
+ *  Page count from the page tree root (counted when /Count is missing).
+ */
+long PDFReaderCoreStructurePageCount(PDFReaderCoreStructureRef structure);
+
+/*
+ *  Page boxes and rotation of one page, descending the page tree by the
+ *  intermediate node /Count values. Returns 0 when the page is not found.
+ */
+int PDFReaderCoreStructureGetPage(PDFReaderCoreStructureRef structure, long page, PDFReaderCoreStructurePage *info);
+
+/*
+ *  Calls function for every page in order (stop early by returning 0).
+ *  Returns the number of pages visited.
+ */
+long PDFReaderCoreStructureVisitPages(PDFReaderCoreStructureRef structure, PDFReaderCoreStructurePageFunction function, void *context);
+
+/*
+ *  Page number of a page object number, or 0.
+ */
+long PDFReaderCoreStructurePageNumberForObject(PDFReaderCoreStructureRef structure, uint32_t object);
+
+/*
+ *  Target page of a named destination - a name tree string (isString != 0)
+ *  or a catalog /Dests name - or 0.
+ */
+long PDFReaderCoreStructureDestinationPage(PDFReaderCoreStructureRef structure, const void *name, size_t length, int isString);
+
+/*
+ *  Calls function for every titled outline item in pre-order, resolving
+ *  each target (stop early by returning 0). Items without a title are
+ *  skipped along with their children. Returns the number of items.
+ */
+long PDFReaderCoreStructureVisitOutline(PDFReaderCoreStructureRef structure, PDFReaderCoreStructureOutlineFunction function, void *context);
+
+/*
+ *  Converts a PDF text string (UTF-16BE or UTF-8 with a BOM, otherwise
+ *  PDFDocEncoding) to NUL terminated UTF-8. Returns the UTF-8 length that
+ *  would have been written (excluding the NUL), like snprintf().
+ */
+size_t PDFReaderCoreTextStringToUTF8(const uint8_t *bytes, size_t length, char *buffer, size_t size);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_STRUCTURE_H
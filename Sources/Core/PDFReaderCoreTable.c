@@ -0,0 +1,159 @@
+//
+//	PDFReaderCoreTable.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "PDFReaderCoreTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Constants
+
+#define MINIMUM_CAPACITY 16
+
+#pragma mark PDFReaderCoreTable functions
+
+static inline uint32_t TableSlot(const PDFReaderCoreTable *table, uint64_t key)
+{
+	key ^= (key >> 33); key *= 0xFF51AFD7ED558CCDULL; key ^= (key >> 33); // Mix
+
+	return (uint32_t)(key & (table->capacity - 1));
+}
+
+static int TableResize(PDFReaderCoreTable *table, uint32_t capacity)
+{
+	uint64_t *keys = calloc(capacity, sizeof(uint64_t)); uint32_t *values = calloc(capacity, sizeof(uint32_t));
+
+	if ((keys == NULL) || (values == NULL)) { free(keys); free(values); return 0; }
+
+	uint64_t *oldKeys = table->keys; uint32_t *oldValues = table->values; uint32_t oldCapacity = table->capacity;
+
+	table->keys = keys; table->values = values; table->capacity = capacity; // New slots
+
+	for (uint32_t index = 0; index < oldCapacity; index++) // Rehash the used slots
+	{
+		if (oldValues[index] == 0) continue; // Empty slot
+
+		uint32_t slot = TableSlot(table, oldKeys[index]);
+
+		while (values[slot] != 0) slot = ((slot + 1) & (capacity - 1));
+
+		keys[slot] = oldKeys[index]; values[slot] = oldValues[index];
+	}
+
+	free(oldKeys); free(oldValues);
+
+	return 1;
+}
+
+int PDFReaderCoreTableInit(PDFReaderCoreTable *table, uint32_t capacity)
+{
+	memset(table, 0x00, sizeof(PDFReaderCoreTable)); uint32_t slots = MINIMUM_CAPACITY;
+
+	while ((slots < (capacity * 2)) && (slots < 0x80000000U)) slots <<= 1; // Load factor <= 0.5
+
+	return TableResize(table, slots);
+}
+
+void PDFReaderCoreTableFree(PDFReaderCoreTable *table)
+{
+	free(table->keys); free(table->values); memset(table, 0x00, sizeof(PDFReaderCoreTable));
+}
+
+void PDFReaderCoreTableClear(PDFReaderCoreTable *table)
+{
+	if (table->values != NULL) memset(table->values, 0x00, (table->capacity * sizeof(uint32_t)));
+
+	table->count = 0;
+}
+
+int PDFReaderCoreTableGet(const PDFReaderCoreTable *table, uint64_t key, uint32_t *value)
+{
+	if (table->capacity == 0) return 0; // No slots
+
+	uint32_t slot = TableSlot(table, key);
+
+	while (table->values[slot] != 0) // Probe until an empty slot
+	{
+		if (table->keys[slot] == key) { if (value != NULL) *value = (table->values[slot] - 1); return 1; }
+
+		slot = ((slot + 1) & (table->capacity - 1));
+	}
+
+	return 0;
+}
+
+int PDFReaderCoreTableSet(PDFReaderCoreTable *table, uint64_t key, uint32_t value)
+{
+	if (((table->count + 1) * 2) > table->capacity) // Keep the load factor <= 0.5
+	{
+		if (TableResize(table, ((table->capacity > 0) ? (table->capacity * 2) : MINIMUM_CAPACITY)) == 0) return 0;
+	}
+
+	uint32_t slot = TableSlot(table, key);
+
+	while (table->values[slot] != 0) // Probe for the key or an empty slot
+	{
+		if (table->keys[slot] == key) { table->values[slot] = (value + 1); return 1; }
+
+		slot = ((slot + 1) & (table->capacity - 1));
+	}
+
+	table->keys[slot] = key; table->values[slot] = (value + 1); table->count++;
+
+	return 1;
+}
+
+int PDFReaderCoreTableRemove(PDFReaderCoreTable *table, uint64_t key)
+{
+	if (table->capacity == 0) return 0; // No slots
+
+	uint32_t mask = (table->capacity - 1); uint32_t slot = TableSlot(table, key);
+
+	while (table->keys[slot] != key) // Find the key slot
+	{
+		if (table->values[slot] == 0) return 0; // Not found
+
+		slot = ((slot + 1) & mask);
+	}
+
+	if (table->values[slot] == 0) return 0; // Empty slot with a matching stale key
+
+	uint32_t hole = slot; uint32_t next = slot; // Backward shift deletion (no tombstones)
+
+	for (;;)
+	{
+		next = ((next + 1) & mask); if (table->values[next] == 0) break;
+
+		uint32_t home = TableSlot(table, table->keys[next]); // Ideal slot of the next key
+
+		if (((next > hole) && ((home <= hole) || (home > next))) || ((next < hole) && ((home <= hole) && (home > next))))
+		{
+			table->keys[hole] = table->keys[next]; table->values[hole] = table->values[next]; hole = next;
+		}
+	}
+
+	table->values[hole] = 0; table->count--;
+
+	return 1;
+}
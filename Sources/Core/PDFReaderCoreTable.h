@@ -0,0 +1,59 @@
+//
+//	PDFReaderCoreTable.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_TABLE_H
+#define PDFREADER_CORE_TABLE_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+/*
+ *  Open addressing (linear probing) map of 64-bit keys to 32-bit values,
+ *  used as the index of the other core containers. Keys are expected to be
+ *  hashes already but are mixed again, so small integers are fine too.
+ */
+typedef struct
+{
+	uint64_t *keys; // Slot keys
+	uint32_t *values; // Slot values + 1 (0 is an empty slot)
+	uint32_t capacity; // Slot count (power of 2)
+	uint32_t count; // Used slots
+} PDFReaderCoreTable;
+
+int PDFReaderCoreTableInit(PDFReaderCoreTable *table, uint32_t capacity);
+
+void PDFReaderCoreTableFree(PDFReaderCoreTable *table);
+
+void PDFReaderCoreTableClear(PDFReaderCoreTable *table);
+
+int PDFReaderCoreTableGet(const PDFReaderCoreTable *table, uint64_t key, uint32_t *value);
+
+int PDFReaderCoreTableSet(PDFReaderCoreTable *table, uint64_t key, uint32_t value);
+
+int PDFReaderCoreTableRemove(PDFReaderCoreTable *table, uint64_t key);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_TABLE_H
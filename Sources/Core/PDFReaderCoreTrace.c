@@ -0,0 +1,362 @@
+//
+//	PDFReaderCoreTrace.c
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime() with -std=c99
+#endif
+
+#include "PDFReaderCoreTrace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#pragma mark Constants
+
+#define TRACE_MAGIC "PDFRTRC1"
+
+#define TRACE_VERSION 1
+
+#define MAXIMUM_CAPACITY (1 << 24)
+
+#pragma mark PDFReaderCoreTrace types
+
+typedef struct
+{
+	uint64_t sequence; // (2 * slot + 1) while being written, (2 * slot + 2) when written
+	PDFReaderCoreTraceEvent event; // Event payload
+} TraceSlot;
+
+typedef struct
+{
+	uint64_t head; // Next slot number
+	uint64_t mask; // Capacity - 1
+	TraceSlot *slots; // Ring storage
+} TraceRing;
+
+typedef struct
+{
+	char magic[8]; // TRACE_MAGIC
+	uint32_t version; // TRACE_VERSION
+	uint32_t eventSize; // sizeof(PDFReaderCoreTraceEvent)
+	uint64_t count; // Events that follow
+	uint64_t dropped; // Events overwritten before the write
+} TraceFileHeader;
+
+#pragma mark PDFReaderCoreTrace variables
+
+int PDFReaderCoreTraceActive = 0;
+
+static TraceRing *traceRing = NULL; // Allocated by the first enable
+
+static pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER; // Serializes enable and reset
+
+static PDFReaderCoreTraceHistogram traceHistograms[PDFReaderCoreTraceStages]; // Durations by stage
+
+static uint64_t traceBytes[PDFReaderCoreTraceStages]; // Bytes written by stage
+
+static const char *traceStageNames[PDFReaderCoreTraceStages] =
+{
+	"thumb-hit", "thumb-miss", "fetch-wait", "fetch", "render-wait", "render-open",
+	"render-draw", "render", "encode-wait", "encode", "display", "page-draw"
+};
+
+#pragma mark PDFReaderCoreTrace functions
+
+static size_t BucketIndex(uint64_t value)
+{
+	if (value < 4) return (size_t)value; // Exact small values
+
+	size_t exponent = 63; while ((value >> exponent) == 0) exponent--; // Highest set bit (2 or more)
+
+	size_t index = ((exponent - 1) * 4) + (size_t)((value >> (exponent - 2)) & 3); // Four linear steps per power of two
+
+	return ((index < PDFREADER_CORE_TRACE_BUCKETS) ? index : (PDFREADER_CORE_TRACE_BUCKETS - 1));
+}
+
+static uint64_t BucketMidpoint(size_t index)
+{
+	if (index < 4) return index; // Exact small values
+
+	size_t exponent = ((index / 4) + 1); uint64_t step = ((uint64_t)1 << (exponent - 2));
+
+	return ((((index % 4) + 4) * step) + (step / 2));
+}
+
+static void AtomicMaximum(uint64_t *maximum, uint64_t value)
+{
+	uint64_t current = __atomic_load_n(maximum, __ATOMIC_RELAXED);
+
+	while ((value > current) && !__atomic_compare_exchange_n(maximum, &current, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+}
+
+static uint16_t ThreadNumber(void)
+{
+	uintptr_t thread = (uintptr_t)pthread_self(); // Opaque handle
+
+	return (uint16_t)((thread >> 4) ^ (thread >> 20) ^ (thread >> 36));
+}
+
+int PDFReaderCoreTraceEnable(size_t capacity)
+{
+	pthread_mutex_lock(&traceLock);
+
+	if (__atomic_load_n(&traceRing, __ATOMIC_ACQUIRE) == NULL) // First enable
+	{
+		if (capacity == 0) capacity = PDFREADER_CORE_TRACE_CAPACITY;
+
+		if (capacity > MAXIMUM_CAPACITY) capacity = MAXIMUM_CAPACITY;
+
+		size_t rounded = 16; while (rounded < capacity) rounded <<= 1; // Power of two
+
+		TraceRing *ring = calloc(1, sizeof(TraceRing)); TraceSlot *slots = calloc(rounded, sizeof(TraceSlot));
+
+		if ((ring == NULL) || (slots == NULL)) { free(ring); free(slots); pthread_mutex_unlock(&traceLock); return 0; }
+
+		ring->slots = slots; ring->mask = (rounded - 1);
+
+		__atomic_store_n(&traceRing, ring, __ATOMIC_RELEASE); // Publish
+	}
+
+	__atomic_store_n(&PDFReaderCoreTraceActive, 1, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&traceLock); return 1;
+}
+
+void PDFReaderCoreTraceDisable(void)
+{
+	__atomic_store_n(&PDFReaderCoreTraceActive, 0, __ATOMIC_RELEASE);
+}
+
+void PDFReaderCoreTraceReset(void)
+{
+	pthread_mutex_lock(&traceLock);
+
+	TraceRing *ring = __atomic_load_n(&traceRing, __ATOMIC_ACQUIRE);
+
+	if (ring != NULL) // Forget every slot
+	{
+		for (uint64_t index = 0; index <= ring->mask; index++) __atomic_store_n(&ring->slots[index].sequence, 0, __ATOMIC_RELAXED);
+
+		__atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+	}
+
+	for (size_t stage = 0; stage < PDFReaderCoreTraceStages; stage++) // Clear the aggregates
+	{
+		PDFReaderCoreTraceHistogram *histogram = &traceHistograms[stage];
+
+		__atomic_store_n(&histogram->count, 0, __ATOMIC_RELAXED); __atomic_store_n(&histogram->sum, 0, __ATOMIC_RELAXED);
+
+		__atomic_store_n(&histogram->maximum, 0, __ATOMIC_RELAXED); __atomic_store_n(&traceBytes[stage], 0, __ATOMIC_RELAXED);
+
+		for (size_t index = 0; index < PDFREADER_CORE_TRACE_BUCKETS; index++) __atomic_store_n(&histogram->buckets[index], 0, __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_unlock(&traceLock);
+}
+
+uint64_t PDFReaderCoreTraceNow(void)
+{
+#ifdef __APPLE__
+	static mach_timebase_info_data_t timebase; // Ticks to nanoseconds
+
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return ((mach_absolute_time() * timebase.numer) / timebase.denom);
+#else
+	struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+void PDFReaderCoreTraceRecord(PDFReaderCoreTraceStage stage, uint32_t identifier, long page, uint64_t start, uint64_t duration, uint32_t bytes)
+{
+	if ((PDFReaderCoreTraceIsEnabled() == 0) || ((unsigned)stage >= PDFReaderCoreTraceStages)) return;
+
+	TraceRing *ring = __atomic_load_n(&traceRing, __ATOMIC_ACQUIRE); if (ring == NULL) return;
+
+	uint64_t slot = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED); // Claim a slot
+
+	TraceSlot *entry = &ring->slots[slot & ring->mask];
+
+	__atomic_store_n(&entry->sequence, ((slot * 2) + 1), __ATOMIC_RELAXED); // Being written
+
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	entry->event.start = start; entry->event.duration = duration; entry->event.identifier = identifier;
+
+	entry->event.page = (int32_t)page; entry->event.bytes = bytes; entry->event.thread = ThreadNumber(); entry->event.stage = (uint16_t)stage;
+
+	__atomic_store_n(&entry->sequence, ((slot * 2) + 2), __ATOMIC_RELEASE); // Written
+
+	PDFReaderCoreTraceHistogram *histogram = &traceHistograms[stage]; // Aggregates
+
+	__atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED); __atomic_fetch_add(&histogram->sum, duration, __ATOMIC_RELAXED);
+
+	__atomic_fetch_add(&histogram->buckets[BucketIndex(duration)], 1, __ATOMIC_RELAXED); AtomicMaximum(&histogram->maximum, duration);
+
+	if (bytes > 0) __atomic_fetch_add(&traceBytes[stage], bytes, __ATOMIC_RELAXED);
+}
+
+size_t PDFReaderCoreTraceCopyEvents(PDFReaderCoreTraceEvent *events, size_t capacity, uint64_t *dropped)
+{
+	TraceRing *ring = __atomic_load_n(&traceRing, __ATOMIC_ACQUIRE);
+
+	if (dropped != NULL) *dropped = 0; // Nothing overwritten yet
+
+	if (ring == NULL) return 0; // Never enabled
+
+	uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE); uint64_t ringSize = (ring->mask + 1);
+
+	uint64_t first = ((head > ringSize) ? (head - ringSize) : 0); // Oldest slot still in the ring
+
+	if (dropped != NULL) *dropped = first;
+
+	if ((head - first) > capacity) first = (head - capacity); // Most recent ones only
+
+	size_t count = 0; // Events copied
+
+	for (uint64_t slot = first; slot < head; slot++)
+	{
+		TraceSlot *entry = &ring->slots[slot & ring->mask]; uint64_t written = ((slot * 2) + 2);
+
+		if (__atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE) != written) continue; // Being written or overwritten
+
+		events[count] = entry->event; __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) == written) count++; // Not torn
+	}
+
+	return count;
+}
+
+void PDFReaderCoreTraceGetHistogram(PDFReaderCoreTraceStage stage, PDFReaderCoreTraceHistogram *histogram, uint64_t *bytes)
+{
+	memset(histogram, 0x00, sizeof(PDFReaderCoreTraceHistogram)); if (bytes != NULL) *bytes = 0;
+
+	if ((unsigned)stage >= PDFReaderCoreTraceStages) return; // Unknown stage
+
+	const PDFReaderCoreTraceHistogram *source = &traceHistograms[stage];
+
+	histogram->count = __atomic_load_n(&source->count, __ATOMIC_RELAXED); histogram->sum = __atomic_load_n(&source->sum, __ATOMIC_RELAXED);
+
+	histogram->maximum = __atomic_load_n(&source->maximum, __ATOMIC_RELAXED); // Snapshot, not a consistent cut
+
+	for (size_t index = 0; index < PDFREADER_CORE_TRACE_BUCKETS; index++) histogram->buckets[index] = __atomic_load_n(&source->buckets[index], __ATOMIC_RELAXED);
+
+	if (bytes != NULL) *bytes = __atomic_load_n(&traceBytes[stage], __ATOMIC_RELAXED);
+}
+
+void PDFReaderCoreTraceHistogramAdd(PDFReaderCoreTraceHistogram *histogram, uint64_t value)
+{
+	histogram->count++; histogram->sum += value; histogram->buckets[BucketIndex(value)]++;
+
+	if (value > histogram->maximum) histogram->maximum = value;
+}
+
+uint64_t PDFReaderCoreTraceHistogramQuantile(const PDFReaderCoreTraceHistogram *histogram, double quantile)
+{
+	uint64_t total = 0; // Bucket counts can run ahead of count while recording
+
+	for (size_t index = 0; index < PDFREADER_CORE_TRACE_BUCKETS; index++) total += histogram->buckets[index];
+
+	if (total == 0) return 0; // Empty
+
+	if (quantile < 0.0) quantile = 0.0; else if (quantile > 1.0) quantile = 1.0;
+
+	uint64_t rank = (uint64_t)((quantile * (double)total) + 0.999999); if (rank == 0) rank = 1;
+
+	uint64_t seen = 0; // Values in the buckets so far
+
+	for (size_t index = 0; index < PDFREADER_CORE_TRACE_BUCKETS; index++)
+	{
+		seen += histogram->buckets[index]; if (seen < rank) continue;
+
+		uint64_t value = BucketMidpoint(index); // Bucket representative
+
+		return (((histogram->maximum > 0) && (value > histogram->maximum)) ? histogram->maximum : value);
+	}
+
+	return histogram->maximum;
+}
+
+const char *PDFReaderCoreTraceStageName(PDFReaderCoreTraceStage stage)
+{
+	return (((unsigned)stage < PDFReaderCoreTraceStages) ? traceStageNames[stage] : "unknown");
+}
+
+int PDFReaderCoreTraceWriteFile(const char *path)
+{
+	TraceRing *ring = __atomic_load_n(&traceRing, __ATOMIC_ACQUIRE);
+
+	size_t capacity = ((ring != NULL) ? (size_t)(ring->mask + 1) : 0); // Everything the ring holds
+
+	PDFReaderCoreTraceEvent *events = malloc((capacity > 0) ? (capacity * sizeof(PDFReaderCoreTraceEvent)) : 1);
+
+	if (events == NULL) return -1; // Out of memory
+
+	TraceFileHeader header; memset(&header, 0x00, sizeof(header)); memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+
+	header.version = TRACE_VERSION; header.eventSize = sizeof(PDFReaderCoreTraceEvent);
+
+	header.count = PDFReaderCoreTraceCopyEvents(events, capacity, &header.dropped);
+
+	FILE *file = fopen(path, "wb"); int status = -1; // Failed
+
+	if (file != NULL) // Header then events
+	{
+		if ((fwrite(&header, sizeof(header), 1, file) == 1) && (fwrite(events, sizeof(PDFReaderCoreTraceEvent), (size_t)header.count, file) == header.count)) status = 0;
+
+		if (fclose(file) != 0) status = -1;
+	}
+
+	free(events); return status;
+}
+
+PDFReaderCoreTraceEvent *PDFReaderCoreTraceReadFile(const char *path, size_t *count, uint64_t *dropped)
+{
+	FILE *file = fopen(path, "rb"); if (file == NULL) return NULL;
+
+	TraceFileHeader header; PDFReaderCoreTraceEvent *events = NULL;
+
+	if ((fread(&header, sizeof(header), 1, file) == 1) && (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0) &&
+		(header.version == TRACE_VERSION) && (header.eventSize == sizeof(PDFReaderCoreTraceEvent)) && (header.count <= MAXIMUM_CAPACITY))
+	{
+		size_t eventCount = (size_t)header.count; events = malloc((eventCount > 0) ? (eventCount * sizeof(PDFReaderCoreTraceEvent)) : 1);
+
+		if ((events != NULL) && (fread(events, sizeof(PDFReaderCoreTraceEvent), eventCount, file) != eventCount)) { free(events); events = NULL; }
+
+		if (events != NULL) { if (count != NULL) *count = eventCount; if (dropped != NULL) *dropped = header.dropped; }
+	}
+
+	fclose(file); return events;
+}
@@ -0,0 +1,150 @@
+//
+//	PDFReaderCoreTrace.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_TRACE_H
+#define PDFREADER_CORE_TRACE_H
+
+#include "PDFReaderCoreTypes.h"
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+/*
+ *  Pipeline tracing: per-stage events in a process-wide lock-free ring
+ *  buffer (any number of writer threads, oldest events overwritten) plus
+ *  aggregate per-stage histograms. Recording is off until enabled; while it
+ *  is off a trace point costs one relaxed load and a branch.
+ *
+ *  Events can be written to a binary trace file (header followed by the
+ *  events, native little-endian layout) and read back off-device, see
+ *  Bench/PDFReaderTrace.c.
+ */
+typedef enum
+{
+	PDFReaderCoreTraceThumbHit = 0, // Thumb request answered from memory (instant)
+	PDFReaderCoreTraceThumbMiss, // Thumb request queued a fetch (instant)
+	PDFReaderCoreTraceFetchWait, // Fetch lane enqueue to start
+	PDFReaderCoreTraceFetch, // Thumb pack or legacy file load
+	PDFReaderCoreTraceRenderWait, // Render lane enqueue to start
+	PDFReaderCoreTraceRenderOpen, // Pooled document page retain
+	PDFReaderCoreTraceRenderDraw, // Page draw into the thumb bitmap
+	PDFReaderCoreTraceRender, // Whole thumb render operation
+	PDFReaderCoreTraceEncodeWait, // Encode lane enqueue to start
+	PDFReaderCoreTraceEncode, // Thumb write (bytes written)
+	PDFReaderCoreTraceDisplay, // Image show dispatch to the main thread block run
+	PDFReaderCoreTracePageDraw, // Page tile draw (drawLayer:inContext:)
+	PDFReaderCoreTraceStages
+} PDFReaderCoreTraceStage;
+
+typedef struct
+{
+	uint64_t start; // Nanoseconds on the trace clock
+	uint64_t duration; // Nanoseconds (0 for instants)
+	uint32_t identifier; // Correlates the stages of one request (cache key hash)
+	int32_t page; // Page number (-1 when not known)
+	uint32_t bytes; // Bytes written (or 0)
+	uint16_t thread; // Recording thread (hashed)
+	uint16_t stage; // PDFReaderCoreTraceStage
+} PDFReaderCoreTraceEvent;
+
+#define PDFREADER_CORE_TRACE_CAPACITY 16384 // Default ring size (events)
+
+#define PDFREADER_CORE_TRACE_BUCKETS 192 // Histogram buckets (4 per power of two)
+
+typedef struct
+{
+	uint64_t count; // Values added
+	uint64_t sum; // Sum of values
+	uint64_t maximum; // Largest value
+	uint64_t buckets[PDFREADER_CORE_TRACE_BUCKETS]; // Log-linear value buckets
+} PDFReaderCoreTraceHistogram;
+
+extern int PDFReaderCoreTraceActive; // Non-zero while recording - use PDFReaderCoreTraceIsEnabled()
+
+static inline int PDFReaderCoreTraceIsEnabled(void)
+{
+	return __atomic_load_n(&PDFReaderCoreTraceActive, __ATOMIC_RELAXED);
+}
+
+/*
+ *  Starts recording. The ring buffer is allocated by the first call with
+ *  capacity events (rounded up to a power of two, 0 for the default) and
+ *  kept for the life of the process. Returns 0 when out of memory.
+ */
+int PDFReaderCoreTraceEnable(size_t capacity);
+
+void PDFReaderCoreTraceDisable(void);
+
+/*
+ *  Discards recorded events and clears the histograms. Events recorded by
+ *  other threads during the reset may survive it.
+ */
+void PDFReaderCoreTraceReset(void);
+
+/*
+ *  Monotonic nanoseconds on the trace clock.
+ */
+uint64_t PDFReaderCoreTraceNow(void);
+
+/*
+ *  Records one event (when enabled) and adds it to the stage histograms:
+ *  duration to the stage duration histogram, bytes to the byte totals.
+ */
+void PDFReaderCoreTraceRecord(PDFReaderCoreTraceStage stage, uint32_t identifier, long page, uint64_t start, uint64_t duration, uint32_t bytes);
+
+/*
+ *  Copies up to capacity of the most recent events, oldest first. Events
+ *  being written during the copy are skipped. Returns the number copied;
+ *  dropped (if not NULL) is set to the number of events overwritten.
+ */
+size_t PDFReaderCoreTraceCopyEvents(PDFReaderCoreTraceEvent *events, size_t capacity, uint64_t *dropped);
+
+/*
+ *  Snapshots the duration histogram and byte total of stage.
+ */
+void PDFReaderCoreTraceGetHistogram(PDFReaderCoreTraceStage stage, PDFReaderCoreTraceHistogram *histogram, uint64_t *bytes);
+
+void PDFReaderCoreTraceHistogramAdd(PDFReaderCoreTraceHistogram *histogram, uint64_t value);
+
+/*
+ *  Approximate value at quantile (0.0 to 1.0) - the midpoint of the bucket
+ *  it falls in (within about 12%), clamped to the maximum.
+ */
+uint64_t PDFReaderCoreTraceHistogramQuantile(const PDFReaderCoreTraceHistogram *histogram, double quantile);
+
+const char *PDFReaderCoreTraceStageName(PDFReaderCoreTraceStage stage);
+
+/*
+ *  Writes the recorded events to a trace file. Returns 0 on success.
+ */
+int PDFReaderCoreTraceWriteFile(const char *path);
+
+/*
+ *  Reads a trace file. Returns malloc()ed events (free() them) or NULL when
+ *  the file is unreadable or not a trace file of this version.
+ */
+PDFReaderCoreTraceEvent *PDFReaderCoreTraceReadFile(const char *path, size_t *count, uint64_t *dropped);
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_TRACE_H
@@ -0,0 +1,61 @@
+//
+//	PDFReaderCoreTypes.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef PDFREADER_CORE_TYPES_H
+#define PDFREADER_CORE_TYPES_H
+
+/*
+ *  The PDFReaderCore* files are plain C99 with no UIKit, CoreGraphics or
+ *  Foundation dependency so that the policy and math they implement can be
+ *  built, benchmarked and regression tested off-device (see Bench/).
+ *  The Objective-C classes are thin adapters over these functions.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#define PDFREADER_CORE_EXTERN_C_BEGIN extern "C" {
+#define PDFREADER_CORE_EXTERN_C_END }
+#else
+#define PDFREADER_CORE_EXTERN_C_BEGIN
+#define PDFREADER_CORE_EXTERN_C_END
+#endif
+
+PDFREADER_CORE_EXTERN_C_BEGIN
+
+typedef struct
+{
+	double x, y; // Origin
+	double width, height; // Size
+} PDFReaderCoreRect;
+
+static inline PDFReaderCoreRect PDFReaderCoreRectMake(double x, double y, double width, double height)
+{
+	PDFReaderCoreRect rect; rect.x = x; rect.y = y; rect.width = width; rect.height = height; return rect;
+}
+
+PDFREADER_CORE_EXTERN_C_END
+
+#endif // PDFREADER_CORE_TYPES_H
@@ -0,0 +1,60 @@
+//
+//	PDFReaderBenchmark.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifdef DEBUG
+
+/*
+ *  DEBUG benchmark support shared by the benchmark methods of
+ *  PDFReaderThumbBenchmark, PDFReaderLibraryIndexer and
+ *  PDFReaderNamedDestinations.
+ */
+
+/*
+ *  Sorts samples (seconds) and logs their count, p50 and p99 - in
+ *  microseconds when the p99 is under a millisecond.
+ */
+void PDFReaderBenchmarkLog(NSString *name, NSMutableArray *samples);
+
+/*
+ *  Synthetic document with a count page tree of fanout pages per
+ *  intermediate node.
+ */
+NSData *PDFReaderBenchmarkCreatePagesPDF(NSUInteger count, NSUInteger fanout);
+
+/*
+ *  Synthetic one page document with count named destinations ("dest0000000"
+ *  and up) in a name tree of leafSize names per leaf.
+ */
+NSData *PDFReaderBenchmarkCreateNameTreePDF(NSUInteger count, NSUInteger leafSize);
+
+/*
+ *  Runs every benchmark (thumb fetch, page count and named destination
+ *  lookup) on a background queue. The demo app calls this when launched
+ *  with the "-PDFReaderBenchmarks YES" argument.
+ */
+void PDFReaderBenchmarkRunAll(void);
+
+#endif // DEBUG
@@ -0,0 +1,158 @@
+//
+//	PDFReaderBenchmark.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderBenchmark.h"
+#import "PDFReaderThumbBenchmark.h"
+#import "PDFReaderLibraryIndexer.h"
+#import "PDFReaderNamedDestinations.h"
+
+#ifdef DEBUG
+
+#pragma mark PDFReaderBenchmark functions
+
+static double BenchmarkPercentile(NSArray *sorted, double percentile)
+{
+	if (sorted.count == 0) return 0.0; // No samples
+
+	NSUInteger index = (NSUInteger)((sorted.count - 1) * percentile);
+
+	return [[sorted objectAtIndex:index] doubleValue];
+}
+
+static NSData *BenchmarkWritePDF(NSArray *objects)
+{
+	NSMutableData *data = [NSMutableData data]; NSMutableArray *offsets = [NSMutableArray arrayWithCapacity:objects.count];
+
+	void (^append)(NSString *) = ^(NSString *string) { [data appendData:[string dataUsingEncoding:NSASCIIStringEncoding]]; };
+
+	append(@"%PDF-1.4\n");
+
+	for (NSString *body in objects) // Objects are numbered from 1 in array order
+	{
+		[offsets addObject:[NSNumber numberWithUnsignedInteger:data.length]];
+
+		append([NSString stringWithFormat:@"%u 0 obj\n%@\nendobj\n", (unsigned)offsets.count, body]);
+	}
+
+	NSUInteger xref = data.length; // Cross-reference table
+
+	append([NSString stringWithFormat:@"xref\n0 %u\n0000000000 65535 f \n", (unsigned)(offsets.count + 1)]);
+
+	for (NSNumber *offset in offsets) append([NSString stringWithFormat:@"%010u 00000 n \n", [offset unsignedIntValue]]);
+
+	append([NSString stringWithFormat:@"trailer\n<< /Size %u /Root 1 0 R >>\nstartxref\n%u\n%%%%EOF\n", (unsigned)(offsets.count + 1), (unsigned)xref]);
+
+	return data;
+}
+
+void PDFReaderBenchmarkLog(NSString *name, NSMutableArray *samples)
+{
+	[samples sortUsingSelector:@selector(compare:)]; // Ascending
+
+	double p50 = BenchmarkPercentile(samples, 0.50); double p99 = BenchmarkPercentile(samples, 0.99);
+
+	if (p99 < 0.001) // Sub-millisecond
+		NSLog(@"%@: n %u, p50 %.3fus, p99 %.3fus", name, (unsigned)samples.count, (p50 * 1000000.0), (p99 * 1000000.0));
+	else
+		NSLog(@"%@: n %u, p50 %.3fms, p99 %.3fms", name, (unsigned)samples.count, (p50 * 1000.0), (p99 * 1000.0));
+}
+
+NSData *PDFReaderBenchmarkCreatePagesPDF(NSUInteger count, NSUInteger fanout)
+{
+	NSUInteger nodes = ((count + fanout - 1) / fanout); // Intermediate nodes (objects 3...)
+
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:(count + nodes + 2)];
+
+	[objects addObject:@"<< /Type /Catalog /Pages 2 0 R >>"];
+
+	NSMutableString *kids = [NSMutableString stringWithString:@"<< /Type /Pages /Kids ["];
+
+	for (NSUInteger node = 0; node < nodes; node++) [kids appendFormat:@" %u 0 R", (unsigned)(node + 3)];
+
+	[kids appendFormat:@" ] /Count %u /MediaBox [0 0 612 792] >>", (unsigned)count]; [objects addObject:kids];
+
+	for (NSUInteger node = 0; node < nodes; node++) // Page objects follow the intermediate nodes
+	{
+		NSUInteger first = (node * fanout); NSUInteger last = MIN((first + fanout), count);
+
+		NSMutableString *body = [NSMutableString stringWithString:@"<< /Type /Pages /Parent 2 0 R /Kids ["];
+
+		for (NSUInteger page = first; page < last; page++) [body appendFormat:@" %u 0 R", (unsigned)(page + nodes + 3)];
+
+		[body appendFormat:@" ] /Count %u >>", (unsigned)(last - first)]; [objects addObject:body];
+	}
+
+	for (NSUInteger page = 0; page < count; page++) // Leaf pages
+	{
+		[objects addObject:[NSString stringWithFormat:@"<< /Type /Page /Parent %u 0 R >>", (unsigned)((page / fanout) + 3)]];
+	}
+
+	return BenchmarkWritePDF(objects);
+}
+
+NSData *PDFReaderBenchmarkCreateNameTreePDF(NSUInteger count, NSUInteger leafSize)
+{
+	NSUInteger leaves = ((count + leafSize - 1) / leafSize); // Leaf nodes (objects 5...)
+
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:(leaves + 4)];
+
+	[objects addObject:@"<< /Type /Catalog /Pages 2 0 R /Names << /Dests 4 0 R >> >>"];
+
+	[objects addObject:@"<< /Type /Pages /Kids [3 0 R] /Count 1 >>"];
+
+	[objects addObject:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] >>"];
+
+	NSMutableString *kids = [NSMutableString stringWithString:@"<< /Kids ["];
+
+	for (NSUInteger leaf = 0; leaf < leaves; leaf++) [kids appendFormat:@" %u 0 R", (unsigned)(leaf + 5)];
+
+	[kids appendString:@" ] >>"]; [objects addObject:kids];
+
+	for (NSUInteger leaf = 0; leaf < leaves; leaf++) // Sorted names, leafSize per leaf
+	{
+		NSUInteger first = (leaf * leafSize); NSUInteger last = (MIN((first + leafSize), count) - 1);
+
+		NSMutableString *node = [NSMutableString stringWithFormat:@"<< /Limits [(dest%07u) (dest%07u)] /Names [", (unsigned)first, (unsigned)last];
+
+		for (NSUInteger index = first; index <= last; index++) [node appendFormat:@" (dest%07u) [3 0 R /XYZ 0 %u 0]", (unsigned)index, (unsigned)(index % 792)];
+
+		[node appendString:@" ] >>"]; [objects addObject:node];
+	}
+
+	return BenchmarkWritePDF(objects);
+}
+
+void PDFReaderBenchmarkRunAll(void)
+{
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0),
+	^{
+		[PDFReaderThumbBenchmark runFetchBenchmarkWithCount:200 size:CGSizeMake(160.0f, 160.0f)]; // Small grid thumbs
+
+		[PDFReaderLibraryIndexer runPageCountBenchmarkWithPageCount:10000];
+
+		[PDFReaderNamedDestinations runLookupBenchmarkWithCount:50000];
+	});
+}
+
+#endif // DEBUG
@@ -0,0 +1,65 @@
+//
+//	PDFReaderCacheFile.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/*
+ *  Header shared by the per-document cache files in the thumb cache
+ *  directory (link index, outline, page metrics and text index). A cache
+ *  file is only valid for the document file size and modification date it
+ *  was built from.
+ */
+typedef struct
+{
+	uint32_t magic; uint32_t version; // Cache file identification
+	uint64_t fileSize; double fileDate; // Document file identity
+	uint32_t count; uint32_t reserved; // Records that follow
+} PDFReaderCacheFileHeader;
+
+/*
+ *  Document file size and modification date. Returns NO when the file
+ *  can not be stat'ed.
+ */
+BOOL PDFReaderCacheFileIdentity(NSURL *fileURL, uint64_t *fileSize, double *fileDate);
+
+PDFReaderCacheFileHeader PDFReaderCacheFileMakeHeader(uint32_t magic, uint32_t version, uint64_t fileSize, double fileDate, uint32_t count);
+
+/*
+ *  Copies the header from the start of data. Returns NO when data is too
+ *  short or was written by another cache format, version or document file.
+ */
+BOOL PDFReaderCacheFileReadHeader(NSData *data, uint32_t magic, uint32_t version, uint64_t fileSize, double fileDate, PDFReaderCacheFileHeader *header);
+
+/*
+ *  Record checksum - the PDFReaderCoreHash FNV-1a hash folded to 32 bits.
+ */
+uint32_t PDFReaderCacheFileChecksum(const void *bytes, size_t length);
+
+NSString *PDFReaderCacheFilePath(NSString *guid, NSString *fileName);
+
+/*
+ *  Atomically writes data to fileName in the document's thumb cache
+ *  directory, creating the directory when needed.
+ */
+BOOL PDFReaderCacheFileWrite(NSString *guid, NSString *fileName, NSData *data);
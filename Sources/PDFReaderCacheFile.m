@@ -0,0 +1,84 @@
+//
+//	PDFReaderCacheFile.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderCacheFile.h"
+#import "PDFReaderThumbCache.h"
+
+#import "PDFReaderCoreHash.h"
+
+#import <sys/stat.h>
+
+#pragma mark PDFReaderCacheFile functions
+
+BOOL PDFReaderCacheFileIdentity(NSURL *fileURL, uint64_t *fileSize, double *fileDate)
+{
+	struct stat info; if (stat([[fileURL path] fileSystemRepresentation], &info) != 0) return NO;
+
+	*fileSize = (uint64_t)info.st_size; *fileDate = ((double)info.st_mtimespec.tv_sec + (info.st_mtimespec.tv_nsec / 1000000000.0));
+
+	return YES;
+}
+
+PDFReaderCacheFileHeader PDFReaderCacheFileMakeHeader(uint32_t magic, uint32_t version, uint64_t fileSize, double fileDate, uint32_t count)
+{
+	PDFReaderCacheFileHeader header; memset(&header, 0x00, sizeof(header));
+
+	header.magic = magic; header.version = version; header.fileSize = fileSize; header.fileDate = fileDate; header.count = count;
+
+	return header;
+}
+
+BOOL PDFReaderCacheFileReadHeader(NSData *data, uint32_t magic, uint32_t version, uint64_t fileSize, double fileDate, PDFReaderCacheFileHeader *header)
+{
+	if (data.length < sizeof(PDFReaderCacheFileHeader)) return NO; // Missing or truncated
+
+	memcpy(header, data.bytes, sizeof(PDFReaderCacheFileHeader));
+
+	if ((header->magic != magic) || (header->version != version)) return NO;
+
+	return ((header->fileSize == fileSize) && (header->fileDate == fileDate)); // Document unchanged
+}
+
+uint32_t PDFReaderCacheFileChecksum(const void *bytes, size_t length)
+{
+	uint64_t hash = PDFReaderCoreHashBytes(bytes, length); // FNV-1a
+
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+NSString *PDFReaderCacheFilePath(NSString *guid, NSString *fileName)
+{
+	NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:guid]; // Thumb cache path
+
+	return [cachePath stringByAppendingPathComponent:fileName];
+}
+
+BOOL PDFReaderCacheFileWrite(NSString *guid, NSString *fileName, NSData *data)
+{
+	NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:guid]; // Document cache directory
+
+	[[NSFileManager new] createDirectoryAtPath:cachePath withIntermediateDirectories:NO attributes:nil error:NULL];
+
+	return [data writeToFile:[cachePath stringByAppendingPathComponent:fileName] atomically:YES];
+}
@@ -82,6 +82,54 @@ extern const BOOL kPDFReaderDefaultIdleTimerDisabled;
  */
 extern const BOOL kPDFReaderDefaultMultimodeDisabled;
 
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for thumbMipChainEnabled: TRUE
+ */
+extern const BOOL kPDFReaderDefaultThumbMipChainEnabled;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for thumbCacheSize: 8 MB
+ */
+extern const NSUInteger kPDFReaderDefaultThumbCacheSize;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for thumbDiskCacheSize: 100 MB
+ */
+extern const unsigned long long kPDFReaderDefaultThumbDiskCacheSize;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for pagePrefetchEnabled: TRUE
+ */
+extern const BOOL kPDFReaderDefaultPagePrefetchEnabled;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for pagePrefetchMemoryBudget: 16 MB
+ */
+extern const NSUInteger kPDFReaderDefaultPagePrefetchMemoryBudget;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for tileCacheSize: 32 MB
+ */
+extern const NSUInteger kPDFReaderDefaultTileCacheSize;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for tileDiskCacheSize: 64 MB
+ */
+extern const unsigned long long kPDFReaderDefaultTileDiskCacheSize;
+
+/**
+ *  @memberof PDFReaderConfig
+ *  Default value for progressiveDisplayEnabled: TRUE
+ */
+extern const BOOL kPDFReaderDefaultProgressiveDisplayEnabled;
+
 /**
  *  `PDFReaderConfig` is a singleton class that manages PDFReader global
  *  configuration parameters.
@@ -174,6 +222,77 @@ extern const BOOL kPDFReaderDefaultMultimodeDisabled;
 @property (nonatomic, readwrite, unsafe_unretained, getter=isMultimodeDisabled)
     BOOL multimodeDisabled;
 
+/**
+ *  When TRUE, a page thumb is rendered once at the largest thumb size that is
+ *  currently on screen for the document (pagebar and thumbs grid) and every
+ *  smaller active size is downsampled from that render.
+ *
+ *  @see kPDFReaderDefaultThumbMipChainEnabled
+ */
+@property (nonatomic, readwrite, unsafe_unretained,
+           getter=isThumbMipChainEnabled) BOOL thumbMipChainEnabled;
+
+/**
+ *  Memory budget (in bytes of decoded pixels) of the in-memory thumb cache.
+ *  Must be set before the first thumb is requested.
+ *
+ *  @see kPDFReaderDefaultThumbCacheSize
+ */
+@property (nonatomic, readwrite, assign) NSUInteger thumbCacheSize;
+
+/**
+ *  Global cap (in bytes) of the on-disk thumb caches of all documents. The
+ *  least recently used pages are evicted when the cap is exceeded.
+ *
+ *  @see kPDFReaderDefaultThumbDiskCacheSize
+ */
+@property (nonatomic, readwrite, assign) unsigned long long thumbDiskCacheSize;
+
+/**
+ *  When TRUE, pages ahead of the scroll direction are warmed (geometry, links
+ *  and a screen resolution render) before they are paged into view. The look
+ *  ahead grows with scroll speed.
+ *
+ *  @see kPDFReaderDefaultPagePrefetchEnabled
+ */
+@property (nonatomic, readwrite, unsafe_unretained,
+           getter=isPagePrefetchEnabled) BOOL pagePrefetchEnabled;
+
+/**
+ *  Memory budget (in bytes of decoded pixels) of the prefetched page renders.
+ *
+ *  @see kPDFReaderDefaultPagePrefetchMemoryBudget
+ */
+@property (nonatomic, readwrite, assign) NSUInteger pagePrefetchMemoryBudget;
+
+/**
+ *  Memory budget (in bytes of decoded pixels) of the rendered page tile cache.
+ *  Set to 0 to disable the tile cache.
+ *
+ *  @see kPDFReaderDefaultTileCacheSize
+ */
+@property (nonatomic, readwrite, assign) NSUInteger tileCacheSize;
+
+/**
+ *  Global cap (in bytes) of the on-disk rendered page tiles of all documents.
+ *  The tiles of the least recently used documents (and the least recently
+ *  drawn pages of the current one) are evicted when the cap is exceeded. Set
+ *  to 0 to keep rendered tiles in memory only.
+ *
+ *  @see kPDFReaderDefaultTileDiskCacheSize
+ */
+@property (nonatomic, readwrite, assign) unsigned long long tileDiskCacheSize;
+
+/**
+ *  When TRUE (and previewThumbEnabled is TRUE), a page view shows the best
+ *  image already available at once (any resident thumb of the page), then a
+ *  screen resolution render, and the sharp tiles draw over it as they arrive.
+ *
+ *  @see kPDFReaderDefaultProgressiveDisplayEnabled
+ */
+@property (nonatomic, readwrite, unsafe_unretained,
+           getter=isProgressiveDisplayEnabled) BOOL progressiveDisplayEnabled;
+
 /**
  * -----------------------------------------------------------------------------
  * @name Accessing the shared PDFReaderConfig Instance
@@ -33,6 +33,14 @@ const BOOL kPDFReaderDefaultPageShadowsEnabled = TRUE;
 const BOOL kPDFReaderDefaultRetinaSupportDisabled = FALSE;
 const BOOL kPDFReaderDefaultIdleTimerDisabled = FALSE;
 const BOOL kPDFReaderDefaultMultimodeDisabled = FALSE;
+const BOOL kPDFReaderDefaultThumbMipChainEnabled = TRUE;
+const NSUInteger kPDFReaderDefaultThumbCacheSize = 8388608;
+const unsigned long long kPDFReaderDefaultThumbDiskCacheSize = 104857600;
+const BOOL kPDFReaderDefaultPagePrefetchEnabled = TRUE;
+const NSUInteger kPDFReaderDefaultPagePrefetchMemoryBudget = 16777216;
+const NSUInteger kPDFReaderDefaultTileCacheSize = 33554432;
+const unsigned long long kPDFReaderDefaultTileDiskCacheSize = 67108864;
+const BOOL kPDFReaderDefaultProgressiveDisplayEnabled = TRUE;
 
 @implementation PDFReaderConfig
 
@@ -67,6 +75,14 @@ const BOOL kPDFReaderDefaultMultimodeDisabled = FALSE;
     _retinaSupportDisabled = kPDFReaderDefaultRetinaSupportDisabled;
     _idleTimerDisabled = kPDFReaderDefaultIdleTimerDisabled;
     _multimodeDisabled = kPDFReaderDefaultMultimodeDisabled;
+    _thumbMipChainEnabled = kPDFReaderDefaultThumbMipChainEnabled;
+    _thumbCacheSize = kPDFReaderDefaultThumbCacheSize;
+    _thumbDiskCacheSize = kPDFReaderDefaultThumbDiskCacheSize;
+    _pagePrefetchEnabled = kPDFReaderDefaultPagePrefetchEnabled;
+    _pagePrefetchMemoryBudget = kPDFReaderDefaultPagePrefetchMemoryBudget;
+    _tileCacheSize = kPDFReaderDefaultTileCacheSize;
+    _tileDiskCacheSize = kPDFReaderDefaultTileDiskCacheSize;
+    _progressiveDisplayEnabled = kPDFReaderDefaultProgressiveDisplayEnabled;
   }
 
   return self;
@@ -24,12 +24,39 @@
 
 #import <UIKit/UIKit.h>
 
+@class PDFReaderPagePrefetchEntry;
+
+typedef struct
+{
+	NSInteger angle; // Page rotation angle (in degrees)
+	CGFloat width, height; // Rotated effective page size
+	CGFloat offsetX, offsetY; // Rotated effective page origin
+} PDFReaderPageGeometry;
+
 @interface PDFReaderContentPage : UIView
 
++ (PDFReaderPageGeometry)geometryForPage:(CGPDFPageRef)page;
+
++ (CGSize)viewSizeForGeometry:(PDFReaderPageGeometry)geometry;
+
++ (CGRect)viewRectForPageRect:(CGRect)pageRect geometry:(PDFReaderPageGeometry)geometry;
+
++ (NSMutableArray *)linksForPage:(CGPDFPageRef)page geometry:(PDFReaderPageGeometry)geometry;
+
++ (id)linkTargetForAnnotation:(CGPDFDictionaryRef)annotationDictionary document:(CGPDFDocumentRef)document;
+
 - (id)initWithURL:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase;
 
+- (id)initWithURL:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase guid:(NSString *)guid;
+
+- (id)initWithURL:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase guid:(NSString *)guid prefetch:(PDFReaderPagePrefetchEntry *)entry;
+
 - (id)processSingleTap:(UITapGestureRecognizer *)recognizer;
 
+- (void)highlightSearchRects:(NSArray *)rects;
+
+- (void)removeSearchHighlights;
+
 @end
 
 #pragma mark -
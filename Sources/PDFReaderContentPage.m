@@ -25,8 +25,17 @@
 #import "PDFReaderConfig.h"
 #import "PDFReaderContentPage.h"
 #import "PDFReaderContentTile.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderNamedDestinations.h"
+#import "PDFReaderLinkIndex.h"
+#import "PDFReaderPageMetrics.h"
+#import "PDFReaderPagePrefetch.h"
+#import "PDFReaderTileCache.h"
+#import "PDFReaderTrace.h"
 #import "CGPDFDocument.h"
 
+#import "PDFReaderCoreGeometry.h"
+
 @implementation PDFReaderContentPage
 {
 	NSMutableArray *_links;
@@ -35,13 +44,42 @@
 
 	CGPDFPageRef _PDFPageRef;
 
-	NSInteger _pageAngle;
+	PDFReaderPageGeometry _geometry;
+
+	NSInteger _page;
+
+	NSString *_guid;
+
+	PDFReaderLinkIndex *_linkIndex;
+
+	NSMutableArray *_searchHighlights;
+
+	BOOL _drawn;
+}
+
+#pragma mark PDFReaderContentPage functions
+
+static inline PDFReaderCoreRect CoreRect(CGRect rect)
+{
+	return PDFReaderCoreRectMake(rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
+}
+
+static inline PDFReaderCoreGeometry CoreGeometry(PDFReaderPageGeometry geometry)
+{
+	PDFReaderCoreGeometry core; core.angle = geometry.angle;
+
+	core.width = geometry.width; core.height = geometry.height; core.offsetX = geometry.offsetX; core.offsetY = geometry.offsetY;
+
+	return core;
+}
 
-	CGFloat _pageWidth;
-	CGFloat _pageHeight;
+static inline PDFReaderPageGeometry PageGeometry(PDFReaderCoreGeometry core)
+{
+	PDFReaderPageGeometry geometry; geometry.angle = core.angle;
 
-	CGFloat _pageOffsetX;
-	CGFloat _pageOffsetY;
+	geometry.width = core.width; geometry.height = core.height; geometry.offsetX = core.offsetX; geometry.offsetY = core.offsetY;
+
+	return geometry;
 }
 
 #pragma mark PDFReaderContentPage class methods
@@ -51,17 +89,78 @@
 	return [PDFReaderContentTile class];
 }
 
++ (PDFReaderPageGeometry)geometryForPage:(CGPDFPageRef)page
+{
+	CGRect cropBoxRect = CGPDFPageGetBoxRect(page, kCGPDFCropBox);
+	CGRect mediaBoxRect = CGPDFPageGetBoxRect(page, kCGPDFMediaBox);
+
+	PDFReaderCoreGeometry core = PDFReaderCoreGeometryMake(CoreRect(cropBoxRect), CoreRect(mediaBoxRect), CGPDFPageGetRotationAngle(page));
+
+	return PageGeometry(core); // Rotated effective page geometry
+}
+
++ (CGSize)viewSizeForGeometry:(PDFReaderPageGeometry)geometry
+{
+	PDFReaderCoreGeometry core = CoreGeometry(geometry); long page_w = 0; long page_h = 0;
+
+	PDFReaderCoreGeometryViewSize(&core, &page_w, &page_h); // Even integer size
+
+	return CGSizeMake(page_w, page_h); // View size
+}
+
+#pragma mark PDFReaderContentPage search methods
+
+- (void)highlightSearchRects:(NSArray *)rects
+{
+	[self removeSearchHighlights]; // Replace any previous search hits
+
+	if (rects.count > 0) // Add highlight views over all hits
+	{
+		UIColor *hilite = [UIColor colorWithRed:1.0f green:0.9f blue:0.0f alpha:0.35f];
+
+		_searchHighlights = [NSMutableArray arrayWithCapacity:rects.count];
+
+		for (NSValue *rect in rects) // Enumerate the page space hit rects array
+		{
+			CGRect viewRect = [PDFReaderContentPage viewRectForPageRect:[rect CGRectValue] geometry:_geometry];
+
+			UIView *highlight = [[UIView alloc] initWithFrame:CGRectStandardize(viewRect)];
+
+			highlight.autoresizesSubviews = NO;
+			highlight.userInteractionEnabled = NO;
+			highlight.contentMode = UIViewContentModeRedraw;
+			highlight.autoresizingMask = UIViewAutoresizingNone;
+			highlight.backgroundColor = hilite; // Color
+
+			[self addSubview:highlight]; [_searchHighlights addObject:highlight];
+		}
+	}
+}
+
+- (void)removeSearchHighlights
+{
+	for (UIView *highlight in _searchHighlights) [highlight removeFromSuperview];
+
+	_searchHighlights = nil;
+}
+
 #pragma mark PDFReaderContentPage PDF link methods
 
 - (void)highlightPageLinks
 {
-	if (_links.count > 0) // Add highlight views over all links
+	NSMutableArray *rects = [NSMutableArray array]; // Link rects
+
+	for (PDFReaderDocumentLink *link in _links) [rects addObject:[NSValue valueWithCGRect:link.rect]];
+
+	if (_linkIndex != nil) [rects addObjectsFromArray:[_linkIndex linkRectsForPage:_page]];
+
+	if (rects.count > 0) // Add highlight views over all links
 	{
 		UIColor *hilite = [UIColor colorWithRed:0.0f green:0.0f blue:1.0f alpha:0.15f];
 
-		for (PDFReaderDocumentLink *link in _links) // Enumerate the links array
+		for (NSValue *rect in rects) // Enumerate the link rects array
 		{
-			UIView *highlight = [[UIView alloc] initWithFrame:link.rect];
+			UIView *highlight = [[UIView alloc] initWithFrame:[rect CGRectValue]];
 
 			highlight.autoresizesSubviews = NO;
 			highlight.userInteractionEnabled = NO;
@@ -74,7 +173,16 @@
 	}
 }
 
-- (PDFReaderDocumentLink *)linkFromAnnotation:(CGPDFDictionaryRef)annotationDictionary
++ (CGRect)viewRectForPageRect:(CGRect)pageRect geometry:(PDFReaderPageGeometry)geometry
+{
+	PDFReaderCoreGeometry core = CoreGeometry(geometry); // Page space to view space
+
+	PDFReaderCoreRect viewRect = PDFReaderCoreGeometryViewRect(&core, CoreRect(pageRect));
+
+	return CGRectMake(viewRect.x, viewRect.y, viewRect.width, viewRect.height); // View CGRect from PDFRect
+}
+
++ (PDFReaderDocumentLink *)linkFromAnnotation:(CGPDFDictionaryRef)annotationDictionary geometry:(PDFReaderPageGeometry)geometry
 {
 	PDFReaderDocumentLink *documentLink = nil; // Document link object
 
@@ -94,41 +202,9 @@
 		if (ll_x > ur_x) { CGPDFReal t = ll_x; ll_x = ur_x; ur_x = t; } // Normalize Xs
 		if (ll_y > ur_y) { CGPDFReal t = ll_y; ll_y = ur_y; ur_y = t; } // Normalize Ys
 
-		ll_x -= _pageOffsetX; ll_y -= _pageOffsetY; // Offset lower-left co-ordinate
-		ur_x -= _pageOffsetX; ur_y -= _pageOffsetY; // Offset upper-right co-ordinate
-
-		switch (_pageAngle) // Page rotation angle (in degrees)
-		{
-			case 90: // 90 degree page rotation
-			{
-				CGPDFReal swap;
-				swap = ll_y; ll_y = ll_x; ll_x = swap;
-				swap = ur_y; ur_y = ur_x; ur_x = swap;
-				break;
-			}
-
-			case 270: // 270 degree page rotation
-			{
-				CGPDFReal swap;
-				swap = ll_y; ll_y = ll_x; ll_x = swap;
-				swap = ur_y; ur_y = ur_x; ur_x = swap;
-				ll_x = ((0.0f - ll_x) + _pageWidth);
-				ur_x = ((0.0f - ur_x) + _pageWidth);
-				break;
-			}
-
-			case 0: // 0 degree page rotation
-			{
-				ll_y = ((0.0f - ll_y) + _pageHeight);
-				ur_y = ((0.0f - ur_y) + _pageHeight);
-				break;
-			}
-		}
-
-		NSInteger vr_x = ll_x; NSInteger vr_w = (ur_x - ll_x); // Integer X and width
-		NSInteger vr_y = ll_y; NSInteger vr_h = (ur_y - ll_y); // Integer Y and height
+		CGRect pageRect = CGRectMake(ll_x, ll_y, (ur_x - ll_x), (ur_y - ll_y)); // Normalized PDFRect
 
-		CGRect viewRect = CGRectMake(vr_x, vr_y, vr_w, vr_h); // View CGRect from PDFRect
+		CGRect viewRect = [PDFReaderContentPage viewRectForPageRect:pageRect geometry:geometry]; // View CGRect from PDFRect
 
 		documentLink = [PDFReaderDocumentLink newWithRect:viewRect dictionary:annotationDictionary];
 	}
@@ -136,13 +212,13 @@
 	return documentLink;
 }
 
-- (void)buildAnnotationLinksList
++ (NSMutableArray *)linksForPage:(CGPDFPageRef)page geometry:(PDFReaderPageGeometry)geometry
 {
-	_links = [NSMutableArray new]; // Links list array
+	NSMutableArray *links = [NSMutableArray new]; // Links list array
 
 	CGPDFArrayRef pageAnnotations = NULL; // Page annotations array
 
-	CGPDFDictionaryRef pageDictionary = CGPDFPageGetDictionary(_PDFPageRef);
+	CGPDFDictionaryRef pageDictionary = CGPDFPageGetDictionary(page);
 
 	if (CGPDFDictionaryGetArray(pageDictionary, "Annots", &pageAnnotations) == true)
 	{
@@ -160,98 +236,27 @@
 				{
 					if (strcmp(annotationSubtype, "Link") == 0) // Found annotation subtype of 'Link'
 					{
-						PDFReaderDocumentLink *documentLink = [self linkFromAnnotation:annotationDictionary];
+						PDFReaderDocumentLink *documentLink = [self linkFromAnnotation:annotationDictionary geometry:geometry];
 
-						if (documentLink != nil) [_links insertObject:documentLink atIndex:0]; // Add link
+						if (documentLink != nil) [links insertObject:documentLink atIndex:0]; // Add link
 					}
 				}
 			}
 		}
 
-		//[self highlightPageLinks]; // Link support debugging
 	}
+
+	return links;
 }
 
-- (CGPDFArrayRef)destinationWithName:(const char *)destinationName inDestsTree:(CGPDFDictionaryRef)node
+- (void)buildAnnotationLinksList
 {
-	CGPDFArrayRef destinationArray = NULL;
-
-	CGPDFArrayRef limitsArray = NULL; // Limits array
-
-	if (CGPDFDictionaryGetArray(node, "Limits", &limitsArray) == true)
-	{
-		CGPDFStringRef lowerLimit = NULL; CGPDFStringRef upperLimit = NULL;
-
-		if (CGPDFArrayGetString(limitsArray, 0, &lowerLimit) == true) // Lower limit
-		{
-			if (CGPDFArrayGetString(limitsArray, 1, &upperLimit) == true) // Upper limit
-			{
-				const char *ll = (const char *)CGPDFStringGetBytePtr(lowerLimit); // Lower string
-				const char *ul = (const char *)CGPDFStringGetBytePtr(upperLimit); // Upper string
-
-				if ((strcmp(destinationName, ll) < 0) || (strcmp(destinationName, ul) > 0))
-				{
-					return NULL; // Destination name is outside this node's limits
-				}
-			}
-		}
-	}
-
-	CGPDFArrayRef namesArray = NULL; // Names array
-
-	if (CGPDFDictionaryGetArray(node, "Names", &namesArray) == true)
-	{
-		NSInteger namesCount = CGPDFArrayGetCount(namesArray);
-
-		for (NSInteger index = 0; index < namesCount; index += 2)
-		{
-			CGPDFStringRef destName; // Destination name string
-
-			if (CGPDFArrayGetString(namesArray, index, &destName) == true)
-			{
-				const char *dn = (const char *)CGPDFStringGetBytePtr(destName);
-
-				if (strcmp(dn, destinationName) == 0) // Found the destination name
-				{
-					if (CGPDFArrayGetArray(namesArray, (index + 1), &destinationArray) == false)
-					{
-						CGPDFDictionaryRef destinationDictionary = NULL; // Destination dictionary
-
-						if (CGPDFArrayGetDictionary(namesArray, (index + 1), &destinationDictionary) == true)
-						{
-							CGPDFDictionaryGetArray(destinationDictionary, "D", &destinationArray);
-						}
-					}
-
-					return destinationArray; // Return the destination array
-				}
-			}
-		}
-	}
-
-	CGPDFArrayRef kidsArray = NULL; // Kids array
+	_links = [PDFReaderContentPage linksForPage:_PDFPageRef geometry:_geometry];
 
-	if (CGPDFDictionaryGetArray(node, "Kids", &kidsArray) == true)
-	{
-		NSInteger kidsCount = CGPDFArrayGetCount(kidsArray);
-
-		for (NSInteger index = 0; index < kidsCount; index++)
-		{
-			CGPDFDictionaryRef kidNode = NULL; // Kid node dictionary
-
-			if (CGPDFArrayGetDictionary(kidsArray, index, &kidNode) == true) // Recurse into node
-			{
-				destinationArray = [self destinationWithName:destinationName inDestsTree:kidNode];
-
-				if (destinationArray != NULL) return destinationArray; // Return destination array
-			}
-		}
-	}
-
-	return NULL;
+	//[self highlightPageLinks]; // Link support debugging
 }
 
-- (id)annotationLinkTarget:(CGPDFDictionaryRef)annotationDictionary
++ (id)linkTargetForAnnotation:(CGPDFDictionaryRef)annotationDictionary document:(CGPDFDocumentRef)document
 {
 	id linkTarget = nil; // Link target object
 
@@ -269,7 +274,10 @@
 			{
 				if (CGPDFDictionaryGetArray(actionDictionary, "D", &destArray) == false)
 				{
-					CGPDFDictionaryGetString(actionDictionary, "D", &destName);
+					if (CGPDFDictionaryGetString(actionDictionary, "D", &destName) == false)
+					{
+						CGPDFDictionaryGetName(actionDictionary, "D", &destString);
+					}
 				}
 			}
 			else // Handle other link action type possibility
@@ -303,40 +311,14 @@
 		}
 	}
 
-	if (destName != NULL) // Handle a destination name
+	if ((destName != NULL) || (destString != NULL)) // Handle a named destination
 	{
-		CGPDFDictionaryRef catalogDictionary = CGPDFDocumentGetCatalog(_PDFDocRef);
-
-		CGPDFDictionaryRef namesDictionary = NULL; // Destination names in the document
-
-		if (CGPDFDictionaryGetDictionary(catalogDictionary, "Names", &namesDictionary) == true)
-		{
-			CGPDFDictionaryRef destsDictionary = NULL; // Document destinations dictionary
-
-			if (CGPDFDictionaryGetDictionary(namesDictionary, "Dests", &destsDictionary) == true)
-			{
-				const char *destinationName = (const char *)CGPDFStringGetBytePtr(destName); // Name
-
-				destArray = [self destinationWithName:destinationName inDestsTree:destsDictionary];
-			}
-		}
-	}
-
-	if (destString != NULL) // Handle a destination string
-	{
-		CGPDFDictionaryRef catalogDictionary = CGPDFDocumentGetCatalog(_PDFDocRef);
-
-		CGPDFDictionaryRef destsDictionary = NULL; // Document destinations dictionary
-
-		if (CGPDFDictionaryGetDictionary(catalogDictionary, "Dests", &destsDictionary) == true)
-		{
-			CGPDFDictionaryRef targetDictionary = NULL; // Destination target dictionary
+		PDFReaderNamedDestinations *destinations = [PDFReaderNamedDestinations destinationsForDocument:document];
 
-			if (CGPDFDictionaryGetDictionary(destsDictionary, destString, &targetDictionary) == true)
-			{
-				CGPDFDictionaryGetArray(targetDictionary, "D", &destArray);
-			}
-		}
+		if (destName != NULL) // Name tree string
+			destArray = [destinations destinationForString:destName];
+		else // Catalog /Dests name
+			destArray = [destinations destinationForName:destString];
 	}
 
 	if (destArray != NULL) // Handle a destination array
@@ -347,19 +329,9 @@
 
 		if (CGPDFArrayGetDictionary(destArray, 0, &pageDictionaryFromDestArray) == true)
 		{
-			NSInteger pageCount = CGPDFDocumentGetNumberOfPages(_PDFDocRef); // Pages
-
-			for (NSInteger pageNumber = 1; pageNumber <= pageCount; pageNumber++)
-			{
-				CGPDFPageRef pageRef = CGPDFDocumentGetPage(_PDFDocRef, pageNumber);
-
-				CGPDFDictionaryRef pageDictionaryFromPage = CGPDFPageGetDictionary(pageRef);
+			PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance]; // Shared page map
 
-				if (pageDictionaryFromPage == pageDictionaryFromDestArray) // Found it
-				{
-					targetPageNumber = pageNumber; break;
-				}
-			}
+			targetPageNumber = [documentPool pageNumberForPageDictionary:pageDictionaryFromDestArray document:document];
 		}
 		else // Try page number from array possibility
 		{
@@ -380,13 +352,24 @@
 	return linkTarget;
 }
 
+- (id)annotationLinkTarget:(CGPDFDictionaryRef)annotationDictionary
+{
+	return [PDFReaderContentPage linkTargetForAnnotation:annotationDictionary document:_PDFDocRef];
+}
+
 - (id)processSingleTap:(UITapGestureRecognizer *)recognizer
 {
 	id result = nil; // Tap result object
 
 	if (recognizer.state == UIGestureRecognizerStateRecognized)
 	{
-		if (_links.count > 0) // Process the single tap
+		if (_linkIndex != nil) // Grid hit-test in the document link index
+		{
+			CGPoint point = [recognizer locationInView:self];
+
+			[_linkIndex hitTestPage:_page point:point target:&result];
+		}
+		else if (_links.count > 0) // Process the single tap
 		{
 			CGPoint point = [recognizer locationInView:self];
 
@@ -431,12 +414,24 @@
 }
 
 - (id)initWithURL:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase
+{
+	return [self initWithURL:fileURL page:page password:phrase guid:nil];
+}
+
+- (id)initWithURL:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase guid:(NSString *)guid
+{
+	return [self initWithURL:fileURL page:page password:phrase guid:guid prefetch:nil];
+}
+
+- (id)initWithURL:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase guid:(NSString *)guid prefetch:(PDFReaderPagePrefetchEntry *)entry
 {
 	CGRect viewRect = CGRectZero; // View rect
 
 	if (fileURL != nil) // Check for non-nil file URL
 	{
-		_PDFDocRef = CGPDFDocumentCreateX((__bridge CFURLRef)fileURL, phrase);
+		PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+		_PDFDocRef = [documentPool retainDocumentWithURL:fileURL password:phrase guid:guid];
 
 		if (_PDFDocRef != NULL) // Check for non-NULL CGPDFDocumentRef
 		{
@@ -446,50 +441,20 @@
 
 			if (page > pages) page = pages; // Check the upper page bounds
 
-			_PDFPageRef = CGPDFDocumentGetPage(_PDFDocRef, page); // Get page
+			_PDFPageRef = [documentPool retainPage:page withURL:fileURL password:phrase guid:guid]; _page = page; _guid = [guid copy];
 
 			if (_PDFPageRef != NULL) // Check for non-NULL CGPDFPageRef
 			{
-				CGPDFPageRetain(_PDFPageRef); // Retain the PDF page
-
-				CGRect cropBoxRect = CGPDFPageGetBoxRect(_PDFPageRef, kCGPDFCropBox);
-				CGRect mediaBoxRect = CGPDFPageGetBoxRect(_PDFPageRef, kCGPDFMediaBox);
-				CGRect effectiveRect = CGRectIntersection(cropBoxRect, mediaBoxRect);
+				if (entry != nil) // Use the prefetched page geometry
+					_geometry = entry.geometry;
+				else if ([[PDFReaderPageMetrics metricsWithGUID:guid] getGeometry:&_geometry forPage:page] == NO)
+					_geometry = [PDFReaderContentPage geometryForPage:_PDFPageRef];
 
-				_pageAngle = CGPDFPageGetRotationAngle(_PDFPageRef); // Angle
-
-				switch (_pageAngle) // Page rotation angle (in degrees)
-				{
-					default: // Default case
-					case 0: case 180: // 0 and 180 degrees
-					{
-						_pageWidth = effectiveRect.size.width;
-						_pageHeight = effectiveRect.size.height;
-						_pageOffsetX = effectiveRect.origin.x;
-						_pageOffsetY = effectiveRect.origin.y;
-						break;
-					}
-
-					case 90: case 270: // 90 and 270 degrees
-					{
-						_pageWidth = effectiveRect.size.height;
-						_pageHeight = effectiveRect.size.width;
-						_pageOffsetX = effectiveRect.origin.y;
-						_pageOffsetY = effectiveRect.origin.x;
-						break;
-					}
-				}
-
-				NSInteger page_w = _pageWidth; // Integer width
-				NSInteger page_h = _pageHeight; // Integer height
-
-				if (page_w % 2) page_w--; if (page_h % 2) page_h--; // Even
-
-				viewRect.size = CGSizeMake(page_w, page_h); // View size
+				viewRect.size = [PDFReaderContentPage viewSizeForGeometry:_geometry]; // View size
 			}
 			else // Error out with a diagnostic
 			{
-				CGPDFDocumentRelease(_PDFDocRef), _PDFDocRef = NULL;
+				[documentPool releaseDocument:_PDFDocRef], _PDFDocRef = NULL;
 
 				NSAssert(NO, @"CGPDFPageRef == NULL");
 			}
@@ -506,7 +471,14 @@
 
 	id view = [self initWithFrame:viewRect]; // UIView setup
 
-	if (view != nil) [self buildAnnotationLinksList]; // Links
+	PDFReaderLinkIndex *linkIndex = [PDFReaderLinkIndex linkIndexWithGUID:guid]; // Document link index
+
+	if ((view != nil) && (linkIndex.isReady == YES)) // Use the document link index
+		_linkIndex = linkIndex;
+	else if ((view != nil) && (entry.links != nil)) // Use the prefetched links
+		_links = [entry.links mutableCopy];
+	else if (view != nil)
+		[self buildAnnotationLinksList]; // Links
 
 	return view;
 }
@@ -522,9 +494,11 @@
 
 - (void)dealloc
 {
-	CGPDFPageRelease(_PDFPageRef), _PDFPageRef = NULL;
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+	if (_PDFPageRef != NULL) [documentPool releasePage:_PDFPageRef], _PDFPageRef = NULL;
 
-	CGPDFDocumentRelease(_PDFDocRef), _PDFDocRef = NULL;
+	if (_PDFDocRef != NULL) [documentPool releaseDocument:_PDFDocRef], _PDFDocRef = NULL;
 }
 
 - (void)didMoveToWindow
@@ -536,25 +510,98 @@
   }
 }
 
+#pragma mark PDFReaderContentPage tile cache methods
+
+- (CGImageRef)newTileImageForRect:(CGRect)tileRect scale:(CGFloat)scale key:(PDFReaderTileKey)tileKey
+{
+	CGImageRef imageRef = NULL; // Rendered tile
+
+	size_t tile_w = (size_t)lround(tileRect.size.width * scale); size_t tile_h = (size_t)lround(tileRect.size.height * scale);
+
+	if ((tile_w == 0) || (tile_h == 0)) return NULL; // Nothing to render
+
+	CFTimeInterval startTime = CACurrentMediaTime(); // Render timing
+
+	CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB(); // RGB color space
+
+	CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+
+	CGContextRef context = CGBitmapContextCreate(NULL, tile_w, tile_h, 8, 0, rgb, bmi);
+
+	if (context != NULL) // Render the tile into its own bitmap so it can be cached
+	{
+		CGContextScaleCTM(context, scale, scale); CGContextTranslateCTM(context, -tileRect.origin.x, -tileRect.origin.y);
+
+		CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); CGContextFillRect(context, tileRect); // White
+
+		CGContextConcatCTM(context, CGPDFPageGetDrawingTransform(_PDFPageRef, kCGPDFCropBox, self.bounds, 0, true));
+
+		CGContextDrawPDFPage(context, _PDFPageRef); // Render the PDF page into the tile bitmap
+
+		imageRef = CGBitmapContextCreateImage(context); CGContextRelease(context);
+	}
+
+	CGColorSpaceRelease(rgb); // Release the color space
+
+	if (imageRef != NULL) // Fill the cache
+	{
+		[[PDFReaderTileCache sharedInstance] storeTile:imageRef forGUID:_guid key:tileKey renderTime:(CACurrentMediaTime() - startTime)];
+	}
+
+	return imageRef;
+}
+
 #pragma mark CATiledLayer delegate methods
 
 - (void)drawLayer:(CATiledLayer *)layer inContext:(CGContextRef)context
 {
 	PDFReaderContentPage *readerContentPage = self; // Retain self
 
-	CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); // White
+	uint64_t traceStart = PDFReaderTraceBegin(PDFReaderCoreTracePageDraw, _guid, _page);
+
+	CGRect clipRect = CGContextGetClipBoundingBox(context); // Tile rect (in view points)
 
-	CGContextFillRect(context, CGContextGetClipBoundingBox(context)); // Fill
+	CGFloat scale = fabs(CGContextGetCTM(context).a); // Tile pixels per view point
 
-	//NSLog(@"%s %@", __FUNCTION__, NSStringFromCGRect(CGContextGetClipBoundingBox(context)));
+	PDFReaderTileKey tileKey; BOOL cached = NO; // Rendered tile cache key
+
+	if (_guid != nil) cached = [PDFReaderTileCache tileKey:&tileKey forPage:_page clipRect:clipRect scale:scale tileSize:layer.tileSize];
+
+	//NSLog(@"%s %@", __FUNCTION__, NSStringFromCGRect(clipRect));
 
 	CGContextTranslateCTM(context, 0.0f, self.bounds.size.height); CGContextScaleCTM(context, 1.0f, -1.0f);
 
-	CGContextConcatCTM(context, CGPDFPageGetDrawingTransform(_PDFPageRef, kCGPDFCropBox, self.bounds, 0, true));
+	CGRect tileRect = CGRectMake(clipRect.origin.x, (self.bounds.size.height - CGRectGetMaxY(clipRect)), clipRect.size.width, clipRect.size.height);
+
+	CGImageRef imageRef = NULL; // Cached (or freshly rendered and cached) tile
+
+	if (cached == YES) // Blit from the tile cache or fill it
+	{
+		imageRef = [[PDFReaderTileCache sharedInstance] newTileForGUID:_guid key:tileKey];
+
+		if (imageRef == NULL) imageRef = [self newTileImageForRect:tileRect scale:scale key:tileKey];
+	}
+
+	if (imageRef != NULL) // Draw the tile pixels 1:1
+	{
+		CGContextDrawImage(context, tileRect, imageRef); CGImageRelease(imageRef);
+	}
+	else // Render straight into the layer
+	{
+		CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); // White
+
+		CGContextFillRect(context, tileRect); // Fill
+
+		CGContextConcatCTM(context, CGPDFPageGetDrawingTransform(_PDFPageRef, kCGPDFCropBox, self.bounds, 0, true));
+
+		//CGContextSetRenderingIntent(context, kCGRenderingIntentDefault); CGContextSetInterpolationQuality(context, kCGInterpolationDefault);
+
+		CGContextDrawPDFPage(context, _PDFPageRef); // Render the PDF page into the context
+	}
 
-	//CGContextSetRenderingIntent(context, kCGRenderingIntentDefault); CGContextSetInterpolationQuality(context, kCGInterpolationDefault);
+	if (_drawn == NO) { _drawn = YES; [PDFReaderPagePrefetch markFirstPixelForPage:_page]; } // First tile
 
-	CGContextDrawPDFPage(context, _PDFPageRef); // Render the PDF page into the context
+	PDFReaderTraceEnd(PDFReaderCoreTracePageDraw, _guid, _page, traceStart, 0);
 
 	if (readerContentPage != nil) readerContentPage = nil; // Release self
 }
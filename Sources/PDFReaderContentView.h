@@ -29,6 +29,7 @@
 @class PDFReaderContentView;
 @class PDFReaderContentPage;
 @class PDFReaderContentThumb;
+@class PDFReaderPagePrefetchEntry;
 
 @protocol PDFReaderContentViewDelegate <NSObject>
 
@@ -44,8 +45,16 @@
 
 - (id)initWithFrame:(CGRect)frame fileURL:(NSURL *)fileURL page:(NSUInteger)page password:(NSString *)phrase;
 
+- (id)initWithFrame:(CGRect)frame fileURL:(NSURL *)fileURL page:(NSUInteger)page password:(NSString *)phrase guid:(NSString *)guid;
+
+- (id)initWithFrame:(CGRect)frame fileURL:(NSURL *)fileURL page:(NSUInteger)page password:(NSString *)phrase guid:(NSString *)guid prefetch:(PDFReaderPagePrefetchEntry *)entry;
+
 - (void)showPageThumb:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase guid:(NSString *)guid;
 
+- (BOOL)needsPreviewRender;
+
+- (void)showPreviewImage:(UIImage *)image;
+
 - (id)processSingleTap:(UITapGestureRecognizer *)recognizer;
 
 - (void)zoomIncrement;
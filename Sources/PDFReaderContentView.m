@@ -26,6 +26,7 @@
 #import "PDFReaderContentView.h"
 #import "PDFReaderContentPage.h"
 #import "PDFReaderThumbCache.h"
+#import "PDFReaderPagePrefetch.h"
 
 #import <QuartzCore/QuartzCore.h>
 
@@ -44,6 +45,8 @@
 	PDFReaderContentThumb *theThumbView;
 
 	UIView *theContainerView;
+
+	BOOL havePreview;
 }
 
 static void *PDFReaderContentViewContext = &PDFReaderContentViewContext;
@@ -84,6 +87,16 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
 }
 
 - (id)initWithFrame:(CGRect)frame fileURL:(NSURL *)fileURL page:(NSUInteger)page password:(NSString *)phrase
+{
+	return [self initWithFrame:frame fileURL:fileURL page:page password:phrase guid:nil];
+}
+
+- (id)initWithFrame:(CGRect)frame fileURL:(NSURL *)fileURL page:(NSUInteger)page password:(NSString *)phrase guid:(NSString *)guid
+{
+	return [self initWithFrame:frame fileURL:fileURL page:page password:phrase guid:guid prefetch:nil];
+}
+
+- (id)initWithFrame:(CGRect)frame fileURL:(NSURL *)fileURL page:(NSUInteger)page password:(NSString *)phrase guid:(NSString *)guid prefetch:(PDFReaderPagePrefetchEntry *)entry
 {
 	if ((self = [super initWithFrame:frame]))
 	{
@@ -114,7 +127,7 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
     _pageThumbLarge = 240;
     _pageThumbSmall = 144;
 
-		theContentView = [[PDFReaderContentPage alloc] initWithURL:fileURL page:page password:phrase];
+		theContentView = [[PDFReaderContentPage alloc] initWithURL:fileURL page:page password:phrase guid:guid prefetch:entry];
 
 		if (theContentView != nil) // Must have a valid and initialized content view
 		{
@@ -142,6 +155,13 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
         theThumbView = [[PDFReaderContentThumb alloc] initWithFrame:theContentView.bounds]; // Page thumb view
 
         [theContainerView addSubview:theThumbView]; // Add the thumb view to the container view
+
+        theThumbView.tag = page; // Tag the thumb view with the page number
+
+        if (entry.image != nil) // Show the prefetched screen resolution render
+        {
+          [theThumbView showImage:entry.image]; havePreview = YES;
+        }
       } // previewThumbEnabled
 
 			[theContainerView addSubview:theContentView]; // Add the content view to the container view
@@ -166,9 +186,16 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
 	[self removeObserver:self forKeyPath:@"frame" context:PDFReaderContentViewContext];
 }
 
+- (void)removeFromSuperview
+{
+	[theThumbView reuse]; // Cancel a preview thumb that is still queued or rendering
+
+	[super removeFromSuperview];
+}
+
 - (void)showPageThumb:(NSURL *)fileURL page:(NSInteger)page password:(NSString *)phrase guid:(NSString *)guid
 {
-  if([PDFReaderConfig sharedConfig].previewThumbEnabled)
+  if([PDFReaderConfig sharedConfig].previewThumbEnabled && (havePreview == NO))
   {
     BOOL large = ([UIDevice currentDevice].userInterfaceIdiom == UIUserInterfaceIdiomPad); // Page thumb size
 
@@ -176,12 +203,31 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
 
     PDFReaderThumbRequest *request = [PDFReaderThumbRequest newForView:theThumbView fileURL:fileURL password:phrase guid:guid page:page size:size];
 
-    UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:request priority:YES]; // Request the page thumb
+    UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:request priorityClass:PDFReaderThumbPriorityVisible]; // Request the page thumb
 
     if ([image isKindOfClass:[UIImage class]]) [theThumbView showImage:image]; // Show image from cache
+
+    else if ([PDFReaderConfig sharedConfig].progressiveDisplayEnabled) // Any resident thumb will do for now
+    {
+      image = [[PDFReaderThumbCache sharedInstance] bestImageForPage:page guid:guid];
+
+      if (image != nil) [theThumbView showImage:image]; // Low resolution placeholder
+    }
   }
 }
 
+- (BOOL)needsPreviewRender
+{
+  PDFReaderConfig *readerConfig = [PDFReaderConfig sharedConfig];
+
+  return (readerConfig.previewThumbEnabled && readerConfig.progressiveDisplayEnabled && (havePreview == NO));
+}
+
+- (void)showPreviewImage:(UIImage *)image
+{
+  if (image != nil) { [theThumbView showImage:image]; havePreview = YES; }
+}
+
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
 {
 	if (context == PDFReaderContentViewContext) // Our context
@@ -321,6 +367,9 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
 //
 
 @implementation PDFReaderContentThumb
+{
+	CGFloat shownPixels;
+}
 
 #pragma mark PDFReaderContentThumb instance methods
 
@@ -336,4 +385,13 @@ static inline CGFloat ZoomScaleThatFits(CGSize target, CGSize source)
 	return self;
 }
 
+- (void)showImage:(UIImage *)image
+{
+	CGFloat pixels = (image.size.width * image.size.height * image.scale * image.scale);
+
+	if ((image != nil) && (pixels <= shownPixels)) return; // Never replace a sharper preview
+
+	[super showImage:image]; shownPixels = pixels; // Show it
+}
+
 @end
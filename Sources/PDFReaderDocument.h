@@ -24,6 +24,9 @@
 
 #import <Foundation/Foundation.h>
 
+@class PDFReaderPageMetrics;
+@class PDFReaderDocumentRecord;
+
 @interface PDFReaderDocument : NSObject <NSObject, NSCoding>
 
 @property (nonatomic, strong, readonly) NSString *guid;
@@ -36,15 +39,24 @@
 @property (nonatomic, strong, readonly) NSString *fileName;
 @property (nonatomic, strong, readonly) NSString *password;
 @property (nonatomic, strong, readonly) NSURL *fileURL;
+@property (nonatomic, strong, readonly) PDFReaderPageMetrics *pageMetrics;
+
++ (NSString *)GUID;
+
++ (NSString *)relativeFilePath:(NSString *)fullFilePath;
 
 + (PDFReaderDocument *)withDocumentFilePath:(NSString *)filename password:(NSString *)phrase;
 
 + (PDFReaderDocument *)unarchiveFromFileName:(NSString *)filename password:(NSString *)phrase;
 
++ (PDFReaderDocumentRecord *)importArchiveForFilePath:(NSString *)filePath;
+
 - (id)initWithFilePath:(NSString *)fullFilePath password:(NSString *)phrase;
 
 - (void)saveReaderDocument;
 
 - (void)updateProperties;
 
+- (void)releaseOpenHandle;
+
 @end
@@ -23,9 +23,21 @@
 //
 
 #import "PDFReaderDocument.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderDocumentStore.h"
+#import "PDFReaderPageMetrics.h"
+#import "PDFReaderOpenTimer.h"
 #import "CGPDFDocument.h"
 #import <fcntl.h>
 
+@interface PDFReaderDocument ()
+
+- (id)initWithRecord:(PDFReaderDocumentRecord *)record;
+
+- (PDFReaderDocumentRecord *)record;
+
+@end
+
 @implementation PDFReaderDocument
 {
 	NSString *_guid;
@@ -47,6 +59,8 @@
 	NSString *_password;
 
 	NSURL *_fileURL;
+
+	CGPDFDocumentRef _openDocRef; // Pooled handle held from open until the first page is shown
 }
 
 #pragma mark Properties
@@ -59,7 +73,7 @@
 @synthesize bookmarks = _bookmarks;
 @synthesize lastOpen = _lastOpen;
 @synthesize password = _password;
-@dynamic fileName, fileURL;
+@dynamic fileName, fileURL, pageMetrics;
 
 #pragma mark PDFReaderDocument class methods
 
@@ -125,22 +139,17 @@
 	return [archivePath stringByAppendingPathComponent:archiveName]; // "{archivePath}/'filename'.plist"
 }
 
-+ (PDFReaderDocument *)unarchiveFromFileName:(NSString *)filename password:(NSString *)phrase
++ (PDFReaderDocumentRecord *)importArchiveForFilePath:(NSString *)filePath
 {
-	PDFReaderDocument *document = nil; // PDFReaderDocument object
+	PDFReaderDocument *document = nil; // Legacy PDFReaderDocument object
 
-	NSString *withName = [filename lastPathComponent]; // File name only
+	NSString *archiveFilePath = [PDFReaderDocument archiveFilePath:[filePath lastPathComponent]]; // Keyed by file name
 
-	NSString *archiveFilePath = [PDFReaderDocument archiveFilePath:withName];
+	if ([[NSFileManager new] fileExistsAtPath:archiveFilePath] == NO) return nil; // Nothing to migrate
 
 	@try // Unarchive an archived PDFReaderDocument object from its property list
 	{
 		document = [NSKeyedUnarchiver unarchiveObjectWithFile:archiveFilePath];
-
-		if ((document != nil) && (phrase != nil)) // Set the document password
-		{
-			[document setValue:[phrase copy] forKey:@"password"];
-		}
 	}
 	@catch (NSException *exception) // Exception handling (just in case O_o)
 	{
@@ -149,6 +158,45 @@
 		#endif
 	}
 
+	if ([document isKindOfClass:[PDFReaderDocument class]] == NO) return nil; // Not a document archive
+
+	PDFReaderDocumentStore *documentStore = [PDFReaderDocumentStore sharedInstance];
+
+	PDFReaderDocumentRecord *record = [document record]; // Keeps its GUID, bookmarks and last page
+
+	NSString *archivedPath = record.fileName; // Relative path (or bare name) the plist was written for
+
+	if ((archivedPath != nil) && ([archivedPath isEqualToString:filePath] == NO) && ([archivedPath isEqualToString:[filePath lastPathComponent]] == NO)) return nil; // Same name in another folder
+
+	record.fileName = filePath; // Stored under the file's relative path
+
+	[documentStore saveRecord:record]; [documentStore flush]; // Move it into the store
+
+	[[NSFileManager new] removeItemAtPath:archiveFilePath error:NULL]; // And remove the property list
+
+	return record;
+}
+
++ (PDFReaderDocument *)unarchiveFromFileName:(NSString *)filename password:(NSString *)phrase
+{
+	PDFReaderDocument *document = nil; // PDFReaderDocument object
+
+	NSString *filePath = [PDFReaderDocument relativeFilePath:filename]; // Store key
+
+	PDFReaderDocumentRecord *record = [[PDFReaderDocumentStore sharedInstance] recordForFileName:filePath];
+
+	if (record == nil) record = [PDFReaderDocument importArchiveForFilePath:filePath]; // Legacy property list
+
+	if (record != nil) // Found in the metadata store
+	{
+		document = [[PDFReaderDocument alloc] initWithRecord:record];
+	}
+
+	if ((document != nil) && (phrase != nil)) // Set the document password
+	{
+		[document setValue:[phrase copy] forKey:@"password"];
+	}
+
 	return document;
 }
 
@@ -156,8 +204,12 @@
 {
 	PDFReaderDocument *document = nil; // PDFReaderDocument object
 
+	[PDFReaderOpenTimer beginOpen]; // Time the open from here to the first rendered pixel
+
 	document = [PDFReaderDocument unarchiveFromFileName:filePath password:phrase];
 
+	[PDFReaderOpenTimer markPhase:@"unarchive"];
+
 	if (document == nil) // Unarchive failed so we create a new PDFReaderDocument object
 	{
 		document = [[PDFReaderDocument alloc] initWithFilePath:filePath password:phrase];
@@ -197,11 +249,23 @@
 {
 	id object = nil; // PDFReaderDocument object
 
-	if ([PDFReaderDocument isPDF:fullFilePath] == YES) // File must exist
+	NSURL *fileURL = ((fullFilePath != nil) ? [[NSURL alloc] initFileURLWithPath:fullFilePath isDirectory:NO] : nil);
+
+	NSString *guid = [PDFReaderDocument GUID]; // Create a document GUID
+
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance]; // Open and parse once
+
+	CGPDFDocumentRef thePDFDocRef = [documentPool retainDocumentWithURL:fileURL password:phrase guid:guid];
+
+	[PDFReaderOpenTimer markPhase:@"parse"];
+
+	if ((thePDFDocRef != NULL) || ([PDFReaderDocument isPDF:fullFilePath] == YES)) // File must be a PDF
 	{
 		if ((self = [super init])) // Initialize superclass object first
 		{
-			_guid = [PDFReaderDocument GUID]; // Create a document GUID
+			_guid = guid; _fileURL = fileURL; // Document identity
+
+			_fileName = [PDFReaderDocument relativeFilePath:fullFilePath]; // File name
 
 			_password = [phrase copy]; // Keep copy of any document password
 
@@ -209,19 +273,13 @@
 
 			_pageNumber = [NSNumber numberWithInteger:1]; // Start on page 1
 
-			_fileName = [PDFReaderDocument relativeFilePath:fullFilePath]; // File name
-
-			CFURLRef docURLRef = (__bridge CFURLRef)[self fileURL]; // CFURLRef from NSURL
-
-			CGPDFDocumentRef thePDFDocRef = CGPDFDocumentCreateX(docURLRef, _password);
-
 			if (thePDFDocRef != NULL) // Get the number of pages in the document
 			{
 				NSInteger pageCount = CGPDFDocumentGetNumberOfPages(thePDFDocRef);
 
 				_pageCount = [NSNumber numberWithInteger:pageCount];
 
-				CGPDFDocumentRelease(thePDFDocRef); // Cleanup
+				_openDocRef = thePDFDocRef; thePDFDocRef = NULL; // Handed on to the first page view
 			}
 			else // Cupertino, we have a problem with the document
 			{
@@ -240,13 +298,43 @@
 
 			[self saveReaderDocument]; // Save the PDFReaderDocument object
 
+			[PDFReaderOpenTimer markPhase:@"archive"];
+
 			object = self; // Return initialized PDFReaderDocument object
 		}
 	}
 
+	if (thePDFDocRef != NULL) [documentPool releaseDocument:thePDFDocRef]; // Not a usable document
+
 	return object;
 }
 
+- (id)initWithRecord:(PDFReaderDocumentRecord *)record
+{
+	if ((self = [super init])) // Initialize superclass object first
+	{
+		_guid = record.guid; _fileName = record.fileName; // Document identity
+
+		_fileDate = record.fileDate; _fileSize = record.fileSize; // File identity
+
+		_pageCount = record.pageCount; _pageNumber = record.pageNumber; _lastOpen = record.lastOpen;
+
+		_bookmarks = ((record.bookmarks != nil) ? [record.bookmarks mutableCopy] : [NSMutableIndexSet new]);
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self releaseOpenHandle];
+}
+
+- (void)releaseOpenHandle
+{
+	if (_openDocRef != NULL) [[PDFReaderDocumentPool sharedInstance] releaseDocument:_openDocRef], _openDocRef = NULL;
+}
+
 - (NSString *)fileName
 {
 	return [_fileName lastPathComponent];
@@ -264,23 +352,49 @@
 	return _fileURL;
 }
 
-- (BOOL)archiveWithFileName:(NSString *)filename
+- (PDFReaderPageMetrics *)pageMetrics
+{
+	PDFReaderPageMetrics *pageMetrics = [PDFReaderPageMetrics metricsWithGUID:_guid];
+
+	[pageMetrics buildWithURL:self.fileURL password:_password]; // Load or compute once
+
+	return pageMetrics;
+}
+
+- (void)setPageNumber:(NSNumber *)pageNumber
+{
+	if ([_pageNumber isEqual:pageNumber] == NO) // Changed
+	{
+		_pageNumber = pageNumber; [self saveReaderDocument]; // Coalesced by the store
+	}
+}
+
+- (void)setLastOpen:(NSDate *)lastOpen
+{
+	_lastOpen = lastOpen; [self saveReaderDocument]; // Coalesced by the store
+}
+
+- (PDFReaderDocumentRecord *)record
 {
-	NSString *archiveFilePath = [PDFReaderDocument archiveFilePath:filename];
+	PDFReaderDocumentRecord *record = [PDFReaderDocumentRecord new]; // Snapshot
+
+	record.guid = _guid; record.fileName = _fileName; record.fileDate = _fileDate; record.fileSize = _fileSize;
+
+	record.pageCount = _pageCount; record.pageNumber = _pageNumber; record.lastOpen = _lastOpen; record.bookmarks = [_bookmarks copy];
 
-	return [NSKeyedArchiver archiveRootObject:self toFile:archiveFilePath];
+	return record;
 }
 
 - (void)saveReaderDocument
 {
-	[self archiveWithFileName:[self fileName]];
+	[[PDFReaderDocumentStore sharedInstance] saveRecord:[self record]];
 }
 
 - (void)updateProperties
 {
-	CFURLRef docURLRef = (__bridge CFURLRef)self.fileURL; // File URL
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
 
-	CGPDFDocumentRef thePDFDocRef = CGPDFDocumentCreateWithURL(docURLRef);
+	CGPDFDocumentRef thePDFDocRef = [documentPool retainDocumentWithURL:self.fileURL password:_password guid:_guid];
 
 	if (thePDFDocRef != NULL) // Get the number of pages in the document
 	{
@@ -288,9 +402,14 @@
 
 		_pageCount = [NSNumber numberWithInteger:pageCount];
 
-		CGPDFDocumentRelease(thePDFDocRef); // Cleanup
+		if (_openDocRef == NULL) // Hold the parsed handle for the first page view
+			_openDocRef = thePDFDocRef;
+		else
+			[documentPool releaseDocument:thePDFDocRef]; // Cleanup
 	}
 
+	[PDFReaderOpenTimer markPhase:@"properties"];
+
 	NSString *fullFilePath = [self.fileURL path]; // Full file path
 
 	NSFileManager *fileManager = [NSFileManager new]; // File manager instance
@@ -28,6 +28,10 @@
 
 + (NSArray *)outlineFromFileURL:(NSURL *)fileURL password:(NSString *)phrase;
 
++ (NSArray *)outlineFromFileURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid;
+
++ (NSArray *)lazyOutlineFromFileURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid;
+
 + (void)logDocumentOutlineArray:(NSArray *)array;
 
 @end
@@ -42,5 +46,6 @@
 @property (nonatomic, strong, readwrite) NSMutableArray *children;
 @property (nonatomic, strong, readonly) NSString *title;
 @property (nonatomic, strong, readonly) id target;
+@property (nonatomic, assign, readonly) BOOL hasChildren;
 
 @end
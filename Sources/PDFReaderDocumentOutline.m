@@ -23,7 +23,47 @@
 //
 
 #import "PDFReaderDocumentOutline.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderNamedDestinations.h"
+#import "PDFReaderCacheFile.h"
 #import "CGPDFDocument.h"
+#import "PDFReaderCoreStructure.h"
+
+//
+//	PDFReaderOutlineSource class interface
+//
+
+@interface PDFReaderOutlineSource : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) CGPDFDocumentRef document;
+
+- (id)initWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid;
+
+@end
+
+@interface PDFReaderDocumentOutline ()
+
++ (id)outlineEntryTarget:(CGPDFDictionaryRef)outlineDictionary document:(CGPDFDocumentRef)document;
+
++ (NSMutableArray *)lazyItems:(CGPDFDictionaryRef)outlineDictionary source:(PDFReaderOutlineSource *)source level:(NSInteger)level;
+
+@end
+
+@interface DocumentOutlineEntry ()
+
+@property (nonatomic, assign, readwrite) NSInteger level;
+@property (nonatomic, strong, readwrite) NSString *title;
+@property (nonatomic, strong, readwrite) id target;
+
+- (id)initWithTitle:(NSString *)title level:(NSInteger)level source:(PDFReaderOutlineSource *)source dictionary:(CGPDFDictionaryRef)dictionary;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderDocumentOutline class implementation
+//
 
 @implementation PDFReaderDocumentOutline
 
@@ -31,6 +71,24 @@
 
 #define HIERARCHICAL_OUTLINE TRUE
 
+#pragma mark Constants
+
+#define CACHE_MAGIC 0x4F545250
+#define CACHE_VERSION 1
+#define CACHE_FILE_NAME @"outline.cache"
+
+#define OUTLINE_DEPTH 64
+
+#define TARGET_NONE 0
+#define TARGET_PAGE 1
+#define TARGET_URL 2
+
+typedef struct
+{
+	uint16_t level; uint8_t type; uint8_t reserved; // Entry level and target type
+	uint32_t value; uint32_t titleLength; // Page number (or URL byte count) and title byte count
+} PDFReaderOutlineCacheRecord;
+
 #pragma mark PDFReaderDocumentOutline functions
 
 void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
@@ -104,97 +162,78 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 	}
 }
 
-#pragma mark PDFReaderDocumentOutline class methods
-
-+ (void)logDocumentOutlineArray:(NSArray *)array
+static NSString *OutlineTitle(const uint8_t *bytes, size_t length)
 {
-	for (DocumentOutlineEntry *item in array) // Enumerate array entries
-	{
-		NSInteger indent = (item.level * 2); // Indent amount for NSLog output
+	size_t size = PDFReaderCoreTextStringToUTF8(bytes, length, NULL, 0); // UTF-8 title length
 
-		NSLog(@"%@%@", [@"" stringByPaddingToLength:indent withString:@" " startingAtIndex:0], item);
+	NSMutableData *utf8 = [NSMutableData dataWithLength:(size + 1)]; // Plus NUL
 
-		[self logDocumentOutlineArray:item.children]; // Log any child entries
-	}
+	PDFReaderCoreTextStringToUTF8(bytes, length, utf8.mutableBytes, utf8.length);
+
+	NSString *title = [[NSString alloc] initWithBytes:utf8.bytes length:size encoding:NSUTF8StringEncoding];
+
+	return [title stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]; // Nil when not UTF-8
 }
 
-+ (CGPDFArrayRef)destinationWithName:(const char *)destinationName inDestsTree:(CGPDFDictionaryRef)node
+static void OutlineCacheAppend(NSMutableData *data, NSInteger level, NSString *title, id target)
 {
-	CGPDFArrayRef destinationArray = NULL;
+	NSData *titleData = [title dataUsingEncoding:NSUTF8StringEncoding]; NSData *url = nil; // Entry bytes
 
-	CGPDFArrayRef limitsArray = NULL; // Limits array
+	PDFReaderOutlineCacheRecord record = { (uint16_t)level, TARGET_NONE, 0, 0, (uint32_t)titleData.length };
 
-	if (CGPDFDictionaryGetArray(node, "Limits", &limitsArray) == true)
+	if ([target isKindOfClass:[NSNumber class]]) // Page number
 	{
-		CGPDFStringRef lowerLimit = NULL; CGPDFStringRef upperLimit = NULL;
-
-		if (CGPDFArrayGetString(limitsArray, 0, &lowerLimit) == true) // Lower limit
-		{
-			if (CGPDFArrayGetString(limitsArray, 1, &upperLimit) == true) // Upper limit
-			{
-				const char *ll = (const char *)CGPDFStringGetBytePtr(lowerLimit); // Lower string
-				const char *ul = (const char *)CGPDFStringGetBytePtr(upperLimit); // Upper string
-
-				if ((strcmp(destinationName, ll) < 0) || (strcmp(destinationName, ul) > 0))
-				{
-					return NULL; // Destination name is outside this node's limits
-				}
-			}
-		}
+		record.type = TARGET_PAGE; record.value = [target unsignedIntValue];
 	}
+	else if ([target isKindOfClass:[NSURL class]]) // URL bytes follow the title
+	{
+		url = [[target absoluteString] dataUsingEncoding:NSUTF8StringEncoding];
 
-	CGPDFArrayRef namesArray = NULL; // Names array
+		record.type = TARGET_URL; record.value = (uint32_t)url.length;
+	}
 
-	if (CGPDFDictionaryGetArray(node, "Names", &namesArray) == true)
-	{
-		NSInteger namesCount = CGPDFArrayGetCount(namesArray);
+	[data appendBytes:&record length:sizeof(record)]; [data appendData:titleData]; if (url != nil) [data appendData:url];
+}
 
-		for (NSInteger index = 0; index < namesCount; index += 2)
-		{
-			CGPDFStringRef destName; // Destination name string
+static int OutlineCacheAppendItem(const PDFReaderCoreOutlineItem *item, void *context)
+{
+	NSMutableData *data = (__bridge NSMutableData *)context; // Cache file contents
 
-			if (CGPDFArrayGetString(namesArray, index, &destName) == true)
-			{
-				const char *dn = (const char *)CGPDFStringGetBytePtr(destName);
+	@autoreleasepool
+	{
+		NSString *trimmed = OutlineTitle(item->title, item->titleLength); if (trimmed == nil) trimmed = @""; // Same decoder as lazy titles
 
-				if (strcmp(dn, destinationName) == 0) // Found the destination name
-				{
-					if (CGPDFArrayGetArray(namesArray, (index + 1), &destinationArray) == false)
-					{
-						CGPDFDictionaryRef destinationDictionary = NULL; // Destination dictionary
+		id entryTarget = nil; // Entry target object
 
-						if (CGPDFArrayGetDictionary(namesArray, (index + 1), &destinationDictionary) == true)
-						{
-							CGPDFDictionaryGetArray(destinationDictionary, "D", &destinationArray);
-						}
-					}
+		if (item->target == PDFReaderCoreOutlineTargetPage) // Page number
+		{
+			entryTarget = [NSNumber numberWithInteger:item->page];
+		}
+		else if (item->target == PDFReaderCoreOutlineTargetURI) // URL
+		{
+			NSString *uri = [[NSString alloc] initWithBytes:item->uri length:item->uriLength encoding:NSASCIIStringEncoding];
 
-					return destinationArray; // Return the destination array
-				}
-			}
+			if (uri != nil) entryTarget = [NSURL URLWithString:uri];
 		}
+
+		OutlineCacheAppend(data, item->level, trimmed, entryTarget);
 	}
 
-	CGPDFArrayRef kidsArray = NULL; // Kids array
+	return 1;
+}
 
-	if (CGPDFDictionaryGetArray(node, "Kids", &kidsArray) == true)
-	{
-		NSInteger kidsCount = CGPDFArrayGetCount(kidsArray);
+#pragma mark PDFReaderDocumentOutline class methods
 
-		for (NSInteger index = 0; index < kidsCount; index++)
-		{
-			CGPDFDictionaryRef kidNode = NULL; // Kid node dictionary
++ (void)logDocumentOutlineArray:(NSArray *)array
+{
+	for (DocumentOutlineEntry *item in array) // Enumerate array entries
+	{
+		NSInteger indent = (item.level * 2); // Indent amount for NSLog output
 
-			if (CGPDFArrayGetDictionary(kidsArray, index, &kidNode) == true) // Recurse into node
-			{
-				destinationArray = [self destinationWithName:destinationName inDestsTree:kidNode];
+		NSLog(@"%@%@", [@"" stringByPaddingToLength:indent withString:@" " startingAtIndex:0], item);
 
-				if (destinationArray != NULL) return destinationArray; // Return destination array
-			}
-		}
+		[self logDocumentOutlineArray:item.children]; // Log any child entries
 	}
-
-	return NULL;
 }
 
 + (id)outlineEntryTarget:(CGPDFDictionaryRef)outlineDictionary document:(CGPDFDocumentRef)document
@@ -215,7 +254,10 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 			{
 				if (CGPDFDictionaryGetArray(actionDictionary, "D", &destArray) == false)
 				{
-					CGPDFDictionaryGetString(actionDictionary, "D", &destName);
+					if (CGPDFDictionaryGetString(actionDictionary, "D", &destName) == false)
+					{
+						CGPDFDictionaryGetName(actionDictionary, "D", &destString);
+					}
 				}
 			}
 			else // Handle other entry action type possibility
@@ -245,40 +287,14 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 		}
 	}
 
-	if (destName != NULL) // Handle a destination name
-	{
-		CGPDFDictionaryRef catalogDictionary = CGPDFDocumentGetCatalog(document);
-
-		CGPDFDictionaryRef namesDictionary = NULL; // Destination names in the document
-
-		if (CGPDFDictionaryGetDictionary(catalogDictionary, "Names", &namesDictionary) == true)
-		{
-			CGPDFDictionaryRef destsDictionary = NULL; // Document destinations dictionary
-
-			if (CGPDFDictionaryGetDictionary(namesDictionary, "Dests", &destsDictionary) == true)
-			{
-				const char *destinationName = (const char *)CGPDFStringGetBytePtr(destName); // Name
-
-				destArray = [self destinationWithName:destinationName inDestsTree:destsDictionary];
-			}
-		}
-	}
-
-	if (destString != NULL) // Handle a destination string
+	if ((destName != NULL) || (destString != NULL)) // Handle a named destination
 	{
-		CGPDFDictionaryRef catalogDictionary = CGPDFDocumentGetCatalog(document);
-
-		CGPDFDictionaryRef destsDictionary = NULL; // Document destinations dictionary
+		PDFReaderNamedDestinations *destinations = [PDFReaderNamedDestinations destinationsForDocument:document];
 
-		if (CGPDFDictionaryGetDictionary(catalogDictionary, "Dests", &destsDictionary) == true)
-		{
-			CGPDFDictionaryRef targetDictionary = NULL; // Destination target dictionary
-
-			if (CGPDFDictionaryGetDictionary(destsDictionary, destString, &targetDictionary) == true)
-			{
-				CGPDFDictionaryGetArray(targetDictionary, "D", &destArray);
-			}
-		}
+		if (destName != NULL) // Name tree string
+			destArray = [destinations destinationForString:destName];
+		else // Catalog /Dests name
+			destArray = [destinations destinationForName:destString];
 	}
 
 	if (destArray != NULL) // Handle a destination array
@@ -289,19 +305,9 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 
 		if (CGPDFArrayGetDictionary(destArray, 0, &pageDictionaryFromDestArray) == true)
 		{
-			NSInteger pageCount = CGPDFDocumentGetNumberOfPages(document); // Pages
-
-			for (NSInteger pageNumber = 1; pageNumber <= pageCount; pageNumber++)
-			{
-				CGPDFPageRef pageRef = CGPDFDocumentGetPage(document, pageNumber);
-
-				CGPDFDictionaryRef pageDictionaryFromPage = CGPDFPageGetDictionary(pageRef);
+			PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance]; // Shared page map
 
-				if (pageDictionaryFromPage == pageDictionaryFromDestArray) // Found it
-				{
-					targetPageNumber = pageNumber; break;
-				}
-			}
+			targetPageNumber = [documentPool pageNumberForPageDictionary:pageDictionaryFromDestArray document:document];
 		}
 		else // Try page number from array possibility
 		{
@@ -322,30 +328,35 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 	return entryTarget;
 }
 
++ (NSString *)outlineItemTitle:(CGPDFDictionaryRef)outlineDictionary
+{
+	NSString *trimmed = nil; // Trimmed outline entry title
+
+	CGPDFStringRef string = NULL; // Outline entry title string
+
+	if (CGPDFDictionaryGetString(outlineDictionary, "Title", &string) == true)
+	{
+		trimmed = OutlineTitle(CGPDFStringGetBytePtr(string), CGPDFStringGetLength(string)); // Same decoder as cached titles
+	}
+
+	return trimmed;
+}
+
 + (void)outlineItems:(CGPDFDictionaryRef)outlineDictionary document:(CGPDFDocumentRef)document array:(NSMutableArray *)array level:(NSInteger)level
 {
 	do // Loop through current level outline entries
 	{
 		DocumentOutlineEntry *outlineEntry = nil; // An entry
 
-		CGPDFStringRef string = NULL; // Outline entry title string
+		NSString *trimmed = [self outlineItemTitle:outlineDictionary]; // Outline entry title
 
-		if (CGPDFDictionaryGetString(outlineDictionary, "Title", &string) == true)
+		if (trimmed != nil) // Add a new entry
 		{
-			CFStringRef title = NULL; // Actual outline title (CFObject) string
-
-			if ((title = CGPDFStringCopyTextString(string)) != NULL) // Copy of CFObject string
-			{
-				NSString *titleString = (__bridge NSString *)title; // CFString to NSString toll-free bridge cast
-
-				id entryTarget = [self outlineEntryTarget:outlineDictionary document:document]; // Get target object
-
-				NSString *trimmed = [titleString stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+			id entryTarget = [self outlineEntryTarget:outlineDictionary document:document]; // Get target object
 
-				outlineEntry = [DocumentOutlineEntry newWithTitle:trimmed target:entryTarget level:level]; // New entry
+			outlineEntry = [DocumentOutlineEntry newWithTitle:trimmed target:entryTarget level:level]; // New entry
 
-				[array addObject:outlineEntry]; CFRelease(title); // Add new entry and cleanup
-			}
+			[array addObject:outlineEntry];
 		}
 
 		if (outlineEntry != nil) // Must have a current outline entry
@@ -368,13 +379,244 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 	} while (CGPDFDictionaryGetDictionary(outlineDictionary, "Next", &outlineDictionary) == true);
 }
 
++ (NSMutableArray *)lazyItems:(CGPDFDictionaryRef)outlineDictionary source:(PDFReaderOutlineSource *)source level:(NSInteger)level
+{
+	NSMutableArray *array = [NSMutableArray array]; // One level of entries
+
+	CFMutableSetRef visited = CFSetCreateMutable(NULL, 0, NULL); // Guard against /Next loops
+
+	do // Loop through current level outline entries - titles only, targets and children on demand
+	{
+		if (CFSetContainsValue(visited, outlineDictionary) == true) break; CFSetAddValue(visited, outlineDictionary);
+
+		NSString *title = [self outlineItemTitle:outlineDictionary]; // Entry title
+
+		if (title != nil) // Add a new lazy entry
+		{
+			[array addObject:[[DocumentOutlineEntry alloc] initWithTitle:title level:level source:source dictionary:outlineDictionary]];
+		}
+
+	} while (CGPDFDictionaryGetDictionary(outlineDictionary, "Next", &outlineDictionary) == true);
+
+	CFRelease(visited); return array;
+}
+
++ (void)cacheItems:(CGPDFDictionaryRef)outlineDictionary document:(CGPDFDocumentRef)document data:(NSMutableData *)data level:(NSInteger)level
+	count:(uint32_t *)count visited:(CFMutableSetRef)visited
+{
+	if (level >= OUTLINE_DEPTH) return; // Malformed (or cyclic) outline
+
+	do // Loop through current level outline entries, resolving every target
+	{
+		if (CFSetContainsValue(visited, outlineDictionary) == true) break; CFSetAddValue(visited, outlineDictionary);
+
+		@autoreleasepool
+		{
+			NSString *title = [self outlineItemTitle:outlineDictionary]; // Entry title
+
+			if (title != nil) // Append the entry and then its children (pre-order)
+			{
+				id entryTarget = [self outlineEntryTarget:outlineDictionary document:document];
+
+				OutlineCacheAppend(data, level, title, entryTarget); (*count)++;
+
+				CGPDFDictionaryRef childItem = NULL; // First child outline item
+
+				if (CGPDFDictionaryGetDictionary(outlineDictionary, "First", &childItem) == true)
+				{
+					[self cacheItems:childItem document:document data:data level:(level + 1) count:count visited:visited];
+				}
+			}
+		}
+
+	} while (CGPDFDictionaryGetDictionary(outlineDictionary, "Next", &outlineDictionary) == true);
+}
+
++ (BOOL)cacheItemsWithStructureURL:(NSURL *)fileURL data:(NSMutableData *)data count:(uint32_t *)count
+{
+	PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithPath([[fileURL path] fileSystemRepresentation], NULL);
+
+	if (structure == NULL) return NO; // Encrypted or not readable without CoreGraphics
+
+	*count = (uint32_t)PDFReaderCoreStructureVisitOutline(structure, OutlineCacheAppendItem, (__bridge void *)data);
+
+	PDFReaderCoreStructureDestroy(structure); return YES;
+}
+
++ (NSString *)outlineCachePathForGUID:(NSString *)guid
+{
+	return PDFReaderCacheFilePath(guid, CACHE_FILE_NAME);
+}
+
++ (void)saveOutlineCacheWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
+{
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0),
+	^{
+		uint64_t fileSize = 0; double fileDate = 0.0; // Document file identity
+
+		if (PDFReaderCacheFileIdentity(fileURL, &fileSize, &fileDate) == NO) return;
+
+		NSMutableData *data = [NSMutableData data]; uint32_t count = 0; // Cache file contents
+
+		PDFReaderCacheFileHeader header; memset(&header, 0x00, sizeof(header));
+
+		[data appendBytes:&header length:sizeof(header)]; // Filled in below
+
+		if ([self cacheItemsWithStructureURL:fileURL data:data count:&count] == NO) // Fall back to CoreGraphics
+		{
+			PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+			CGPDFDocumentRef document = [documentPool retainDocumentWithURL:fileURL password:phrase guid:guid];
+
+			if (document == NULL) return; // Unable to open the document
+
+			CGPDFDictionaryRef outlines = NULL; CGPDFDictionaryRef firstItem = NULL; // Document's outlines
+
+			if (CGPDFDictionaryGetDictionary(CGPDFDocumentGetCatalog(document), "Outlines", &outlines) == true)
+			{
+				if (CGPDFDictionaryGetDictionary(outlines, "First", &firstItem) == true)
+				{
+					CFMutableSetRef visited = CFSetCreateMutable(NULL, 0, NULL); // Every item once
+
+					[self cacheItems:firstItem document:document data:data level:0 count:&count visited:visited];
+
+					CFRelease(visited);
+				}
+			}
+
+			[documentPool releaseDocument:document]; // Done with the document
+		}
+
+		header = PDFReaderCacheFileMakeHeader(CACHE_MAGIC, CACHE_VERSION, fileSize, fileDate, count); // Entries (pre-order)
+
+		[data replaceBytesInRange:NSMakeRange(0, sizeof(header)) withBytes:&header];
+
+		PDFReaderCacheFileWrite(guid, CACHE_FILE_NAME, data);
+	});
+}
+
++ (NSArray *)outlineFromCacheWithURL:(NSURL *)fileURL guid:(NSString *)guid
+{
+	uint64_t fileSize = 0; double fileDate = 0.0; // Document file identity
+
+	if (PDFReaderCacheFileIdentity(fileURL, &fileSize, &fileDate) == NO) return nil;
+
+	NSData *data = [NSData dataWithContentsOfFile:[self outlineCachePathForGUID:guid] options:NSDataReadingMappedIfSafe error:NULL];
+
+	PDFReaderCacheFileHeader header; // Missing, truncated, stale or for a changed document
+
+	if (PDFReaderCacheFileReadHeader(data, CACHE_MAGIC, CACHE_VERSION, fileSize, fileDate, &header) == NO) return nil;
+
+	const uint8_t *bytes = ((const uint8_t *)data.bytes + sizeof(header)); const uint8_t *end = ((const uint8_t *)data.bytes + data.length);
+
+	NSMutableArray *outlineArray = [NSMutableArray array]; // Top level outline entries array
+
+	NSMutableArray *parents = [NSMutableArray array]; // Last entry at each level
+
+	for (uint32_t index = 0; index < header.count; index++) // Rebuild the tree from pre-order levels
+	{
+		PDFReaderOutlineCacheRecord record; id target = nil; // Entry record
+
+		if ((size_t)(end - bytes) < sizeof(record)) return nil;
+
+		memcpy(&record, bytes, sizeof(record)); bytes += sizeof(record);
+
+		size_t urlLength = ((record.type == TARGET_URL) ? record.value : 0); // URL bytes after the title
+
+		if ((size_t)(end - bytes) < (record.titleLength + urlLength)) return nil;
+
+		NSString *title = [[NSString alloc] initWithBytes:bytes length:record.titleLength encoding:NSUTF8StringEncoding];
+
+		bytes += record.titleLength; if (title == nil) title = @""; // Keep the tree shape
+
+		if (record.type == TARGET_PAGE) // Page number
+		{
+			target = [NSNumber numberWithInteger:record.value];
+		}
+		else if (record.type == TARGET_URL) // URL
+		{
+			NSString *string = [[NSString alloc] initWithBytes:bytes length:urlLength encoding:NSUTF8StringEncoding];
+
+			bytes += urlLength; if (string != nil) target = [NSURL URLWithString:string];
+		}
+
+		NSInteger level = MIN((NSInteger)record.level, (NSInteger)parents.count); // Clamp bad level jumps
+
+		DocumentOutlineEntry *outlineEntry = [DocumentOutlineEntry newWithTitle:title target:target level:level];
+
+		if (level == 0) // Top level entry
+		{
+			[outlineArray addObject:outlineEntry];
+		}
+		else // Child of the last entry one level up
+		{
+			DocumentOutlineEntry *parent = [parents objectAtIndex:(level - 1)];
+
+			if (parent.children == nil) parent.children = [NSMutableArray array];
+
+			[parent.children addObject:outlineEntry];
+		}
+
+		[parents removeObjectsInRange:NSMakeRange(level, (parents.count - level))]; [parents addObject:outlineEntry];
+	}
+
+	return outlineArray;
+}
+
++ (NSArray *)lazyOutlineFromFileURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
+{
+	NSMutableArray *outlineArray = nil; // Mutable outline array
+
+	if ((fileURL != nil) && [fileURL isFileURL]) // Check for valid file URL
+	{
+		if (guid != nil) // Try the resolved outline cache first
+		{
+			NSArray *cached = [self outlineFromCacheWithURL:fileURL guid:guid];
+
+			if (cached != nil) return cached;
+		}
+
+		PDFReaderOutlineSource *source = [[PDFReaderOutlineSource alloc] initWithURL:fileURL password:phrase guid:guid];
+
+		if (source != nil) // Check for an open document
+		{
+			CGPDFDocumentRef document = source.document; // Held open by the source
+
+			CGPDFDictionaryRef outlines = NULL; // Document's outlines
+
+			CGPDFDictionaryRef catalog = CGPDFDocumentGetCatalog(document);
+
+			if (CGPDFDictionaryGetDictionary(catalog, "Outlines", &outlines) == true)
+			{
+				CGPDFDictionaryRef firstItem = NULL; // First outline item entry
+
+				if (CGPDFDictionaryGetDictionary(outlines, "First", &firstItem) == true)
+				{
+					outlineArray = [self lazyItems:firstItem source:source level:0]; // Top level only
+				}
+			}
+
+			if ((outlineArray != nil) && (guid != nil)) [self saveOutlineCacheWithURL:fileURL password:phrase guid:guid];
+		}
+	}
+
+	return [outlineArray copy]; // NSArray
+}
+
 + (NSArray *)outlineFromFileURL:(NSURL *)fileURL password:(NSString *)phrase
+{
+	return [self outlineFromFileURL:fileURL password:phrase guid:nil];
+}
+
++ (NSArray *)outlineFromFileURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
 {
 	NSMutableArray *outlineArray = nil; // Mutable outline array
 
 	if ((fileURL != nil) && [fileURL isFileURL]) // Check for valid file URL
 	{
-		CGPDFDocumentRef document = CGPDFDocumentCreateX((__bridge CFURLRef)fileURL, phrase);
+		PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+		CGPDFDocumentRef document = [documentPool retainDocumentWithURL:fileURL password:phrase guid:guid];
 
 		if (document != NULL) // Check for non-NULL CGPDFDocumentRef
 		{
@@ -394,7 +636,7 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 				}
 			}
 
-			CGPDFDocumentRelease(document); // Cleanup
+			[documentPool releaseDocument:document]; // Cleanup
 		}
 	}
 
@@ -411,14 +653,6 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 //	DocumentOutlineEntry class implementation
 //
 
-@interface DocumentOutlineEntry ()
-
-@property (nonatomic, assign, readwrite) NSInteger level;
-@property (nonatomic, strong, readwrite) NSString *title;
-@property (nonatomic, strong, readwrite) id target;
-
-@end
-
 @implementation DocumentOutlineEntry
 {
 	NSInteger _level;
@@ -428,6 +662,14 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 	NSString *_title;
 
 	id _target;
+
+	PDFReaderOutlineSource *_source;
+
+	CGPDFDictionaryRef _dictionary;
+
+	CGPDFDictionaryRef _firstChild;
+
+	BOOL _resolved;
 }
 
 #pragma mark Properties
@@ -450,12 +692,54 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 {
 	if ((self = [super init]))
 	{
-		self.title = title; self.target = target; self.level = level;
+		self.title = title; self.target = target; self.level = level; _resolved = YES;
+	}
+
+	return self;
+}
+
+- (id)initWithTitle:(NSString *)title level:(NSInteger)level source:(PDFReaderOutlineSource *)source dictionary:(CGPDFDictionaryRef)dictionary
+{
+	if ((self = [super init]))
+	{
+		self.title = title; self.level = level; _source = source; _dictionary = dictionary;
+
+		CGPDFDictionaryGetDictionary(dictionary, "First", &_firstChild); // Children on expansion
 	}
 
 	return self;
 }
 
+- (id)target
+{
+	if (_source == nil) return _target; // Resolved when created
+
+	@synchronized(_source) // Mutex lock
+	{
+		if (_resolved == NO) // Resolve the destination when first shown or tapped
+		{
+			_target = [PDFReaderDocumentOutline outlineEntryTarget:_dictionary document:_source.document]; _resolved = YES;
+		}
+
+		return _target;
+	}
+}
+
+- (NSMutableArray *)children
+{
+	if ((_children == nil) && (_firstChild != NULL) && (_level < OUTLINE_DEPTH)) // Materialize on expansion
+	{
+		@synchronized(_source) { _children = [PDFReaderDocumentOutline lazyItems:_firstChild source:_source level:(_level + 1)]; }
+	}
+
+	return _children;
+}
+
+- (BOOL)hasChildren
+{
+	return ((_firstChild != NULL) || (_children.count > 0));
+}
+
 - (NSString *)description
 {
 	NSString *format = @"%@ Title = '%@', Target = '%@', Level = (%i)";
@@ -464,3 +748,39 @@ void logDictionaryEntry(const char *key, CGPDFObjectRef object, void *info)
 }
 
 @end
+
+#pragma mark -
+
+//
+//	PDFReaderOutlineSource class implementation
+//
+
+@implementation PDFReaderOutlineSource
+{
+	CGPDFDocumentRef _document;
+}
+
+#pragma mark Properties
+
+@synthesize document = _document;
+
+#pragma mark PDFReaderOutlineSource instance methods
+
+- (id)initWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
+{
+	if ((self = [super init])) // Keep the pooled document open while lazy entries exist
+	{
+		_document = [[PDFReaderDocumentPool sharedInstance] retainDocumentWithURL:fileURL password:phrase guid:guid];
+
+		if (_document == NULL) self = nil; // Unable to open the document
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_document != NULL) [[PDFReaderDocumentPool sharedInstance] releaseDocument:_document], _document = NULL;
+}
+
+@end
@@ -0,0 +1,63 @@
+//
+//	PDFReaderDocumentPool.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+/**
+ *  `PDFReaderDocumentPool` is a process-wide pool of open CGPDFDocumentRef
+ *  handles keyed by document GUID (or file path when no GUID is known) and
+ *  file identity (size and modification date).
+ *
+ *  Every retain must be balanced by the matching release method. Documents
+ *  that have no outstanding retains are closed after an idle timeout.
+ */
+@interface PDFReaderDocumentPool : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) NSUInteger openCount;
+@property (nonatomic, assign, readonly) NSUInteger reuseCount;
+@property (nonatomic, assign, readonly) NSUInteger evictionCount;
+@property (nonatomic, assign, readonly) NSUInteger pageEvictionCount;
+
++ (PDFReaderDocumentPool *)sharedInstance;
+
+- (CGPDFDocumentRef)retainDocumentWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid;
+
+- (void)releaseDocument:(CGPDFDocumentRef)document;
+
+- (CGPDFPageRef)retainPage:(NSInteger)page withURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid;
+
+- (void)releasePage:(CGPDFPageRef)page;
+
+- (NSInteger)pageNumberForPageDictionary:(CGPDFDictionaryRef)pageDictionary document:(CGPDFDocumentRef)document;
+
+- (id)attachmentForKey:(NSString *)key document:(CGPDFDocumentRef)document creator:(id (^)(void))creator;
+
+- (void)closeDocumentsWithGUID:(NSString *)guid;
+
+- (void)closeIdleDocuments;
+
+- (void)logStatistics;
+
+@end
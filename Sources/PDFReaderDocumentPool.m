@@ -0,0 +1,597 @@
+//
+//	PDFReaderDocumentPool.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderDocumentPool.h"
+#import "CGPDFDocument.h"
+
+#import <UIKit/UIKit.h>
+#import <sys/stat.h>
+
+#pragma mark -
+
+//
+//	PDFReaderDocumentHandle class interface
+//
+
+@interface PDFReaderDocumentHandle : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *key;
+@property (nonatomic, assign, readonly) CGPDFDocumentRef document;
+@property (nonatomic, assign, readwrite) NSInteger useCount;
+@property (nonatomic, assign, readwrite) CFAbsoluteTime lastUse;
+@property (nonatomic, assign, readwrite) BOOL retired;
+
+- (id)initWithKey:(NSString *)key document:(CGPDFDocumentRef)document size:(off_t)size time:(time_t)time;
+
+- (BOOL)matchesSize:(off_t)size time:(time_t)time;
+
+- (CGPDFPageRef)retainPage:(NSInteger)page evicted:(NSUInteger *)evicted;
+
+- (NSUInteger)trimHotPages;
+
+- (NSInteger)pageNumberForPageDictionary:(CGPDFDictionaryRef)pageDictionary;
+
+- (id)attachmentForKey:(NSString *)key creator:(id (^)(void))creator;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderDocumentPool class implementation
+//
+
+@implementation PDFReaderDocumentPool
+{
+	NSMutableDictionary *handles;
+
+	CFMutableDictionaryRef documents;
+
+	dispatch_source_t idleTimer;
+
+	NSUInteger _openCount;
+
+	NSUInteger _reuseCount;
+
+	NSUInteger _evictionCount;
+
+	NSUInteger _pageEvictionCount;
+}
+
+#pragma mark Constants
+
+#define IDLE_TIMEOUT 30.0
+
+#pragma mark Properties
+
+@synthesize openCount = _openCount;
+@synthesize reuseCount = _reuseCount;
+@synthesize evictionCount = _evictionCount;
+@synthesize pageEvictionCount = _pageEvictionCount;
+
+#pragma mark PDFReaderDocumentPool functions
+
+static BOOL FileIdentityForURL(NSURL *fileURL, off_t *size, time_t *time)
+{
+	struct stat info; const char *path = [[fileURL path] fileSystemRepresentation];
+
+	if ((path != NULL) && (stat(path, &info) == 0)) // Get size and modification time
+	{
+		*size = info.st_size; *time = info.st_mtime; return YES;
+	}
+
+	return NO;
+}
+
+#pragma mark PDFReaderDocumentPool class methods
+
++ (PDFReaderDocumentPool *)sharedInstance
+{
+	static dispatch_once_t predicate = 0;
+
+	static PDFReaderDocumentPool *object = nil; // Object
+
+	dispatch_once(&predicate, ^{ object = [self new]; });
+
+	return object; // PDFReaderDocumentPool singleton
+}
+
+#pragma mark PDFReaderDocumentPool instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize
+	{
+		handles = [NSMutableDictionary new]; // Current handles by key
+
+		documents = CFDictionaryCreateMutable(NULL, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+
+		__weak PDFReaderDocumentPool *weakSelf = self; // Timer and notification blocks
+
+		idleTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+
+		uint64_t interval = (IDLE_TIMEOUT * NSEC_PER_SEC); uint64_t leeway = (interval / 4); // Timer interval
+
+		dispatch_source_set_timer(idleTimer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, leeway);
+
+		dispatch_source_set_event_handler(idleTimer, ^{ [weakSelf closeIdleDocuments]; });
+
+		dispatch_resume(idleTimer); // Start the idle handle timer
+
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveMemoryWarning:)
+			name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	if (documents != NULL) CFRelease(documents), documents = NULL;
+}
+
+- (void)closeHandle:(PDFReaderDocumentHandle *)handle
+{
+	if ([handles objectForKey:handle.key] == handle) [handles removeObjectForKey:handle.key];
+
+	handle.retired = YES; // No longer handed out for new retains
+
+	if (handle.useCount <= 0) // Close it now
+	{
+		CFDictionaryRemoveValue(documents, handle.document);
+	}
+}
+
+- (PDFReaderDocumentHandle *)handleWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
+{
+	PDFReaderDocumentHandle *handle = nil; // Document handle
+
+	off_t fileSize = 0; time_t fileTime = 0; // File identity
+
+	if ((fileURL != nil) && FileIdentityForURL(fileURL, &fileSize, &fileTime))
+	{
+		NSString *key = ((guid != nil) ? guid : [fileURL path]); // Pool key
+
+		handle = [handles objectForKey:key]; // Look for an open handle
+
+		if ((handle != nil) && ([handle matchesSize:fileSize time:fileTime] == NO))
+		{
+			[self closeHandle:handle]; handle = nil; // File changed on disk
+		}
+
+		if (handle == nil) // Open and parse the document
+		{
+			CGPDFDocumentRef document = CGPDFDocumentCreateX((__bridge CFURLRef)fileURL, phrase);
+
+			if (document != NULL) // Add a new handle to the pool
+			{
+				handle = [[PDFReaderDocumentHandle alloc] initWithKey:key document:document size:fileSize time:fileTime];
+
+				CFDictionarySetValue(documents, document, (__bridge const void *)handle);
+
+				[handles setObject:handle forKey:key]; _openCount++;
+
+				CGPDFDocumentRelease(document); // Handle holds it
+			}
+		}
+		else // Reuse open handle
+		{
+			_reuseCount++;
+		}
+	}
+
+	return handle;
+}
+
+- (CGPDFDocumentRef)retainDocumentWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
+{
+	CGPDFDocumentRef document = NULL; // Retained document
+
+	@synchronized(handles) // Mutex lock
+	{
+		PDFReaderDocumentHandle *handle = [self handleWithURL:fileURL password:phrase guid:guid];
+
+		if (handle != nil) // Hand out a retained document reference
+		{
+			document = CGPDFDocumentRetain(handle.document);
+
+			handle.useCount++; handle.lastUse = CFAbsoluteTimeGetCurrent();
+		}
+	}
+
+	return document;
+}
+
+- (void)relinquishDocument:(CGPDFDocumentRef)document
+{
+	PDFReaderDocumentHandle *handle = (__bridge PDFReaderDocumentHandle *)CFDictionaryGetValue(documents, document);
+
+	if (handle != nil) // Balance the use count
+	{
+		handle.useCount--; handle.lastUse = CFAbsoluteTimeGetCurrent();
+
+		if ((handle.retired == YES) && (handle.useCount <= 0)) [self closeHandle:handle];
+	}
+}
+
+- (void)releaseDocument:(CGPDFDocumentRef)document
+{
+	if (document != NULL) // Check for non-NULL CGPDFDocumentRef
+	{
+		@synchronized(handles) // Mutex lock
+		{
+			[self relinquishDocument:document];
+
+			CGPDFDocumentRelease(document);
+		}
+	}
+}
+
+- (CGPDFPageRef)retainPage:(NSInteger)page withURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid
+{
+	CGPDFPageRef pageRef = NULL; // Retained page
+
+	@synchronized(handles) // Mutex lock
+	{
+		PDFReaderDocumentHandle *handle = [self handleWithURL:fileURL password:phrase guid:guid];
+
+		if (handle != nil) // Hand out a retained page reference
+		{
+			NSUInteger evicted = 0; pageRef = [handle retainPage:page evicted:&evicted];
+
+			if (pageRef != NULL) { handle.useCount++; handle.lastUse = CFAbsoluteTimeGetCurrent(); }
+
+			_pageEvictionCount += evicted;
+		}
+	}
+
+	return pageRef;
+}
+
+- (void)releasePage:(CGPDFPageRef)page
+{
+	if (page != NULL) // Check for non-NULL CGPDFPageRef
+	{
+		@synchronized(handles) // Mutex lock
+		{
+			[self relinquishDocument:CGPDFPageGetDocument(page)];
+
+			CGPDFPageRelease(page);
+		}
+	}
+}
+
+- (NSInteger)pageNumberForPageDictionary:(CGPDFDictionaryRef)pageDictionary document:(CGPDFDocumentRef)document
+{
+	if ((pageDictionary == NULL) || (document == NULL)) return 0; // Nothing to find
+
+	PDFReaderDocumentHandle *handle = nil; // Pooled document handle
+
+	@synchronized(handles) // Mutex lock
+	{
+		handle = (__bridge PDFReaderDocumentHandle *)CFDictionaryGetValue(documents, document);
+	}
+
+	if (handle != nil) return [handle pageNumberForPageDictionary:pageDictionary]; // Shared page map
+
+	NSInteger pageCount = CGPDFDocumentGetNumberOfPages(document); // Not pooled - scan the pages
+
+	for (NSInteger pageNumber = 1; pageNumber <= pageCount; pageNumber++)
+	{
+		CGPDFPageRef pageRef = CGPDFDocumentGetPage(document, pageNumber);
+
+		if (CGPDFPageGetDictionary(pageRef) == pageDictionary) return pageNumber;
+	}
+
+	return 0;
+}
+
+- (id)attachmentForKey:(NSString *)key document:(CGPDFDocumentRef)document creator:(id (^)(void))creator
+{
+	if ((key == nil) || (document == NULL) || (creator == nil)) return nil; // Nothing to attach
+
+	PDFReaderDocumentHandle *handle = nil; // Pooled document handle
+
+	@synchronized(handles) // Mutex lock
+	{
+		handle = (__bridge PDFReaderDocumentHandle *)CFDictionaryGetValue(documents, document);
+	}
+
+	return ((handle != nil) ? [handle attachmentForKey:key creator:creator] : creator()); // Not pooled - not cached
+}
+
+- (void)closeDocumentsWithGUID:(NSString *)guid
+{
+	@synchronized(handles) // Mutex lock
+	{
+		PDFReaderDocumentHandle *handle = [handles objectForKey:guid];
+
+		if (handle != nil) [self closeHandle:handle];
+	}
+}
+
+- (void)closeIdleDocuments
+{
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent(); // Right about now
+
+	@synchronized(handles) // Mutex lock
+	{
+		for (PDFReaderDocumentHandle *handle in [handles allValues])
+		{
+			if ((handle.useCount <= 0) && ((now - handle.lastUse) > IDLE_TIMEOUT))
+			{
+				[self closeHandle:handle]; _evictionCount++;
+			}
+		}
+	}
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification
+{
+	@synchronized(handles) // Mutex lock
+	{
+		for (PDFReaderDocumentHandle *handle in [handles allValues])
+		{
+			if (handle.useCount <= 0) // Close idle handles
+			{
+				[self closeHandle:handle]; _evictionCount++;
+			}
+			else // Drop hot pages of busy handles
+			{
+				_pageEvictionCount += [handle trimHotPages];
+			}
+		}
+	}
+}
+
+- (void)logStatistics
+{
+#ifdef DEBUG
+	@synchronized(handles) // Mutex lock
+	{
+		NSLog(@"%s open %i, opens %u, reuses %u, evictions %u, page evictions %u", __FUNCTION__,
+			(int)handles.count, (unsigned)_openCount, (unsigned)_reuseCount, (unsigned)_evictionCount, (unsigned)_pageEvictionCount);
+	}
+#endif
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderDocumentHandle class implementation
+//
+
+@implementation PDFReaderDocumentHandle
+{
+	NSString *_key;
+
+	CGPDFDocumentRef _document;
+
+	NSMutableArray *hotPages;
+
+	NSMutableDictionary *hotPageRefs;
+
+	CFMutableDictionaryRef pageNumbers;
+
+	NSMutableDictionary *attachments;
+
+	off_t _fileSize;
+
+	time_t _fileTime;
+
+	NSInteger _useCount;
+
+	CFAbsoluteTime _lastUse;
+
+	BOOL _retired;
+}
+
+#pragma mark Constants
+
+#define HOT_PAGES 8
+
+#define PAGE_TREE_DEPTH 64
+
+#pragma mark Properties
+
+@synthesize key = _key;
+@synthesize document = _document;
+@synthesize useCount = _useCount;
+@synthesize lastUse = _lastUse;
+@synthesize retired = _retired;
+
+#pragma mark PDFReaderDocumentHandle functions
+
+static BOOL PageTreeWalk(CGPDFDictionaryRef node, CFMutableDictionaryRef map, CFMutableSetRef visited, NSInteger *pageNumber, NSInteger depth)
+{
+	if (CFSetContainsValue(visited, node) == true) return NO; // Repeated or cyclic node
+
+	CFSetAddValue(visited, node); CGPDFArrayRef kids = NULL; // Page tree node kids
+
+	if (CGPDFDictionaryGetArray(node, "Kids", &kids) == true) // Intermediate /Pages node
+	{
+		if (depth >= PAGE_TREE_DEPTH) return NO; // Malformed page tree
+
+		size_t count = CGPDFArrayGetCount(kids); // Number of kids
+
+		for (size_t index = 0; index < count; index++)
+		{
+			CGPDFDictionaryRef kid = NULL; // Kid dictionary
+
+			if (CGPDFArrayGetDictionary(kids, index, &kid) == true)
+			{
+				if (PageTreeWalk(kid, map, visited, pageNumber, (depth + 1)) == NO) return NO;
+			}
+		}
+	}
+	else // Leaf /Page node
+	{
+		(*pageNumber)++; CFDictionarySetValue(map, node, (const void *)(intptr_t)(*pageNumber));
+	}
+
+	return YES;
+}
+
+#pragma mark PDFReaderDocumentHandle instance methods
+
+- (id)initWithKey:(NSString *)key document:(CGPDFDocumentRef)document size:(off_t)size time:(time_t)time
+{
+	if ((self = [super init]))
+	{
+		_key = [key copy]; _document = CGPDFDocumentRetain(document);
+
+		_fileSize = size; _fileTime = time; _lastUse = CFAbsoluteTimeGetCurrent();
+
+		hotPages = [NSMutableArray new]; hotPageRefs = [NSMutableDictionary new];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self trimHotPages]; // Release hot pages
+
+	if (pageNumbers != NULL) CFRelease(pageNumbers), pageNumbers = NULL;
+
+	CGPDFDocumentRelease(_document), _document = NULL;
+}
+
+- (BOOL)matchesSize:(off_t)size time:(time_t)time
+{
+	return ((_fileSize == size) && (_fileTime == time));
+}
+
+- (CGPDFPageRef)retainPage:(NSInteger)page evicted:(NSUInteger *)evicted
+{
+	NSNumber *key = [NSNumber numberWithInteger:page]; // Page number key
+
+	CGPDFPageRef pageRef = [[hotPageRefs objectForKey:key] pointerValue];
+
+	if (pageRef != NULL) // Move the hot page to the front of the list
+	{
+		[hotPages removeObject:key]; [hotPages insertObject:key atIndex:0];
+	}
+	else // Get the page from the document and keep it hot
+	{
+		pageRef = CGPDFDocumentGetPage(_document, page);
+
+		if (pageRef != NULL) // Check for non-NULL CGPDFPageRef
+		{
+			[hotPageRefs setObject:[NSValue valueWithPointer:CGPDFPageRetain(pageRef)] forKey:key];
+
+			[hotPages insertObject:key atIndex:0]; // Most recently used
+
+			while (hotPages.count > HOT_PAGES) // Evict least recently used
+			{
+				NSNumber *coldKey = [hotPages lastObject]; [hotPages removeLastObject];
+
+				CGPDFPageRelease([[hotPageRefs objectForKey:coldKey] pointerValue]);
+
+				[hotPageRefs removeObjectForKey:coldKey]; (*evicted)++;
+			}
+		}
+	}
+
+	return ((pageRef != NULL) ? CGPDFPageRetain(pageRef) : NULL);
+}
+
+- (NSUInteger)trimHotPages
+{
+	NSUInteger count = hotPages.count; // Number of hot pages
+
+	for (NSValue *value in [hotPageRefs allValues]) CGPDFPageRelease([value pointerValue]);
+
+	[hotPages removeAllObjects]; [hotPageRefs removeAllObjects];
+
+	return count;
+}
+
+- (void)buildPageNumbers
+{
+	pageNumbers = CFDictionaryCreateMutable(NULL, 0, NULL, NULL); // Page dictionary -> page number
+
+	NSInteger pageCount = CGPDFDocumentGetNumberOfPages(_document); NSInteger pageNumber = 0;
+
+	CGPDFDictionaryRef catalog = CGPDFDocumentGetCatalog(_document); CGPDFDictionaryRef pages = NULL; BOOL walked = NO;
+
+	if (CGPDFDictionaryGetDictionary(catalog, "Pages", &pages) == true) // Walk the page tree
+	{
+		CFMutableSetRef visited = CFSetCreateMutable(NULL, 0, NULL); // Every node once
+
+		walked = PageTreeWalk(pages, pageNumbers, visited, &pageNumber, 0);
+
+		CFRelease(visited);
+	}
+
+	if ((walked == NO) || (pageNumber != pageCount)) // Page tree is malformed or disagrees with CGPDF - ask for every page instead
+	{
+		CFDictionaryRemoveAllValues(pageNumbers);
+
+		for (pageNumber = 1; pageNumber <= pageCount; pageNumber++)
+		{
+			CGPDFPageRef pageRef = CGPDFDocumentGetPage(_document, pageNumber);
+
+			CGPDFDictionaryRef pageDictionary = CGPDFPageGetDictionary(pageRef);
+
+			if (pageDictionary != NULL) CFDictionarySetValue(pageNumbers, pageDictionary, (const void *)(intptr_t)pageNumber);
+		}
+	}
+}
+
+- (NSInteger)pageNumberForPageDictionary:(CGPDFDictionaryRef)pageDictionary
+{
+	@synchronized(self) // Built once per open document, on first use
+	{
+		if (pageNumbers == NULL) [self buildPageNumbers];
+
+		return (NSInteger)(intptr_t)CFDictionaryGetValue(pageNumbers, pageDictionary);
+	}
+}
+
+- (id)attachmentForKey:(NSString *)key creator:(id (^)(void))creator
+{
+	@synchronized(self) // Created once per open document, on first use
+	{
+		id object = [attachments objectForKey:key]; // Cached object
+
+		if (object == nil) // Create and keep it with the document
+		{
+			if ((object = creator()) != nil)
+			{
+				if (attachments == nil) attachments = [NSMutableDictionary new];
+
+				[attachments setObject:object forKey:key];
+			}
+		}
+
+		return object;
+	}
+}
+
+@end
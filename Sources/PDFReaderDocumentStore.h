@@ -0,0 +1,75 @@
+//
+//	PDFReaderDocumentStore.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  `PDFReaderDocumentRecord` is the persisted metadata of one document (the
+ *  same properties `PDFReaderDocument` used to keep in its keyed archive).
+ */
+@interface PDFReaderDocumentRecord : NSObject <NSObject, NSCopying>
+
+@property (nonatomic, strong, readwrite) NSString *guid;
+@property (nonatomic, strong, readwrite) NSString *fileName;
+@property (nonatomic, strong, readwrite) NSDate *fileDate;
+@property (nonatomic, strong, readwrite) NSNumber *fileSize;
+@property (nonatomic, strong, readwrite) NSNumber *pageCount;
+@property (nonatomic, strong, readwrite) NSNumber *pageNumber;
+@property (nonatomic, strong, readwrite) NSDate *lastOpen;
+@property (nonatomic, strong, readwrite) NSIndexSet *bookmarks;
+
+@end
+
+/**
+ *  `PDFReaderDocumentStore` keeps the metadata of every document in a single
+ *  append-only log (`Application Support/PDFReaderDocuments.store`), indexed
+ *  in memory by file path (relative to the application directory, as kept in
+ *  `fileName`) and by GUID. The legacy plists were keyed by bare file name;
+ *  that key is only used when importing them.
+ *
+ *  Saves are coalesced on a serial queue and appended in one write. The log
+ *  is compacted when stale records outweigh live ones. Legacy per-document
+ *  plists are migrated by `PDFReaderDocument` on first read.
+ */
+@interface PDFReaderDocumentStore : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) NSUInteger recordCount;
+
++ (PDFReaderDocumentStore *)sharedInstance;
+
+- (PDFReaderDocumentRecord *)recordForFileName:(NSString *)fileName;
+
+- (PDFReaderDocumentRecord *)recordForGUID:(NSString *)guid;
+
+- (NSArray *)allRecords;
+
+- (void)saveRecord:(PDFReaderDocumentRecord *)record;
+
+- (void)saveRecords:(NSArray *)records;
+
+- (void)removeRecordForFileName:(NSString *)fileName;
+
+- (void)flush;
+
+@end
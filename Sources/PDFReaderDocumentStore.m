@@ -0,0 +1,526 @@
+//
+//	PDFReaderDocumentStore.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderDocumentStore.h"
+#import "PDFReaderCacheFile.h"
+
+#import <UIKit/UIKit.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+#pragma mark Constants
+
+#define STORE_MAGIC 0x53445250
+#define STORE_VERSION 3
+#define STORE_FILE_NAME @"PDFReaderDocuments.store"
+
+#define STORE_SAVE_DELAY 1.0
+
+#define STORE_COMPACT_SLACK (64 * 1024)
+
+#define RECORD_PUT 1
+#define RECORD_DELETE 2
+
+typedef struct
+{
+	uint32_t magic; uint32_t version; // Store identification
+} PDFReaderDocumentStoreHeader;
+
+typedef struct
+{
+	uint32_t length; uint32_t checksum; // Payload that follows
+} PDFReaderDocumentStoreFrame;
+
+#pragma mark -
+
+//
+//	PDFReaderDocumentStore class implementation
+//
+
+@implementation PDFReaderDocumentStore
+{
+	dispatch_queue_t storeQueue;
+
+	NSString *storePath;
+
+	NSMutableDictionary *records; // Records by relative file path (record.fileName)
+
+	NSMutableDictionary *guids; // Relative file paths by GUID
+
+	NSMutableDictionary *frameSizes; // Live frame sizes by relative file path
+
+	NSMutableDictionary *pending; // Unwritten frames by relative file path
+
+	unsigned long long logBytes;
+
+	unsigned long long liveBytes;
+
+	BOOL saveScheduled;
+}
+
+#pragma mark PDFReaderDocumentStore functions
+
+static void StoreAppendString(NSMutableData *data, NSString *string)
+{
+	NSData *bytes = [string dataUsingEncoding:NSUTF8StringEncoding]; uint16_t length = (uint16_t)MIN(bytes.length, UINT16_MAX);
+
+	[data appendBytes:&length length:sizeof(length)]; [data appendBytes:bytes.bytes length:length];
+}
+
+static BOOL StoreRead(const uint8_t **bytes, const uint8_t *end, void *value, size_t length)
+{
+	if ((size_t)(end - *bytes) < length) return NO; // Truncated
+
+	memcpy(value, *bytes, length); *bytes += length; return YES;
+}
+
+static NSString *StoreReadString(const uint8_t **bytes, const uint8_t *end)
+{
+	uint16_t length = 0; if (StoreRead(bytes, end, &length, sizeof(length)) == NO) return nil;
+
+	if ((size_t)(end - *bytes) < length) return nil; // Truncated
+
+	NSString *string = [[NSString alloc] initWithBytes:*bytes length:length encoding:NSUTF8StringEncoding];
+
+	*bytes += length; return string;
+}
+
+static BOOL StoreWrite(int fd, const void *bytes, size_t length, off_t offset)
+{
+	const uint8_t *data = bytes; // Write everything or fail
+
+	while (length > 0) // Handle short writes
+	{
+		ssize_t written = pwrite(fd, data, length, offset);
+
+		if (written < 0) { if (errno == EINTR) continue; return NO; }
+
+		data += written; length -= written; offset += written;
+	}
+
+	return YES;
+}
+
+static NSData *StoreFrame(NSData *payload)
+{
+	PDFReaderDocumentStoreFrame frame = { (uint32_t)payload.length, PDFReaderCacheFileChecksum(payload.bytes, payload.length) };
+
+	NSMutableData *data = [NSMutableData dataWithBytes:&frame length:sizeof(frame)];
+
+	[data appendData:payload]; return data;
+}
+
+static NSData *StorePutFrame(PDFReaderDocumentRecord *record)
+{
+	NSMutableData *payload = [NSMutableData data]; uint8_t op = RECORD_PUT; // Put record payload
+
+	[payload appendBytes:&op length:sizeof(op)]; StoreAppendString(payload, record.guid); StoreAppendString(payload, record.fileName);
+
+	double fileDate = [record.fileDate timeIntervalSinceReferenceDate]; int64_t fileSize = [record.fileSize longLongValue];
+
+	int32_t pageCount = [record.pageCount intValue]; int32_t pageNumber = [record.pageNumber intValue];
+
+	double lastOpen = [record.lastOpen timeIntervalSinceReferenceDate]; uint32_t bookmarkCount = (uint32_t)record.bookmarks.count;
+
+	[payload appendBytes:&fileDate length:sizeof(fileDate)]; [payload appendBytes:&fileSize length:sizeof(fileSize)];
+
+	[payload appendBytes:&pageCount length:sizeof(pageCount)]; [payload appendBytes:&pageNumber length:sizeof(pageNumber)];
+
+	[payload appendBytes:&lastOpen length:sizeof(lastOpen)]; [payload appendBytes:&bookmarkCount length:sizeof(bookmarkCount)];
+
+	[record.bookmarks enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop)
+	{
+		uint32_t page = (uint32_t)index; [payload appendBytes:&page length:sizeof(page)];
+	}];
+
+	return StoreFrame(payload);
+}
+
+static NSData *StoreDeleteFrame(NSString *fileName)
+{
+	NSMutableData *payload = [NSMutableData data]; uint8_t op = RECORD_DELETE; // Delete record payload
+
+	[payload appendBytes:&op length:sizeof(op)]; StoreAppendString(payload, fileName);
+
+	return StoreFrame(payload);
+}
+
+static PDFReaderDocumentRecord *StoreReadPut(const uint8_t *bytes, const uint8_t *end)
+{
+	PDFReaderDocumentRecord *record = [PDFReaderDocumentRecord new]; // Decoded record
+
+	record.guid = StoreReadString(&bytes, end); record.fileName = StoreReadString(&bytes, end);
+
+	if ((record.guid == nil) || (record.fileName == nil)) return nil;
+
+	double fileDate = 0.0; int64_t fileSize = 0; int32_t pageCount = 0; int32_t pageNumber = 0; double lastOpen = 0.0; uint32_t bookmarkCount = 0;
+
+	if ((StoreRead(&bytes, end, &fileDate, sizeof(fileDate)) && StoreRead(&bytes, end, &fileSize, sizeof(fileSize)) &&
+		StoreRead(&bytes, end, &pageCount, sizeof(pageCount)) && StoreRead(&bytes, end, &pageNumber, sizeof(pageNumber)) &&
+		StoreRead(&bytes, end, &lastOpen, sizeof(lastOpen)) && StoreRead(&bytes, end, &bookmarkCount, sizeof(bookmarkCount))) == NO) return nil;
+
+	if ((size_t)(end - bytes) < (bookmarkCount * sizeof(uint32_t))) return nil; // Truncated
+
+	NSMutableIndexSet *bookmarks = [NSMutableIndexSet indexSet]; // Bookmarked pages
+
+	for (uint32_t index = 0; index < bookmarkCount; index++) { uint32_t page; StoreRead(&bytes, end, &page, sizeof(page)); [bookmarks addIndex:page]; }
+
+	record.fileDate = [NSDate dateWithTimeIntervalSinceReferenceDate:fileDate]; record.fileSize = [NSNumber numberWithLongLong:fileSize];
+
+	record.pageCount = [NSNumber numberWithInt:pageCount]; record.pageNumber = [NSNumber numberWithInt:pageNumber];
+
+	record.lastOpen = [NSDate dateWithTimeIntervalSinceReferenceDate:lastOpen]; record.bookmarks = bookmarks;
+
+	return record;
+}
+
+#pragma mark PDFReaderDocumentStore class methods
+
++ (PDFReaderDocumentStore *)sharedInstance
+{
+	static dispatch_once_t predicate = 0;
+
+	static PDFReaderDocumentStore *object = nil; // Object
+
+	dispatch_once(&predicate, ^{ object = [self new]; });
+
+	return object; // PDFReaderDocumentStore singleton
+}
+
+#pragma mark PDFReaderDocumentStore instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize
+	{
+		storeQueue = dispatch_queue_create("PDFReaderDocumentStoreQueue", DISPATCH_QUEUE_SERIAL);
+
+		NSFileManager *fileManager = [NSFileManager new]; // File manager instance
+
+		NSURL *pathURL = [fileManager URLForDirectory:NSApplicationSupportDirectory inDomain:NSUserDomainMask appropriateForURL:nil create:YES error:NULL];
+
+		storePath = [[pathURL path] stringByAppendingPathComponent:STORE_FILE_NAME];
+
+		records = [NSMutableDictionary new]; guids = [NSMutableDictionary new];
+
+		frameSizes = [NSMutableDictionary new]; pending = [NSMutableDictionary new];
+
+		dispatch_async(storeQueue, ^{ [self loadStore]; });
+
+		NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+
+		[notificationCenter addObserver:self selector:@selector(flush) name:UIApplicationDidEnterBackgroundNotification object:nil];
+
+		[notificationCenter addObserver:self selector:@selector(flush) name:UIApplicationWillTerminateNotification object:nil];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)applyRecord:(PDFReaderDocumentRecord *)record frameSize:(NSUInteger)frameSize
+{
+	NSString *fileName = record.fileName; PDFReaderDocumentRecord *old = [records objectForKey:fileName];
+
+	if (old != nil) { [guids removeObjectForKey:old.guid]; liveBytes -= [[frameSizes objectForKey:fileName] unsignedIntegerValue]; }
+
+	[records setObject:record forKey:fileName]; [guids setObject:fileName forKey:record.guid];
+
+	[frameSizes setObject:[NSNumber numberWithUnsignedInteger:frameSize] forKey:fileName]; liveBytes += frameSize;
+}
+
+- (void)applyDeleteForFileName:(NSString *)fileName
+{
+	PDFReaderDocumentRecord *old = [records objectForKey:fileName]; if (old == nil) return;
+
+	[guids removeObjectForKey:old.guid]; [records removeObjectForKey:fileName];
+
+	liveBytes -= [[frameSizes objectForKey:fileName] unsignedIntegerValue]; [frameSizes removeObjectForKey:fileName];
+}
+
+#pragma mark PDFReaderDocumentStore file methods
+
+- (void)loadStore
+{
+	NSData *data = [NSData dataWithContentsOfFile:storePath options:NSDataReadingMappedIfSafe error:NULL];
+
+	if (data.length < sizeof(PDFReaderDocumentStoreHeader)) return; // Missing - created on first write
+
+	const uint8_t *start = data.bytes; const uint8_t *bytes = start; const uint8_t *end = (start + data.length);
+
+	PDFReaderDocumentStoreHeader header; StoreRead(&bytes, end, &header, sizeof(header));
+
+	if ((header.magic != STORE_MAGIC) || (header.version != STORE_VERSION)) // Unknown - start over
+	{
+		[[NSFileManager new] removeItemAtPath:storePath error:NULL]; return;
+	}
+
+	PDFReaderDocumentStoreFrame frame; // Replay the log, the last record for a file path wins
+
+	while (StoreRead(&bytes, end, &frame, sizeof(frame)) == YES)
+	{
+		if (((size_t)(end - bytes) < frame.length) || (frame.length == 0)) { bytes -= sizeof(frame); break; } // Torn tail
+
+		if (PDFReaderCacheFileChecksum(bytes, frame.length) != frame.checksum) { bytes -= sizeof(frame); break; } // Torn tail
+
+		const uint8_t *payload = bytes; const uint8_t *payloadEnd = (bytes + frame.length); bytes = payloadEnd;
+
+		uint8_t op = 0; StoreRead(&payload, payloadEnd, &op, sizeof(op)); // Record type
+
+		if (op == RECORD_PUT) // Document metadata
+		{
+			PDFReaderDocumentRecord *record = StoreReadPut(payload, payloadEnd);
+
+			if (record != nil) [self applyRecord:record frameSize:(sizeof(frame) + frame.length)];
+		}
+		else if (op == RECORD_DELETE) // Removed document
+		{
+			NSString *fileName = StoreReadString(&payload, payloadEnd); if (fileName != nil) [self applyDeleteForFileName:fileName];
+		}
+	}
+
+	logBytes = (bytes - start); // Valid log bytes
+
+	if (bytes < end) // Drop a torn tail so appends follow the last good record
+	{
+		int fd = open([storePath fileSystemRepresentation], O_WRONLY);
+
+		if (fd >= 0) { ftruncate(fd, logBytes); close(fd); } // The next append overwrites it anyway
+	}
+}
+
+- (BOOL)compactStore
+{
+	NSMutableData *data = [NSMutableData data]; // Live records only
+
+	PDFReaderDocumentStoreHeader header = { STORE_MAGIC, STORE_VERSION };
+
+	[data appendBytes:&header length:sizeof(header)];
+
+	for (PDFReaderDocumentRecord *record in [records objectEnumerator]) [data appendData:StorePutFrame(record)];
+
+	if ([data writeToFile:storePath atomically:YES] == NO) return NO;
+
+	logBytes = data.length; return YES;
+}
+
+- (void)writePending
+{
+	saveScheduled = NO; if (pending.count == 0) return; // Nothing to write
+
+	if (logBytes > ((liveBytes * 2) + STORE_COMPACT_SLACK)) // Rewrite live records only
+	{
+		if ([self compactStore] == YES) [pending removeAllObjects]; // Else kept for the next save
+
+		return;
+	}
+
+	NSMutableData *data = [NSMutableData data]; // One append for the whole batch
+
+	if (logBytes == 0) // New store file
+	{
+		PDFReaderDocumentStoreHeader header = { STORE_MAGIC, STORE_VERSION };
+
+		[data appendBytes:&header length:sizeof(header)];
+	}
+
+	for (NSData *frame in [pending objectEnumerator]) [data appendData:frame]; // Latest frame per file path
+
+	int fd = open([storePath fileSystemRepresentation], (O_WRONLY | O_CREAT), 0644);
+
+	if (fd < 0) return; // Pending frames are kept for the next save
+
+	BOOL written = StoreWrite(fd, data.bytes, data.length, logBytes); // ENOSPC or EIO fail here
+
+	if (written == NO) ftruncate(fd, logBytes); // Drop a partial append
+
+	close(fd);
+
+	if (written == YES) // Only now are the frames on disk
+	{
+		logBytes += data.length; [pending removeAllObjects];
+	}
+}
+
+- (void)scheduleSave
+{
+	if (saveScheduled == NO) // Coalesce store writes
+	{
+		saveScheduled = YES; // Write once after a burst of changes
+
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(STORE_SAVE_DELAY * NSEC_PER_SEC)), storeQueue,
+		^{
+			[self writePending];
+		});
+	}
+}
+
+#pragma mark PDFReaderDocumentStore public methods
+
+- (NSUInteger)recordCount
+{
+	__block NSUInteger count = 0; dispatch_sync(storeQueue, ^{ count = records.count; });
+
+	return count;
+}
+
+- (PDFReaderDocumentRecord *)recordForFileName:(NSString *)fileName
+{
+	if (fileName == nil) return nil; // No key
+
+	__block PDFReaderDocumentRecord *record = nil; // Copy of the stored record
+
+	dispatch_sync(storeQueue, ^{ record = [[records objectForKey:fileName] copy]; });
+
+	return record;
+}
+
+- (PDFReaderDocumentRecord *)recordForGUID:(NSString *)guid
+{
+	if (guid == nil) return nil; // No key
+
+	__block PDFReaderDocumentRecord *record = nil; // Copy of the stored record
+
+	dispatch_sync(storeQueue, ^{ NSString *fileName = [guids objectForKey:guid]; if (fileName != nil) record = [[records objectForKey:fileName] copy]; });
+
+	return record;
+}
+
+- (NSArray *)allRecords
+{
+	__block NSArray *all = nil; // Snapshot of every record - nothing to decode
+
+	dispatch_sync(storeQueue, ^{ all = [[NSArray alloc] initWithArray:[records allValues] copyItems:YES]; });
+
+	return all;
+}
+
+- (void)saveRecord:(PDFReaderDocumentRecord *)record
+{
+	if ((record.guid == nil) || (record.fileName == nil)) return; // Must have both keys
+
+	PDFReaderDocumentRecord *copy = [record copy]; // Snapshot now, write later
+
+	dispatch_async(storeQueue,
+	^{
+		NSData *frame = StorePutFrame(copy); [self applyRecord:copy frameSize:frame.length];
+
+		[pending setObject:frame forKey:copy.fileName]; [self scheduleSave];
+	});
+}
+
+- (void)saveRecords:(NSArray *)batch
+{
+	NSArray *copies = [[NSArray alloc] initWithArray:batch copyItems:YES]; // Snapshot now, write later
+
+	dispatch_async(storeQueue,
+	^{
+		for (PDFReaderDocumentRecord *copy in copies) // One queue hop for the whole batch
+		{
+			if ((copy.guid == nil) || (copy.fileName == nil)) continue; // Must have both keys
+
+			NSData *frame = StorePutFrame(copy); [self applyRecord:copy frameSize:frame.length];
+
+			[pending setObject:frame forKey:copy.fileName];
+		}
+
+		[self scheduleSave];
+	});
+}
+
+- (void)removeRecordForFileName:(NSString *)fileName
+{
+	if (fileName == nil) return; // No key
+
+	NSString *key = [fileName copy]; // Relative file path
+
+	dispatch_async(storeQueue,
+	^{
+		[self applyDeleteForFileName:key];
+
+		[pending setObject:StoreDeleteFrame(key) forKey:key]; [self scheduleSave];
+	});
+}
+
+- (void)flush
+{
+	dispatch_sync(storeQueue, ^{ [self writePending]; });
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderDocumentRecord class implementation
+//
+
+@implementation PDFReaderDocumentRecord
+{
+	NSString *_guid;
+
+	NSString *_fileName;
+
+	NSDate *_fileDate;
+
+	NSNumber *_fileSize;
+
+	NSNumber *_pageCount;
+
+	NSNumber *_pageNumber;
+
+	NSDate *_lastOpen;
+
+	NSIndexSet *_bookmarks;
+}
+
+#pragma mark Properties
+
+@synthesize guid = _guid;
+@synthesize fileName = _fileName;
+@synthesize fileDate = _fileDate;
+@synthesize fileSize = _fileSize;
+@synthesize pageCount = _pageCount;
+@synthesize pageNumber = _pageNumber;
+@synthesize lastOpen = _lastOpen;
+@synthesize bookmarks = _bookmarks;
+
+#pragma mark PDFReaderDocumentRecord instance methods
+
+- (id)copyWithZone:(NSZone *)zone
+{
+	PDFReaderDocumentRecord *copy = [PDFReaderDocumentRecord new];
+
+	copy.guid = _guid; copy.fileName = _fileName; copy.fileDate = _fileDate; copy.fileSize = _fileSize;
+
+	copy.pageCount = _pageCount; copy.pageNumber = _pageNumber; copy.lastOpen = _lastOpen; copy.bookmarks = [_bookmarks copy];
+
+	return copy;
+}
+
+@end
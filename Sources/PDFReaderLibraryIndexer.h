@@ -0,0 +1,64 @@
+//
+//	PDFReaderLibraryIndexer.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <UIKit/UIKit.h>
+
+typedef void (^PDFReaderLibraryIndexerBatchHandler)(NSArray *records);
+
+typedef void (^PDFReaderLibraryIndexerCompletionHandler)(NSUInteger indexed, NSUInteger skipped, BOOL cancelled);
+
+/**
+ *  `PDFReaderLibraryIndexer` scans a directory tree for PDF files and creates
+ *  or refreshes their `PDFReaderDocumentRecord` entries in the document store
+ *  without creating `PDFReaderDocument` objects one at a time.
+ *
+ *  Files are opened with bounded parallelism on low priority threads. Files
+ *  whose size and modification date match their stored record are skipped.
+ *  Records are saved and handed to `batchHandler` (on the main queue) in
+ *  batches as they complete. When `thumbSize` is not `CGSizeZero`, a first
+ *  page thumb is queued at pre-warm priority for every indexed document.
+ */
+@interface PDFReaderLibraryIndexer : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *directoryPath;
+@property (nonatomic, assign, readwrite) NSUInteger maxConcurrent;
+@property (nonatomic, assign, readwrite) NSUInteger batchSize;
+@property (nonatomic, assign, readwrite) CGSize thumbSize;
+@property (nonatomic, copy, readwrite) PDFReaderLibraryIndexerBatchHandler batchHandler;
+@property (nonatomic, copy, readwrite) PDFReaderLibraryIndexerCompletionHandler completionHandler;
+@property (nonatomic, assign, readonly) NSUInteger indexedCount;
+@property (nonatomic, assign, readonly) NSUInteger skippedCount;
+@property (nonatomic, assign, readonly) NSUInteger failedCount;
+@property (nonatomic, assign, readonly, getter=isCancelled) BOOL cancelled;
+@property (nonatomic, assign, readonly, getter=isFinished) BOOL finished;
+
++ (void)runPageCountBenchmarkWithPageCount:(NSUInteger)count;
+
+- (id)initWithDirectoryPath:(NSString *)path;
+
+- (void)start;
+
+- (void)cancel;
+
+@end
@@ -0,0 +1,321 @@
+//
+//	PDFReaderLibraryIndexer.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderLibraryIndexer.h"
+#import "PDFReaderDocument.h"
+#import "PDFReaderDocumentStore.h"
+#import "PDFReaderThumbRequest.h"
+#import "PDFReaderThumbCache.h"
+#import "PDFReaderBenchmark.h"
+#import "PDFReaderCoreStructure.h"
+
+#pragma mark Constants
+
+#define DEFAULT_MAX_CONCURRENT 4
+#define DEFAULT_BATCH_SIZE 32
+
+#pragma mark PDFReaderLibraryIndexer functions
+
+static NSInteger StructurePageCount(NSURL *fileURL)
+{
+	PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithPath([[fileURL path] fileSystemRepresentation], NULL);
+
+	if (structure == NULL) return 0; // Encrypted or not readable without CoreGraphics
+
+	NSInteger pageCount = PDFReaderCoreStructurePageCount(structure); PDFReaderCoreStructureDestroy(structure);
+
+	return pageCount;
+}
+
+@implementation PDFReaderLibraryIndexer
+{
+	NSString *_directoryPath;
+
+	NSUInteger _maxConcurrent;
+
+	NSUInteger _batchSize;
+
+	CGSize _thumbSize;
+
+	PDFReaderLibraryIndexerBatchHandler _batchHandler;
+
+	PDFReaderLibraryIndexerCompletionHandler _completionHandler;
+
+	NSUInteger _indexedCount;
+
+	NSUInteger _skippedCount;
+
+	NSUInteger _failedCount;
+
+	BOOL _cancelled;
+
+	BOOL _finished;
+
+	BOOL started;
+
+	NSString *applicationPath; // Only files inside it can be stored
+
+	NSMutableArray *results; // Records waiting for the next batch
+}
+
+#pragma mark Properties
+
+@synthesize directoryPath = _directoryPath;
+@synthesize maxConcurrent = _maxConcurrent;
+@synthesize batchSize = _batchSize;
+@synthesize thumbSize = _thumbSize;
+@synthesize batchHandler = _batchHandler;
+@synthesize completionHandler = _completionHandler;
+@synthesize indexedCount = _indexedCount;
+@synthesize skippedCount = _skippedCount;
+@synthesize failedCount = _failedCount;
+@synthesize cancelled = _cancelled;
+@synthesize finished = _finished;
+
+#pragma mark PDFReaderLibraryIndexer class methods
+
++ (void)runPageCountBenchmarkWithPageCount:(NSUInteger)count
+{
+#ifdef DEBUG
+	if (count == 0) return; // Nothing to count
+
+	NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PDFReaderPageCountBenchmark.pdf"];
+
+	if ([PDFReaderBenchmarkCreatePagesPDF(count, 32) writeToFile:path atomically:YES] == NO) { NSLog(@"%s Unable to write the benchmark document", __FUNCTION__); return; }
+
+	NSURL *fileURL = [NSURL fileURLWithPath:path isDirectory:NO]; NSUInteger runs = 20; NSUInteger mismatches = 0;
+
+	NSMutableArray *graphicsSamples = [NSMutableArray arrayWithCapacity:runs];
+
+	NSMutableArray *structureSamples = [NSMutableArray arrayWithCapacity:runs];
+
+	for (NSUInteger run = 0; run < runs; run++)
+	{
+		CFAbsoluteTime graphicsStart = CFAbsoluteTimeGetCurrent(); // CoreGraphics open and count
+
+		CGPDFDocumentRef document = CGPDFDocumentCreateWithURL((__bridge CFURLRef)fileURL);
+
+		size_t graphicsCount = ((document != NULL) ? CGPDFDocumentGetNumberOfPages(document) : 0); CGPDFDocumentRelease(document);
+
+		[graphicsSamples addObject:[NSNumber numberWithDouble:(CFAbsoluteTimeGetCurrent() - graphicsStart)]];
+
+		CFAbsoluteTime structureStart = CFAbsoluteTimeGetCurrent(); // Structure reader open and count
+
+		NSInteger structureCount = StructurePageCount(fileURL);
+
+		[structureSamples addObject:[NSNumber numberWithDouble:(CFAbsoluteTimeGetCurrent() - structureStart)]];
+
+		if ((graphicsCount != count) || (structureCount != (NSInteger)count)) mismatches++;
+	}
+
+	PDFReaderBenchmarkLog(@"CoreGraphics page count", graphicsSamples); PDFReaderBenchmarkLog(@"Structure reader page count", structureSamples);
+
+	if (mismatches > 0) NSLog(@"%s %u runs miscounted %u pages", __FUNCTION__, (unsigned)mismatches, (unsigned)count);
+
+	[[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+#endif // DEBUG
+}
+
+#pragma mark PDFReaderLibraryIndexer instance methods
+
+- (id)initWithDirectoryPath:(NSString *)path
+{
+	if ((self = [super init])) // Initialize superclass object first
+	{
+		_directoryPath = [path copy]; _batchSize = DEFAULT_BATCH_SIZE; _thumbSize = CGSizeZero;
+
+		_maxConcurrent = MAX(1, MIN([[NSProcessInfo processInfo] activeProcessorCount], DEFAULT_MAX_CONCURRENT));
+
+		results = [NSMutableArray new];
+
+		NSArray *documentsPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES);
+
+		applicationPath = [[documentsPaths objectAtIndex:0] stringByDeletingLastPathComponent]; // Strip "Documents" component
+	}
+
+	return self;
+}
+
+- (void)start
+{
+	@synchronized(self) { if (started == YES) return; started = YES; }
+
+	dispatch_semaphore_t slots = dispatch_semaphore_create(MAX(1, _maxConcurrent)); // Bounded parallelism
+
+	dispatch_queue_t workQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0);
+
+	dispatch_queue_t scanQueue = dispatch_queue_create("PDFReaderLibraryIndexerScanQueue", DISPATCH_QUEUE_SERIAL);
+
+	dispatch_group_t group = dispatch_group_create(); // Outstanding file work
+
+	dispatch_async(scanQueue,
+	^{
+		NSMutableDictionary *known = [NSMutableDictionary new]; // Stored records by relative file path
+
+		for (PDFReaderDocumentRecord *record in [[PDFReaderDocumentStore sharedInstance] allRecords])
+		{
+			[known setObject:record forKey:record.fileName];
+		}
+
+		NSArray *keys = [NSArray arrayWithObjects:NSURLIsRegularFileKey, NSURLFileSizeKey, NSURLContentModificationDateKey, nil];
+
+		NSURL *directoryURL = [[NSURL alloc] initFileURLWithPath:_directoryPath isDirectory:YES];
+
+		NSDirectoryEnumerator *enumerator = [[NSFileManager new] enumeratorAtURL:directoryURL includingPropertiesForKeys:keys
+																		 options:NSDirectoryEnumerationSkipsHiddenFiles errorHandler:nil];
+
+		for (NSURL *fileURL in enumerator) // Walk the directory tree
+		{
+			if (_cancelled == YES) break; // Stop scanning
+
+			if ([[fileURL pathExtension] caseInsensitiveCompare:@"pdf"] != NSOrderedSame) continue;
+
+			NSNumber *regular = nil; NSNumber *fileSize = nil; NSDate *fileDate = nil; // File attributes
+
+			[fileURL getResourceValue:&regular forKey:NSURLIsRegularFileKey error:NULL]; if ([regular boolValue] == NO) continue;
+
+			[fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+
+			[fileURL getResourceValue:&fileDate forKey:NSURLContentModificationDateKey error:NULL];
+
+			NSString *filePath = [fileURL path]; PDFReaderDocumentRecord *record = nil; // Same file in the same folder
+
+			if ([filePath rangeOfString:applicationPath].location != NSNotFound) record = [known objectForKey:[PDFReaderDocument relativeFilePath:filePath]];
+
+			if ((record != nil) && [record.fileSize isEqual:fileSize] && (fabs([record.fileDate timeIntervalSinceDate:fileDate]) < 1.0))
+			{
+				@synchronized(self) { _skippedCount++; } continue; // Unchanged
+			}
+
+			dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER); // Wait for a free slot
+
+			if (_cancelled == YES) { dispatch_semaphore_signal(slots); break; }
+
+			dispatch_group_async(group, workQueue,
+			^{
+				PDFReaderDocumentRecord *indexed = [self indexFileURL:fileURL size:fileSize date:fileDate record:record];
+
+				if (indexed != nil) [self addResult:indexed]; else @synchronized(self) { _failedCount++; }
+
+				dispatch_semaphore_signal(slots);
+			});
+		}
+
+		dispatch_group_notify(group, scanQueue,
+		^{
+			[self sendBatch]; // Whatever is left
+
+			BOOL cancelled = _cancelled; NSUInteger indexed, skipped; // Final counts
+
+			@synchronized(self) { _finished = YES; indexed = _indexedCount; skipped = _skippedCount; }
+
+			PDFReaderLibraryIndexerCompletionHandler handler = _completionHandler;
+
+			if (handler != nil) dispatch_async(dispatch_get_main_queue(), ^{ handler(indexed, skipped, cancelled); });
+
+			#ifdef DEBUG
+				NSLog(@"%s %i indexed, %i skipped, %i failed%@", __FUNCTION__, (int)indexed, (int)skipped, (int)_failedCount, (cancelled ? @" (cancelled)" : @""));
+			#endif
+		});
+	});
+}
+
+- (void)cancel
+{
+	_cancelled = YES; // Checked before each file
+}
+
+- (PDFReaderDocumentRecord *)indexFileURL:(NSURL *)fileURL size:(NSNumber *)fileSize date:(NSDate *)fileDate record:(PDFReaderDocumentRecord *)stored
+{
+	if (_cancelled == YES) return nil; // Skip the work
+
+	if ([[fileURL path] rangeOfString:applicationPath].location == NSNotFound) return nil; // Not storable
+
+	BOOL unlocked = YES; NSInteger pageCount = StructurePageCount(fileURL); // Unencrypted documents skip CoreGraphics
+
+	if (pageCount <= 0) // Fall back to a full CoreGraphics open
+	{
+		CGPDFDocumentRef thePDFDocRef = CGPDFDocumentCreateWithURL((__bridge CFURLRef)fileURL);
+
+		if (thePDFDocRef == NULL) return nil; // Not a readable PDF
+
+		unlocked = ((CGPDFDocumentIsEncrypted(thePDFDocRef) == NO) || (CGPDFDocumentUnlockWithPassword(thePDFDocRef, "") == YES));
+
+		pageCount = CGPDFDocumentGetNumberOfPages(thePDFDocRef); CGPDFDocumentRelease(thePDFDocRef);
+	}
+
+	NSString *filePath = [PDFReaderDocument relativeFilePath:[fileURL path]]; // Store key
+
+	if (stored == nil) stored = [PDFReaderDocument importArchiveForFilePath:filePath]; // Keep legacy bookmarks
+
+	PDFReaderDocumentRecord *record = ((stored != nil) ? [stored copy] : [PDFReaderDocumentRecord new]);
+
+	if (stored == nil) // New document
+	{
+		record.guid = [PDFReaderDocument GUID]; record.pageNumber = [NSNumber numberWithInteger:1];
+
+		record.lastOpen = [NSDate dateWithTimeIntervalSinceReferenceDate:0.0]; record.bookmarks = [NSIndexSet indexSet];
+	}
+
+	record.fileName = filePath;
+
+	record.fileDate = fileDate; record.fileSize = fileSize; record.pageCount = [NSNumber numberWithInteger:pageCount];
+
+	if ((unlocked == YES) && (pageCount > 0) && (CGSizeEqualToSize(_thumbSize, CGSizeZero) == NO)) // Queue a first page thumb
+	{
+		[PDFReaderThumbCache createThumbCacheWithGUID:record.guid]; // Thumb cache directory
+
+		PDFReaderThumbRequest *request = [PDFReaderThumbRequest newForView:nil fileURL:fileURL password:nil guid:record.guid page:1 size:_thumbSize];
+
+		[[PDFReaderThumbCache sharedInstance] thumbRequest:request priorityClass:PDFReaderThumbPriorityPrewarm];
+	}
+
+	return record;
+}
+
+- (void)addResult:(PDFReaderDocumentRecord *)record
+{
+	BOOL full = NO; // Batch ready
+
+	@synchronized(self) { [results addObject:record]; _indexedCount++; full = (results.count >= MAX(1, _batchSize)); }
+
+	if (full == YES) [self sendBatch];
+}
+
+- (void)sendBatch
+{
+	NSArray *batch = nil; // Records to save and report
+
+	@synchronized(self) { if (results.count > 0) { batch = [results copy]; [results removeAllObjects]; } }
+
+	if (batch == nil) return; // Nothing to send
+
+	[[PDFReaderDocumentStore sharedInstance] saveRecords:batch]; // One coalesced store write
+
+	PDFReaderLibraryIndexerBatchHandler handler = _batchHandler;
+
+	if (handler != nil) dispatch_async(dispatch_get_main_queue(), ^{ handler(batch); });
+}
+
+@end
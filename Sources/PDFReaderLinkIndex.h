@@ -0,0 +1,54 @@
+//
+//	PDFReaderLinkIndex.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ *  `PDFReaderLinkIndex` holds every link annotation of a document: its rect
+ *  (in page view space) and its resolved target (page number `NSNumber` or
+ *  `NSURL`). Each page's links are bucketed in a fixed grid, so a tap only
+ *  tests the links in one cell.
+ *
+ *  The index is built once on a background queue and saved next to the
+ *  document's thumbs (`Caches/<GUID>/links.index`). It is rebuilt when the
+ *  document file changes size or modification date.
+ */
+@interface PDFReaderLinkIndex : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *guid;
+@property (nonatomic, assign, readonly, getter=isReady) BOOL ready;
+@property (nonatomic, assign, readonly) NSUInteger linkCount;
+
++ (PDFReaderLinkIndex *)linkIndexWithGUID:(NSString *)guid;
+
++ (void)closeLinkIndexWithGUID:(NSString *)guid;
+
+- (void)buildWithURL:(NSURL *)fileURL password:(NSString *)phrase;
+
+- (BOOL)hitTestPage:(NSInteger)page point:(CGPoint)point target:(id *)target;
+
+- (NSArray *)linkRectsForPage:(NSInteger)page;
+
+@end
@@ -0,0 +1,477 @@
+//
+//	PDFReaderLinkIndex.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderLinkIndex.h"
+#import "PDFReaderContentPage.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderCacheFile.h"
+
+#import <UIKit/UIKit.h>
+
+#pragma mark Constants
+
+#define INDEX_MAGIC 0x494C5250
+#define INDEX_VERSION 1
+#define INDEX_FILE_NAME @"links.index"
+
+#define GRID_COLUMNS 16
+#define GRID_ROWS 16
+#define GRID_CELLS (GRID_COLUMNS * GRID_ROWS)
+
+#define TARGET_NONE 0
+#define TARGET_PAGE 1
+#define TARGET_URL 2
+
+typedef struct
+{
+	float x; float y; float w; float h; // Link rect
+	uint32_t type; uint32_t value; // Target type and page number (or URL byte count)
+} PDFReaderLinkIndexRecord;
+
+#pragma mark -
+
+//
+//	PDFReaderLinkIndexPage class interface
+//
+
+@interface PDFReaderLinkIndexPage : NSObject <NSObject>
+{
+@public // Instance variables
+
+	CGSize pageSize;
+
+	NSUInteger count;
+
+	CGRect *rects;
+
+	NSArray *targets;
+
+	uint32_t cellStart[GRID_CELLS + 1];
+
+	uint32_t *cellLinks;
+}
+
+- (id)initWithPageSize:(CGSize)size rects:(const CGRect *)linkRects targets:(NSArray *)linkTargets;
+
+- (BOOL)hitTestPoint:(CGPoint)point target:(id *)target;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderLinkIndex class implementation
+//
+
+@implementation PDFReaderLinkIndex
+{
+	NSString *_guid;
+
+	NSArray *pages; // PDFReaderLinkIndexPage objects (index 0 is page 1)
+
+	NSUInteger _linkCount;
+
+	BOOL building;
+}
+
+#pragma mark Properties
+
+@synthesize guid = _guid;
+
+#pragma mark PDFReaderLinkIndex class methods
+
++ (NSMutableDictionary *)openIndexes
+{
+	static dispatch_once_t predicate = 0;
+
+	static NSMutableDictionary *indexes = nil; // Open link indexes by GUID
+
+	dispatch_once(&predicate, ^{ indexes = [NSMutableDictionary new]; });
+
+	return indexes;
+}
+
++ (dispatch_queue_t)buildQueue
+{
+	static dispatch_once_t predicate = 0;
+
+	static dispatch_queue_t queue = NULL; // Serial background build queue
+
+	dispatch_once(&predicate,
+	^{
+		queue = dispatch_queue_create("PDFReaderLinkIndexQueue", DISPATCH_QUEUE_SERIAL);
+
+		dispatch_set_target_queue(queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+	});
+
+	return queue;
+}
+
++ (PDFReaderLinkIndex *)linkIndexWithGUID:(NSString *)guid
+{
+	if (guid == nil) return nil; // Must have a document GUID
+
+	NSMutableDictionary *indexes = [PDFReaderLinkIndex openIndexes];
+
+	@synchronized(indexes) // Mutex lock
+	{
+		PDFReaderLinkIndex *index = [indexes objectForKey:guid];
+
+		if (index == nil) // New (empty) link index
+		{
+			index = [PDFReaderLinkIndex new]; index->_guid = [guid copy];
+
+			[indexes setObject:index forKey:guid];
+		}
+
+		return index;
+	}
+}
+
++ (void)closeLinkIndexWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to close
+
+	NSMutableDictionary *indexes = [PDFReaderLinkIndex openIndexes];
+
+	@synchronized(indexes) { [indexes removeObjectForKey:guid]; }
+}
+
++ (NSString *)indexPathForGUID:(NSString *)guid
+{
+	return PDFReaderCacheFilePath(guid, INDEX_FILE_NAME);
+}
+
+#pragma mark PDFReaderLinkIndex instance methods
+
+- (BOOL)isReady
+{
+	@synchronized(self) { return (pages != nil); }
+}
+
+- (NSUInteger)linkCount
+{
+	@synchronized(self) { return _linkCount; }
+}
+
+- (void)buildWithURL:(NSURL *)fileURL password:(NSString *)phrase
+{
+	@synchronized(self) // Mutex lock
+	{
+		if ((pages != nil) || (building == YES) || (fileURL == nil)) return;
+
+		building = YES; // Once
+	}
+
+	dispatch_async([PDFReaderLinkIndex buildQueue],
+	^{
+		uint64_t fileSize = 0; double fileDate = 0.0; // Document file identity
+
+		BOOL known = PDFReaderCacheFileIdentity(fileURL, &fileSize, &fileDate);
+
+		NSArray *newPages = (known ? [self loadIndexWithFileSize:fileSize fileDate:fileDate] : nil);
+
+		if (newPages == nil) // Missing or stale - walk the document once
+		{
+			newPages = [self indexDocumentWithURL:fileURL password:phrase];
+
+			if ((newPages != nil) && (known == YES)) [self saveIndex:newPages fileSize:fileSize fileDate:fileDate];
+		}
+
+		NSUInteger links = 0; for (PDFReaderLinkIndexPage *page in newPages) links += page->count;
+
+		@synchronized(self) { pages = newPages; _linkCount = links; building = NO; }
+
+#ifdef DEBUG
+		NSLog(@"%s %@ pages %i links %i", __FUNCTION__, _guid, (int)newPages.count, (int)links);
+#endif
+	});
+}
+
+- (NSArray *)indexDocumentWithURL:(NSURL *)fileURL password:(NSString *)phrase
+{
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+	CGPDFDocumentRef document = [documentPool retainDocumentWithURL:fileURL password:phrase guid:_guid];
+
+	if (document == NULL) return nil; // Unable to open the document
+
+	NSInteger pageCount = CGPDFDocumentGetNumberOfPages(document); // Pages
+
+	NSMutableArray *newPages = [NSMutableArray arrayWithCapacity:pageCount];
+
+	for (NSInteger number = 1; number <= pageCount; number++) // Walk every page once
+	{
+		@autoreleasepool
+		{
+			CGPDFPageRef pageRef = CGPDFDocumentGetPage(document, number);
+
+			PDFReaderPageGeometry geometry = [PDFReaderContentPage geometryForPage:pageRef];
+
+			NSArray *links = ((pageRef != NULL) ? [PDFReaderContentPage linksForPage:pageRef geometry:geometry] : nil);
+
+			CGRect *rects = malloc(MAX(links.count, 1) * sizeof(CGRect)); NSMutableArray *targets = [NSMutableArray array];
+
+			[links enumerateObjectsUsingBlock:^(PDFReaderDocumentLink *link, NSUInteger index, BOOL *stop)
+			{
+				id target = [PDFReaderContentPage linkTargetForAnnotation:link.dictionary document:document];
+
+				rects[index] = link.rect; [targets addObject:((target != nil) ? target : [NSNull null])];
+			}];
+
+			CGSize pageSize = CGSizeMake(geometry.width, geometry.height); // Page view space
+
+			[newPages addObject:[[PDFReaderLinkIndexPage alloc] initWithPageSize:pageSize rects:rects targets:targets]];
+
+			free(rects);
+		}
+	}
+
+	[documentPool releaseDocument:document]; return newPages;
+}
+
+- (void)saveIndex:(NSArray *)newPages fileSize:(uint64_t)fileSize fileDate:(double)fileDate
+{
+	NSMutableData *data = [NSMutableData data]; // Index file contents
+
+	PDFReaderCacheFileHeader header = PDFReaderCacheFileMakeHeader(INDEX_MAGIC, INDEX_VERSION, fileSize, fileDate, (uint32_t)newPages.count);
+
+	[data appendBytes:&header length:sizeof(header)]; // Page count
+
+	for (PDFReaderLinkIndexPage *page in newPages) // Page size, link count, then links
+	{
+		float size[2] = { page->pageSize.width, page->pageSize.height }; uint32_t count = (uint32_t)page->count;
+
+		[data appendBytes:size length:sizeof(size)]; [data appendBytes:&count length:sizeof(count)];
+
+		for (NSUInteger index = 0; index < page->count; index++)
+		{
+			CGRect rect = page->rects[index]; id target = [page->targets objectAtIndex:index]; NSData *url = nil;
+
+			PDFReaderLinkIndexRecord record = { rect.origin.x, rect.origin.y, rect.size.width, rect.size.height, TARGET_NONE, 0 };
+
+			if ([target isKindOfClass:[NSNumber class]]) // Page number
+			{
+				record.type = TARGET_PAGE; record.value = [target unsignedIntValue];
+			}
+			else if ([target isKindOfClass:[NSURL class]]) // URL bytes follow
+			{
+				url = [[target absoluteString] dataUsingEncoding:NSUTF8StringEncoding];
+
+				record.type = TARGET_URL; record.value = (uint32_t)url.length;
+			}
+
+			[data appendBytes:&record length:sizeof(record)]; if (url != nil) [data appendData:url];
+		}
+	}
+
+	PDFReaderCacheFileWrite(_guid, INDEX_FILE_NAME, data);
+}
+
+- (NSArray *)loadIndexWithFileSize:(uint64_t)fileSize fileDate:(double)fileDate
+{
+	NSString *indexPath = [PDFReaderLinkIndex indexPathForGUID:_guid]; // Index file
+
+	NSData *data = [NSData dataWithContentsOfFile:indexPath options:NSDataReadingMappedIfSafe error:NULL];
+
+	PDFReaderCacheFileHeader header; // Missing, truncated, stale or for a changed document
+
+	if (PDFReaderCacheFileReadHeader(data, INDEX_MAGIC, INDEX_VERSION, fileSize, fileDate, &header) == NO) return nil;
+
+	const uint8_t *bytes = ((const uint8_t *)data.bytes + sizeof(header)); const uint8_t *end = ((const uint8_t *)data.bytes + data.length);
+
+	NSMutableArray *newPages = [NSMutableArray arrayWithCapacity:header.count];
+
+	for (uint32_t number = 0; number < header.count; number++) // Read each page
+	{
+		float size[2]; uint32_t count = 0; // Page size and link count
+
+		if ((size_t)(end - bytes) < (sizeof(size) + sizeof(count))) return nil;
+
+		memcpy(size, bytes, sizeof(size)); bytes += sizeof(size); memcpy(&count, bytes, sizeof(count)); bytes += sizeof(count);
+
+		CGRect *rects = malloc(MAX(count, 1) * sizeof(CGRect)); NSMutableArray *targets = [NSMutableArray arrayWithCapacity:count];
+
+		for (uint32_t index = 0; index < count; index++) // Read each link
+		{
+			PDFReaderLinkIndexRecord record; id target = [NSNull null];
+
+			if ((size_t)(end - bytes) < sizeof(record)) { free(rects); return nil; }
+
+			memcpy(&record, bytes, sizeof(record)); bytes += sizeof(record);
+
+			rects[index] = CGRectMake(record.x, record.y, record.w, record.h); // Link rect
+
+			if (record.type == TARGET_PAGE) // Page number
+			{
+				target = [NSNumber numberWithInteger:record.value];
+			}
+			else if (record.type == TARGET_URL) // URL
+			{
+				if ((size_t)(end - bytes) < record.value) { free(rects); return nil; }
+
+				NSString *string = [[NSString alloc] initWithBytes:bytes length:record.value encoding:NSUTF8StringEncoding];
+
+				bytes += record.value; NSURL *url = ((string != nil) ? [NSURL URLWithString:string] : nil);
+
+				if (url != nil) target = url;
+			}
+
+			[targets addObject:target];
+		}
+
+		[newPages addObject:[[PDFReaderLinkIndexPage alloc] initWithPageSize:CGSizeMake(size[0], size[1]) rects:rects targets:targets]];
+
+		free(rects);
+	}
+
+	return newPages;
+}
+
+- (PDFReaderLinkIndexPage *)indexPageForPage:(NSInteger)page
+{
+	@synchronized(self) // Mutex lock
+	{
+		if ((page < 1) || (page > (NSInteger)pages.count)) return nil;
+
+		return [pages objectAtIndex:(page - 1)];
+	}
+}
+
+- (BOOL)hitTestPage:(NSInteger)page point:(CGPoint)point target:(id *)target
+{
+	PDFReaderLinkIndexPage *indexPage = [self indexPageForPage:page];
+
+	return [indexPage hitTestPoint:point target:target];
+}
+
+- (NSArray *)linkRectsForPage:(NSInteger)page
+{
+	PDFReaderLinkIndexPage *indexPage = [self indexPageForPage:page];
+
+	if (indexPage == nil) return nil; // No such page (or not ready)
+
+	NSMutableArray *rects = [NSMutableArray arrayWithCapacity:indexPage->count];
+
+	for (NSUInteger index = 0; index < indexPage->count; index++) [rects addObject:[NSValue valueWithCGRect:indexPage->rects[index]]];
+
+	return rects;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderLinkIndexPage class implementation
+//
+
+@implementation PDFReaderLinkIndexPage
+
+#pragma mark PDFReaderLinkIndexPage functions
+
+static inline NSInteger GridColumn(CGFloat x, CGSize size)
+{
+	NSInteger column = (NSInteger)floor((x * GRID_COLUMNS) / size.width); return MIN(MAX(column, 0), (GRID_COLUMNS - 1));
+}
+
+static inline NSInteger GridRow(CGFloat y, CGSize size)
+{
+	NSInteger row = (NSInteger)floor((y * GRID_ROWS) / size.height); return MIN(MAX(row, 0), (GRID_ROWS - 1));
+}
+
+#pragma mark PDFReaderLinkIndexPage instance methods
+
+- (id)initWithPageSize:(CGSize)size rects:(const CGRect *)linkRects targets:(NSArray *)linkTargets
+{
+	if ((self = [super init])) // Bucket the links into the grid cells they overlap
+	{
+		pageSize = size; count = linkTargets.count; targets = [linkTargets copy];
+
+		rects = malloc(MAX(count, 1) * sizeof(CGRect)); memcpy(rects, linkRects, (count * sizeof(CGRect)));
+
+		if ((pageSize.width <= 0.0f) || (pageSize.height <= 0.0f)) pageSize = CGSizeMake(1.0f, 1.0f);
+
+		uint32_t cellCount[GRID_CELLS]; memset(cellCount, 0x00, sizeof(cellCount)); // Links per cell
+
+		for (NSUInteger pass = 0; pass < 2; pass++) // Count, then fill
+		{
+			for (NSUInteger index = 0; index < count; index++)
+			{
+				CGRect rect = rects[index]; // Link rect
+
+				NSInteger c0 = GridColumn(CGRectGetMinX(rect), pageSize); NSInteger c1 = GridColumn(CGRectGetMaxX(rect), pageSize);
+
+				NSInteger r0 = GridRow(CGRectGetMinY(rect), pageSize); NSInteger r1 = GridRow(CGRectGetMaxY(rect), pageSize);
+
+				for (NSInteger row = r0; row <= r1; row++)
+				{
+					for (NSInteger column = c0; column <= c1; column++)
+					{
+						NSInteger cell = ((row * GRID_COLUMNS) + column); // Grid cell
+
+						if (pass == 0) cellCount[cell]++; else cellLinks[cellStart[cell] + cellCount[cell]++] = (uint32_t)index;
+					}
+				}
+			}
+
+			if (pass == 0) // Prefix sums give each cell's slice of cellLinks
+			{
+				cellStart[0] = 0; for (NSInteger cell = 0; cell < GRID_CELLS; cell++) cellStart[cell + 1] = (cellStart[cell] + cellCount[cell]);
+
+				cellLinks = malloc(MAX(cellStart[GRID_CELLS], 1) * sizeof(uint32_t)); memset(cellCount, 0x00, sizeof(cellCount));
+			}
+		}
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (rects != NULL) free(rects), rects = NULL;
+
+	if (cellLinks != NULL) free(cellLinks), cellLinks = NULL;
+}
+
+- (BOOL)hitTestPoint:(CGPoint)point target:(id *)target
+{
+	if ((count == 0) || (point.x < 0.0f) || (point.y < 0.0f) || (point.x > pageSize.width) || (point.y > pageSize.height)) return NO;
+
+	NSInteger cell = ((GridRow(point.y, pageSize) * GRID_COLUMNS) + GridColumn(point.x, pageSize));
+
+	for (uint32_t slot = cellStart[cell]; slot < cellStart[cell + 1]; slot++) // Same order as the links list
+	{
+		uint32_t index = cellLinks[slot]; // Link index
+
+		if (CGRectContainsPoint(rects[index], point) == true) // Found it
+		{
+			id object = [targets objectAtIndex:index]; *target = ((object != [NSNull null]) ? object : nil); return YES;
+		}
+	}
+
+	return NO;
+}
+
+@end
@@ -111,7 +111,7 @@
 
 		PDFReaderThumbRequest *request = [PDFReaderThumbRequest newForView:pageThumbView fileURL:fileURL password:phrase guid:guid page:page size:size];
 
-		UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:request priority:YES]; // Request the thumb
+		UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:request priorityClass:PDFReaderThumbPriorityPagebarLarge]; // Request the thumb
 
 		UIImage *thumb = ([image isKindOfClass:[UIImage class]] ? image : nil); [pageThumbView showImage:thumb];
 	}
@@ -202,6 +202,10 @@
 
 		document = object; // Retain the document object for our use
 
+		[PDFReaderThumbCache registerThumbSize:CGSizeMake(THUMB_SMALL_WIDTH, THUMB_SMALL_HEIGHT) forGUID:document.guid];
+
+		[PDFReaderThumbCache registerThumbSize:CGSizeMake(THUMB_LARGE_WIDTH, THUMB_LARGE_HEIGHT) forGUID:document.guid];
+
 		[self updatePageNumberText:[document.pageNumber integerValue]];
 
 		miniThumbViews = [NSMutableDictionary new]; // Small thumbs
@@ -210,6 +214,13 @@
 	return self;
 }
 
+- (void)dealloc
+{
+	[PDFReaderThumbCache unregisterThumbSize:CGSizeMake(THUMB_SMALL_WIDTH, THUMB_SMALL_HEIGHT) forGUID:document.guid];
+
+	[PDFReaderThumbCache unregisterThumbSize:CGSizeMake(THUMB_LARGE_WIDTH, THUMB_LARGE_HEIGHT) forGUID:document.guid];
+}
+
 - (void)removeFromSuperview
 {
 	[trackTimer invalidate]; [enableTimer invalidate];
@@ -286,7 +297,7 @@
 
 			PDFReaderThumbRequest *thumbRequest = [PDFReaderThumbRequest newForView:smallThumbView fileURL:fileURL password:phrase guid:guid page:page size:size];
 
-			UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:thumbRequest priority:NO]; // Request the thumb
+			UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:thumbRequest priorityClass:PDFReaderThumbPriorityPagebarSmall]; // Request the thumb
 
 			if ([image isKindOfClass:[UIImage class]]) [smallThumbView showImage:image]; // Use thumb image from cache
 
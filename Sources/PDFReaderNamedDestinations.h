@@ -0,0 +1,54 @@
+//
+//	PDFReaderNamedDestinations.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ *  `PDFReaderNamedDestinations` resolves named destinations to destination
+ *  arrays (target page followed by the view). The document's `/Names /Dests`
+ *  name tree and legacy catalog `/Dests` dictionary are flattened once into
+ *  hash tables keyed by the raw name bytes and length, so binary names work
+ *  and each lookup is O(1).
+ *
+ *  Tables are kept with the pooled document (see `PDFReaderDocumentPool`)
+ *  and the returned arrays are only valid while the document is retained.
+ */
+@interface PDFReaderNamedDestinations : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
++ (PDFReaderNamedDestinations *)destinationsForDocument:(CGPDFDocumentRef)document;
+
++ (void)runLookupBenchmarkWithCount:(NSUInteger)count;
+
+- (id)initWithDocument:(CGPDFDocumentRef)document;
+
+- (CGPDFArrayRef)destinationForString:(CGPDFStringRef)name;
+
+- (CGPDFArrayRef)destinationForName:(const char *)name;
+
+- (CGPDFArrayRef)destinationForBytes:(const void *)bytes length:(size_t)length;
+
+@end
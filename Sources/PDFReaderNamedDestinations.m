@@ -0,0 +1,295 @@
+//
+//	PDFReaderNamedDestinations.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderNamedDestinations.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderBenchmark.h"
+
+#import "PDFReaderCoreNameTable.h"
+
+@implementation PDFReaderNamedDestinations
+{
+	PDFReaderCoreNameTableRef treeDestinations; // Name tree strings
+
+	PDFReaderCoreNameTableRef legacyDestinations; // Catalog /Dests names
+}
+
+#pragma mark Constants
+
+#define ATTACHMENT_KEY @"PDFReaderNamedDestinations"
+
+#define NAME_TREE_DEPTH 32
+
+#pragma mark PDFReaderNamedDestinations functions
+
+static CGPDFArrayRef DestinationFromObject(CGPDFObjectRef object)
+{
+	CGPDFArrayRef destinationArray = NULL; CGPDFDictionaryRef destinationDictionary = NULL;
+
+	if (CGPDFObjectGetValue(object, kCGPDFObjectTypeArray, &destinationArray) == true) return destinationArray;
+
+	if (CGPDFObjectGetValue(object, kCGPDFObjectTypeDictionary, &destinationDictionary) == true)
+	{
+		CGPDFDictionaryGetArray(destinationDictionary, "D", &destinationArray);
+	}
+
+	return destinationArray;
+}
+
+static void FlattenNameTree(CGPDFDictionaryRef node, PDFReaderCoreNameTableRef table, NSInteger depth)
+{
+	CGPDFArrayRef namesArray = NULL; // Leaf (or root) names array
+
+	if (CGPDFDictionaryGetArray(node, "Names", &namesArray) == true)
+	{
+		size_t namesCount = CGPDFArrayGetCount(namesArray); // Name, value pairs
+
+		for (size_t index = 0; (index + 1) < namesCount; index += 2)
+		{
+			CGPDFStringRef name = NULL; CGPDFObjectRef value = NULL; // Pair
+
+			if ((CGPDFArrayGetString(namesArray, index, &name) == true) && (CGPDFArrayGetObject(namesArray, (index + 1), &value) == true))
+			{
+				CGPDFArrayRef destinationArray = DestinationFromObject(value); if (destinationArray == NULL) continue;
+
+				PDFReaderCoreNameTableAdd(table, CGPDFStringGetBytePtr(name), CGPDFStringGetLength(name), destinationArray); // First wins
+			}
+		}
+	}
+
+	CGPDFArrayRef kidsArray = NULL; // Intermediate node kids
+
+	if ((depth < NAME_TREE_DEPTH) && (CGPDFDictionaryGetArray(node, "Kids", &kidsArray) == true))
+	{
+		size_t kidsCount = CGPDFArrayGetCount(kidsArray); // Number of kids
+
+		for (size_t index = 0; index < kidsCount; index++)
+		{
+			CGPDFDictionaryRef kidNode = NULL; // Kid node dictionary
+
+			if (CGPDFArrayGetDictionary(kidsArray, index, &kidNode) == true)
+			{
+				FlattenNameTree(kidNode, table, (depth + 1));
+			}
+		}
+	}
+}
+
+static void FlattenDestsEntry(const char *key, CGPDFObjectRef object, void *info)
+{
+	PDFReaderCoreNameTableRef table = (PDFReaderCoreNameTableRef)info; // Legacy table
+
+	CGPDFArrayRef destinationArray = DestinationFromObject(object); // Array or << /D array >>
+
+	if (destinationArray != NULL) PDFReaderCoreNameTableAdd(table, key, strlen(key), destinationArray);
+}
+
+#pragma mark PDFReaderNamedDestinations class methods
+
++ (PDFReaderNamedDestinations *)destinationsForDocument:(CGPDFDocumentRef)document
+{
+	if (document == NULL) return nil; // No document
+
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance]; // Cached per pooled document
+
+	return [documentPool attachmentForKey:ATTACHMENT_KEY document:document creator:
+	^id {
+		return [[PDFReaderNamedDestinations alloc] initWithDocument:document];
+	}];
+}
+
+#pragma mark PDFReaderNamedDestinations instance methods
+
+- (id)initWithDocument:(CGPDFDocumentRef)document
+{
+	if ((self = [super init])) // Flatten both destination sources
+	{
+		treeDestinations = PDFReaderCoreNameTableCreate(0); legacyDestinations = PDFReaderCoreNameTableCreate(0);
+
+		CGPDFDictionaryRef catalogDictionary = CGPDFDocumentGetCatalog(document);
+
+		CGPDFDictionaryRef namesDictionary = NULL; CGPDFDictionaryRef destsDictionary = NULL;
+
+		if (CGPDFDictionaryGetDictionary(catalogDictionary, "Names", &namesDictionary) == true)
+		{
+			if (CGPDFDictionaryGetDictionary(namesDictionary, "Dests", &destsDictionary) == true)
+			{
+				FlattenNameTree(destsDictionary, treeDestinations, 0);
+			}
+		}
+
+		if (CGPDFDictionaryGetDictionary(catalogDictionary, "Dests", &destsDictionary) == true)
+		{
+			CGPDFDictionaryApplyFunction(destsDictionary, FlattenDestsEntry, legacyDestinations);
+		}
+
+		PDFReaderCoreNameTableFinish(treeDestinations); PDFReaderCoreNameTableFinish(legacyDestinations); // Sorted
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	PDFReaderCoreNameTableDestroy(treeDestinations); PDFReaderCoreNameTableDestroy(legacyDestinations);
+}
+
+- (NSUInteger)count
+{
+	return (PDFReaderCoreNameTableCount(treeDestinations) + PDFReaderCoreNameTableCount(legacyDestinations));
+}
+
+- (CGPDFArrayRef)destinationForBytes:(const void *)bytes length:(size_t)length
+{
+	if (bytes == NULL) return NULL; // No name
+
+	return (CGPDFArrayRef)PDFReaderCoreNameTableLookup(treeDestinations, bytes, length);
+}
+
+- (CGPDFArrayRef)destinationForString:(CGPDFStringRef)name
+{
+	if (name == NULL) return NULL; // No name
+
+	return [self destinationForBytes:CGPDFStringGetBytePtr(name) length:CGPDFStringGetLength(name)];
+}
+
+- (CGPDFArrayRef)destinationForName:(const char *)name
+{
+	if (name == NULL) return NULL; // No name
+
+	return (CGPDFArrayRef)PDFReaderCoreNameTableLookup(legacyDestinations, name, strlen(name));
+}
+
+#pragma mark PDFReaderNamedDestinations benchmark functions
+
+#ifdef DEBUG
+
+static CGPDFArrayRef BenchmarkTreeLookup(const char *name, CGPDFDictionaryRef node)
+{
+	CGPDFArrayRef limitsArray = NULL; CGPDFStringRef lower = NULL; CGPDFStringRef upper = NULL; // Recursive walk baseline
+
+	if ((CGPDFDictionaryGetArray(node, "Limits", &limitsArray) == true) &&
+		(CGPDFArrayGetString(limitsArray, 0, &lower) == true) && (CGPDFArrayGetString(limitsArray, 1, &upper) == true))
+	{
+		if ((strcmp(name, (const char *)CGPDFStringGetBytePtr(lower)) < 0) || (strcmp(name, (const char *)CGPDFStringGetBytePtr(upper)) > 0)) return NULL;
+	}
+
+	CGPDFArrayRef namesArray = NULL; CGPDFArrayRef kidsArray = NULL; CGPDFArrayRef destinationArray = NULL;
+
+	if (CGPDFDictionaryGetArray(node, "Names", &namesArray) == true)
+	{
+		size_t namesCount = CGPDFArrayGetCount(namesArray);
+
+		for (size_t index = 0; index < namesCount; index += 2)
+		{
+			CGPDFStringRef destName = NULL; // Linear leaf scan
+
+			if ((CGPDFArrayGetString(namesArray, index, &destName) == true) && (strcmp((const char *)CGPDFStringGetBytePtr(destName), name) == 0))
+			{
+				CGPDFArrayGetArray(namesArray, (index + 1), &destinationArray); return destinationArray;
+			}
+		}
+	}
+
+	if (CGPDFDictionaryGetArray(node, "Kids", &kidsArray) == true)
+	{
+		size_t kidsCount = CGPDFArrayGetCount(kidsArray);
+
+		for (size_t index = 0; index < kidsCount; index++)
+		{
+			CGPDFDictionaryRef kidNode = NULL; // Recurse into node
+
+			if (CGPDFArrayGetDictionary(kidsArray, index, &kidNode) == true)
+			{
+				if ((destinationArray = BenchmarkTreeLookup(name, kidNode)) != NULL) return destinationArray;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+#endif // DEBUG
+
++ (void)runLookupBenchmarkWithCount:(NSUInteger)count
+{
+#ifdef DEBUG
+	if (count == 0) return; // Nothing to look up
+
+	NSData *data = PDFReaderBenchmarkCreateNameTreePDF(count, 256); // Synthetic name tree document
+
+	CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)data);
+
+	CGPDFDocumentRef document = CGPDFDocumentCreateWithProvider(provider); CGDataProviderRelease(provider);
+
+	if (document == NULL) { NSLog(@"%s Unable to parse the benchmark document", __FUNCTION__); return; }
+
+	CFAbsoluteTime start = CFAbsoluteTimeGetCurrent(); // Flatten once
+
+	PDFReaderNamedDestinations *destinations = [[PDFReaderNamedDestinations alloc] initWithDocument:document];
+
+	NSLog(@"Name tree flatten: %u names in %.1fms", (unsigned)destinations.count, ((CFAbsoluteTimeGetCurrent() - start) * 1000.0));
+
+	CGPDFDictionaryRef namesDictionary = NULL; CGPDFDictionaryRef treeRoot = NULL; // Baseline walk root
+
+	CGPDFDictionaryGetDictionary(CGPDFDocumentGetCatalog(document), "Names", &namesDictionary);
+
+	CGPDFDictionaryGetDictionary(namesDictionary, "Dests", &treeRoot);
+
+	NSUInteger lookups = MIN(count, 10000); srandom(2014); // Repeatable random names
+
+	NSMutableArray *hashSamples = [NSMutableArray arrayWithCapacity:lookups];
+
+	NSMutableArray *treeSamples = [NSMutableArray arrayWithCapacity:lookups];
+
+	NSUInteger misses = 0; char name[32]; // Lookup name
+
+	for (NSUInteger lookup = 0; lookup < lookups; lookup++)
+	{
+		snprintf(name, sizeof(name), "dest%07u", (unsigned)(random() % count)); size_t length = strlen(name);
+
+		CFAbsoluteTime hashStart = CFAbsoluteTimeGetCurrent(); // Flattened table lookup
+
+		CGPDFArrayRef hashArray = [destinations destinationForBytes:name length:length];
+
+		[hashSamples addObject:[NSNumber numberWithDouble:(CFAbsoluteTimeGetCurrent() - hashStart)]];
+
+		CFAbsoluteTime treeStart = CFAbsoluteTimeGetCurrent(); // Name tree walk
+
+		CGPDFArrayRef treeArray = BenchmarkTreeLookup(name, treeRoot);
+
+		[treeSamples addObject:[NSNumber numberWithDouble:(CFAbsoluteTimeGetCurrent() - treeStart)]];
+
+		if ((hashArray == NULL) || (hashArray != treeArray)) misses++;
+	}
+
+	PDFReaderBenchmarkLog(@"Named destination table lookup", hashSamples); PDFReaderBenchmarkLog(@"Named destination tree walk", treeSamples);
+
+	if (misses > 0) NSLog(@"%s %u lookups disagreed", __FUNCTION__, (unsigned)misses);
+
+	destinations = nil; CGPDFDocumentRelease(document);
+#endif // DEBUG
+}
+
+@end
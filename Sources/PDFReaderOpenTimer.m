@@ -0,0 +1,99 @@
+//
+//	PDFReaderOpenTimer.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderOpenTimer.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+@implementation PDFReaderOpenTimer
+
+#pragma mark Constants
+
+#define MAXIMUM_PHASES 16
+
+#pragma mark PDFReaderOpenTimer functions
+
+static CFTimeInterval openStart = 0.0; // Zero when no open is being timed
+
+static CFTimeInterval phaseTimes[MAXIMUM_PHASES]; // Phase end times
+
+static __unsafe_unretained NSString *phaseNames[MAXIMUM_PHASES]; // Phase names (string literals)
+
+static NSUInteger phaseCount = 0;
+
+static NSTimeInterval lastOpenTime = 0.0;
+
+#pragma mark PDFReaderOpenTimer class methods
+
++ (void)beginOpen
+{
+	@synchronized([PDFReaderOpenTimer class]) // Mutex lock
+	{
+		openStart = CACurrentMediaTime(); phaseCount = 0;
+	}
+}
+
++ (void)markPhase:(NSString *)phase
+{
+	CFTimeInterval now = CACurrentMediaTime(); // Phase end
+
+	@synchronized([PDFReaderOpenTimer class]) // Mutex lock
+	{
+		if ((openStart == 0.0) || (phaseCount >= MAXIMUM_PHASES)) return; // Not timing
+
+		phaseNames[phaseCount] = phase; phaseTimes[phaseCount] = now; phaseCount++;
+	}
+}
+
++ (void)markFirstPixel
+{
+	CFTimeInterval now = CACurrentMediaTime(); // Open end
+
+	@synchronized([PDFReaderOpenTimer class]) // Mutex lock
+	{
+		if (openStart == 0.0) return; // Not timing an open
+
+		lastOpenTime = (now - openStart); // Tap to first pixel
+
+#ifdef DEBUG
+		NSMutableString *breakdown = [NSMutableString string]; CFTimeInterval last = openStart;
+
+		for (NSUInteger index = 0; index < phaseCount; index++) // Time spent in each phase
+		{
+			[breakdown appendFormat:@" %@ %.1fms,", phaseNames[index], ((phaseTimes[index] - last) * 1000.0)]; last = phaseTimes[index];
+		}
+
+		NSLog(@"%s%@ first pixel %.1fms, total %.1fms", __FUNCTION__, breakdown, ((now - last) * 1000.0), (lastOpenTime * 1000.0));
+#endif
+
+		openStart = 0.0; phaseCount = 0; // Done
+	}
+}
+
++ (NSTimeInterval)lastOpenTime
+{
+	@synchronized([PDFReaderOpenTimer class]) { return lastOpenTime; }
+}
+
+@end
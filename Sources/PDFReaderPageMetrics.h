@@ -0,0 +1,56 @@
+//
+//	PDFReaderPageMetrics.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "PDFReaderContentPage.h"
+
+/**
+ *  `PDFReaderPageMetrics` holds the geometry of every page in a document
+ *  (rotation, rotated effective size and origin) as compact parallel arrays,
+ *  so views and thumbs can be sized without opening pages.
+ *
+ *  The table is computed once on a background thread - from one walk of the
+ *  page tree with the lightweight structure reader when the document is not
+ *  encrypted, else in parallel chunks of CoreGraphics pages - and saved next
+ *  to the document's thumbs (`Caches/<GUID>/page.metrics`). It is recomputed
+ *  when the document file changes size or modification date.
+ */
+@interface PDFReaderPageMetrics : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *guid;
+@property (nonatomic, assign, readonly, getter=isReady) BOOL ready;
+@property (nonatomic, assign, readonly) NSInteger pageCount;
+
++ (PDFReaderPageMetrics *)metricsWithGUID:(NSString *)guid;
+
++ (void)closeMetricsWithGUID:(NSString *)guid;
+
+- (void)buildWithURL:(NSURL *)fileURL password:(NSString *)phrase;
+
+- (BOOL)getGeometry:(PDFReaderPageGeometry *)geometry forPage:(NSInteger)page;
+
+- (CGSize)viewSizeForPage:(NSInteger)page;
+
+@end
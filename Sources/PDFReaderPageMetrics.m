@@ -0,0 +1,344 @@
+//
+//	PDFReaderPageMetrics.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderPageMetrics.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderCacheFile.h"
+#import "PDFReaderCoreGeometry.h"
+#import "PDFReaderCoreStructure.h"
+
+#pragma mark Constants
+
+#define METRICS_MAGIC 0x4D475052
+#define METRICS_VERSION 1
+#define METRICS_FILE_NAME @"page.metrics"
+
+#define CHUNK_PAGES 64
+
+typedef struct
+{
+	int16_t *angles; float *widths, *heights, *offsetsX, *offsetsY; // Arrays to fill
+	NSInteger count; // Array slots
+} PDFReaderPageMetricsFill;
+
+@implementation PDFReaderPageMetrics
+{
+	NSString *_guid;
+
+	NSInteger _pageCount;
+
+	int16_t *angles; // Page rotation angles (in degrees)
+
+	float *widths; float *heights; // Rotated effective page sizes
+
+	float *offsetsX; float *offsetsY; // Rotated effective page origins
+
+	BOOL building;
+
+	BOOL _ready;
+}
+
+#pragma mark Properties
+
+@synthesize guid = _guid;
+
+#pragma mark PDFReaderPageMetrics functions
+
+static int MetricsFillPage(const PDFReaderCoreStructurePage *page, void *context)
+{
+	PDFReaderPageMetricsFill *fill = (PDFReaderPageMetricsFill *)context; NSInteger index = (page->page - 1);
+
+	if (index >= fill->count) return 0; // More pages than the page tree root counts
+
+	PDFReaderCoreGeometry geometry = PDFReaderCoreGeometryMake(page->cropBox, page->mediaBox, page->rotate);
+
+	fill->angles[index] = geometry.angle; fill->widths[index] = geometry.width; fill->heights[index] = geometry.height;
+
+	fill->offsetsX[index] = geometry.offsetX; fill->offsetsY[index] = geometry.offsetY;
+
+	return 1;
+}
+
+#pragma mark PDFReaderPageMetrics class methods
+
++ (NSMutableDictionary *)openMetrics
+{
+	static dispatch_once_t predicate = 0;
+
+	static NSMutableDictionary *metrics = nil; // Open metrics tables by GUID
+
+	dispatch_once(&predicate, ^{ metrics = [NSMutableDictionary new]; });
+
+	return metrics;
+}
+
++ (PDFReaderPageMetrics *)metricsWithGUID:(NSString *)guid
+{
+	if (guid == nil) return nil; // Must have a document GUID
+
+	NSMutableDictionary *metrics = [PDFReaderPageMetrics openMetrics];
+
+	@synchronized(metrics) // Mutex lock
+	{
+		PDFReaderPageMetrics *table = [metrics objectForKey:guid];
+
+		if (table == nil) // New (empty) metrics table
+		{
+			table = [PDFReaderPageMetrics new]; table->_guid = [guid copy];
+
+			[metrics setObject:table forKey:guid];
+		}
+
+		return table;
+	}
+}
+
++ (void)closeMetricsWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to close
+
+	NSMutableDictionary *metrics = [PDFReaderPageMetrics openMetrics];
+
+	@synchronized(metrics) { [metrics removeObjectForKey:guid]; }
+}
+
++ (NSString *)metricsPathForGUID:(NSString *)guid
+{
+	return PDFReaderCacheFilePath(guid, METRICS_FILE_NAME);
+}
+
+#pragma mark PDFReaderPageMetrics instance methods
+
+- (void)dealloc
+{
+	[self freeArrays];
+}
+
+- (void)freeArrays
+{
+	if (angles != NULL) free(angles), angles = NULL;
+
+	if (widths != NULL) free(widths), widths = NULL;
+
+	if (heights != NULL) free(heights), heights = NULL;
+
+	if (offsetsX != NULL) free(offsetsX), offsetsX = NULL;
+
+	if (offsetsY != NULL) free(offsetsY), offsetsY = NULL;
+}
+
+- (BOOL)allocateArrays:(NSInteger)count
+{
+	size_t slots = MAX(count, 1); // Never zero sized
+
+	angles = calloc(slots, sizeof(int16_t)); widths = calloc(slots, sizeof(float)); heights = calloc(slots, sizeof(float));
+
+	offsetsX = calloc(slots, sizeof(float)); offsetsY = calloc(slots, sizeof(float));
+
+	if ((angles == NULL) || (widths == NULL) || (heights == NULL) || (offsetsX == NULL) || (offsetsY == NULL))
+	{
+		[self freeArrays]; return NO;
+	}
+
+	return YES;
+}
+
+- (BOOL)isReady
+{
+	@synchronized(self) { return _ready; }
+}
+
+- (NSInteger)pageCount
+{
+	@synchronized(self) { return (_ready ? _pageCount : 0); }
+}
+
+- (void)buildWithURL:(NSURL *)fileURL password:(NSString *)phrase
+{
+	@synchronized(self) // Mutex lock
+	{
+		if ((_ready == YES) || (building == YES) || (fileURL == nil)) return;
+
+		building = YES; // Once
+	}
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0),
+	^{
+		uint64_t fileSize = 0; double fileDate = 0.0; // Document file identity
+
+		BOOL known = PDFReaderCacheFileIdentity(fileURL, &fileSize, &fileDate); BOOL loaded = NO;
+
+		CFAbsoluteTime start = CFAbsoluteTimeGetCurrent(); // Build timing
+
+		if (known == YES) loaded = [self loadMetricsWithFileSize:fileSize fileDate:fileDate];
+
+		if (loaded == NO) // Missing or stale - compute from the document
+		{
+			if ([self computeMetricsWithURL:fileURL password:phrase] && (known == YES))
+			{
+				[self saveMetricsWithFileSize:fileSize fileDate:fileDate];
+			}
+		}
+
+		@synchronized(self) { _ready = (angles != NULL); building = NO; }
+
+#ifdef DEBUG
+		NSLog(@"%s %@ pages %i %@ in %.1fms", __FUNCTION__, _guid, (int)_pageCount,
+			(loaded ? @"loaded" : @"computed"), ((CFAbsoluteTimeGetCurrent() - start) * 1000.0));
+#endif
+	});
+}
+
+- (BOOL)computeMetricsWithStructureURL:(NSURL *)fileURL
+{
+	PDFReaderCoreStructureRef structure = PDFReaderCoreStructureCreateWithPath([[fileURL path] fileSystemRepresentation], NULL);
+
+	if (structure == NULL) return NO; // Encrypted or not readable without CoreGraphics
+
+	NSInteger count = PDFReaderCoreStructurePageCount(structure); BOOL computed = NO; // Pages
+
+	if ((count > 0) && ([self allocateArrays:count] == YES)) // One page tree walk fills every slot
+	{
+		PDFReaderPageMetricsFill fill = { angles, widths, heights, offsetsX, offsetsY, count };
+
+		computed = (PDFReaderCoreStructureVisitPages(structure, MetricsFillPage, &fill) == count);
+
+		if (computed == NO) [self freeArrays]; // Page tree and /Count disagree
+	}
+
+	PDFReaderCoreStructureDestroy(structure);
+
+	if (computed == YES) _pageCount = count;
+
+	return computed;
+}
+
+- (BOOL)computeMetricsWithURL:(NSURL *)fileURL password:(NSString *)phrase
+{
+	if ([self computeMetricsWithStructureURL:fileURL] == YES) return YES; // Unencrypted documents skip CoreGraphics
+
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+	CGPDFDocumentRef document = [documentPool retainDocumentWithURL:fileURL password:phrase guid:_guid];
+
+	if (document == NULL) return NO; // Unable to open the document
+
+	NSInteger count = CGPDFDocumentGetNumberOfPages(document); // Pages
+
+	if ([self allocateArrays:count] == NO) { [documentPool releaseDocument:document]; return NO; }
+
+	size_t chunks = ((count + CHUNK_PAGES - 1) / CHUNK_PAGES); // Parallel chunks of pages
+
+	int16_t *angle = angles; float *width = widths; float *height = heights; float *offsetX = offsetsX; float *offsetY = offsetsY;
+
+	dispatch_apply(chunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0),
+	^(size_t chunk)
+	{
+		NSInteger first = (chunk * CHUNK_PAGES); NSInteger last = MIN((first + CHUNK_PAGES), count);
+
+		for (NSInteger index = first; index < last; index++) // Each chunk fills its own slots
+		{
+			CGPDFPageRef pageRef = CGPDFDocumentGetPage(document, (index + 1)); if (pageRef == NULL) continue;
+
+			PDFReaderPageGeometry geometry = [PDFReaderContentPage geometryForPage:pageRef];
+
+			angle[index] = geometry.angle; width[index] = geometry.width; height[index] = geometry.height;
+
+			offsetX[index] = geometry.offsetX; offsetY[index] = geometry.offsetY;
+		}
+	});
+
+	_pageCount = count; [documentPool releaseDocument:document]; return YES;
+}
+
+- (void)saveMetricsWithFileSize:(uint64_t)fileSize fileDate:(double)fileDate
+{
+	NSMutableData *data = [NSMutableData data]; size_t count = _pageCount; // Metrics file contents
+
+	PDFReaderCacheFileHeader header = PDFReaderCacheFileMakeHeader(METRICS_MAGIC, METRICS_VERSION, fileSize, fileDate, (uint32_t)count);
+
+	[data appendBytes:&header length:sizeof(header)]; // Page count
+
+	[data appendBytes:widths length:(count * sizeof(float))]; [data appendBytes:heights length:(count * sizeof(float))];
+
+	[data appendBytes:offsetsX length:(count * sizeof(float))]; [data appendBytes:offsetsY length:(count * sizeof(float))];
+
+	[data appendBytes:angles length:(count * sizeof(int16_t))]; // Last, keeps the floats aligned
+
+	PDFReaderCacheFileWrite(_guid, METRICS_FILE_NAME, data);
+}
+
+- (BOOL)loadMetricsWithFileSize:(uint64_t)fileSize fileDate:(double)fileDate
+{
+	NSString *metricsPath = [PDFReaderPageMetrics metricsPathForGUID:_guid]; // Metrics file
+
+	NSData *data = [NSData dataWithContentsOfFile:metricsPath options:NSDataReadingMappedIfSafe error:NULL];
+
+	PDFReaderCacheFileHeader header; // Missing, truncated, stale or for a changed document
+
+	if (PDFReaderCacheFileReadHeader(data, METRICS_MAGIC, METRICS_VERSION, fileSize, fileDate, &header) == NO) return NO;
+
+	size_t count = header.count; size_t floats = (count * sizeof(float)); // Array sizes
+
+	if (data.length != (sizeof(header) + (floats * 4) + (count * sizeof(int16_t)))) return NO;
+
+	if ([self allocateArrays:count] == NO) return NO; // Out of memory
+
+	const uint8_t *bytes = ((const uint8_t *)data.bytes + sizeof(header)); // Arrays
+
+	memcpy(widths, bytes, floats); bytes += floats; memcpy(heights, bytes, floats); bytes += floats;
+
+	memcpy(offsetsX, bytes, floats); bytes += floats; memcpy(offsetsY, bytes, floats); bytes += floats;
+
+	memcpy(angles, bytes, (count * sizeof(int16_t))); _pageCount = count; return YES;
+}
+
+- (BOOL)getGeometry:(PDFReaderPageGeometry *)geometry forPage:(NSInteger)page
+{
+	@synchronized(self) // Mutex lock
+	{
+		if ((_ready == NO) || (page < 1) || (page > _pageCount)) return NO;
+
+		NSInteger index = (page - 1); // Zero based
+
+		if ((widths[index] <= 0.0f) || (heights[index] <= 0.0f)) return NO; // Page failed to load
+
+		geometry->angle = angles[index]; geometry->width = widths[index]; geometry->height = heights[index];
+
+		geometry->offsetX = offsetsX[index]; geometry->offsetY = offsetsY[index];
+
+		return YES;
+	}
+}
+
+- (CGSize)viewSizeForPage:(NSInteger)page
+{
+	PDFReaderPageGeometry geometry; // Page geometry
+
+	if ([self getGeometry:&geometry forPage:page] == NO) return CGSizeZero;
+
+	return [PDFReaderContentPage viewSizeForGeometry:geometry];
+}
+
+@end
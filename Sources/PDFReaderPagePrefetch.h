@@ -0,0 +1,80 @@
+//
+//	PDFReaderPagePrefetch.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "PDFReaderContentPage.h"
+
+/**
+ *  `PDFReaderPagePrefetchEntry` is a warmed page: its geometry, link list and
+ *  a screen resolution render. It keeps the page open in the document pool.
+ */
+@interface PDFReaderPagePrefetchEntry : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) NSInteger page;
+@property (nonatomic, assign, readonly) PDFReaderPageGeometry geometry;
+@property (nonatomic, strong, readonly) NSArray *links;
+@property (nonatomic, strong, readonly) UIImage *image;
+@property (nonatomic, assign, readonly) NSUInteger cost;
+
+@end
+
+/**
+ *  `PDFReaderPagePrefetch` warms the pages ahead of the scroll direction of
+ *  the reader's paging scroll view. The look ahead grows and shrinks with the
+ *  page turn rate and is capped by `PDFReaderConfig.pagePrefetchMemoryBudget`.
+ *  Work for pages that fall out of the predicted range is cancelled.
+ *
+ *  All instance methods must be called on the main thread.
+ */
+@interface PDFReaderPagePrefetch : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) NSInteger lookAhead;
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+@property (nonatomic, assign, readonly) NSUInteger cancelCount;
+
+- (id)initWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid pageCount:(NSInteger)pageCount;
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView;
+
+- (void)showPage:(NSInteger)page window:(NSRange)window viewSize:(CGSize)viewSize;
+
+- (PDFReaderPagePrefetchEntry *)takeEntryForPage:(NSInteger)page;
+
+- (void)renderPreviewForPage:(NSInteger)page viewSize:(CGSize)viewSize completion:(void (^)(UIImage *image))completion;
+
+- (void)cancelPreviewForPage:(NSInteger)page;
+
+- (void)cancelAllPrefetch;
+
+- (void)logStatistics;
+
++ (void)markPageTurnForPage:(NSInteger)page;
+
++ (void)markFirstPixelForPage:(NSInteger)page;
+
++ (void)logFirstPixelStatistics;
+
+@end
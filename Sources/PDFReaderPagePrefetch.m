@@ -0,0 +1,675 @@
+//
+//	PDFReaderPagePrefetch.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderConfig.h"
+#import "PDFReaderPagePrefetch.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderLinkIndex.h"
+#import "PDFReaderPageMetrics.h"
+#import "PDFReaderOpenTimer.h"
+
+#import <QuartzCore/QuartzCore.h>
+
+#pragma mark Constants
+
+#define PREFETCH_HORIZON 1.0
+#define PREFETCH_MINIMUM 1
+#define PREFETCH_MAXIMUM 8
+#define PREFETCH_SMOOTHING 0.5
+#define PREFETCH_IDLE 2.0
+#define FIRST_PIXEL_SAMPLES 256
+
+#pragma mark -
+
+//
+//	PDFReaderPagePrefetchEntry class extension
+//
+
+@interface PDFReaderPagePrefetchEntry ()
+
+@property (nonatomic, assign, readwrite) PDFReaderPageGeometry geometry;
+@property (nonatomic, strong, readwrite) NSArray *links;
+@property (nonatomic, strong, readwrite) UIImage *image;
+@property (nonatomic, assign, readwrite) NSUInteger cost;
+
+- (id)initWithPage:(NSInteger)page document:(CGPDFDocumentRef)document pageRef:(CGPDFPageRef)pageRef;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderPagePrefetchOperation class interface
+//
+
+@interface PDFReaderPagePrefetchOperation : NSOperation
+
+@property (nonatomic, assign, readonly) NSInteger page;
+
+@property (nonatomic, copy, readwrite) void (^previewBlock)(UIImage *image);
+
+- (id)initWithPrefetch:(PDFReaderPagePrefetch *)prefetch page:(NSInteger)page viewSize:(CGSize)viewSize scale:(CGFloat)scale;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderPagePrefetch class extension
+//
+
+@interface PDFReaderPagePrefetch ()
+
+@property (nonatomic, strong, readonly) NSURL *fileURL;
+@property (nonatomic, strong, readonly) NSString *password;
+@property (nonatomic, strong, readonly) NSString *guid;
+
+- (void)finishPrefetch:(PDFReaderPagePrefetchOperation *)operation entry:(PDFReaderPagePrefetchEntry *)entry;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderPagePrefetch class implementation
+//
+
+@implementation PDFReaderPagePrefetch
+{
+	NSInteger pageCount;
+
+	NSOperationQueue *prefetchQueue;
+
+	NSMutableDictionary *operations;
+
+	NSMutableDictionary *previews;
+
+	NSMutableDictionary *entries;
+
+	NSMutableIndexSet *predicted;
+
+	NSUInteger usedBytes;
+
+	NSInteger currentPage;
+
+	NSRange currentWindow;
+
+	CGSize currentViewSize;
+
+	NSInteger direction;
+
+	double turnRate;
+
+	double scrollRate;
+
+	CFTimeInterval lastTurnTime;
+
+	CFTimeInterval lastScrollTime;
+
+	CGFloat lastScrollOffset;
+}
+
+#pragma mark Properties
+
+@synthesize fileURL = _fileURL;
+@synthesize password = _password;
+@synthesize guid = _guid;
+@synthesize lookAhead = _lookAhead;
+@synthesize hitCount = _hitCount;
+@synthesize missCount = _missCount;
+@synthesize cancelCount = _cancelCount;
+
+#pragma mark PDFReaderPagePrefetch class methods
+
+static double firstPixelSamples[FIRST_PIXEL_SAMPLES];
+
+static NSUInteger firstPixelCount = 0;
+
++ (NSMutableDictionary *)pageTurnTimes
+{
+	static dispatch_once_t predicate = 0;
+
+	static NSMutableDictionary *times = nil; // Page turn start times by page
+
+	dispatch_once(&predicate, ^{ times = [NSMutableDictionary new]; });
+
+	return times;
+}
+
++ (void)markPageTurnForPage:(NSInteger)page
+{
+	NSNumber *key = [NSNumber numberWithInteger:page]; NSNumber *time = [NSNumber numberWithDouble:CACurrentMediaTime()];
+
+	@synchronized([PDFReaderPagePrefetch class]) // Mutex lock
+	{
+		[[self pageTurnTimes] setObject:time forKey:key];
+	}
+}
+
++ (void)markFirstPixelForPage:(NSInteger)page
+{
+	[PDFReaderOpenTimer markFirstPixel]; // Ends any document open being timed
+
+	NSNumber *key = [NSNumber numberWithInteger:page]; double elapsed = 0.0;
+
+	@synchronized([PDFReaderPagePrefetch class]) // Mutex lock
+	{
+		NSMutableDictionary *times = [self pageTurnTimes]; NSNumber *time = [times objectForKey:key];
+
+		if (time == nil) return; // Not waiting for this page
+
+		elapsed = (CACurrentMediaTime() - [time doubleValue]); [times removeObjectForKey:key];
+
+		firstPixelSamples[firstPixelCount % FIRST_PIXEL_SAMPLES] = elapsed; firstPixelCount++;
+	}
+
+#ifdef DEBUG
+	NSLog(@"%s page %i %.1f ms", __FUNCTION__, (int)page, (elapsed * 1000.0));
+#endif
+}
+
++ (void)logFirstPixelStatistics
+{
+#ifdef DEBUG
+	NSMutableArray *samples = [NSMutableArray array]; // Recent samples
+
+	@synchronized([PDFReaderPagePrefetch class]) // Mutex lock
+	{
+		NSUInteger count = MIN(firstPixelCount, FIRST_PIXEL_SAMPLES);
+
+		for (NSUInteger index = 0; index < count; index++) [samples addObject:[NSNumber numberWithDouble:firstPixelSamples[index]]];
+	}
+
+	if (samples.count == 0) return; // Nothing measured yet
+
+	[samples sortUsingSelector:@selector(compare:)]; NSUInteger last = (samples.count - 1);
+
+	double p50 = [[samples objectAtIndex:(last / 2)] doubleValue]; double p99 = [[samples objectAtIndex:((last * 99) / 100)] doubleValue];
+
+	NSLog(@"%s pages %i p50 %.1f ms p99 %.1f ms max %.1f ms", __FUNCTION__, (int)samples.count,
+		(p50 * 1000.0), (p99 * 1000.0), ([[samples lastObject] doubleValue] * 1000.0));
+#endif
+}
+
+#pragma mark PDFReaderPagePrefetch instance methods
+
+- (id)initWithURL:(NSURL *)fileURL password:(NSString *)phrase guid:(NSString *)guid pageCount:(NSInteger)count
+{
+	if ((self = [super init])) // Initialize object
+	{
+		_fileURL = [fileURL copy]; _password = [phrase copy]; _guid = [guid copy]; pageCount = count;
+
+		prefetchQueue = [NSOperationQueue new]; [prefetchQueue setName:@"PDFReaderPagePrefetchQueue"];
+
+		[prefetchQueue setMaxConcurrentOperationCount:1]; // Stay out of the way of visible work
+
+		operations = [NSMutableDictionary new]; entries = [NSMutableDictionary new]; previews = [NSMutableDictionary new];
+
+		predicted = [NSMutableIndexSet new]; direction = 1; _lookAhead = PREFETCH_MINIMUM;
+
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveMemoryWarning:)
+			name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	[prefetchQueue cancelAllOperations];
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification
+{
+	[self cancelAllPrefetch]; // Give it all back
+}
+
+- (NSUInteger)bytesPerPage
+{
+	CGFloat scale = [UIScreen mainScreen].scale; // Screen pixels per point
+
+	return (NSUInteger)(currentViewSize.width * scale * currentViewSize.height * scale * 4.0f);
+}
+
+- (void)removeEntryForKey:(NSNumber *)key
+{
+	PDFReaderPagePrefetchEntry *entry = [entries objectForKey:key];
+
+	if (entry != nil) { usedBytes -= entry.cost; [entries removeObjectForKey:key]; }
+}
+
+- (void)updatePrediction
+{
+	PDFReaderConfig *readerConfig = [PDFReaderConfig sharedConfig];
+
+	NSUInteger bytesPerPage = [self bytesPerPage]; // Estimated render cost
+
+	NSUInteger budgetPages = ((bytesPerPage > 0) ? (readerConfig.pagePrefetchMemoryBudget / bytesPerPage) : 0);
+
+	if ((readerConfig.pagePrefetchEnabled == NO) || (budgetPages == 0) || (currentPage == 0))
+	{
+		[self cancelAllPrefetch]; return;
+	}
+
+	CFTimeInterval now = CACurrentMediaTime(); // Decay stale page turn rate
+
+	double rate = (((now - lastTurnTime) > PREFETCH_IDLE) ? scrollRate : MAX(turnRate, scrollRate));
+
+	NSInteger lookAhead = (NSInteger)ceil(rate * PREFETCH_HORIZON); // Pages per horizon
+
+	lookAhead = MAX(lookAhead, PREFETCH_MINIMUM); lookAhead = MIN(lookAhead, PREFETCH_MAXIMUM);
+
+	lookAhead = MIN(lookAhead, (NSInteger)budgetPages); _lookAhead = lookAhead;
+
+	NSInteger first = currentWindow.location; NSInteger last = (NSMaxRange(currentWindow) - 1);
+
+	NSMutableIndexSet *pages = [NSMutableIndexSet indexSet]; // Predicted pages (outside the view window)
+
+	for (NSInteger index = 1; index <= lookAhead; index++) // Ahead of the scroll direction
+	{
+		NSInteger page = ((direction > 0) ? (last + index) : (first - index));
+
+		if ((page >= 1) && (page <= pageCount)) [pages addIndex:page];
+	}
+
+	if ((NSInteger)budgetPages > lookAhead) // One page behind in case of a reversal
+	{
+		NSInteger page = ((direction > 0) ? (first - 1) : (last + 1));
+
+		if ((page >= 1) && (page <= pageCount)) [pages addIndex:page];
+	}
+
+	predicted = pages; // New predicted range
+
+	for (NSNumber *key in [operations allKeys]) // Cancel work that fell out of range
+	{
+		if ([pages containsIndex:[key integerValue]] == NO)
+		{
+			[[operations objectForKey:key] cancel]; [operations removeObjectForKey:key]; _cancelCount++;
+		}
+	}
+
+	for (NSNumber *key in [entries allKeys]) // Drop warmed pages that fell out of range
+	{
+		if ([pages containsIndex:[key integerValue]] == NO) [self removeEntryForKey:key];
+	}
+
+	CGFloat scale = [UIScreen mainScreen].scale; // Screen pixels per point
+
+	for (NSInteger index = 1; index <= (lookAhead + 1); index++) // Nearest pages first
+	{
+		NSInteger ahead = ((direction > 0) ? (last + index) : (first - index));
+
+		NSInteger behind = ((direction > 0) ? (first - index) : (last + index));
+
+		for (NSNumber *key in [NSArray arrayWithObjects:[NSNumber numberWithInteger:ahead], [NSNumber numberWithInteger:behind], nil])
+		{
+			if ([pages containsIndex:[key integerValue]] == NO) continue; // Not predicted
+
+			if (([entries objectForKey:key] != nil) || ([operations objectForKey:key] != nil)) continue;
+
+			PDFReaderPagePrefetchOperation *operation = [[PDFReaderPagePrefetchOperation alloc]
+				initWithPrefetch:self page:[key integerValue] viewSize:currentViewSize scale:scale];
+
+			[operation setQueuePriority:((index == 1) ? NSOperationQueuePriorityHigh : NSOperationQueuePriorityLow)];
+
+			[operation setThreadPriority:0.25]; [operations setObject:operation forKey:key];
+
+			[prefetchQueue addOperation:operation];
+		}
+	}
+}
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView
+{
+	CGFloat width = scrollView.bounds.size.width; if (width <= 0.0f) return;
+
+	CGFloat offset = scrollView.contentOffset.x; CFTimeInterval now = CACurrentMediaTime();
+
+	CFTimeInterval elapsed = (now - lastScrollTime); CGFloat delta = (offset - lastScrollOffset);
+
+	lastScrollTime = now; lastScrollOffset = offset; // Track the scroll position
+
+	if ((elapsed <= 0.0) || (elapsed > PREFETCH_IDLE) || ((scrollView.isDragging == NO) && (scrollView.isDecelerating == NO)))
+	{
+		scrollRate = 0.0; return; // Not a user scroll (or the first sample)
+	}
+
+	double rate = (fabs(delta) / width / elapsed); // Pages per second
+
+	scrollRate = ((PREFETCH_SMOOTHING * rate) + ((1.0 - PREFETCH_SMOOTHING) * scrollRate));
+
+	NSInteger newDirection = ((delta > 0.0f) ? 1 : ((delta < 0.0f) ? -1 : direction));
+
+	NSInteger lookAhead = MIN(MAX((NSInteger)ceil(scrollRate * PREFETCH_HORIZON), PREFETCH_MINIMUM), PREFETCH_MAXIMUM);
+
+	if ((newDirection != direction) || (lookAhead > _lookAhead)) // Only re-plan on a real change
+	{
+		direction = newDirection; [self updatePrediction];
+	}
+}
+
+- (void)showPage:(NSInteger)page window:(NSRange)window viewSize:(CGSize)viewSize
+{
+	CFTimeInterval now = CACurrentMediaTime(); // Page turn time
+
+	if ((currentPage > 0) && (page != currentPage)) // Page turn rate and direction
+	{
+		CFTimeInterval elapsed = MAX((now - lastTurnTime), 0.001);
+
+		double rate = ((elapsed > PREFETCH_IDLE) ? 0.0 : (labs(page - currentPage) / elapsed));
+
+		turnRate = ((PREFETCH_SMOOTHING * rate) + ((1.0 - PREFETCH_SMOOTHING) * turnRate));
+
+		direction = ((page > currentPage) ? 1 : -1);
+	}
+
+	if (CGSizeEqualToSize(viewSize, currentViewSize) == false) // Renders are the wrong size
+	{
+		[self cancelAllPrefetch]; currentViewSize = viewSize;
+	}
+
+	currentPage = page; currentWindow = window; lastTurnTime = now;
+
+	[self updatePrediction];
+}
+
+- (PDFReaderPagePrefetchEntry *)takeEntryForPage:(NSInteger)page
+{
+	NSNumber *key = [NSNumber numberWithInteger:page]; // Page key
+
+	PDFReaderPagePrefetchEntry *entry = [entries objectForKey:key];
+
+	if (entry != nil) { [self removeEntryForKey:key]; _hitCount++; } else _missCount++;
+
+	NSOperation *operation = [operations objectForKey:key]; // Too late for it now
+
+	if (operation != nil) { [operation cancel]; [operations removeObjectForKey:key]; _cancelCount++; }
+
+	return entry;
+}
+
+- (void)renderPreviewForPage:(NSInteger)page viewSize:(CGSize)viewSize completion:(void (^)(UIImage *image))completion
+{
+	NSNumber *key = [NSNumber numberWithInteger:page]; // Page key
+
+	if ([previews objectForKey:key] != nil) return; // Already on its way
+
+	PDFReaderPagePrefetchOperation *operation = [[PDFReaderPagePrefetchOperation alloc]
+		initWithPrefetch:self page:page viewSize:viewSize scale:[UIScreen mainScreen].scale];
+
+	[operation setPreviewBlock:completion]; [operation setQueuePriority:NSOperationQueuePriorityVeryHigh];
+
+	[operation setThreadPriority:0.5]; [previews setObject:operation forKey:key]; // Ahead of any prefetch
+
+	[prefetchQueue addOperation:operation];
+}
+
+- (void)cancelPreviewForPage:(NSInteger)page
+{
+	NSNumber *key = [NSNumber numberWithInteger:page]; // Page key
+
+	[[previews objectForKey:key] cancel]; [previews removeObjectForKey:key];
+}
+
+- (void)finishPrefetch:(PDFReaderPagePrefetchOperation *)operation entry:(PDFReaderPagePrefetchEntry *)entry
+{
+	NSNumber *key = [NSNumber numberWithInteger:operation.page]; // Page key
+
+	if (operation.previewBlock != nil) // Preview render for an on-screen page view
+	{
+		if ([previews objectForKey:key] != operation) return; // Cancelled
+
+		[previews removeObjectForKey:key]; operation.previewBlock(entry.image); return;
+	}
+
+	if ([operations objectForKey:key] != operation) return; // Cancelled or replaced
+
+	[operations removeObjectForKey:key]; // Done
+
+	if ((entry == nil) || ([predicted containsIndex:operation.page] == NO)) return;
+
+	NSUInteger budget = [PDFReaderConfig sharedConfig].pagePrefetchMemoryBudget;
+
+	while (((usedBytes + entry.cost) > budget) && (entries.count > 0)) // Evict the farthest warmed page
+	{
+		NSNumber *farthest = nil; NSInteger distance = 0;
+
+		for (NSNumber *other in [entries allKeys])
+		{
+			NSInteger value = labs([other integerValue] - currentPage);
+
+			if (value > distance) { distance = value; farthest = other; }
+		}
+
+		if (distance <= labs(operation.page - currentPage)) return; // New page is the farthest
+
+		[self removeEntryForKey:farthest];
+	}
+
+	if ((usedBytes + entry.cost) > budget) return; // Too big for the budget
+
+	[entries setObject:entry forKey:key]; usedBytes += entry.cost;
+}
+
+- (void)cancelAllPrefetch
+{
+	for (NSOperation *operation in [operations objectEnumerator]) [operation cancel]; // Preview renders carry on
+
+	_cancelCount += operations.count; [operations removeAllObjects]; [entries removeAllObjects]; usedBytes = 0;
+}
+
+- (void)logStatistics
+{
+#ifdef DEBUG
+	NSLog(@"%s hits %i misses %i cancelled %i look ahead %i warmed %i (%i bytes)", __FUNCTION__, (int)_hitCount,
+		(int)_missCount, (int)_cancelCount, (int)_lookAhead, (int)entries.count, (int)usedBytes);
+#endif
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderPagePrefetchEntry class implementation
+//
+
+@implementation PDFReaderPagePrefetchEntry
+{
+	CGPDFDocumentRef _document;
+
+	CGPDFPageRef _pageRef;
+}
+
+#pragma mark Properties
+
+@synthesize page = _page;
+@synthesize geometry = _geometry;
+@synthesize links = _links;
+@synthesize image = _image;
+@synthesize cost = _cost;
+
+#pragma mark PDFReaderPagePrefetchEntry instance methods
+
+- (id)initWithPage:(NSInteger)page document:(CGPDFDocumentRef)document pageRef:(CGPDFPageRef)pageRef
+{
+	if ((self = [super init])) // Takes over the pool retains
+	{
+		_page = page; _document = document; _pageRef = pageRef;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+	if (_pageRef != NULL) [documentPool releasePage:_pageRef], _pageRef = NULL;
+
+	if (_document != NULL) [documentPool releaseDocument:_document], _document = NULL;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderPagePrefetchOperation class implementation
+//
+
+@implementation PDFReaderPagePrefetchOperation
+{
+	__weak PDFReaderPagePrefetch *_prefetch;
+
+	NSURL *_fileURL;
+
+	NSString *_password;
+
+	NSString *_guid;
+
+	CGSize _viewSize;
+
+	CGFloat _scale;
+}
+
+#pragma mark Properties
+
+@synthesize page = _page;
+@synthesize previewBlock = _previewBlock;
+
+#pragma mark PDFReaderPagePrefetchOperation instance methods
+
+- (id)initWithPrefetch:(PDFReaderPagePrefetch *)prefetch page:(NSInteger)page viewSize:(CGSize)viewSize scale:(CGFloat)scale
+{
+	if ((self = [super init]))
+	{
+		_prefetch = prefetch; _page = page; _viewSize = viewSize; _scale = scale;
+
+		_fileURL = prefetch.fileURL; _password = prefetch.password; _guid = prefetch.guid;
+	}
+
+	return self;
+}
+
+- (UIImage *)renderPage:(CGPDFPageRef)pageRef geometry:(PDFReaderPageGeometry)geometry cost:(NSUInteger *)cost
+{
+	UIImage *image = nil; // Screen resolution render
+
+	CGSize pageSize = [PDFReaderContentPage viewSizeForGeometry:geometry];
+
+	if ((pageSize.width <= 0.0f) || (pageSize.height <= 0.0f)) return nil;
+
+	CGFloat w_scale = (_viewSize.width / pageSize.width); CGFloat h_scale = (_viewSize.height / pageSize.height);
+
+	CGFloat fit = ((w_scale < h_scale) ? w_scale : h_scale) * _scale; // Aspect fit in pixels
+
+	size_t target_w = (size_t)(pageSize.width * fit); size_t target_h = (size_t)(pageSize.height * fit);
+
+	if ((target_w == 0) || (target_h == 0)) return nil; // Nothing to render
+
+	CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB(); // RGB color space
+
+	CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+
+	CGContextRef context = CGBitmapContextCreate(NULL, target_w, target_h, 8, 0, rgb, bmi);
+
+	if (context != NULL) // Must have a valid custom CGBitmap context to draw into
+	{
+		CGRect renderRect = CGRectMake(0.0f, 0.0f, target_w, target_h); // Render rect
+
+		CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); CGContextFillRect(context, renderRect); // White fill
+
+		CGContextConcatCTM(context, CGPDFPageGetDrawingTransform(pageRef, kCGPDFCropBox, renderRect, 0, true)); // Fit rect
+
+		if (self.isCancelled == NO) CGContextDrawPDFPage(context, pageRef); // Render the PDF page
+
+		CGImageRef imageRef = CGBitmapContextCreateImage(context); // Create CGImage from the CGBitmap context
+
+		if (imageRef != NULL) // Wrap it at screen scale
+		{
+			image = [UIImage imageWithCGImage:imageRef scale:_scale orientation:UIImageOrientationUp];
+
+			*cost = (CGImageGetBytesPerRow(imageRef) * target_h); CGImageRelease(imageRef);
+		}
+
+		CGContextRelease(context);
+	}
+
+	CGColorSpaceRelease(rgb); return image;
+}
+
+- (void)finishWithEntry:(PDFReaderPagePrefetchEntry *)entry
+{
+	PDFReaderPagePrefetch *prefetch = _prefetch; // A nil entry still ends the request
+
+	dispatch_async(dispatch_get_main_queue(), // Hand over on the main thread
+	^{
+		[prefetch finishPrefetch:self entry:entry];
+	});
+}
+
+- (void)main
+{
+	if (self.isCancelled == YES) { [self finishWithEntry:nil]; return; } // Fell out of the predicted range
+
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+	CGPDFDocumentRef document = [documentPool retainDocumentWithURL:_fileURL password:_password guid:_guid];
+
+	if (document == NULL) { [self finishWithEntry:nil]; return; } // Unable to open the document
+
+	CGPDFPageRef pageRef = [documentPool retainPage:_page withURL:_fileURL password:_password guid:_guid];
+
+	if (pageRef == NULL) { [documentPool releaseDocument:document]; [self finishWithEntry:nil]; return; }
+
+	PDFReaderPagePrefetchEntry *entry = [[PDFReaderPagePrefetchEntry alloc] initWithPage:_page document:document pageRef:pageRef];
+
+	PDFReaderPageGeometry geometry; // Page geometry from the document metrics table (or the page)
+
+	if ([[PDFReaderPageMetrics metricsWithGUID:_guid] getGeometry:&geometry forPage:_page] == NO)
+	{
+		geometry = [PDFReaderContentPage geometryForPage:pageRef];
+	}
+
+	entry.geometry = geometry;
+
+	if ([PDFReaderLinkIndex linkIndexWithGUID:_guid].isReady == NO) // Page links (unless indexed)
+	{
+		entry.links = [PDFReaderContentPage linksForPage:pageRef geometry:geometry];
+	}
+
+	NSUInteger cost = 0; // Render bytes
+
+	if (self.isCancelled == NO) entry.image = [self renderPage:pageRef geometry:geometry cost:&cost];
+
+	if (self.isCancelled == YES) { [self finishWithEntry:nil]; return; } // Fell out of the predicted range
+
+	entry.cost = cost; [self finishWithEntry:entry];
+}
+
+@end
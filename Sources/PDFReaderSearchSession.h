@@ -0,0 +1,61 @@
+//
+//	PDFReaderSearchSession.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class PDFReaderDocument;
+
+typedef void (^PDFReaderSearchResultsHandler)(NSArray *hits);
+
+typedef void (^PDFReaderSearchCompletionHandler)(BOOL cancelled);
+
+/**
+ *  `PDFReaderSearchSession` runs one text search over a document and streams
+ *  `PDFReaderTextHit` results to `resultsHandler` (on the main queue) in
+ *  batches, visiting pages in order of distance from the document's current
+ *  page (`PDFReaderDocument.pageNumber`).
+ *
+ *  Indexed pages are answered from the document's `PDFReaderTextIndex`;
+ *  pages not indexed yet are extracted on demand. A session is cheap, so
+ *  cancel it and start a new one whenever the query changes.
+ */
+@interface PDFReaderSearchSession : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *query;
+@property (nonatomic, copy, readwrite) PDFReaderSearchResultsHandler resultsHandler;
+@property (nonatomic, copy, readwrite) PDFReaderSearchCompletionHandler completionHandler;
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+@property (nonatomic, assign, readonly) NSUInteger pagesScanned;
+@property (nonatomic, assign, readonly) NSTimeInterval timeToFirstHit;
+@property (nonatomic, assign, readonly) double pagesPerSecond;
+@property (nonatomic, assign, readonly, getter=isCancelled) BOOL cancelled;
+@property (nonatomic, assign, readonly, getter=isFinished) BOOL finished;
+
+- (id)initWithDocument:(PDFReaderDocument *)document query:(NSString *)query;
+
+- (void)start;
+
+- (void)cancel;
+
+@end
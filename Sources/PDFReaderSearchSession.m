@@ -0,0 +1,213 @@
+//
+//	PDFReaderSearchSession.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderSearchSession.h"
+#import "PDFReaderDocument.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderTextIndex.h"
+
+#pragma mark Constants
+
+#define BATCH_INTERVAL 0.05
+#define WINDOW_FACTOR 2
+
+@implementation PDFReaderSearchSession
+{
+	NSString *_query;
+
+	PDFReaderSearchResultsHandler _resultsHandler;
+
+	PDFReaderSearchCompletionHandler _completionHandler;
+
+	NSUInteger _hitCount;
+
+	NSUInteger _pagesScanned;
+
+	NSTimeInterval _timeToFirstHit;
+
+	double _pagesPerSecond;
+
+	BOOL _cancelled;
+
+	BOOL _finished;
+
+	BOOL started;
+
+	NSURL *fileURL; NSString *password; NSString *guid;
+
+	NSInteger pageCount; NSInteger currentPage;
+
+	CFAbsoluteTime startTime;
+}
+
+#pragma mark Properties
+
+@synthesize query = _query;
+@synthesize resultsHandler = _resultsHandler;
+@synthesize completionHandler = _completionHandler;
+@synthesize hitCount = _hitCount;
+@synthesize pagesScanned = _pagesScanned;
+@synthesize timeToFirstHit = _timeToFirstHit;
+@synthesize pagesPerSecond = _pagesPerSecond;
+@synthesize cancelled = _cancelled;
+@synthesize finished = _finished;
+
+#pragma mark PDFReaderSearchSession instance methods
+
+- (id)initWithDocument:(PDFReaderDocument *)document query:(NSString *)query
+{
+	if ((self = [super init])) // Initialize superclass object first
+	{
+		_query = [query copy]; fileURL = document.fileURL; password = document.password; guid = document.guid;
+
+		pageCount = [document.pageCount integerValue]; currentPage = [document.pageNumber integerValue];
+
+		if (currentPage < 1) currentPage = 1; if (currentPage > pageCount) currentPage = pageCount;
+	}
+
+	return self;
+}
+
+- (void)start
+{
+	@synchronized(self) { if (started == YES) return; started = YES; }
+
+	startTime = CFAbsoluteTimeGetCurrent(); // Latency is measured from here
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{ [self search]; });
+}
+
+- (void)cancel
+{
+	@synchronized(self) { _cancelled = YES; } // Checked before every page and every delivery
+}
+
+- (BOOL)isCancelled
+{
+	@synchronized(self) { return _cancelled; }
+}
+
+- (void)sendBatch:(NSMutableArray *)batch
+{
+	if (batch.count == 0) return; // Nothing to send
+
+	NSArray *hits = [batch copy]; [batch removeAllObjects]; PDFReaderSearchResultsHandler handler = _resultsHandler;
+
+	if (handler != nil) dispatch_async(dispatch_get_main_queue(), ^{ if ([self isCancelled] == NO) handler(hits); });
+}
+
+- (void)search
+{
+	NSArray *words = [PDFReaderTextIndex wordsForText:_query]; // Query words
+
+	PDFReaderTextIndex *textIndex = [PDFReaderTextIndex textIndexWithGUID:guid];
+
+	NSIndexSet *indexed = textIndex.indexedPages; NSIndexSet *candidates = [textIndex pagesContainingWords:words];
+
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance]; CGPDFDocumentRef document = NULL;
+
+	NSInteger window = MAX(1, ([[NSProcessInfo processInfo] activeProcessorCount] * WINDOW_FACTOR)); // Pages extracted together
+
+	NSMutableArray *batch = [NSMutableArray array]; CFAbsoluteTime lastSend = startTime; NSInteger visited = 0;
+
+	NSInteger *order = malloc(MAX(pageCount, 1) * sizeof(NSInteger)); NSInteger count = 0; // Pages by distance from the current page
+
+	for (NSInteger distance = 0; (count < pageCount) && (order != NULL); distance++)
+	{
+		if ((currentPage + distance) <= pageCount) order[count++] = (currentPage + distance);
+
+		if ((distance > 0) && ((currentPage - distance) >= 1)) order[count++] = (currentPage - distance);
+	}
+
+	if (words.count == 0) count = 0; // Nothing to search for
+
+	for (NSInteger first = 0; first < count; first += window) // Windows of nearest pages
+	{
+		if ([self isCancelled] == YES) break; // A newer query replaced this one
+
+		NSInteger last = MIN((first + window), count); NSMutableArray *extract = [NSMutableArray array];
+
+		for (NSInteger index = first; index < last; index++) // Pages not in the index yet
+		{
+			if ([indexed containsIndex:order[index]] == NO) [extract addObject:[NSNumber numberWithInteger:order[index]]];
+		}
+
+		if (extract.count > 0) // Extract them on demand, in parallel
+		{
+			if (document == NULL) document = [documentPool retainDocumentWithURL:fileURL password:password guid:guid];
+
+			if (document == NULL) break; // Unable to open the document
+
+			dispatch_apply(extract.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0),
+			^(size_t index)
+			{
+				if ([self isCancelled] == NO) [textIndex indexPage:[[extract objectAtIndex:index] integerValue] document:document];
+			});
+		}
+
+		for (NSInteger index = first; index < last; index++) // Collect hits in distance order
+		{
+			NSInteger page = order[index]; visited++;
+
+			if (([indexed containsIndex:page] == YES) && ([candidates containsIndex:page] == NO)) continue; // Indexed without the words
+
+			NSArray *hits = [textIndex hitsForWords:words page:page]; if (hits.count == 0) continue;
+
+			[batch addObjectsFromArray:hits];
+
+			@synchronized(self) // First hit latency
+			{
+				if (_hitCount == 0) _timeToFirstHit = (CFAbsoluteTimeGetCurrent() - startTime);
+
+				_hitCount += hits.count;
+			}
+		}
+
+		@synchronized(self) { _pagesScanned = visited; } CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+
+		if ((batch.count > 0) && ((_hitCount == batch.count) || ((now - lastSend) >= BATCH_INTERVAL)))
+		{
+			[self sendBatch:batch]; lastSend = now; // The first hits go out at once
+		}
+	}
+
+	[self sendBatch:batch]; if (order != NULL) free(order);
+
+	if (document != NULL) [documentPool releaseDocument:document];
+
+	CFAbsoluteTime elapsed = (CFAbsoluteTimeGetCurrent() - startTime); BOOL cancelled = [self isCancelled];
+
+	@synchronized(self) { _pagesPerSecond = ((elapsed > 0.0) ? (visited / elapsed) : 0.0); _finished = YES; }
+
+#ifdef DEBUG
+	NSLog(@"%s '%@' %i hits, %i pages, first hit %.1fms, %.0f pages/s%@", __FUNCTION__, _query, (int)_hitCount, (int)visited,
+		(_timeToFirstHit * 1000.0), _pagesPerSecond, (cancelled ? @" (cancelled)" : @""));
+#endif
+
+	PDFReaderSearchCompletionHandler handler = _completionHandler;
+
+	if (handler != nil) dispatch_async(dispatch_get_main_queue(), ^{ handler(cancelled); });
+}
+
+@end
@@ -0,0 +1,84 @@
+//
+//	PDFReaderTextIndex.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ *  `PDFReaderTextHit` is one match of a search: the page number and the
+ *  bounds of the matched words in page space (PDF default user space).
+ */
+@interface PDFReaderTextHit : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) NSInteger page;
+@property (nonatomic, assign, readonly) NSUInteger wordIndex;
+@property (nonatomic, assign, readonly) CGRect rect;
+
+@end
+
+/**
+ *  `PDFReaderTextIndex` extracts the words of every page (with their glyph
+ *  bounds) from the page content streams and keeps an inverted index of
+ *  them: word -> pages, and per page word -> word positions.
+ *
+ *  Pages are extracted in parallel on background threads and each finished
+ *  page is appended to `Caches/<GUID>/text.index`, so indexing resumes where
+ *  it stopped and a partially indexed document can already be searched (see
+ *  `indexedPages`). The file is discarded when the document file changes
+ *  size or modification date. A page that is not indexed yet can be
+ *  extracted on demand with `indexPage:document:`.
+ *
+ *  Words are runs of letters and digits, compared case insensitively. A
+ *  query of several words (e.g. "AB-1234") matches them as a phrase.
+ */
+@interface PDFReaderTextIndex : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *guid;
+@property (nonatomic, assign, readonly, getter=isComplete) BOOL complete;
+@property (nonatomic, assign, readonly) NSInteger pageCount;
+@property (nonatomic, strong, readonly) NSIndexSet *indexedPages;
+
++ (PDFReaderTextIndex *)textIndexWithGUID:(NSString *)guid;
+
++ (void)closeTextIndexWithGUID:(NSString *)guid;
+
++ (NSArray *)wordsForText:(NSString *)text;
+
+- (void)buildWithURL:(NSURL *)fileURL password:(NSString *)phrase;
+
+- (BOOL)isPageIndexed:(NSInteger)page;
+
+- (BOOL)indexPage:(NSInteger)page document:(CGPDFDocumentRef)document;
+
+- (NSIndexSet *)pagesContainingWords:(NSArray *)words;
+
+- (NSArray *)hitsForWords:(NSArray *)words page:(NSInteger)page;
+
+- (NSIndexSet *)pagesMatchingText:(NSString *)text;
+
+- (NSArray *)hitsForText:(NSString *)text;
+
+- (NSArray *)hitsForText:(NSString *)text page:(NSInteger)page;
+
+@end
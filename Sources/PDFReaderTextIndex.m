@@ -0,0 +1,1463 @@
+//
+//	PDFReaderTextIndex.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderTextIndex.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderCacheFile.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+
+#pragma mark Constants
+
+#define TEXT_MAGIC 0x58545250
+#define TEXT_VERSION 2
+#define TEXT_FILE_NAME @"text.index"
+
+#define CHUNK_PAGES 16
+
+#define STATE_DEPTH 32
+#define WORD_LENGTH 64
+#define RESOURCE_DEPTH 16
+#define FORM_DEPTH 8
+#define MAP_RANGE_LIMIT 65536
+
+#define DEFAULT_WIDTH 500.0f
+#define GLYPH_DESCENT -0.2f
+#define GLYPH_HEIGHT 1.0f
+#define WORD_GAP 0.25f
+
+typedef struct
+{
+	uint32_t page; uint32_t length; // Page segment payload
+	uint32_t checksum; uint32_t reserved;
+} PDFReaderTextIndexSegment;
+
+#pragma mark -
+
+//
+//	PDFReaderTextHit class interface
+//
+
+@interface PDFReaderTextHit ()
+
+- (id)initWithPage:(NSInteger)page wordIndex:(NSUInteger)wordIndex rect:(CGRect)rect;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextIndexPage class interface
+//
+
+@interface PDFReaderTextIndexPage : NSObject <NSObject>
+{
+@public // Read under the owning index lock
+
+	NSData *rects; // Word bounds (x, y, w, h floats)
+
+	NSDictionary *postings; // Word -> word positions (uint32 NSData)
+}
+
++ (PDFReaderTextIndexPage *)pageWithSegment:(const uint8_t *)bytes length:(size_t)length;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextFont class interface
+//
+
+@interface PDFReaderTextFont : NSObject <NSObject>
+{
+@public // Read by the scanner callbacks
+
+	BOOL twoByte; // Type0 (two byte codes)
+
+	BOOL decodable; // Codes map to text
+
+	CGFloat defaultWidth;
+
+	NSInteger firstChar;
+
+	NSData *widths; // CGFloat glyph widths from firstChar
+
+	NSMutableDictionary *cidWidths; // Type0 CID -> width
+
+	NSMutableDictionary *unicodes; // Code -> NSString
+}
+
++ (PDFReaderTextFont *)fontWithDictionary:(CGPDFDictionaryRef)fontDictionary;
+
+- (CGFloat)widthForCode:(NSUInteger)code;
+
+- (NSString *)textForCode:(NSUInteger)code;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextScanner class interface
+//
+
+typedef struct
+{
+	CGAffineTransform ctm; // Current transformation matrix
+	CGFloat charSpacing, wordSpacing; // Tc and Tw
+	CGFloat hScale, leading, rise; // Tz (as a fraction), TL and Ts
+	CGFloat fontSize; // Tf size
+	__unsafe_unretained PDFReaderTextFont *font; // Owned by the scanner
+} PDFReaderTextState;
+
+@interface PDFReaderTextScanner : NSObject <NSObject>
+{
+@public // Accessed by the scanner callbacks
+
+	PDFReaderTextState states[STATE_DEPTH]; NSInteger depth;
+
+	NSInteger baseDepth, formDepth; // Current Form XObject state floor and nesting
+
+	CGAffineTransform textMatrix, lineMatrix;
+
+	CGPDFDictionaryRef fontsDictionary, xobjectsDictionary; // Current resources
+
+	NSMutableDictionary *fonts; // Font resource name -> PDFReaderTextFont
+
+	NSMutableString *word; CGRect wordRect; CGPoint wordEnd;
+
+	NSMutableArray *words; // Page words in reading order
+
+	NSMutableData *rects; // Word bounds (x, y, w, h floats)
+}
+
++ (NSData *)segmentForPage:(CGPDFPageRef)page;
+
+- (PDFReaderTextFont *)fontNamed:(const char *)name;
+
+- (void)scanForm:(CGPDFStreamRef)stream parent:(CGPDFContentStreamRef)parent;
+
+- (void)finishWord;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextIndex class implementation
+//
+
+@implementation PDFReaderTextIndex
+{
+	NSString *_guid;
+
+	NSInteger _pageCount;
+
+	NSMutableIndexSet *pagesDone; // Indexed pages
+
+	NSMutableDictionary *pages; // Page number -> PDFReaderTextIndexPage
+
+	NSMutableDictionary *terms; // Word -> NSMutableIndexSet of pages
+
+	int indexFile; // Appends finished page segments
+
+	uint64_t indexEnd; // End of the last good segment
+
+	BOOL building;
+
+	BOOL stopped;
+
+	BOOL closed;
+}
+
+#pragma mark Properties
+
+@synthesize guid = _guid;
+@dynamic complete, pageCount, indexedPages;
+
+#pragma mark PDFReaderTextIndex functions
+
+static BOOL TextRead(const uint8_t **bytes, const uint8_t *end, void *value, size_t length)
+{
+	if ((size_t)(end - *bytes) < length) return NO; // Truncated
+
+	memcpy(value, *bytes, length); *bytes += length; return YES;
+}
+
+static BOOL TextWrite(int fd, const void *bytes, size_t length, off_t offset)
+{
+	const uint8_t *data = bytes; // Write everything or fail
+
+	while (length > 0) // Handle short writes
+	{
+		ssize_t written = pwrite(fd, data, length, offset);
+
+		if (written < 0) { if (errno == EINTR) continue; return NO; }
+
+		data += written; length -= written; offset += written;
+	}
+
+	return YES;
+}
+
+static NSUInteger TextFindPosition(NSData *positions, uint32_t position)
+{
+	const uint32_t *values = positions.bytes; NSUInteger low = 0; NSUInteger high = (positions.length / sizeof(uint32_t));
+
+	while (low < high) // Binary search sorted word positions
+	{
+		NSUInteger middle = ((low + high) / 2); uint32_t value; memcpy(&value, &values[middle], sizeof(value));
+
+		if (value == position) return middle; if (value < position) low = (middle + 1); else high = middle;
+	}
+
+	return NSNotFound;
+}
+
+#pragma mark PDFReaderTextIndex class methods
+
++ (NSMutableDictionary *)openIndexes
+{
+	static dispatch_once_t predicate = 0;
+
+	static NSMutableDictionary *indexes = nil; // Open text indexes by GUID
+
+	dispatch_once(&predicate, ^{ indexes = [NSMutableDictionary new]; });
+
+	return indexes;
+}
+
++ (PDFReaderTextIndex *)textIndexWithGUID:(NSString *)guid
+{
+	if (guid == nil) return nil; // Must have a document GUID
+
+	NSMutableDictionary *indexes = [PDFReaderTextIndex openIndexes];
+
+	@synchronized(indexes) // Mutex lock
+	{
+		PDFReaderTextIndex *index = [indexes objectForKey:guid];
+
+		if (index == nil) // New (empty) text index
+		{
+			index = [PDFReaderTextIndex new]; index->_guid = [guid copy];
+
+			[indexes setObject:index forKey:guid];
+		}
+		else // Reopen it if it was closed while its build was still running
+		{
+			@synchronized(index) { index->closed = NO; }
+		}
+
+		return index;
+	}
+}
+
++ (void)closeTextIndexWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to close
+
+	NSMutableDictionary *indexes = [PDFReaderTextIndex openIndexes];
+
+	@synchronized(indexes) // Mutex lock
+	{
+		PDFReaderTextIndex *index = [indexes objectForKey:guid];
+
+		if (index != nil) @synchronized(index) // Stop any build after its current pages
+		{
+			index->closed = YES; if (index->building == NO) [indexes removeObjectForKey:guid]; // Else one writer until it stops
+		}
+	}
+}
+
++ (void)forgetTextIndex:(PDFReaderTextIndex *)index
+{
+	NSMutableDictionary *indexes = [PDFReaderTextIndex openIndexes];
+
+	@synchronized(indexes) // Unless it was reopened meanwhile
+	{
+		if ([indexes objectForKey:index->_guid] == index) @synchronized(index)
+		{
+			if ((index->closed == YES) && (index->building == NO)) [indexes removeObjectForKey:index->_guid];
+		}
+	}
+}
+
++ (NSString *)indexPathForGUID:(NSString *)guid
+{
+	return PDFReaderCacheFilePath(guid, TEXT_FILE_NAME);
+}
+
++ (NSArray *)wordsForText:(NSString *)text
+{
+	NSMutableArray *words = [NSMutableArray array]; NSMutableString *word = [NSMutableString string];
+
+	NSCharacterSet *letters = [NSCharacterSet alphanumericCharacterSet]; NSUInteger length = text.length;
+
+	for (NSUInteger index = 0; index <= length; index++) // Runs of letters and digits
+	{
+		unichar character = ((index < length) ? [text characterAtIndex:index] : 0x0020);
+
+		if ([letters characterIsMember:character] == YES)
+		{
+			if (word.length < WORD_LENGTH) CFStringAppendCharacters((__bridge CFMutableStringRef)word, &character, 1);
+		}
+		else if (word.length > 0) // End of a word
+		{
+			[words addObject:[word lowercaseString]]; [word setString:@""];
+		}
+	}
+
+	return words;
+}
+
+#pragma mark PDFReaderTextIndex instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize superclass object first
+	{
+		pagesDone = [NSMutableIndexSet new]; pages = [NSMutableDictionary new]; terms = [NSMutableDictionary new];
+
+		indexFile = -1; // Not persisting
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (indexFile >= 0) close(indexFile);
+}
+
+- (BOOL)isComplete
+{
+	@synchronized(self) { return ((_pageCount > 0) && (pagesDone.count == (NSUInteger)_pageCount)); }
+}
+
+- (NSInteger)pageCount
+{
+	@synchronized(self) { return _pageCount; }
+}
+
+- (NSIndexSet *)indexedPages
+{
+	@synchronized(self) { return [pagesDone copy]; }
+}
+
+- (BOOL)isPageIndexed:(NSInteger)page
+{
+	@synchronized(self) { return [pagesDone containsIndex:page]; }
+}
+
+- (BOOL)addPage:(PDFReaderTextIndexPage *)indexPage number:(NSInteger)page
+{
+	if ((indexPage == nil) || ([pagesDone containsIndex:page] == YES)) return NO; // Bad or duplicate page
+
+	[pages setObject:indexPage forKey:[NSNumber numberWithInteger:page]]; [pagesDone addIndex:page];
+
+	for (NSString *term in indexPage->postings) // Merge into word -> pages
+	{
+		NSMutableIndexSet *termPages = [terms objectForKey:term];
+
+		if (termPages == nil) { termPages = [NSMutableIndexSet new]; [terms setObject:termPages forKey:term]; }
+
+		[termPages addIndex:page];
+	}
+
+	return YES;
+}
+
+- (void)buildWithURL:(NSURL *)fileURL password:(NSString *)phrase
+{
+	@synchronized(self) // Mutex lock
+	{
+		if ((building == YES) || (closed == YES) || (fileURL == nil)) return;
+
+		if ((_pageCount > 0) && (pagesDone.count == (NSUInteger)_pageCount)) return;
+
+		building = YES; // Once at a time
+	}
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0),
+	^{
+		uint64_t fileSize = 0; double fileDate = 0.0; // Document file identity
+
+		BOOL known = PDFReaderCacheFileIdentity(fileURL, &fileSize, &fileDate);
+
+		CFAbsoluteTime start = CFAbsoluteTimeGetCurrent(); // Build timing
+
+		NSInteger loaded = 0; if (known == YES) loaded = [self loadIndexWithFileSize:fileSize fileDate:fileDate];
+
+		NSInteger extracted = 0; // The index file may already cover every page - then the document is never opened
+
+		if ([self isComplete] == NO) extracted = [self extractPagesWithURL:fileURL password:phrase fileSize:fileSize fileDate:fileDate persist:known];
+
+		BOOL forget = NO; BOOL resume = NO; // Closed, or reopened after the build stopped
+
+		@synchronized(self) // Build done
+		{
+			building = NO; if (indexFile >= 0) close(indexFile), indexFile = -1;
+
+			forget = closed; resume = ((closed == NO) && (stopped == YES)); stopped = NO;
+		}
+
+#ifdef DEBUG
+		NSLog(@"%s %@ pages %i loaded %i extracted %i in %.1fms", __FUNCTION__, _guid, (int)_pageCount,
+			(int)loaded, (int)extracted, ((CFAbsoluteTimeGetCurrent() - start) * 1000.0));
+#endif
+
+		if (forget == YES) [PDFReaderTextIndex forgetTextIndex:self]; else if (resume == YES) [self buildWithURL:fileURL password:phrase];
+	});
+}
+
+- (NSInteger)loadIndexWithFileSize:(uint64_t)fileSize fileDate:(double)fileDate
+{
+	NSString *indexPath = [PDFReaderTextIndex indexPathForGUID:_guid]; // Text index file
+
+	NSData *data = [NSData dataWithContentsOfFile:indexPath options:NSDataReadingMappedIfSafe error:NULL];
+
+	if (data == nil) return 0; // No index file yet
+
+	PDFReaderCacheFileHeader header; // Truncated, stale or for a changed document
+
+	if (PDFReaderCacheFileReadHeader(data, TEXT_MAGIC, TEXT_VERSION, fileSize, fileDate, &header) == NO)
+	{
+		[[NSFileManager new] removeItemAtPath:indexPath error:NULL]; return 0; // Stale - start over
+	}
+
+	@synchronized(self) { _pageCount = header.count; } // Same document file - same page count
+
+	const uint8_t *start = data.bytes; const uint8_t *bytes = (start + sizeof(header)); const uint8_t *end = (start + data.length);
+
+	PDFReaderTextIndexSegment segment; NSInteger count = 0; // Finished page segments
+
+	while (TextRead(&bytes, end, &segment, sizeof(segment)) == YES)
+	{
+		if (((size_t)(end - bytes) < segment.length) || (PDFReaderCacheFileChecksum(bytes, segment.length) != segment.checksum))
+		{
+			bytes -= sizeof(segment); break; // Torn tail
+		}
+
+		PDFReaderTextIndexPage *indexPage = [PDFReaderTextIndexPage pageWithSegment:bytes length:segment.length];
+
+		if ((indexPage != nil) && (segment.page > 0) && (segment.page <= header.count))
+		{
+			@synchronized(self) { [self addPage:indexPage number:segment.page]; } count++;
+		}
+
+		bytes += segment.length;
+	}
+
+	@synchronized(self) { indexEnd = (bytes - start); } // Appends overwrite any torn tail
+
+	if (bytes < end) // Drop a torn tail so appends follow the last good segment
+	{
+		int fd = open([indexPath fileSystemRepresentation], O_WRONLY);
+
+		if (fd >= 0) { ftruncate(fd, (bytes - start)); close(fd); }
+	}
+
+	return count;
+}
+
+- (NSInteger)extractPagesWithURL:(NSURL *)fileURL password:(NSString *)phrase fileSize:(uint64_t)fileSize fileDate:(double)fileDate persist:(BOOL)persist
+{
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
+
+	CGPDFDocumentRef document = [documentPool retainDocumentWithURL:fileURL password:phrase guid:_guid];
+
+	if (document == NULL) return 0; // Unable to open the document
+
+	NSInteger count = CGPDFDocumentGetNumberOfPages(document); NSMutableArray *remaining = [NSMutableArray array];
+
+	@synchronized(self) // Pages still to extract
+	{
+		_pageCount = count;
+
+		for (NSInteger page = 1; page <= count; page++)
+		{
+			if ([pagesDone containsIndex:page] == NO) [remaining addObject:[NSNumber numberWithInteger:page]];
+		}
+	}
+
+	if ((persist == YES) && (remaining.count > 0)) // Open the index file for appends
+	{
+		NSString *indexPath = [PDFReaderTextIndex indexPathForGUID:_guid]; // Text index file
+
+		if ([[NSFileManager new] fileExistsAtPath:indexPath] == NO) // New index file
+		{
+			PDFReaderCacheFileHeader header = PDFReaderCacheFileMakeHeader(TEXT_MAGIC, TEXT_VERSION, fileSize, fileDate, (uint32_t)count);
+
+			if (PDFReaderCacheFileWrite(_guid, TEXT_FILE_NAME, [NSData dataWithBytes:&header length:sizeof(header)]) == YES)
+			{
+				@synchronized(self) { indexEnd = sizeof(header); } // Page count
+			}
+		}
+
+		int fd = open([indexPath fileSystemRepresentation], O_WRONLY); // Segments are written at indexEnd
+
+		@synchronized(self) // No end offset without a loaded or new header
+		{
+			if ((fd >= 0) && (indexEnd == 0)) close(fd), fd = -1;
+
+			indexFile = fd;
+		}
+	}
+
+	NSUInteger total = remaining.count; size_t chunks = ((total + CHUNK_PAGES - 1) / CHUNK_PAGES); // Parallel chunks of pages
+
+	__block NSInteger extracted = 0;
+
+	dispatch_apply(chunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0),
+	^(size_t chunk)
+	{
+		NSUInteger first = (chunk * CHUNK_PAGES); NSUInteger last = MIN((first + CHUNK_PAGES), total);
+
+		for (NSUInteger index = first; index < last; index++) // Each finished page is searchable at once
+		{
+			@synchronized(self) { if (closed == YES) { stopped = YES; return; } }
+
+			NSInteger page = [[remaining objectAtIndex:index] integerValue];
+
+			if ([self isPageIndexed:page] == YES) continue; // Extracted on demand meanwhile
+
+			if ([self indexPage:page document:document] == YES) @synchronized(self) { extracted++; }
+		}
+	});
+
+	[documentPool releaseDocument:document]; return extracted;
+}
+
+- (BOOL)indexPage:(NSInteger)page document:(CGPDFDocumentRef)document
+{
+	if ([self isPageIndexed:page] == YES) return YES; // Already searchable
+
+	CGPDFPageRef pageRef = CGPDFDocumentGetPage(document, page); if (pageRef == NULL) return NO;
+
+	@autoreleasepool // Scanner temporaries
+	{
+		NSData *payload = [PDFReaderTextScanner segmentForPage:pageRef];
+
+		PDFReaderTextIndexPage *indexPage = [PDFReaderTextIndexPage pageWithSegment:payload.bytes length:payload.length];
+
+		PDFReaderTextIndexSegment segment; memset(&segment, 0x00, sizeof(segment));
+
+		segment.page = (uint32_t)page; segment.length = (uint32_t)payload.length;
+
+		segment.checksum = PDFReaderCacheFileChecksum(payload.bytes, payload.length);
+
+		NSMutableData *data = [NSMutableData dataWithBytes:&segment length:sizeof(segment)]; [data appendData:payload];
+
+		@synchronized(self) // Searchable, and saved while a build has the index file open
+		{
+			if (([self addPage:indexPage number:page] == YES) && (indexFile >= 0))
+			{
+				if (TextWrite(indexFile, data.bytes, data.length, indexEnd) == YES) // ENOSPC or EIO fail here
+				{
+					indexEnd += data.length;
+				}
+				else // Drop the partial segment and stop saving - the pages stay searchable
+				{
+					ftruncate(indexFile, indexEnd); close(indexFile); indexFile = -1;
+				}
+			}
+		}
+	}
+
+	return YES;
+}
+
+- (NSIndexSet *)pagesMatchingText:(NSString *)text
+{
+	NSMutableIndexSet *matches = [NSMutableIndexSet indexSet]; // Pages with the phrase
+
+	for (PDFReaderTextHit *hit in [self hitsForText:text]) [matches addIndex:hit.page];
+
+	return matches;
+}
+
+- (NSArray *)hitsForText:(NSString *)text
+{
+	NSArray *words = [PDFReaderTextIndex wordsForText:text]; if (words.count == 0) return [NSArray array];
+
+	NSIndexSet *candidates = [self pagesContainingWords:words]; // Pages containing every word
+
+	NSMutableArray *hits = [NSMutableArray array]; // Phrase matches in page order
+
+	[candidates enumerateIndexesUsingBlock:^(NSUInteger page, BOOL *stop)
+	{
+		[hits addObjectsFromArray:[self hitsForWords:words page:page]];
+	}];
+
+	return hits;
+}
+
+- (NSIndexSet *)pagesContainingWords:(NSArray *)words
+{
+	NSMutableIndexSet *candidates = nil; // Indexed pages containing every word
+
+	@synchronized(self) // Mutex lock
+	{
+		for (NSString *term in words) // Intersect the word page sets
+		{
+			NSIndexSet *termPages = [terms objectForKey:term]; if (termPages == nil) return [NSIndexSet indexSet];
+
+			if (candidates == nil) candidates = [termPages mutableCopy]; else
+			{
+				NSMutableIndexSet *common = [NSMutableIndexSet indexSet];
+
+				[candidates enumerateIndexesUsingBlock:^(NSUInteger page, BOOL *stop) { if ([termPages containsIndex:page]) [common addIndex:page]; }];
+
+				candidates = common;
+			}
+		}
+	}
+
+	return ((candidates != nil) ? candidates : [NSIndexSet indexSet]);
+}
+
+- (NSArray *)hitsForText:(NSString *)text page:(NSInteger)page
+{
+	NSArray *words = [PDFReaderTextIndex wordsForText:text]; if (words.count == 0) return [NSArray array];
+
+	return [self hitsForWords:words page:page];
+}
+
+- (NSArray *)hitsForWords:(NSArray *)words page:(NSInteger)page
+{
+	NSMutableArray *hits = [NSMutableArray array]; // Phrase matches on the page
+
+	@synchronized(self) // Mutex lock
+	{
+		PDFReaderTextIndexPage *indexPage = [pages objectForKey:[NSNumber numberWithInteger:page]];
+
+		if (indexPage == nil) return hits; // Not indexed (yet)
+
+		NSMutableArray *lists = [NSMutableArray array]; // Word position lists
+
+		for (NSString *term in words) // Every word must be on the page
+		{
+			NSData *positions = [indexPage->postings objectForKey:term]; if (positions == nil) return hits;
+
+			[lists addObject:positions];
+		}
+
+		NSData *firsts = [lists objectAtIndex:0]; const uint32_t *values = firsts.bytes;
+
+		const float *bounds = indexPage->rects.bytes; NSUInteger wordCount = (indexPage->rects.length / (sizeof(float) * 4));
+
+		for (NSUInteger index = 0; index < (firsts.length / sizeof(uint32_t)); index++)
+		{
+			uint32_t position; memcpy(&position, &values[index], sizeof(position)); BOOL match = YES;
+
+			for (NSUInteger next = 1; (next < lists.count) && (match == YES); next++) // Consecutive words
+			{
+				match = (TextFindPosition([lists objectAtIndex:next], (position + (uint32_t)next)) != NSNotFound);
+			}
+
+			if ((match == NO) || ((position + words.count) > wordCount)) continue; // No phrase here
+
+			CGRect rect = CGRectNull; // Union of the phrase word bounds
+
+			for (NSUInteger word = position; word < (position + words.count); word++)
+			{
+				const float *box = &bounds[word * 4]; rect = CGRectUnion(rect, CGRectMake(box[0], box[1], box[2], box[3]));
+			}
+
+			[hits addObject:[[PDFReaderTextHit alloc] initWithPage:page wordIndex:position rect:rect]];
+		}
+	}
+
+	return hits;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextIndexPage class implementation
+//
+
+@implementation PDFReaderTextIndexPage
+
+#pragma mark PDFReaderTextIndexPage class methods
+
++ (PDFReaderTextIndexPage *)pageWithSegment:(const uint8_t *)bytes length:(size_t)length
+{
+	const uint8_t *end = (bytes + length); uint32_t wordCount = 0; uint32_t termCount = 0;
+
+	if (TextRead(&bytes, end, &wordCount, sizeof(wordCount)) == NO) return nil;
+
+	size_t rectBytes = (wordCount * sizeof(float) * 4); if ((size_t)(end - bytes) < rectBytes) return nil;
+
+	PDFReaderTextIndexPage *indexPage = [PDFReaderTextIndexPage new]; // Decoded page
+
+	indexPage->rects = [NSData dataWithBytes:bytes length:rectBytes]; bytes += rectBytes;
+
+	if (TextRead(&bytes, end, &termCount, sizeof(termCount)) == NO) return nil;
+
+	NSMutableDictionary *postings = [NSMutableDictionary dictionaryWithCapacity:termCount];
+
+	for (uint32_t index = 0; index < termCount; index++) // Word -> positions
+	{
+		uint8_t size = 0; if ((TextRead(&bytes, end, &size, sizeof(size)) == NO) || ((size_t)(end - bytes) < size)) return nil;
+
+		NSString *term = [[NSString alloc] initWithBytes:bytes length:size encoding:NSUTF8StringEncoding]; bytes += size;
+
+		uint32_t count = 0; if (TextRead(&bytes, end, &count, sizeof(count)) == NO) return nil;
+
+		size_t positionBytes = (count * sizeof(uint32_t)); if ((size_t)(end - bytes) < positionBytes) return nil;
+
+		if (term != nil) [postings setObject:[NSData dataWithBytes:bytes length:positionBytes] forKey:term];
+
+		bytes += positionBytes;
+	}
+
+	indexPage->postings = postings; return indexPage;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextHit class implementation
+//
+
+@implementation PDFReaderTextHit
+{
+	NSInteger _page;
+
+	NSUInteger _wordIndex;
+
+	CGRect _rect;
+}
+
+#pragma mark Properties
+
+@synthesize page = _page;
+@synthesize wordIndex = _wordIndex;
+@synthesize rect = _rect;
+
+#pragma mark PDFReaderTextHit instance methods
+
+- (id)initWithPage:(NSInteger)page wordIndex:(NSUInteger)wordIndex rect:(CGRect)rect
+{
+	if ((self = [super init])) // Initialize superclass object first
+	{
+		_page = page; _wordIndex = wordIndex; _rect = rect;
+	}
+
+	return self;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextFont class implementation
+//
+
+@implementation PDFReaderTextFont
+
+#pragma mark PDFReaderTextFont functions
+
+static BOOL TextHexToken(const uint8_t **bytes, const uint8_t *end, NSMutableData *token)
+{
+	const uint8_t *p = *bytes; [token setLength:0]; // Hex string bytes
+
+	if ((p >= end) || (*p != '<')) return NO; p++; int high = -1;
+
+	while ((p < end) && (*p != '>')) // Hex digits, whitespace ignored
+	{
+		int digit = -1; uint8_t c = *p++;
+
+		if ((c >= '0') && (c <= '9')) digit = (c - '0'); else if ((c >= 'a') && (c <= 'f')) digit = (c - 'a' + 10); else if ((c >= 'A') && (c <= 'F')) digit = (c - 'A' + 10);
+
+		if (digit < 0) continue; if (high < 0) high = digit; else { uint8_t byte = ((high << 4) | digit); [token appendBytes:&byte length:1]; high = -1; }
+	}
+
+	if (high >= 0) { uint8_t byte = (high << 4); [token appendBytes:&byte length:1]; } // Odd digit count
+
+	*bytes = ((p < end) ? (p + 1) : p); return YES;
+}
+
+static NSUInteger TextCodeValue(NSData *token)
+{
+	const uint8_t *bytes = token.bytes; NSUInteger value = 0; // Big endian code
+
+	for (NSUInteger index = 0; (index < token.length) && (index < 4); index++) value = ((value << 8) | bytes[index]);
+
+	return value;
+}
+
+static NSString *TextUnicodeString(NSData *token, NSUInteger offset)
+{
+	NSUInteger count = (token.length / 2); if (count == 0) return nil; // UTF-16BE
+
+	unichar *characters = malloc(count * sizeof(unichar)); const uint8_t *bytes = token.bytes;
+
+	for (NSUInteger index = 0; index < count; index++) characters[index] = ((bytes[index * 2] << 8) | bytes[(index * 2) + 1]);
+
+	characters[count - 1] += offset; // bfrange increments the last character
+
+	NSString *string = [[NSString alloc] initWithCharacters:characters length:count]; free(characters);
+
+	return string;
+}
+
+#pragma mark PDFReaderTextFont class methods
+
++ (PDFReaderTextFont *)fontWithDictionary:(CGPDFDictionaryRef)fontDictionary
+{
+	PDFReaderTextFont *font = [PDFReaderTextFont new]; // Font metrics and text map
+
+	font->defaultWidth = DEFAULT_WIDTH; font->decodable = YES;
+
+	const char *subtype = NULL; CGPDFDictionaryGetName(fontDictionary, "Subtype", &subtype);
+
+	if ((subtype != NULL) && (strcmp(subtype, "Type0") == 0)) // Composite font (assume Identity-H)
+	{
+		font->twoByte = YES; font->decodable = NO; // Glyph IDs - text only through /ToUnicode
+
+		CGPDFArrayRef descendants = NULL; CGPDFDictionaryRef descendant = NULL;
+
+		if (CGPDFDictionaryGetArray(fontDictionary, "DescendantFonts", &descendants) && CGPDFArrayGetDictionary(descendants, 0, &descendant))
+		{
+			CGPDFReal width = 1000.0f; CGPDFDictionaryGetNumber(descendant, "DW", &width); font->defaultWidth = width;
+
+			CGPDFArrayRef array = NULL; if (CGPDFDictionaryGetArray(descendant, "W", &array)) [font parseCIDWidths:array];
+		}
+	}
+	else // Simple font (one byte codes)
+	{
+		CGPDFInteger firstChar = 0; CGPDFArrayRef array = NULL; CGPDFDictionaryRef descriptor = NULL;
+
+		CGPDFDictionaryGetInteger(fontDictionary, "FirstChar", &firstChar); font->firstChar = firstChar;
+
+		if (CGPDFDictionaryGetDictionary(fontDictionary, "FontDescriptor", &descriptor))
+		{
+			CGPDFReal missing = 0.0f; if (CGPDFDictionaryGetNumber(descriptor, "MissingWidth", &missing) && (missing > 0.0f)) font->defaultWidth = missing;
+		}
+
+		if (CGPDFDictionaryGetArray(fontDictionary, "Widths", &array))
+		{
+			size_t count = CGPDFArrayGetCount(array); NSMutableData *widths = [NSMutableData dataWithLength:(count * sizeof(CGFloat))];
+
+			CGFloat *values = widths.mutableBytes; // Glyph widths
+
+			for (size_t index = 0; index < count; index++) { CGPDFReal width = 0.0f; CGPDFArrayGetNumber(array, index, &width); values[index] = width; }
+
+			font->widths = widths;
+		}
+	}
+
+	CGPDFStreamRef toUnicode = NULL; // Code -> Unicode map
+
+	if (CGPDFDictionaryGetStream(fontDictionary, "ToUnicode", &toUnicode)) [font parseToUnicode:toUnicode];
+
+	return font;
+}
+
+#pragma mark PDFReaderTextFont instance methods
+
+- (void)parseCIDWidths:(CGPDFArrayRef)array
+{
+	cidWidths = [NSMutableDictionary new]; size_t count = CGPDFArrayGetCount(array); size_t index = 0;
+
+	while (index < count) // c [w1 w2 ...] or c_first c_last w
+	{
+		CGPDFInteger first = 0; CGPDFArrayRef list = NULL; if (CGPDFArrayGetInteger(array, index++, &first) == false) break;
+
+		if (CGPDFArrayGetArray(array, index, &list)) // c [w1 w2 ...]
+		{
+			size_t widthCount = MIN(CGPDFArrayGetCount(list), MAP_RANGE_LIMIT); index++;
+
+			for (size_t item = 0; item < widthCount; item++)
+			{
+				CGPDFReal width = 0.0f; CGPDFArrayGetNumber(list, item, &width);
+
+				[cidWidths setObject:[NSNumber numberWithFloat:width] forKey:[NSNumber numberWithInteger:(first + item)]];
+			}
+		}
+		else // c_first c_last w
+		{
+			CGPDFInteger last = 0; CGPDFReal width = 0.0f;
+
+			if ((CGPDFArrayGetInteger(array, index++, &last) == false) || (CGPDFArrayGetNumber(array, index++, &width) == false)) break;
+
+			for (CGPDFInteger cid = first; (cid <= last) && ((cid - first) < MAP_RANGE_LIMIT); cid++)
+			{
+				[cidWidths setObject:[NSNumber numberWithFloat:width] forKey:[NSNumber numberWithInteger:cid]];
+			}
+		}
+	}
+}
+
+- (void)parseToUnicode:(CGPDFStreamRef)stream
+{
+	CGPDFDataFormat format; CFDataRef data = CGPDFStreamCopyData(stream, &format);
+
+	if (data == NULL) return; // Unable to read the CMap stream
+
+	if (format == CGPDFDataFormatRaw) // Parse bfchar and bfrange sections
+	{
+		const uint8_t *bytes = CFDataGetBytePtr(data); const uint8_t *end = (bytes + CFDataGetLength(data));
+
+		NSMutableData *token = [NSMutableData data]; NSMutableArray *operands = [NSMutableArray array];
+
+		unicodes = [NSMutableDictionary new]; NSInteger mode = 0; BOOL list = NO; // 1 = bfchar, 2 = bfrange
+
+		while (bytes < end) // Simple CMap tokenizer
+		{
+			uint8_t c = *bytes; // Next character
+
+			if ((c == ' ') || (c == '\n') || (c == '\r') || (c == '\t')) { bytes++; continue; }
+
+			if (c == '[') { list = YES; bytes++; continue; } // bfrange destination list
+
+			if (c == ']') // <low> <high> [<unicode> ...]
+			{
+				if ((mode == 2) && (list == YES) && (operands.count > 2))
+				{
+					NSUInteger low = TextCodeValue([operands objectAtIndex:0]); NSUInteger count = (operands.count - 2);
+
+					for (NSUInteger item = 0; item < count; item++)
+					{
+						NSString *text = TextUnicodeString([operands objectAtIndex:(2 + item)], 0);
+
+						if (text != nil) [unicodes setObject:text forKey:[NSNumber numberWithUnsignedInteger:(low + item)]];
+					}
+				}
+
+				list = NO; [operands removeAllObjects]; bytes++; continue;
+			}
+
+			if (c == '<') // Hex string
+			{
+				if (TextHexToken(&bytes, end, token) == NO) break; [operands addObject:[token copy]];
+
+				if ((mode == 1) && (operands.count == 2)) // <code> <unicode>
+				{
+					NSString *text = TextUnicodeString([operands objectAtIndex:1], 0);
+
+					if (text != nil) [unicodes setObject:text forKey:[NSNumber numberWithUnsignedInteger:TextCodeValue([operands objectAtIndex:0])]];
+
+					[operands removeAllObjects];
+				}
+				else if ((mode == 2) && (list == NO) && (operands.count == 3)) // <low> <high> <unicode>
+				{
+					NSUInteger low = TextCodeValue([operands objectAtIndex:0]); NSUInteger high = TextCodeValue([operands objectAtIndex:1]);
+
+					for (NSUInteger code = low; (code <= high) && ((code - low) < MAP_RANGE_LIMIT); code++)
+					{
+						NSString *text = TextUnicodeString([operands objectAtIndex:2], (code - low));
+
+						if (text != nil) [unicodes setObject:text forKey:[NSNumber numberWithUnsignedInteger:code]];
+					}
+
+					[operands removeAllObjects];
+				}
+
+				continue;
+			}
+
+			const uint8_t *word = bytes; // Keyword or other token
+
+			while ((bytes < end) && (*bytes > ' ') && (*bytes != '<') && (*bytes != '[') && (*bytes != ']')) bytes++;
+
+			size_t length = (bytes - word); if (length == 0) { bytes++; continue; }
+
+			if ((length == 11) && (memcmp(word, "beginbfchar", 11) == 0)) mode = 1; else
+			if ((length == 12) && (memcmp(word, "beginbfrange", 12) == 0)) mode = 2; else
+			if ((length >= 9) && (memcmp(word, "end", 3) == 0)) mode = 0;
+
+			list = NO; [operands removeAllObjects];
+		}
+	}
+
+	CFRelease(data);
+}
+
+- (CGFloat)widthForCode:(NSUInteger)code
+{
+	if (twoByte == YES) // CID widths
+	{
+		NSNumber *width = [cidWidths objectForKey:[NSNumber numberWithUnsignedInteger:code]];
+
+		return ((width != nil) ? [width floatValue] : defaultWidth);
+	}
+
+	NSInteger index = (code - firstChar); NSUInteger count = (widths.length / sizeof(CGFloat));
+
+	if ((index >= 0) && ((NSUInteger)index < count)) return ((const CGFloat *)widths.bytes)[index];
+
+	return defaultWidth;
+}
+
+- (NSString *)textForCode:(NSUInteger)code
+{
+	NSString *text = [unicodes objectForKey:[NSNumber numberWithUnsignedInteger:code]];
+
+	if ((text == nil) && (decodable == YES)) // Latin-1 fallback for simple fonts
+	{
+		unichar character = (unichar)code; text = [NSString stringWithCharacters:&character length:1];
+	}
+
+	return text;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTextScanner class implementation
+//
+
+@implementation PDFReaderTextScanner
+
+#pragma mark PDFReaderTextScanner functions
+
+static PDFReaderTextState *TextCurrentState(PDFReaderTextScanner *scanner)
+{
+	return &scanner->states[scanner->depth];
+}
+
+static void TextMoveLine(PDFReaderTextScanner *scanner, CGFloat tx, CGFloat ty)
+{
+	scanner->lineMatrix = CGAffineTransformConcat(CGAffineTransformMakeTranslation(tx, ty), scanner->lineMatrix);
+
+	scanner->textMatrix = scanner->lineMatrix;
+}
+
+static void TextShowString(PDFReaderTextScanner *scanner, CGPDFStringRef string)
+{
+	PDFReaderTextState *state = TextCurrentState(scanner); PDFReaderTextFont *font = state->font;
+
+	const unsigned char *bytes = CGPDFStringGetBytePtr(string); size_t length = CGPDFStringGetLength(string);
+
+	size_t step = ((font->twoByte == YES) ? 2 : 1); NSCharacterSet *letters = [NSCharacterSet alphanumericCharacterSet];
+
+	CGAffineTransform fontMatrix = CGAffineTransformMake((state->fontSize * state->hScale), 0.0f, 0.0f, state->fontSize, 0.0f, state->rise);
+
+	for (size_t index = 0; (index + step) <= length; index += step) // Each character code
+	{
+		NSUInteger code = ((step == 2) ? ((bytes[index] << 8) | bytes[index + 1]) : bytes[index]);
+
+		CGFloat width = ([font widthForCode:code] / 1000.0f); // Glyph space to text space
+
+		CGAffineTransform renderMatrix = CGAffineTransformConcat(CGAffineTransformConcat(fontMatrix, scanner->textMatrix), state->ctm);
+
+		CGRect glyphRect = CGRectApplyAffineTransform(CGRectMake(0.0f, GLYPH_DESCENT, width, GLYPH_HEIGHT), renderMatrix);
+
+		CGPoint origin = CGPointApplyAffineTransform(CGPointMake(0.0f, 0.0f), renderMatrix);
+
+		CGFloat size = hypot(renderMatrix.c, renderMatrix.d); // Rendered font size
+
+		if ((scanner->word.length > 0) && (hypot((origin.x - scanner->wordEnd.x), (origin.y - scanner->wordEnd.y)) > (size * WORD_GAP)))
+		{
+			[scanner finishWord]; // Positioned apart from the previous glyph
+		}
+
+		NSString *text = [font textForCode:code]; NSUInteger count = text.length;
+
+		for (NSUInteger item = 0; item < count; item++) // Letters and digits extend the word
+		{
+			unichar character = [text characterAtIndex:item];
+
+			if ([letters characterIsMember:character] == YES)
+			{
+				if (scanner->word.length < WORD_LENGTH) CFStringAppendCharacters((__bridge CFMutableStringRef)scanner->word, &character, 1);
+
+				scanner->wordRect = CGRectUnion(scanner->wordRect, glyphRect);
+			}
+			else
+				[scanner finishWord];
+		}
+
+		CGFloat spacing = (((step == 1) && (code == 0x20)) ? state->wordSpacing : 0.0f); // Tw only for single byte spaces
+
+		CGFloat tx = (((width * state->fontSize) + state->charSpacing + spacing) * state->hScale);
+
+		scanner->textMatrix = CGAffineTransformConcat(CGAffineTransformMakeTranslation(tx, 0.0f), scanner->textMatrix);
+
+		scanner->wordEnd = CGPointApplyAffineTransform(CGPointMake(0.0f, 0.0f), CGAffineTransformConcat(CGAffineTransformConcat(fontMatrix, scanner->textMatrix), state->ctm));
+	}
+}
+
+static void TextOp_q(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info;
+
+	if (object->depth < (STATE_DEPTH - 1)) { object->states[object->depth + 1] = object->states[object->depth]; object->depth++; }
+}
+
+static void TextOp_Q(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; if (object->depth > object->baseDepth) object->depth--;
+}
+
+static void TextOp_cm(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFReal m[6]; // a b c d e f
+
+	for (NSInteger index = 5; index >= 0; index--) if (CGPDFScannerPopNumber(scanner, &m[index]) == false) return;
+
+	PDFReaderTextState *state = TextCurrentState(object);
+
+	state->ctm = CGAffineTransformConcat(CGAffineTransformMake(m[0], m[1], m[2], m[3], m[4], m[5]), state->ctm);
+}
+
+static void TextOp_BT(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info;
+
+	object->textMatrix = CGAffineTransformIdentity; object->lineMatrix = CGAffineTransformIdentity;
+}
+
+static void TextOp_ET(CGPDFScannerRef scanner, void *info)
+{
+	[(__bridge PDFReaderTextScanner *)info finishWord];
+}
+
+static void TextOp_Tf(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFReal size = 0.0f; const char *name = NULL;
+
+	if ((CGPDFScannerPopNumber(scanner, &size) == false) || (CGPDFScannerPopName(scanner, &name) == false)) return;
+
+	PDFReaderTextState *state = TextCurrentState(object); state->fontSize = size; state->font = [object fontNamed:name];
+}
+
+static void TextOp_Tc(CGPDFScannerRef scanner, void *info)
+{
+	CGPDFReal value; if (CGPDFScannerPopNumber(scanner, &value)) TextCurrentState((__bridge PDFReaderTextScanner *)info)->charSpacing = value;
+}
+
+static void TextOp_Tw(CGPDFScannerRef scanner, void *info)
+{
+	CGPDFReal value; if (CGPDFScannerPopNumber(scanner, &value)) TextCurrentState((__bridge PDFReaderTextScanner *)info)->wordSpacing = value;
+}
+
+static void TextOp_Tz(CGPDFScannerRef scanner, void *info)
+{
+	CGPDFReal value; if (CGPDFScannerPopNumber(scanner, &value)) TextCurrentState((__bridge PDFReaderTextScanner *)info)->hScale = (value / 100.0f);
+}
+
+static void TextOp_TL(CGPDFScannerRef scanner, void *info)
+{
+	CGPDFReal value; if (CGPDFScannerPopNumber(scanner, &value)) TextCurrentState((__bridge PDFReaderTextScanner *)info)->leading = value;
+}
+
+static void TextOp_Ts(CGPDFScannerRef scanner, void *info)
+{
+	CGPDFReal value; if (CGPDFScannerPopNumber(scanner, &value)) TextCurrentState((__bridge PDFReaderTextScanner *)info)->rise = value;
+}
+
+static void TextOp_Td(CGPDFScannerRef scanner, void *info)
+{
+	CGPDFReal tx, ty; if (CGPDFScannerPopNumber(scanner, &ty) && CGPDFScannerPopNumber(scanner, &tx)) TextMoveLine((__bridge PDFReaderTextScanner *)info, tx, ty);
+}
+
+static void TextOp_TD(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFReal tx, ty;
+
+	if (CGPDFScannerPopNumber(scanner, &ty) && CGPDFScannerPopNumber(scanner, &tx)) { TextCurrentState(object)->leading = -ty; TextMoveLine(object, tx, ty); }
+}
+
+static void TextOp_Tm(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFReal m[6]; // a b c d e f
+
+	for (NSInteger index = 5; index >= 0; index--) if (CGPDFScannerPopNumber(scanner, &m[index]) == false) return;
+
+	object->lineMatrix = CGAffineTransformMake(m[0], m[1], m[2], m[3], m[4], m[5]); object->textMatrix = object->lineMatrix;
+}
+
+static void TextOp_TStar(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; TextMoveLine(object, 0.0f, -TextCurrentState(object)->leading);
+}
+
+static void TextOp_Tj(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFStringRef string = NULL;
+
+	if (CGPDFScannerPopString(scanner, &string) && (TextCurrentState(object)->font != nil)) TextShowString(object, string);
+}
+
+static void TextOp_Quote(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFStringRef string = NULL;
+
+	if (CGPDFScannerPopString(scanner, &string) == false) return; TextOp_TStar(scanner, info);
+
+	if (TextCurrentState(object)->font != nil) TextShowString(object, string);
+}
+
+static void TextOp_DoubleQuote(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFStringRef string = NULL; CGPDFReal aw, ac;
+
+	if ((CGPDFScannerPopString(scanner, &string) && CGPDFScannerPopNumber(scanner, &ac) && CGPDFScannerPopNumber(scanner, &aw)) == false) return;
+
+	PDFReaderTextState *state = TextCurrentState(object); state->wordSpacing = aw; state->charSpacing = ac; TextOp_TStar(scanner, info);
+
+	if (state->font != nil) TextShowString(object, string);
+}
+
+static void TextOp_TJ(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; CGPDFArrayRef array = NULL;
+
+	if (CGPDFScannerPopArray(scanner, &array) == false) return; PDFReaderTextState *state = TextCurrentState(object);
+
+	if (state->font == nil) return; size_t count = CGPDFArrayGetCount(array);
+
+	for (size_t index = 0; index < count; index++) // Strings and position adjustments
+	{
+		CGPDFStringRef string = NULL; CGPDFReal adjust = 0.0f;
+
+		if (CGPDFArrayGetString(array, index, &string)) TextShowString(object, string); else
+		if (CGPDFArrayGetNumber(array, index, &adjust)) // Thousandths of text space
+		{
+			CGFloat tx = (-(adjust / 1000.0f) * state->fontSize * state->hScale);
+
+			object->textMatrix = CGAffineTransformConcat(CGAffineTransformMakeTranslation(tx, 0.0f), object->textMatrix);
+		}
+	}
+}
+
+static void TextOp_Do(CGPDFScannerRef scanner, void *info)
+{
+	PDFReaderTextScanner *object = (__bridge PDFReaderTextScanner *)info; const char *name = NULL; CGPDFStreamRef stream = NULL;
+
+	if ((CGPDFScannerPopName(scanner, &name) == false) || (object->xobjectsDictionary == NULL)) return;
+
+	if (CGPDFDictionaryGetStream(object->xobjectsDictionary, name, &stream)) [object scanForm:stream parent:CGPDFScannerGetContentStream(scanner)];
+}
+
+#pragma mark PDFReaderTextScanner class methods
+
++ (CGPDFOperatorTableRef)operatorTable
+{
+	static dispatch_once_t predicate = 0;
+
+	static CGPDFOperatorTableRef table = NULL; // Shared (read-only) operator table
+
+	dispatch_once(&predicate,
+	^{
+		table = CGPDFOperatorTableCreate();
+
+		CGPDFOperatorTableSetCallback(table, "q", TextOp_q); CGPDFOperatorTableSetCallback(table, "Q", TextOp_Q);
+
+		CGPDFOperatorTableSetCallback(table, "cm", TextOp_cm); CGPDFOperatorTableSetCallback(table, "BT", TextOp_BT);
+
+		CGPDFOperatorTableSetCallback(table, "ET", TextOp_ET); CGPDFOperatorTableSetCallback(table, "Tf", TextOp_Tf);
+
+		CGPDFOperatorTableSetCallback(table, "Tc", TextOp_Tc); CGPDFOperatorTableSetCallback(table, "Tw", TextOp_Tw);
+
+		CGPDFOperatorTableSetCallback(table, "Tz", TextOp_Tz); CGPDFOperatorTableSetCallback(table, "TL", TextOp_TL);
+
+		CGPDFOperatorTableSetCallback(table, "Ts", TextOp_Ts); CGPDFOperatorTableSetCallback(table, "Td", TextOp_Td);
+
+		CGPDFOperatorTableSetCallback(table, "TD", TextOp_TD); CGPDFOperatorTableSetCallback(table, "Tm", TextOp_Tm);
+
+		CGPDFOperatorTableSetCallback(table, "T*", TextOp_TStar); CGPDFOperatorTableSetCallback(table, "Tj", TextOp_Tj);
+
+		CGPDFOperatorTableSetCallback(table, "'", TextOp_Quote); CGPDFOperatorTableSetCallback(table, "\"", TextOp_DoubleQuote);
+
+		CGPDFOperatorTableSetCallback(table, "TJ", TextOp_TJ); CGPDFOperatorTableSetCallback(table, "Do", TextOp_Do);
+	});
+
+	return table;
+}
+
++ (NSData *)segmentForPage:(CGPDFPageRef)page
+{
+	PDFReaderTextScanner *object = [PDFReaderTextScanner new]; // Page scanner state
+
+	CGPDFDictionaryRef pageDictionary = CGPDFPageGetDictionary(page); // Find the (inherited) font resources
+
+	for (NSInteger level = 0; (pageDictionary != NULL) && (level < RESOURCE_DEPTH); level++)
+	{
+		CGPDFDictionaryRef resources = NULL; // Page or inherited resources
+
+		if (CGPDFDictionaryGetDictionary(pageDictionary, "Resources", &resources))
+		{
+			CGPDFDictionaryGetDictionary(resources, "Font", &object->fontsDictionary);
+
+			CGPDFDictionaryGetDictionary(resources, "XObject", &object->xobjectsDictionary); break;
+		}
+
+		if (CGPDFDictionaryGetDictionary(pageDictionary, "Parent", &pageDictionary) == false) break;
+	}
+
+	CGPDFContentStreamRef contentStream = CGPDFContentStreamCreateWithPage(page);
+
+	CGPDFScannerRef scanner = CGPDFScannerCreate(contentStream, [PDFReaderTextScanner operatorTable], (__bridge void *)object);
+
+	CGPDFScannerScan(scanner); [object finishWord]; // Extract the page words
+
+	CGPDFScannerRelease(scanner); CGPDFContentStreamRelease(contentStream);
+
+	return [object segment];
+}
+
+#pragma mark PDFReaderTextScanner instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize superclass object first
+	{
+		PDFReaderTextState *state = &states[0]; memset(state, 0x00, sizeof(PDFReaderTextState));
+
+		state->ctm = CGAffineTransformIdentity; state->hScale = 1.0f; state->fontSize = 1.0f;
+
+		textMatrix = CGAffineTransformIdentity; lineMatrix = CGAffineTransformIdentity;
+
+		fonts = [NSMutableDictionary new]; words = [NSMutableArray new]; rects = [NSMutableData new];
+
+		word = [NSMutableString new]; wordRect = CGRectNull;
+	}
+
+	return self;
+}
+
+- (PDFReaderTextFont *)fontNamed:(const char *)name
+{
+	NSString *key = [NSString stringWithUTF8String:name]; PDFReaderTextFont *font = [fonts objectForKey:key];
+
+	if ((font == nil) && (fontsDictionary != NULL)) // Load the font resource once per page
+	{
+		CGPDFDictionaryRef fontDictionary = NULL;
+
+		if (CGPDFDictionaryGetDictionary(fontsDictionary, name, &fontDictionary))
+		{
+			font = [PDFReaderTextFont fontWithDictionary:fontDictionary]; [fonts setObject:font forKey:key];
+		}
+	}
+
+	return font;
+}
+
+- (void)scanForm:(CGPDFStreamRef)stream parent:(CGPDFContentStreamRef)parent
+{
+	CGPDFDictionaryRef form = CGPDFStreamGetDictionary(stream); const char *subtype = NULL;
+
+	if ((CGPDFDictionaryGetName(form, "Subtype", &subtype) == false) || (strcmp(subtype, "Form") != 0)) return; // Images have no text
+
+	if ((formDepth >= FORM_DEPTH) || (depth >= (STATE_DEPTH - 1))) return; // Too deeply nested (or a cycle)
+
+	CGPDFDictionaryRef savedFonts = fontsDictionary; CGPDFDictionaryRef savedXObjects = xobjectsDictionary; NSMutableDictionary *savedCache = fonts;
+
+	CGAffineTransform savedText = textMatrix; CGAffineTransform savedLine = lineMatrix; NSInteger savedDepth = depth; NSInteger savedBase = baseDepth;
+
+	CGPDFDictionaryRef resources = NULL; // Without its own resources a form uses the page's
+
+	if (CGPDFDictionaryGetDictionary(form, "Resources", &resources))
+	{
+		fontsDictionary = NULL; CGPDFDictionaryGetDictionary(resources, "Font", &fontsDictionary);
+
+		xobjectsDictionary = NULL; CGPDFDictionaryGetDictionary(resources, "XObject", &xobjectsDictionary);
+
+		fonts = [NSMutableDictionary new]; // Font names are per resource dictionary
+	}
+
+	states[depth + 1] = states[depth]; depth++; baseDepth = depth; formDepth++; // Implicit q
+
+	CGPDFArrayRef matrix = NULL; CGPDFReal m[6]; // Form space to user space
+
+	if (CGPDFDictionaryGetArray(form, "Matrix", &matrix) && (CGPDFArrayGetCount(matrix) == 6))
+	{
+		BOOL valid = YES; for (size_t index = 0; index < 6; index++) if (CGPDFArrayGetNumber(matrix, index, &m[index]) == false) valid = NO;
+
+		PDFReaderTextState *state = TextCurrentState(self); // Form state
+
+		if (valid == YES) state->ctm = CGAffineTransformConcat(CGAffineTransformMake(m[0], m[1], m[2], m[3], m[4], m[5]), state->ctm);
+	}
+
+	CGPDFContentStreamRef contentStream = CGPDFContentStreamCreateWithStream(stream, resources, parent);
+
+	CGPDFScannerRef scanner = CGPDFScannerCreate(contentStream, [PDFReaderTextScanner operatorTable], (__bridge void *)self);
+
+	CGPDFScannerScan(scanner); CGPDFScannerRelease(scanner); CGPDFContentStreamRelease(contentStream);
+
+	fontsDictionary = savedFonts; xobjectsDictionary = savedXObjects; fonts = savedCache; // Implicit Q
+
+	textMatrix = savedText; lineMatrix = savedLine; depth = savedDepth; baseDepth = savedBase; formDepth--;
+}
+
+- (void)finishWord
+{
+	if (word.length > 0) // Record the word and its bounds
+	{
+		float box[4] = { wordRect.origin.x, wordRect.origin.y, wordRect.size.width, wordRect.size.height };
+
+		[words addObject:[word lowercaseString]]; [rects appendBytes:box length:sizeof(box)];
+	}
+
+	[word setString:@""]; wordRect = CGRectNull;
+}
+
+- (NSData *)segment
+{
+	NSMutableDictionary *postings = [NSMutableDictionary dictionary]; uint32_t position = 0; // Word -> positions
+
+	for (NSString *term in words) // Positions are ascending per word
+	{
+		NSMutableData *positions = [postings objectForKey:term];
+
+		if (positions == nil) { positions = [NSMutableData data]; [postings setObject:positions forKey:term]; }
+
+		[positions appendBytes:&position length:sizeof(position)]; position++;
+	}
+
+	NSMutableData *data = [NSMutableData data]; uint32_t wordCount = (uint32_t)words.count; uint32_t termCount = (uint32_t)postings.count;
+
+	[data appendBytes:&wordCount length:sizeof(wordCount)]; [data appendData:rects];
+
+	[data appendBytes:&termCount length:sizeof(termCount)];
+
+	[postings enumerateKeysAndObjectsUsingBlock:^(NSString *term, NSData *positions, BOOL *stop)
+	{
+		NSData *bytes = [term dataUsingEncoding:NSUTF8StringEncoding]; uint8_t size = (uint8_t)MIN(bytes.length, UINT8_MAX);
+
+		uint32_t count = (uint32_t)(positions.length / sizeof(uint32_t));
+
+		[data appendBytes:&size length:sizeof(size)]; [data appendBytes:bytes.bytes length:size];
+
+		[data appendBytes:&count length:sizeof(count)]; [data appendData:positions];
+	}];
+
+	return data;
+}
+
+@end
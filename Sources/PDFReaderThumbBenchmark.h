@@ -0,0 +1,40 @@
+//
+//	PDFReaderThumbBenchmark.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ *  `PDFReaderThumbBenchmark` compares thumb fetch latency of the legacy PNG
+ *  files (load, inflate and redraw to decode) against the mapped raw pixels
+ *  of `PDFReaderThumbPack`. Results (p50/p99 in milliseconds) are logged.
+ *
+ *  Only available in DEBUG builds - it is a no-op otherwise. It is run by
+ *  PDFReaderBenchmarkRunAll() with the other benchmarks.
+ */
+@interface PDFReaderThumbBenchmark : NSObject <NSObject>
+
++ (void)runFetchBenchmarkWithCount:(NSUInteger)count size:(CGSize)size;
+
+@end
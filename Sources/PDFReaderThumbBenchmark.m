@@ -0,0 +1,162 @@
+//
+//	PDFReaderThumbBenchmark.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderThumbBenchmark.h"
+#import "PDFReaderThumbCache.h"
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderBenchmark.h"
+
+#import <ImageIO/ImageIO.h>
+
+@implementation PDFReaderThumbBenchmark
+
+#pragma mark Constants
+
+#define BENCHMARK_GUID @"PDFReaderThumbBenchmark"
+
+#pragma mark PDFReaderThumbBenchmark functions
+
+#ifdef DEBUG
+
+static CGImageRef BenchmarkCreateImage(size_t width, size_t height, NSUInteger seed)
+{
+	CGImageRef imageRef = NULL; CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+
+	CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst); // Render format
+
+	CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, rgb, bmi);
+
+	if (context != NULL) // Draw something page-like that does not compress to nothing
+	{
+		CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); CGContextFillRect(context, CGRectMake(0.0f, 0.0f, width, height));
+
+		srandom((unsigned)seed); // Repeatable text-like noise per thumb
+
+		for (size_t line = 4; line < height; line += 6) // Fake lines of text
+		{
+			for (size_t x = 4; x < (width - 4); x += (2 + (random() % 5)))
+			{
+				CGFloat gray = ((random() % 128) / 255.0f); CGContextSetRGBFillColor(context, gray, gray, gray, 1.0f);
+
+				CGContextFillRect(context, CGRectMake(x, line, 1.0f + (random() % 3), 3.0f));
+			}
+		}
+
+		imageRef = CGBitmapContextCreateImage(context); CGContextRelease(context);
+	}
+
+	CGColorSpaceRelease(rgb); return imageRef;
+}
+
+#endif // DEBUG
+
+#pragma mark PDFReaderThumbBenchmark class methods
+
++ (void)runFetchBenchmarkWithCount:(NSUInteger)count size:(CGSize)size
+{
+#ifdef DEBUG
+	CGFloat scale = [[UIScreen mainScreen] scale]; size_t width = (size.width * scale); size_t height = (size.height * scale);
+
+	NSString *packPath = [PDFReaderThumbCache thumbCachePathForGUID:BENCHMARK_GUID]; // Benchmark pack
+
+	NSString *pngPath = [NSTemporaryDirectory() stringByAppendingPathComponent:BENCHMARK_GUID];
+
+	NSFileManager *fileManager = [NSFileManager new]; [PDFReaderThumbPack closePackWithGUID:BENCHMARK_GUID];
+
+	[fileManager removeItemAtPath:packPath error:NULL]; [fileManager removeItemAtPath:pngPath error:NULL];
+
+	[fileManager createDirectoryAtPath:pngPath withIntermediateDirectories:YES attributes:nil error:NULL];
+
+	PDFReaderThumbPack *thumbPack = [PDFReaderThumbPack packWithGUID:BENCHMARK_GUID];
+
+	for (NSUInteger page = 1; page <= count; page++) // Write the same thumbs in both formats
+	{
+		CGImageRef imageRef = BenchmarkCreateImage(width, height, page); if (imageRef == NULL) continue;
+
+		NSURL *fileURL = [NSURL fileURLWithPath:[pngPath stringByAppendingPathComponent:[NSString stringWithFormat:@"%07d.png", (int)page]]];
+
+		CGImageDestinationRef thumbRef = CGImageDestinationCreateWithURL((__bridge CFURLRef)fileURL, (CFStringRef)@"public.png", 1, NULL);
+
+		if (thumbRef != NULL) { CGImageDestinationAddImage(thumbRef, imageRef, NULL); CGImageDestinationFinalize(thumbRef); CFRelease(thumbRef); }
+
+		[thumbPack storeImage:imageRef page:page size:size]; CGImageRelease(imageRef);
+	}
+
+	NSMutableArray *pngSamples = [NSMutableArray arrayWithCapacity:count];
+
+	NSMutableArray *packSamples = [NSMutableArray arrayWithCapacity:count];
+
+	for (NSUInteger page = 1; page <= count; page++) // Legacy path: load, inflate and redraw to decode
+	{
+		@autoreleasepool
+		{
+			CFAbsoluteTime start = CFAbsoluteTimeGetCurrent(); // Start the clock
+
+			NSURL *fileURL = [NSURL fileURLWithPath:[pngPath stringByAppendingPathComponent:[NSString stringWithFormat:@"%07d.png", (int)page]]];
+
+			CGImageSourceRef loadRef = CGImageSourceCreateWithURL((__bridge CFURLRef)fileURL, NULL);
+
+			CGImageRef imageRef = ((loadRef != NULL) ? CGImageSourceCreateImageAtIndex(loadRef, 0, NULL) : NULL);
+
+			if (loadRef != NULL) CFRelease(loadRef); if (imageRef == NULL) continue;
+
+			UIImage *image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+
+			UIGraphicsBeginImageContextWithOptions(image.size, YES, scale); [image drawAtPoint:CGPointZero];
+
+			UIImage *decoded = UIGraphicsGetImageFromCurrentImageContext(); UIGraphicsEndImageContext();
+
+			[pngSamples addObject:[NSNumber numberWithDouble:(CFAbsoluteTimeGetCurrent() - start)]];
+
+			CGImageRelease(imageRef); decoded = nil;
+		}
+	}
+
+	for (NSUInteger page = 1; page <= count; page++) // Pack path: map, wrap and fault in every pixel
+	{
+		@autoreleasepool
+		{
+			CFAbsoluteTime start = CFAbsoluteTimeGetCurrent(); // Start the clock
+
+			CGImageRef imageRef = [thumbPack newImageForPage:page size:size]; if (imageRef == NULL) continue;
+
+			UIImage *image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+
+			CFDataRef pixels = CGDataProviderCopyData(CGImageGetDataProvider(image.CGImage)); // Touches every page (upper bound)
+
+			[packSamples addObject:[NSNumber numberWithDouble:(CFAbsoluteTimeGetCurrent() - start)]];
+
+			if (pixels != NULL) CFRelease(pixels); CGImageRelease(imageRef);
+		}
+	}
+
+	PDFReaderBenchmarkLog(@"PNG fetch + decode", pngSamples); PDFReaderBenchmarkLog(@"Pack fetch (mapped)", packSamples);
+
+	[PDFReaderThumbPack closePackWithGUID:BENCHMARK_GUID]; // Done with the pack
+
+	[fileManager removeItemAtPath:packPath error:NULL]; [fileManager removeItemAtPath:pngPath error:NULL];
+#endif // DEBUG
+}
+
+@end
@@ -25,6 +25,19 @@
 #import <UIKit/UIKit.h>
 
 #import "PDFReaderThumbRequest.h"
+#import "PDFReaderThumbQueue.h"
+
+typedef struct
+{
+	NSUInteger hits; // Requests answered from memory
+	NSUInteger misses; // Requests that queued a fetch
+	NSUInteger coalesced; // Requests that joined an in-flight thumb
+	NSUInteger evictions; // Images dropped to stay within budget
+	NSUInteger entries; // Images resident
+	NSUInteger inFlight; // Thumbs being fetched or rendered
+	NSUInteger bytesResident; // Decoded bytes resident
+	NSUInteger byteBudget; // Current (pressure adjusted) budget
+} PDFReaderThumbCacheStatistics;
 
 @interface PDFReaderThumbCache : NSObject <NSObject>
 
@@ -40,8 +53,22 @@
 
 + (NSString *)thumbCachePathForGUID:(NSString *)guid;
 
++ (void)registerThumbSize:(CGSize)size forGUID:(NSString *)guid;
+
++ (void)unregisterThumbSize:(CGSize)size forGUID:(NSString *)guid;
+
++ (NSArray *)thumbSizesForGUID:(NSString *)guid;
+
 - (id)thumbRequest:(PDFReaderThumbRequest *)request priority:(BOOL)priority;
 
+- (id)thumbRequest:(PDFReaderThumbRequest *)request priorityClass:(PDFReaderThumbPriority)priorityClass;
+
+- (void)cancelRequestForView:(PDFReaderThumbView *)view tag:(NSUInteger)tag;
+
+- (UIImage *)imageForKey:(NSString *)key;
+
+- (UIImage *)bestImageForPage:(NSInteger)page guid:(NSString *)guid;
+
 - (void)setObject:(UIImage *)image forKey:(NSString *)key;
 
 - (void)removeObjectForKey:(NSString *)key;
@@ -50,4 +77,8 @@
 
 - (void)removeAllObjects;
 
+- (PDFReaderThumbCacheStatistics)statistics;
+
+- (void)logStatistics;
+
 @end
@@ -22,19 +22,156 @@
 //	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#import "PDFReaderConfig.h"
 #import "PDFReaderThumbCache.h"
 #import "PDFReaderThumbQueue.h"
 #import "PDFReaderThumbFetch.h"
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderThumbManifest.h"
 #import "PDFReaderThumbView.h"
+#import "PDFReaderTrace.h"
 
-@implementation PDFReaderThumbCache
+#import "PDFReaderCoreHash.h"
+#import "PDFReaderCoreLRU.h"
+
+#import <pthread.h>
+
+#pragma mark Constants
+
+#define STRIPE_COUNT 8
+
+#define PRESSURE_LEVELS 3
+
+#define PRESSURE_RELIEF 60.0
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheEntry class interface
+//
+
+@interface PDFReaderThumbCacheEntry : NSObject <NSObject>
 {
-	NSCache *thumbCache;
+@public // Instance variables
+
+	NSString *key;
+
+	UIImage *image;
+
+	NSUInteger cost;
+
+	uint64_t hash;
 }
 
-#pragma mark Constants
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheWaiter class interface
+//
+
+@interface PDFReaderThumbCacheWaiter : NSObject <NSObject>
+{
+@public // Instance variables
 
-#define CACHE_SIZE 2097152
+	__weak PDFReaderThumbView *view; // Never keeps the view alive
+
+	PDFReaderThumbPriority priorityClass;
+
+	BOOL targeted;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheFuture class interface
+//
+
+@interface PDFReaderThumbCacheFuture : NSObject <NSObject>
+{
+@public // Instance variables
+
+	NSString *key;
+
+	NSNumber *tag;
+
+	NSInteger page;
+
+	NSMutableArray *waiters;
+
+	PDFReaderThumbPriority priorityClass;
+}
+
+- (PDFReaderThumbPriority)addWaiter:(PDFReaderThumbView *)view priorityClass:(PDFReaderThumbPriority)priority;
+
+- (PDFReaderThumbPriority)removeWaiter:(PDFReaderThumbView *)view;
+
+- (BOOL)hasWaiter:(PDFReaderThumbView *)view;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheStripe class interface
+//
+
+@interface PDFReaderThumbCacheStripe : NSObject <NSObject>
+{
+@public // Instance variables
+
+	pthread_mutex_t lock;
+
+	NSMutableDictionary *entries;
+
+	NSMutableDictionary *inFlight;
+
+	NSMutableDictionary *inFlightTags;
+
+	PDFReaderCoreLRURef lru;
+
+	NSUInteger hits;
+
+	NSUInteger misses;
+
+	NSUInteger coalesced;
+
+	NSUInteger evictions;
+}
+
+- (void)touchEntry:(PDFReaderThumbCacheEntry *)entry;
+
+- (void)setImage:(UIImage *)image forKey:(NSString *)key cost:(NSUInteger)cost;
+
+- (void)removeEntryForKey:(NSString *)key;
+
+- (PDFReaderThumbCacheFuture *)removeFutureForKey:(NSString *)key;
+
+- (void)trimToBytes:(NSUInteger)limit;
+
+- (void)removeAllEntries;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCache class implementation
+//
+
+@implementation PDFReaderThumbCache
+{
+	PDFReaderThumbCacheStripe *stripes[STRIPE_COUNT];
+
+	NSUInteger byteBudget;
+
+	NSUInteger pressureLevel;
+
+	CFAbsoluteTime pressureTime;
+}
 
 #pragma mark PDFReaderThumbCache class methods
 
@@ -83,6 +220,10 @@
 
 + (void)removeThumbCacheWithGUID:(NSString *)guid
 {
+	[PDFReaderThumbPack closePackWithGUID:guid]; // Close the pack file first
+
+	[[PDFReaderThumbManifest sharedInstance] removeGUID:guid]; // Forget its thumbs
+
 	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0),
 	^{
 		NSFileManager *fileManager = [NSFileManager new]; // File manager instance
@@ -102,46 +243,77 @@
 	NSDictionary *attributes = [NSDictionary dictionaryWithObject:[NSDate date] forKey:NSFileModificationDate];
 
 	[fileManager setAttributes:attributes ofItemAtPath:cachePath error:NULL]; // New modification date
+
+	[[PDFReaderThumbManifest sharedInstance] touchGUID:guid]; // Document last use
 }
 
 + (void)purgeThumbCachesOlderThan:(NSTimeInterval)age
 {
-	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0),
-	^{
-		NSDate *now = [NSDate date]; // Right about now time
+	[[PDFReaderThumbManifest sharedInstance] purgeDocumentsOlderThan:age]; // No caches directory walk
+}
 
-		NSString *cachesPath = [PDFReaderThumbCache appCachesPath]; // Caches path
++ (NSMutableDictionary *)activeThumbSizes
+{
+	static dispatch_once_t predicate = 0;
 
-		NSFileManager *fileManager = [NSFileManager new]; // File manager instance
+	static NSMutableDictionary *sizes = nil; // Counted thumb sizes by GUID
 
-		NSArray *cachesList = [fileManager contentsOfDirectoryAtPath:cachesPath error:NULL];
+	dispatch_once(&predicate, ^{ sizes = [NSMutableDictionary new]; });
 
-		if (cachesList != nil) // Process caches directory contents
-		{
-			for (NSString *cacheName in cachesList) // Enumerate directory contents
-			{
-				if (cacheName.length == 36) // This is a very hacky cache ident kludge
-				{
-					NSString *cachePath = [cachesPath stringByAppendingPathComponent:cacheName];
+	return sizes;
+}
 
-					NSDictionary *attributes = [fileManager attributesOfItemAtPath:cachePath error:NULL];
++ (void)registerThumbSize:(CGSize)size forGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Must have a document GUID
 
-					NSDate *cacheDate = [attributes objectForKey:NSFileModificationDate]; // Cache date
+	NSMutableDictionary *sizes = [PDFReaderThumbCache activeThumbSizes];
 
-					NSTimeInterval seconds = [now timeIntervalSinceDate:cacheDate]; // Cache age
+	@synchronized(sizes) // Mutex lock
+	{
+		NSCountedSet *guidSizes = [sizes objectForKey:guid];
 
-					if (seconds > age) // Older than so remove the thumb cache
-					{
-						[fileManager removeItemAtPath:cachePath error:NULL];
+		if (guidSizes == nil) { guidSizes = [NSCountedSet new]; [sizes setObject:guidSizes forKey:guid]; }
 
-						#ifdef DEBUG
-							NSLog(@"%s purged %@", __FUNCTION__, cacheName);
-						#endif
-					}
-				}
-			}
-		}
-	});
+		[guidSizes addObject:[NSValue valueWithCGSize:size]]; // Thumb size is now on screen
+	}
+}
+
++ (void)unregisterThumbSize:(CGSize)size forGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	NSMutableDictionary *sizes = [PDFReaderThumbCache activeThumbSizes];
+
+	@synchronized(sizes) // Mutex lock
+	{
+		NSCountedSet *guidSizes = [sizes objectForKey:guid];
+
+		[guidSizes removeObject:[NSValue valueWithCGSize:size]]; // Thumb size is gone
+
+		if (guidSizes.count == 0) [sizes removeObjectForKey:guid];
+	}
+}
+
++ (NSArray *)thumbSizesForGUID:(NSString *)guid
+{
+	if (guid == nil) return [NSArray array]; // Must have a document GUID
+
+	NSMutableDictionary *sizes = [PDFReaderThumbCache activeThumbSizes];
+
+	@synchronized(sizes) // Mutex lock
+	{
+		NSArray *guidSizes = [[sizes objectForKey:guid] allObjects]; // Active sizes
+
+		return [guidSizes sortedArrayUsingComparator:^NSComparisonResult(NSValue *value1, NSValue *value2)
+		{
+			CGSize size1 = [value1 CGSizeValue]; CGSize size2 = [value2 CGSizeValue]; // Largest first
+
+			CGFloat area1 = (size1.width * size1.height); CGFloat area2 = (size2.width * size2.height);
+
+			return ((area1 > area2) ? NSOrderedAscending : ((area1 < area2) ? NSOrderedDescending : NSOrderedSame));
+		}];
+	}
 }
 
 #pragma mark PDFReaderThumbCache instance methods
@@ -150,78 +322,522 @@
 {
 	if ((self = [super init])) // Initialize
 	{
-		thumbCache = [NSCache new]; // Cache
+		for (NSInteger index = 0; index < STRIPE_COUNT; index++) stripes[index] = [PDFReaderThumbCacheStripe new];
 
-		[thumbCache setName:@"PDFReaderThumbCache"];
+		byteBudget = [PDFReaderConfig sharedConfig].thumbCacheSize; // Byte budget
 
-		[thumbCache setTotalCostLimit:CACHE_SIZE];
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveMemoryWarning:)
+			name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 	}
 
 	return self;
 }
 
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (PDFReaderThumbCacheStripe *)stripeForKey:(NSString *)key
+{
+	return stripes[([key hash] % STRIPE_COUNT)];
+}
+
+- (NSUInteger)stripeBudget
+{
+	@synchronized(self) // Mutex lock
+	{
+		if ((pressureLevel > 0) && ((CFAbsoluteTimeGetCurrent() - pressureTime) > PRESSURE_RELIEF))
+		{
+			pressureLevel--; pressureTime = CFAbsoluteTimeGetCurrent(); // Grow back one step
+		}
+
+		return ((byteBudget >> pressureLevel) / STRIPE_COUNT);
+	}
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification
+{
+	@synchronized(self) // Mutex lock
+	{
+		if (pressureLevel < PRESSURE_LEVELS) pressureLevel++; // Halve the budget
+
+		pressureTime = CFAbsoluteTimeGetCurrent();
+	}
+
+	NSUInteger limit = [self stripeBudget]; // New stripe budget
+
+	for (NSInteger index = 0; index < STRIPE_COUNT; index++) // Shrink each stripe
+	{
+		PDFReaderThumbCacheStripe *stripe = stripes[index];
+
+		pthread_mutex_lock(&stripe->lock); [stripe trimToBytes:limit]; pthread_mutex_unlock(&stripe->lock);
+	}
+}
+
 - (id)thumbRequest:(PDFReaderThumbRequest *)request priority:(BOOL)priority
 {
-	@synchronized(thumbCache) // Mutex lock
+	PDFReaderThumbPriority priorityClass = (priority ? PDFReaderThumbPriorityVisible : PDFReaderThumbPriorityPagebarSmall);
+
+	return [self thumbRequest:request priorityClass:priorityClass];
+}
+
+- (id)thumbRequest:(PDFReaderThumbRequest *)request priorityClass:(PDFReaderThumbPriority)priorityClass
+{
+	NSString *cacheKey = request.cacheKey; PDFReaderThumbCacheStripe *stripe = [self stripeForKey:cacheKey];
+
+	id object = nil; BOOL promote = NO; BOOL fetch = NO; // Request outcome
+
+	pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+	PDFReaderThumbCacheEntry *entry = [stripe->entries objectForKey:cacheKey];
+
+	PDFReaderThumbCacheFuture *future = ((entry == nil) ? [stripe->inFlight objectForKey:cacheKey] : nil);
+
+	if (entry != nil) // Cache hit - move the image to the front of the LRU list
+	{
+		[stripe touchEntry:entry]; object = entry->image; stripe->hits++;
+	}
+	else if (future != nil) // Already being fetched or rendered - wait for the same result
+	{
+		PDFReaderThumbPriority current = future->priorityClass; // Before this waiter
+
+		promote = ([future addWaiter:request.thumbView priorityClass:priorityClass] < current);
+
+		priorityClass = future->priorityClass; object = [NSNull null]; stripe->coalesced++;
+	}
+	else // Cache miss - mark it in-flight and queue a fetch
 	{
-		id object = [thumbCache objectForKey:request.cacheKey];
+		future = [PDFReaderThumbCacheFuture new]; future->key = cacheKey; future->page = request.thumbPage;
+
+		future->tag = [NSNumber numberWithUnsignedInteger:request.targetTag]; [future addWaiter:request.thumbView priorityClass:priorityClass];
 
-		if (object == nil) // Thumb object does not yet exist in the cache
+		[stripe->inFlight setObject:future forKey:cacheKey]; // Keyed by the cache key
+
+		if ([stripe->inFlightTags objectForKey:future->tag] == nil) // Never replace a colliding key's future
 		{
-			object = [NSNull null]; // Return an NSNull thumb placeholder object
+			[stripe->inFlightTags setObject:future forKey:future->tag];
+		}
+
+		object = [NSNull null]; stripe->misses++; fetch = YES;
+	}
+
+	pthread_mutex_unlock(&stripe->lock);
 
-			[thumbCache setObject:object forKey:request.cacheKey cost:2]; // Cache the placeholder object
+	if (entry != nil) PDFReaderTraceMark(PDFReaderCoreTraceThumbHit, cacheKey, request.thumbPage, 0.0);
 
-			PDFReaderThumbFetch *thumbFetch = [[PDFReaderThumbFetch alloc] initWithRequest:request]; // Create a thumb fetch operation
+	if (fetch == YES) // Create and queue a thumb fetch operation
+	{
+		PDFReaderTraceMark(PDFReaderCoreTraceThumbMiss, cacheKey, request.thumbPage, 0.0);
 
-			[thumbFetch setQueuePriority:(priority ? NSOperationQueuePriorityNormal : NSOperationQueuePriorityLow)]; // Queue priority
+		PDFReaderThumbFetch *thumbFetch = [[PDFReaderThumbFetch alloc] initWithRequest:request]; // Create a thumb fetch operation
 
-			request.thumbView.operation = thumbFetch; [thumbFetch setThreadPriority:(priority ? 0.55 : 0.35)]; // Thread priority
+		[thumbFetch setPriorityClass:priorityClass]; request.thumbView.operation = thumbFetch; // Queue and thread priority
 
-			[[PDFReaderThumbQueue sharedInstance] addLoadOperation:thumbFetch]; // Queue the operation
+		[[PDFReaderThumbQueue sharedInstance] addLoadOperation:thumbFetch]; // Queue the operation
+	}
+	else if (promote == YES) // Already queued - bump it if it is now more urgent
+	{
+		[[PDFReaderThumbQueue sharedInstance] promoteOperationForKey:cacheKey priority:priorityClass];
+	}
+
+	return object; // NSNull or UIImage
+}
+
+- (void)cancelRequestForView:(PDFReaderThumbView *)view tag:(NSUInteger)tag
+{
+	if (tag == 0) return; // Untagged view
+
+	PDFReaderThumbCacheStripe *stripe = stripes[(tag % STRIPE_COUNT)]; // Target tag is the cache key hash
+
+	NSString *cacheKey = nil; BOOL demote = NO; BOOL cancel = NO; // Request outcome
+
+	PDFReaderThumbPriority priorityClass = PDFReaderThumbPriorityPrewarm;
+
+	pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+	NSNumber *tagKey = [NSNumber numberWithUnsignedInteger:tag]; // Tag lookup
+
+	PDFReaderThumbCacheFuture *future = [stripe->inFlightTags objectForKey:tagKey];
+
+	if ((future != nil) && ([future hasWaiter:view] == NO)) // Tag held by another key with the same hash
+	{
+		future = nil; // Find the view's own future - colliding keys share this stripe
+
+		for (PDFReaderThumbCacheFuture *other in [stripe->inFlight objectEnumerator])
+		{
+			if ([other->tag isEqualToNumber:tagKey] && [other hasWaiter:view]) { future = other; break; }
 		}
+	}
+
+	if (future != nil) // Stop waiting - and only cancel the work when nobody else is
+	{
+		PDFReaderThumbPriority current = future->priorityClass; // Before this waiter left
+
+		priorityClass = [future removeWaiter:view]; cacheKey = future->key;
 
-		return object; // NSNull or UIImage
+		if (future->waiters.count == 0) { [stripe removeFutureForKey:cacheKey]; cancel = YES; }
+
+		demote = ((cancel == NO) && (priorityClass > current));
+	}
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	if (cancel == YES) // Last waiter gone - cancel the fetch or render for this key only
+	{
+		[[PDFReaderThumbQueue sharedInstance] cancelOperationForKey:cacheKey];
+	}
+	else if (demote == YES) // Remaining waiters are less urgent
+	{
+		[[PDFReaderThumbQueue sharedInstance] demoteOperationForKey:cacheKey priority:priorityClass];
 	}
 }
 
-- (void)setObject:(UIImage *)image forKey:(NSString *)key
+- (void)deliverImage:(UIImage *)image future:(PDFReaderThumbCacheFuture *)future
+{
+	NSArray *waiters = future->waiters; NSUInteger targetTag = [future->tag unsignedIntegerValue];
+
+	NSString *cacheKey = future->key; NSInteger page = future->page; // Trace point
+
+	uint64_t dispatched = PDFReaderTraceBegin(PDFReaderCoreTraceDisplay, cacheKey, page);
+
+	dispatch_async(dispatch_get_main_queue(), // Queue image show on main thread
+	^{
+		for (PDFReaderThumbCacheWaiter *waiter in waiters) // Show it in every thumb view still waiting for it
+		{
+			PDFReaderThumbView *thumbView = waiter->view; // Target thumb view
+
+			if ((thumbView != nil) && (thumbView.targetTag == targetTag)) [thumbView showImage:image];
+		}
+
+		PDFReaderTraceEnd(PDFReaderCoreTraceDisplay, cacheKey, page, dispatched, 0);
+	});
+}
+
+- (UIImage *)imageForKey:(NSString *)key
+{
+	PDFReaderThumbCacheStripe *stripe = [self stripeForKey:key]; UIImage *image = nil;
+
+	pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+	PDFReaderThumbCacheEntry *entry = [stripe->entries objectForKey:key];
+
+	if (entry != nil) { [stripe touchEntry:entry]; image = entry->image; }
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	return image;
+}
+
+- (UIImage *)bestImageForPage:(NSInteger)page guid:(NSString *)guid
 {
-	@synchronized(thumbCache) // Mutex lock
+	for (NSValue *value in [PDFReaderThumbCache thumbSizesForGUID:guid]) // Largest active size first
 	{
-		NSUInteger bytes = (image.size.width * image.size.height * 4.0f);
+		NSString *key = [PDFReaderThumbRequest cacheKeyForPage:page size:[value CGSizeValue] guid:guid];
+
+		UIImage *image = [self imageForKey:key]; // Resident thumb
 
-		[thumbCache setObject:image forKey:key cost:bytes]; // Cache image
+		if ([image isKindOfClass:[UIImage class]]) return image;
 	}
+
+	return nil;
+}
+
+- (void)setObject:(UIImage *)image forKey:(NSString *)key
+{
+	if ((image == nil) || (key == nil)) return; // Nothing to cache
+
+	CGImageRef imageRef = image.CGImage; // Charge the real pixel buffer size
+
+	NSUInteger cost = ((imageRef != NULL) ? (CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef)) : 0);
+
+	PDFReaderThumbCacheStripe *stripe = [self stripeForKey:key]; NSUInteger limit = [self stripeBudget];
+
+	pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+	PDFReaderThumbCacheFuture *future = [stripe removeFutureForKey:key]; // No longer in-flight
+
+	[stripe setImage:image forKey:key cost:cost]; [stripe trimToBytes:limit];
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	if (future != nil) [self deliverImage:image future:future]; // To all waiters
 }
 
 - (void)removeObjectForKey:(NSString *)key
 {
-	@synchronized(thumbCache) // Mutex lock
+	PDFReaderThumbCacheStripe *stripe = [self stripeForKey:key];
+
+	pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+	[stripe removeFutureForKey:key]; [stripe removeEntryForKey:key];
+
+	pthread_mutex_unlock(&stripe->lock);
+}
+
+- (void)removeNullForKey:(NSString *)key
+{
+	PDFReaderThumbCacheStripe *stripe = [self stripeForKey:key];
+
+	pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+	[stripe removeFutureForKey:key]; // Cached images stay
+
+	pthread_mutex_unlock(&stripe->lock);
+}
+
+- (void)removeAllObjects
+{
+	for (NSInteger index = 0; index < STRIPE_COUNT; index++)
 	{
-		[thumbCache removeObjectForKey:key];
+		PDFReaderThumbCacheStripe *stripe = stripes[index];
+
+		pthread_mutex_lock(&stripe->lock); [stripe removeAllEntries]; pthread_mutex_unlock(&stripe->lock);
 	}
 }
 
-- (void)removeNullForKey:(NSString *)key
+- (PDFReaderThumbCacheStatistics)statistics
 {
-	@synchronized(thumbCache) // Mutex lock
+	PDFReaderThumbCacheStatistics statistics; memset(&statistics, 0x00, sizeof(statistics));
+
+	statistics.byteBudget = ([self stripeBudget] * STRIPE_COUNT); // Pressure adjusted budget
+
+	for (NSInteger index = 0; index < STRIPE_COUNT; index++)
 	{
-		id object = [thumbCache objectForKey:key];
+		PDFReaderThumbCacheStripe *stripe = stripes[index];
+
+		pthread_mutex_lock(&stripe->lock); // Stripe lock
+
+		statistics.hits += stripe->hits; statistics.misses += stripe->misses; statistics.coalesced += stripe->coalesced; statistics.evictions += stripe->evictions;
+
+		statistics.entries += stripe->entries.count; statistics.inFlight += stripe->inFlight.count; statistics.bytesResident += PDFReaderCoreLRUBytes(stripe->lru);
+
+		pthread_mutex_unlock(&stripe->lock);
+	}
+
+	return statistics;
+}
+
+- (void)logStatistics
+{
+#ifdef DEBUG
+	PDFReaderThumbCacheStatistics statistics = [self statistics];
+
+	NSLog(@"%s hits %u, misses %u, coalesced %u, evictions %u, entries %u, in-flight %u, bytes %u of %u", __FUNCTION__,
+		(unsigned)statistics.hits, (unsigned)statistics.misses, (unsigned)statistics.coalesced, (unsigned)statistics.evictions, (unsigned)statistics.entries,
+		(unsigned)statistics.inFlight, (unsigned)statistics.bytesResident, (unsigned)statistics.byteBudget);
+#endif
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheEntry class implementation
+//
 
-		if ([object isMemberOfClass:[NSNull class]])
+@implementation PDFReaderThumbCacheEntry
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheWaiter class implementation
+//
+
+@implementation PDFReaderThumbCacheWaiter
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheFuture class implementation
+//
+
+@implementation PDFReaderThumbCacheFuture
+
+#pragma mark PDFReaderThumbCacheFuture instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize
+	{
+		waiters = [NSMutableArray new]; priorityClass = PDFReaderThumbPriorityPrewarm;
+	}
+
+	return self;
+}
+
+- (void)updatePriorityClass
+{
+	priorityClass = PDFReaderThumbPriorityPrewarm; // Least urgent
+
+	for (NSInteger index = (waiters.count - 1); index >= 0; index--) // Most urgent waiter wins
+	{
+		PDFReaderThumbCacheWaiter *waiter = [waiters objectAtIndex:index];
+
+		if ((waiter->targeted == YES) && (waiter->view == nil)) // View was freed while waiting
 		{
-			[thumbCache removeObjectForKey:key];
+			[waiters removeObjectAtIndex:index]; continue;
 		}
+
+		if (waiter->priorityClass < priorityClass) priorityClass = waiter->priorityClass;
 	}
 }
 
-- (void)removeAllObjects
+- (PDFReaderThumbPriority)addWaiter:(PDFReaderThumbView *)view priorityClass:(PDFReaderThumbPriority)priority
+{
+	PDFReaderThumbCacheWaiter *waiter = nil; // Existing waiter for the view
+
+	if (view != nil) // Views without a target (pre-warm) always add a waiter
+	{
+		for (PDFReaderThumbCacheWaiter *other in waiters) if (other->view == view) { waiter = other; break; }
+	}
+
+	if (waiter == nil) // Add a new waiter
+	{
+		waiter = [PDFReaderThumbCacheWaiter new]; waiter->view = view; waiter->priorityClass = priority;
+
+		waiter->targeted = (view != nil); // Pre-warm waiters have no view to lose
+
+		[waiters addObject:waiter];
+	}
+	else if (priority < waiter->priorityClass) // Same view asked again more urgently
+	{
+		waiter->priorityClass = priority;
+	}
+
+	[self updatePriorityClass]; return priorityClass;
+}
+
+- (PDFReaderThumbPriority)removeWaiter:(PDFReaderThumbView *)view
+{
+	for (NSInteger index = (waiters.count - 1); index >= 0; index--) // Remove the view's waiter
+	{
+		PDFReaderThumbCacheWaiter *waiter = [waiters objectAtIndex:index];
+
+		if (waiter->view == view) [waiters removeObjectAtIndex:index];
+	}
+
+	[self updatePriorityClass]; return priorityClass;
+}
+
+- (BOOL)hasWaiter:(PDFReaderThumbView *)view
+{
+	for (PDFReaderThumbCacheWaiter *waiter in waiters) if (waiter->view == view) return YES;
+
+	return NO;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbCacheStripe class implementation
+//
+
+@implementation PDFReaderThumbCacheStripe
+
+#pragma mark PDFReaderThumbCacheStripe functions
+
+static void StripeEvictEntry(uint64_t hash, size_t cost, void *value, void *context)
+{
+	PDFReaderThumbCacheStripe *stripe = (__bridge PDFReaderThumbCacheStripe *)context; // Owning stripe
+
+	PDFReaderThumbCacheEntry *entry = (__bridge PDFReaderThumbCacheEntry *)value; // Retained by entries
+
+	[stripe->entries removeObjectForKey:entry->key]; stripe->evictions++;
+}
+
+#pragma mark PDFReaderThumbCacheStripe instance methods
+
+- (id)init
 {
-	@synchronized(thumbCache) // Mutex lock
+	if ((self = [super init])) // Initialize
 	{
-		[thumbCache removeAllObjects];
+		pthread_mutex_init(&lock, NULL); // Stripe lock
+
+		entries = [NSMutableDictionary new]; inFlight = [NSMutableDictionary new]; inFlightTags = [NSMutableDictionary new];
+
+		lru = PDFReaderCoreLRUCreate(0); // Byte budget LRU list
 	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	PDFReaderCoreLRUDestroy(lru);
+
+	pthread_mutex_destroy(&lock);
+}
+
+- (void)touchEntry:(PDFReaderThumbCacheEntry *)entry
+{
+	PDFReaderCoreLRUTouch(lru, entry->hash); // Most recently used
+}
+
+- (void)setImage:(UIImage *)image forKey:(NSString *)key cost:(NSUInteger)cost
+{
+	PDFReaderThumbCacheEntry *entry = [entries objectForKey:key];
+
+	if (entry == nil) // Add a new entry
+	{
+		entry = [PDFReaderThumbCacheEntry new]; entry->key = [key copy];
+
+		entry->hash = PDFReaderCoreHashString([entry->key UTF8String]); // LRU key
+
+		PDFReaderThumbCacheEntry *other = (__bridge PDFReaderThumbCacheEntry *)PDFReaderCoreLRUPeek(lru, entry->hash);
+
+		if (other != nil) [self removeEntryForKey:other->key]; // Hash collision - the new key wins
+
+		[entries setObject:entry forKey:entry->key];
+	}
+
+	entry->image = image; entry->cost = cost; // Replaces the image of an existing entry
+
+	if (PDFReaderCoreLRUSet(lru, entry->hash, cost, (__bridge void *)entry) == 0) [entries removeObjectForKey:key];
+}
+
+- (void)removeEntryForKey:(NSString *)key
+{
+	PDFReaderThumbCacheEntry *entry = [entries objectForKey:key];
+
+	if (entry != nil) // Unlink it before the dictionary releases it
+	{
+		PDFReaderCoreLRURemove(lru, entry->hash); [entries removeObjectForKey:key];
+	}
+}
+
+- (PDFReaderThumbCacheFuture *)removeFutureForKey:(NSString *)key
+{
+	PDFReaderThumbCacheFuture *future = [inFlight objectForKey:key];
+
+	if (future != nil) // Unlink it from both indexes
+	{
+		if ([inFlightTags objectForKey:future->tag] == future) [inFlightTags removeObjectForKey:future->tag];
+
+		[inFlight removeObjectForKey:key];
+	}
+
+	return future;
+}
+
+- (void)trimToBytes:(NSUInteger)limit
+{
+	PDFReaderCoreLRUTrim(lru, limit, StripeEvictEntry, (__bridge void *)self); // Evict least recently used images
+}
+
+- (void)removeAllEntries
+{
+	PDFReaderCoreLRURemoveAll(lru); // Entries are released with the dictionary contents
+
+	[entries removeAllObjects]; [inFlight removeAllObjects]; [inFlightTags removeAllObjects];
 }
 
 @end
+
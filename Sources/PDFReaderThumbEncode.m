@@ -0,0 +1,84 @@
+//
+//	PDFReaderThumbEncode.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderThumbEncode.h"
+#import "PDFReaderThumbRequest.h"
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderThumbManifest.h"
+#import "PDFReaderTrace.h"
+
+@implementation PDFReaderThumbEncode
+{
+	NSInteger thumbPage;
+
+	CGSize thumbSize;
+
+	CGImageRef thumbImage;
+}
+
+#pragma mark PDFReaderThumbEncode instance methods
+
+- (id)initWithRequest:(PDFReaderThumbRequest *)options image:(CGImageRef)imageRef
+{
+	return [self initWithGUID:options.guid page:options.thumbPage size:options.thumbSize image:imageRef];
+}
+
+- (id)initWithGUID:(NSString *)guid page:(NSInteger)page size:(CGSize)size image:(CGImageRef)imageRef
+{
+	if ((self = [super initWithGUID:guid]))
+	{
+		thumbPage = page; thumbSize = size; thumbImage = CGImageRetain(imageRef);
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	CGImageRelease(thumbImage), thumbImage = NULL;
+}
+
+- (void)main
+{
+	if ((self.isCancelled == YES) || (thumbImage == NULL)) return;
+
+	NSString *traceKey = ((PDFReaderCoreTraceIsEnabled() != 0) ? [PDFReaderThumbRequest cacheKeyForPage:thumbPage size:thumbSize guid:self.guid] : nil);
+
+	uint64_t traceStart = PDFReaderTraceBegin(PDFReaderCoreTraceEncode, traceKey, thumbPage); NSUInteger bytes = 0; // Bytes written
+
+	PDFReaderThumbPack *thumbPack = [PDFReaderThumbPack packWithGUID:self.guid]; // Document thumb pack
+
+	if ([thumbPack storeImage:thumbImage page:thumbPage size:thumbSize] == YES) // Append to the pack
+	{
+		bytes = [thumbPack bytesForPage:thumbPage size:thumbSize]; // Aligned size on disk
+
+		[[PDFReaderThumbManifest sharedInstance] recordGUID:self.guid page:thumbPage size:thumbSize bytes:bytes fileBytes:thumbPack.fileBytes];
+	}
+
+	PDFReaderTraceEnd(PDFReaderCoreTraceEncode, traceKey, thumbPage, traceStart, bytes);
+
+	CGImageRelease(thumbImage), thumbImage = NULL; // Done with it
+}
+
+@end
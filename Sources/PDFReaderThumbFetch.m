@@ -26,6 +26,9 @@
 #import "PDFReaderThumbRender.h"
 #import "PDFReaderThumbCache.h"
 #import "PDFReaderThumbView.h"
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderThumbManifest.h"
+#import "PDFReaderTrace.h"
 
 #import <ImageIO/ImageIO.h>
 
@@ -34,13 +37,62 @@
 	PDFReaderThumbRequest *request;
 }
 
+#pragma mark PDFReaderThumbFetch class methods
+
++ (NSMutableDictionary *)legacyThumbCounts
+{
+	static dispatch_once_t predicate = 0;
+
+	static NSMutableDictionary *counts = nil; // Legacy PNG thumb counts by GUID
+
+	dispatch_once(&predicate, ^{ counts = [NSMutableDictionary new]; });
+
+	return counts;
+}
+
++ (BOOL)hasLegacyThumbsForGUID:(NSString *)guid
+{
+	NSMutableDictionary *counts = [PDFReaderThumbFetch legacyThumbCounts];
+
+	@synchronized(counts) // Mutex lock
+	{
+		NSNumber *count = [counts objectForKey:guid];
+
+		if (count == nil) // Scan the thumb cache directory once per document
+		{
+			NSUInteger files = 0; NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:guid];
+
+			for (NSString *file in [[NSFileManager new] contentsOfDirectoryAtPath:cachePath error:NULL])
+			{
+				if ([[file pathExtension] isEqualToString:@"png"] == YES) files++;
+			}
+
+			count = [NSNumber numberWithUnsignedInteger:files]; [counts setObject:count forKey:guid];
+		}
+
+		return ([count unsignedIntegerValue] > 0);
+	}
+}
+
++ (void)migratedLegacyThumbForGUID:(NSString *)guid
+{
+	NSMutableDictionary *counts = [PDFReaderThumbFetch legacyThumbCounts];
+
+	@synchronized(counts) // Mutex lock
+	{
+		NSUInteger files = [[counts objectForKey:guid] unsignedIntegerValue];
+
+		if (files > 0) [counts setObject:[NSNumber numberWithUnsignedInteger:(files - 1)] forKey:guid];
+	}
+}
+
 #pragma mark PDFReaderThumbFetch instance methods
 
 - (id)initWithRequest:(PDFReaderThumbRequest *)options
 {
-	if ((self = [super initWithGUID:options.guid]))
+	if ((self = [super initWithGUID:options.guid key:options.cacheKey]))
 	{
-		request = options;
+		request = options; self.page = options.thumbPage; self.targetTag = options.targetTag; // Registry keys
 	}
 
 	return self;
@@ -68,27 +120,73 @@
 
 - (void)main
 {
-	CGImageRef imageRef = NULL; NSURL *thumbURL = [self thumbFileURL];
+	uint64_t traceStart = PDFReaderTraceBegin(PDFReaderCoreTraceFetch, request.cacheKey, request.thumbPage);
+
+	PDFReaderThumbPack *thumbPack = [PDFReaderThumbPack packWithGUID:request.guid]; // Document thumb pack
+
+	CGImageRef imageRef = [thumbPack newImageForPage:request.thumbPage size:request.thumbSize]; // Mapped pixels
 
-	CGImageSourceRef loadRef = CGImageSourceCreateWithURL((__bridge CFURLRef)thumbURL, NULL);
+	PDFReaderThumbManifest *manifest = [PDFReaderThumbManifest sharedInstance]; // Disk cache bookkeeping
 
-	if (loadRef != NULL) // Load the existing thumb image
+	if (imageRef != NULL) [manifest touchGUID:request.guid page:request.thumbPage size:request.thumbSize];
+
+	if ((imageRef == NULL) && ([PDFReaderThumbFetch hasLegacyThumbsForGUID:request.guid] == YES)) // Migrate a legacy PNG thumb file into the pack
 	{
-		imageRef = CGImageSourceCreateImageAtIndex(loadRef, 0, NULL); // Load it
+		NSURL *thumbURL = [self thumbFileURL]; // Legacy thumb file URL
+
+		CGImageSourceRef loadRef = CGImageSourceCreateWithURL((__bridge CFURLRef)thumbURL, NULL);
+
+		if (loadRef != NULL) // Load the existing thumb image
+		{
+			CGImageRef legacyRef = CGImageSourceCreateImageAtIndex(loadRef, 0, NULL); // Load it
+
+			CFRelease(loadRef); // Release CGImageSource reference
+
+			if (legacyRef != NULL) // Decode it once into the pack and use the mapped pixels from now on
+			{
+				if ([thumbPack storeImage:legacyRef page:request.thumbPage size:request.thumbSize] == YES)
+				{
+					NSFileManager *fileManager = [NSFileManager new]; // File manager instance
+
+					NSDictionary *attributes = [fileManager attributesOfItemAtPath:[thumbURL path] error:NULL];
+
+					[fileManager removeItemAtURL:thumbURL error:NULL]; // PNG no longer needed
+
+					[PDFReaderThumbFetch migratedLegacyThumbForGUID:request.guid];
+
+					NSUInteger bytes = [thumbPack bytesForPage:request.thumbPage size:request.thumbSize];
+
+					[manifest recordGUID:request.guid page:request.thumbPage size:request.thumbSize bytes:bytes fileBytes:thumbPack.fileBytes];
+
+					[manifest releaseLegacyBytes:[attributes fileSize] forGUID:request.guid];
+
+					imageRef = [thumbPack newImageForPage:request.thumbPage size:request.thumbSize];
+				}
+
+				if (imageRef == NULL) imageRef = CGImageRetain(legacyRef); // Pack unavailable
 
-		CFRelease(loadRef); // Release CGImageSource reference
+				CGImageRelease(legacyRef);
+			}
+		}
 	}
-	else // Existing thumb image not found - so create and queue up a thumb render operation on the work queue
+
+	PDFReaderTraceEnd(PDFReaderCoreTraceFetch, request.cacheKey, request.thumbPage, traceStart, 0);
+
+	if (imageRef == NULL) // Existing thumb image not found - so create and queue up a thumb render operation on the work queue
 	{
 		PDFReaderThumbRender *thumbRender = [[PDFReaderThumbRender alloc] initWithRequest:request]; // Create a thumb render operation
 
-		[thumbRender setQueuePriority:self.queuePriority]; [thumbRender setThreadPriority:(self.threadPriority - 0.1)]; // Priority
+		[thumbRender setPriorityClass:self.priorityClass]; // Inherit the (possibly promoted) priority class
 
 		if (self.isCancelled == NO) // We're not cancelled - so update things and add the render operation to the work queue
 		{
 			request.thumbView.operation = thumbRender; // Update the thumb view operation property to the new operation
 
-			[[PDFReaderThumbQueue sharedInstance] addWorkOperation:thumbRender]; return; // Queue the operation
+			[[PDFReaderThumbQueue sharedInstance] addWorkOperation:thumbRender]; // Queue the operation
+
+			if (self.isCancelled == YES) [thumbRender cancel]; // Cancelled during the hand-off
+
+			return;
 		}
 	}
 
@@ -98,27 +196,7 @@
 
 		CGImageRelease(imageRef); // Release the CGImage reference from the above thumb load code
 
-		UIGraphicsBeginImageContextWithOptions(image.size, YES, request.scale); // Graphics context
-
-		[image drawAtPoint:CGPointZero]; // Decode and draw the image on this background thread
-
-		UIImage *decoded = UIGraphicsGetImageFromCurrentImageContext(); // Newly decoded image
-
-		UIGraphicsEndImageContext(); // Cleanup after the bitmap-based graphics drawing context
-
-		[[PDFReaderThumbCache sharedInstance] setObject:decoded forKey:request.cacheKey]; // Cache it
-
-		if (self.isCancelled == NO) // Show the image in the target thumb view on the main thread
-		{
-			PDFReaderThumbView *thumbView = request.thumbView; // Target thumb view for image show
-
-			NSUInteger targetTag = request.targetTag; // Target reference tag for image show
-
-			dispatch_async(dispatch_get_main_queue(), // Queue image show on main thread
-			^{
-				if (thumbView.targetTag == targetTag) [thumbView showImage:decoded];
-			});
-		}
+		[[PDFReaderThumbCache sharedInstance] setObject:image forKey:request.cacheKey]; // Cache it and show it to all waiters
 	}
 
 	request.thumbView.operation = nil; // Break retain loop
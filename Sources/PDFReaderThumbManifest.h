@@ -0,0 +1,65 @@
+//
+//	PDFReaderThumbManifest.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ *  `PDFReaderThumbManifest` tracks the on-disk thumb caches of all documents
+ *  in a single binary manifest (`Caches/PDFReaderThumbs.manifest`): the size
+ *  and last use of every document and of every thumb in its pack.
+ *
+ *  When the total exceeds `PDFReaderConfig.thumbDiskCacheSize` the least
+ *  recently used pages (across all documents) are evicted from their packs.
+ *  The rendered page tile packs are sized here too; when they exceed
+ *  `PDFReaderConfig.tileDiskCacheSize` the tile packs of the least recently
+ *  used documents are removed. All bookkeeping runs on a private serial queue.
+ */
+@interface PDFReaderThumbManifest : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) unsigned long long totalBytes;
+@property (nonatomic, assign, readonly) NSUInteger documentCount;
+@property (nonatomic, assign, readonly) NSUInteger evictedPageCount;
+
++ (PDFReaderThumbManifest *)sharedInstance;
+
+- (void)recordGUID:(NSString *)guid page:(NSInteger)page size:(CGSize)size bytes:(NSUInteger)bytes fileBytes:(unsigned long long)fileBytes;
+
+- (void)recordTileBytes:(unsigned long long)fileBytes forGUID:(NSString *)guid;
+
+- (void)touchGUID:(NSString *)guid page:(NSInteger)page size:(CGSize)size;
+
+- (void)touchGUID:(NSString *)guid;
+
+- (void)releaseLegacyBytes:(unsigned long long)bytes forGUID:(NSString *)guid;
+
+- (void)removeGUID:(NSString *)guid;
+
+- (void)purgeDocumentsOlderThan:(NSTimeInterval)age;
+
+- (void)enforceByteCap;
+
+- (void)saveManifest;
+
+@end
@@ -0,0 +1,699 @@
+//
+//	PDFReaderThumbManifest.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderConfig.h"
+#import "PDFReaderThumbManifest.h"
+#import "PDFReaderThumbCache.h"
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderTileCache.h"
+
+#import <UIKit/UIKit.h>
+#import <sys/stat.h>
+
+#pragma mark Constants
+
+#define MANIFEST_MAGIC 0x4D545250
+#define MANIFEST_VERSION 2
+#define MANIFEST_FILE_NAME @"PDFReaderThumbs.manifest"
+#define MANIFEST_SAVE_DELAY 5.0
+#define MANIFEST_LOW_WATER 0.9
+#define MANIFEST_IDLE_PACK 60.0
+
+typedef struct
+{
+	uint32_t magic; uint32_t version; // Manifest identification
+	uint32_t documentCount; uint32_t reserved; // Documents that follow
+} PDFReaderThumbManifestHeader;
+
+typedef struct
+{
+	uint64_t packBytes; uint64_t legacyBytes; // On-disk sizes
+	uint64_t tileBytes; // Tile pack size
+	uint32_t lastUse; uint32_t entryCount; // Entries that follow
+	uint16_t guidLength; uint16_t reserved[3]; // GUID bytes that follow
+} PDFReaderThumbManifestDocumentRecord;
+
+typedef struct
+{
+	uint64_t key; // Page number and thumb size
+	uint32_t bytes; uint32_t lastUse; // Size and last use
+} PDFReaderThumbManifestEntryRecord;
+
+#pragma mark -
+
+//
+//	PDFReaderThumbManifestDocument class interface
+//
+
+@interface PDFReaderThumbManifestDocument : NSObject <NSObject>
+{
+@public // Instance variables
+
+	NSString *guid;
+
+	NSMutableDictionary *entries; // Entry key -> (bytes << 32 | last use)
+
+	uint64_t packBytes;
+
+	uint64_t legacyBytes;
+
+	uint64_t tileBytes;
+
+	uint32_t lastUse;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbManifest class implementation
+//
+
+@implementation PDFReaderThumbManifest
+{
+	dispatch_queue_t manifestQueue;
+
+	NSMutableDictionary *documents;
+
+	NSString *manifestPath;
+
+	BOOL saveScheduled;
+
+	BOOL enforceScheduled;
+
+	NSUInteger _evictedPageCount;
+}
+
+#pragma mark PDFReaderThumbManifest functions
+
+static inline uint32_t ManifestNow(void)
+{
+	return (uint32_t)CFAbsoluteTimeGetCurrent(); // Seconds since the reference date
+}
+
+static inline uint32_t ManifestAge(uint32_t now, uint32_t lastUse)
+{
+	return ((lastUse < now) ? (now - lastUse) : 0); // Clock set back - treat it as just used
+}
+
+static inline uint64_t ManifestKey(NSInteger page, CGSize size)
+{
+	return ((((uint64_t)page) << 32) | (((uint64_t)((uint16_t)size.width)) << 16) | ((uint16_t)size.height));
+}
+
+static inline uint64_t ManifestValue(uint32_t bytes, uint32_t lastUse)
+{
+	return ((((uint64_t)bytes) << 32) | lastUse);
+}
+
+#pragma mark PDFReaderThumbManifest class methods
+
++ (PDFReaderThumbManifest *)sharedInstance
+{
+	static dispatch_once_t predicate = 0;
+
+	static PDFReaderThumbManifest *object = nil; // Object
+
+	dispatch_once(&predicate, ^{ object = [self new]; });
+
+	return object; // PDFReaderThumbManifest singleton
+}
+
+#pragma mark PDFReaderThumbManifest instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize
+	{
+		manifestQueue = dispatch_queue_create("PDFReaderThumbManifestQueue", DISPATCH_QUEUE_SERIAL);
+
+		dispatch_set_target_queue(manifestQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+
+		NSString *cachesPath = [[PDFReaderThumbCache thumbCachePathForGUID:@"."] stringByDeletingLastPathComponent];
+
+		manifestPath = [cachesPath stringByAppendingPathComponent:MANIFEST_FILE_NAME];
+
+		documents = [NSMutableDictionary new]; // Documents by GUID
+
+		dispatch_async(manifestQueue, ^{ [self loadManifest]; });
+
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(saveManifest)
+			name:UIApplicationDidEnterBackgroundNotification object:nil];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (PDFReaderThumbManifestDocument *)documentForGUID:(NSString *)guid create:(BOOL)create
+{
+	PDFReaderThumbManifestDocument *document = [documents objectForKey:guid];
+
+	if ((document == nil) && (create == YES)) // New document
+	{
+		document = [PDFReaderThumbManifestDocument new]; document->guid = [guid copy];
+
+		document->entries = [NSMutableDictionary new]; document->lastUse = ManifestNow();
+
+		[documents setObject:document forKey:document->guid];
+	}
+
+	return document;
+}
+
+- (unsigned long long)currentTotalBytes
+{
+	unsigned long long total = 0; // Sum of all documents
+
+	for (PDFReaderThumbManifestDocument *document in [documents objectEnumerator])
+	{
+		total += (document->packBytes + document->legacyBytes);
+	}
+
+	return total;
+}
+
+- (unsigned long long)currentTileBytes
+{
+	unsigned long long total = 0; // Sum of all tile packs
+
+	for (PDFReaderThumbManifestDocument *document in [documents objectEnumerator]) total += document->tileBytes;
+
+	return total;
+}
+
+- (void)scheduleSave
+{
+	if (saveScheduled == NO) // Coalesce manifest writes
+	{
+		saveScheduled = YES; // Save once after a burst of changes
+
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MANIFEST_SAVE_DELAY * NSEC_PER_SEC)), manifestQueue,
+		^{
+			[self writeManifest];
+		});
+	}
+}
+
+- (void)scheduleEnforce
+{
+	if (enforceScheduled == NO) // Coalesce eviction passes
+	{
+		enforceScheduled = YES; dispatch_async(manifestQueue, ^{ [self evictToByteCap]; });
+	}
+}
+
+#pragma mark PDFReaderThumbManifest file methods
+
+- (void)writeManifest
+{
+	saveScheduled = NO; NSMutableData *data = [NSMutableData data];
+
+	PDFReaderThumbManifestHeader header; memset(&header, 0x00, sizeof(header));
+
+	header.magic = MANIFEST_MAGIC; header.version = MANIFEST_VERSION; header.documentCount = (uint32_t)documents.count;
+
+	[data appendBytes:&header length:sizeof(header)];
+
+	for (PDFReaderThumbManifestDocument *document in [documents objectEnumerator])
+	{
+		NSData *guidData = [document->guid dataUsingEncoding:NSUTF8StringEncoding];
+
+		PDFReaderThumbManifestDocumentRecord record; memset(&record, 0x00, sizeof(record));
+
+		record.packBytes = document->packBytes; record.legacyBytes = document->legacyBytes; record.tileBytes = document->tileBytes; record.lastUse = document->lastUse;
+
+		record.entryCount = (uint32_t)document->entries.count; record.guidLength = (uint16_t)guidData.length;
+
+		[data appendBytes:&record length:sizeof(record)]; [data appendData:guidData];
+
+		[document->entries enumerateKeysAndObjectsUsingBlock:^(NSNumber *key, NSNumber *value, BOOL *stop)
+		{
+			uint64_t packed = [value unsignedLongLongValue]; PDFReaderThumbManifestEntryRecord entry;
+
+			entry.key = [key unsignedLongLongValue]; entry.bytes = (uint32_t)(packed >> 32); entry.lastUse = (uint32_t)packed;
+
+			[data appendBytes:&entry length:sizeof(entry)];
+		}];
+	}
+
+	[data writeToFile:manifestPath atomically:YES]; // Write temporary file and rename
+}
+
+- (BOOL)readManifest
+{
+	NSData *data = [NSData dataWithContentsOfFile:manifestPath options:NSDataReadingMappedIfSafe error:NULL];
+
+	if (data.length < sizeof(PDFReaderThumbManifestHeader)) return NO; // Missing or truncated
+
+	const uint8_t *bytes = data.bytes; const uint8_t *end = (bytes + data.length);
+
+	PDFReaderThumbManifestHeader header; memcpy(&header, bytes, sizeof(header)); bytes += sizeof(header);
+
+	if ((header.magic != MANIFEST_MAGIC) || (header.version != MANIFEST_VERSION)) return NO;
+
+	for (uint32_t index = 0; index < header.documentCount; index++) // Read each document
+	{
+		PDFReaderThumbManifestDocumentRecord record; // Document record
+
+		if ((end - bytes) < (ptrdiff_t)sizeof(record)) return NO; memcpy(&record, bytes, sizeof(record)); bytes += sizeof(record);
+
+		size_t entryBytes = ((size_t)record.entryCount * sizeof(PDFReaderThumbManifestEntryRecord));
+
+		if ((size_t)(end - bytes) < (record.guidLength + entryBytes)) return NO; // Truncated
+
+		NSString *guid = [[NSString alloc] initWithBytes:bytes length:record.guidLength encoding:NSUTF8StringEncoding];
+
+		bytes += record.guidLength; if (guid == nil) return NO; // Invalid GUID
+
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:guid create:YES];
+
+		document->packBytes = record.packBytes; document->legacyBytes = record.legacyBytes; document->tileBytes = record.tileBytes; document->lastUse = record.lastUse;
+
+		for (uint32_t entryIndex = 0; entryIndex < record.entryCount; entryIndex++) // Read each entry
+		{
+			PDFReaderThumbManifestEntryRecord entry; memcpy(&entry, bytes, sizeof(entry)); bytes += sizeof(entry);
+
+			[document->entries setObject:[NSNumber numberWithUnsignedLongLong:ManifestValue(entry.bytes, entry.lastUse)]
+								forKey:[NSNumber numberWithUnsignedLongLong:entry.key]];
+		}
+	}
+
+	return YES;
+}
+
+- (void)reconcileDocument:(PDFReaderThumbManifestDocument *)document
+{
+	PDFReaderThumbPack *thumbPack = [PDFReaderThumbPack packWithGUID:document->guid];
+
+	NSMutableDictionary *entries = [NSMutableDictionary new]; uint32_t lastUse = document->lastUse;
+
+	[thumbPack enumerateEntriesUsingBlock:^(NSInteger page, CGSize size, NSUInteger bytes)
+	{
+		NSNumber *key = [NSNumber numberWithUnsignedLongLong:ManifestKey(page, size)]; // Keep known last use
+
+		NSNumber *known = [document->entries objectForKey:key]; uint32_t used = (known ? (uint32_t)[known unsignedLongLongValue] : lastUse);
+
+		[entries setObject:[NSNumber numberWithUnsignedLongLong:ManifestValue((uint32_t)bytes, used)] forKey:key];
+	}];
+
+	document->entries = entries; document->packBytes = thumbPack.fileBytes;
+}
+
+- (void)rebuildManifest
+{
+	NSFileManager *fileManager = [NSFileManager new]; // File manager instance
+
+	NSString *cachesPath = [manifestPath stringByDeletingLastPathComponent]; // Caches path
+
+	for (NSString *name in [fileManager contentsOfDirectoryAtPath:cachesPath error:NULL])
+	{
+		NSString *cachePath = [cachesPath stringByAppendingPathComponent:name]; // Candidate thumb cache
+
+		NSArray *files = [fileManager contentsOfDirectoryAtPath:cachePath error:NULL]; if (files.count == 0) continue;
+
+		BOOL packed = [fileManager fileExistsAtPath:[PDFReaderThumbPack packPathForGUID:name]];
+
+		NSDictionary *tileAttributes = [fileManager attributesOfItemAtPath:[PDFReaderTileCache tilePackPathForGUID:name] error:NULL];
+
+		unsigned long long legacyBytes = 0; // Old PNG thumb files
+
+		for (NSString *file in files) // Sum up any old PNG thumb files
+		{
+			if ([[file pathExtension] isEqualToString:@"png"] == NO) continue;
+
+			NSDictionary *attributes = [fileManager attributesOfItemAtPath:[cachePath stringByAppendingPathComponent:file] error:NULL];
+
+			legacyBytes += [attributes fileSize];
+		}
+
+		if ((packed == NO) && (legacyBytes == 0) && (tileAttributes == nil)) continue; // Not a thumb cache
+
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:name create:YES];
+
+		NSDate *date = [[fileManager attributesOfItemAtPath:cachePath error:NULL] fileModificationDate];
+
+		document->lastUse = (uint32_t)[date timeIntervalSinceReferenceDate]; document->legacyBytes = legacyBytes;
+
+		document->tileBytes = [tileAttributes fileSize]; // Zero without a tile pack
+
+		if (packed == YES) { [self reconcileDocument:document]; [PDFReaderThumbPack closePackWithGUID:name]; }
+	}
+
+	[self writeManifest];
+}
+
+- (void)loadManifest
+{
+	if ([self readManifest] == NO) // Missing or damaged - walk the caches directory once
+	{
+		[documents removeAllObjects]; [self rebuildManifest]; return;
+	}
+
+	for (PDFReaderThumbManifestDocument *document in [documents allValues]) // Pick up out-of-band changes
+	{
+		struct stat info; const char *tilePath = [[PDFReaderTileCache tilePackPathForGUID:document->guid] fileSystemRepresentation];
+
+		document->tileBytes = ((stat(tilePath, &info) == 0) ? info.st_size : 0); // Tile packs are sized, not scanned
+
+		const char *path = [[PDFReaderThumbPack packPathForGUID:document->guid] fileSystemRepresentation];
+
+		if (stat(path, &info) != 0) // Pack is gone
+		{
+			document->packBytes = 0; [document->entries removeAllObjects];
+
+			if ((document->legacyBytes == 0) && (document->tileBytes == 0)) [documents removeObjectForKey:document->guid];
+		}
+		else if ((uint64_t)info.st_size != document->packBytes) // Pack changed since the last save
+		{
+			[self reconcileDocument:document]; [PDFReaderThumbPack closePackWithGUID:document->guid];
+		}
+	}
+
+	if ([self currentTotalBytes] > [PDFReaderConfig sharedConfig].thumbDiskCacheSize) [self scheduleEnforce];
+
+	[self evictTilesToByteCapExceptGUID:nil];
+}
+
+#pragma mark PDFReaderThumbManifest eviction methods
+
+- (void)evictTilesToByteCapExceptGUID:(NSString *)guid
+{
+	unsigned long long cap = [PDFReaderConfig sharedConfig].tileDiskCacheSize;
+
+	unsigned long long total = [self currentTileBytes]; if ((cap == 0) || (total <= cap)) return;
+
+	unsigned long long target = (cap * MANIFEST_LOW_WATER); // Evict a little extra
+
+	NSMutableArray *victims = [NSMutableArray array]; // Documents with tile packs
+
+	for (PDFReaderThumbManifestDocument *document in [documents objectEnumerator])
+	{
+		if ((document->tileBytes > 0) && ([document->guid isEqualToString:guid] == NO)) [victims addObject:document];
+	}
+
+	[victims sortUsingComparator:^NSComparisonResult(PDFReaderThumbManifestDocument *document1, PDFReaderThumbManifestDocument *document2)
+	{
+		uint32_t use1 = document1->lastUse; uint32_t use2 = document2->lastUse; // Oldest first
+
+		return ((use1 < use2) ? NSOrderedAscending : ((use1 > use2) ? NSOrderedDescending : NSOrderedSame));
+	}];
+
+	for (PDFReaderThumbManifestDocument *document in victims) // Drop whole tile packs of the coldest documents
+	{
+		if (total <= target) break; // Back under the cap
+
+		[[PDFReaderTileCache sharedInstance] removeTilePackWithGUID:document->guid];
+
+		total -= document->tileBytes; document->tileBytes = 0;
+	}
+
+	[self scheduleSave];
+}
+
+- (void)evictToByteCap
+{
+	enforceScheduled = NO; // Allow the next pass to be scheduled
+
+	unsigned long long cap = [PDFReaderConfig sharedConfig].thumbDiskCacheSize;
+
+	unsigned long long total = [self currentTotalBytes]; if (total <= cap) return;
+
+	unsigned long long target = (cap * MANIFEST_LOW_WATER); // Evict a little extra
+
+	NSMutableArray *victims = [NSMutableArray array]; // Pages (and legacy documents) by last use
+
+	for (PDFReaderThumbManifestDocument *document in [documents objectEnumerator])
+	{
+		NSMutableDictionary *pages = [NSMutableDictionary dictionary]; // Page -> [last use, bytes]
+
+		[document->entries enumerateKeysAndObjectsUsingBlock:^(NSNumber *key, NSNumber *value, BOOL *stop)
+		{
+			NSNumber *page = [NSNumber numberWithUnsignedInt:(uint32_t)([key unsignedLongLongValue] >> 32)];
+
+			uint64_t packed = [value unsignedLongLongValue]; NSArray *known = [pages objectForKey:page];
+
+			uint32_t lastUse = (uint32_t)packed; uint64_t bytes = (packed >> 32); // Entry last use and size
+
+			if (known != nil) // Newest use and total bytes of all sizes of the page
+			{
+				lastUse = MAX(lastUse, [[known objectAtIndex:0] unsignedIntValue]); bytes += [[known objectAtIndex:1] unsignedLongLongValue];
+			}
+
+			[pages setObject:[NSArray arrayWithObjects:[NSNumber numberWithUnsignedInt:lastUse], [NSNumber numberWithUnsignedLongLong:bytes], nil] forKey:page];
+		}];
+
+		[pages enumerateKeysAndObjectsUsingBlock:^(NSNumber *page, NSArray *use, BOOL *stop)
+		{
+			[victims addObject:[NSArray arrayWithObjects:[use objectAtIndex:0], document->guid, page, [use objectAtIndex:1], nil]];
+		}];
+
+		if (document->legacyBytes > 0) // Old PNG thumbs go as a whole document (page 0)
+		{
+			[victims addObject:[NSArray arrayWithObjects:[NSNumber numberWithUnsignedInt:document->lastUse], document->guid, [NSNumber numberWithInteger:0], [NSNumber numberWithUnsignedLongLong:document->legacyBytes], nil]];
+		}
+	}
+
+	[victims sortUsingComparator:^NSComparisonResult(NSArray *victim1, NSArray *victim2)
+	{
+		return [[victim1 objectAtIndex:0] compare:[victim2 objectAtIndex:0]]; // Oldest first
+	}];
+
+	NSMutableSet *touched = [NSMutableSet set]; NSFileManager *fileManager = [NSFileManager new];
+
+	for (NSArray *victim in victims) // Evict the coldest pages first
+	{
+		if (total <= target) break; // Back under the cap
+
+		NSString *guid = [victim objectAtIndex:1]; NSInteger page = [[victim objectAtIndex:2] integerValue];
+
+		PDFReaderThumbManifestDocument *document = [documents objectForKey:guid];
+
+		if (page == 0) // Remove old PNG thumb files
+		{
+			NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:guid];
+
+			for (NSString *file in [fileManager contentsOfDirectoryAtPath:cachePath error:NULL])
+			{
+				if ([[file pathExtension] isEqualToString:@"png"]) [fileManager removeItemAtPath:[cachePath stringByAppendingPathComponent:file] error:NULL];
+			}
+
+			total -= document->legacyBytes; document->legacyBytes = 0;
+		}
+		else // Drop every size of the page from the pack
+		{
+			[[PDFReaderThumbPack packWithGUID:guid] removePage:page]; [touched addObject:guid];
+
+			total -= [[victim objectAtIndex:3] unsignedLongLongValue]; _evictedPageCount++;
+
+			for (NSNumber *key in [document->entries allKeys]) // Forget the page entries
+			{
+				if ((NSInteger)([key unsignedLongLongValue] >> 32) == page) [document->entries removeObjectForKey:key];
+			}
+		}
+	}
+
+	uint32_t now = ManifestNow(); // Right about now
+
+	for (NSString *guid in touched) // Reclaim the evicted bytes on disk
+	{
+		PDFReaderThumbPack *thumbPack = [PDFReaderThumbPack packWithGUID:guid]; [thumbPack compact];
+
+		PDFReaderThumbManifestDocument *document = [documents objectForKey:guid]; document->packBytes = thumbPack.fileBytes;
+
+		if (ManifestAge(now, document->lastUse) > MANIFEST_IDLE_PACK) [PDFReaderThumbPack closePackWithGUID:guid];
+	}
+
+	[self scheduleSave];
+}
+
+#pragma mark PDFReaderThumbManifest public methods
+
+- (void)recordGUID:(NSString *)guid page:(NSInteger)page size:(CGSize)size bytes:(NSUInteger)bytes fileBytes:(unsigned long long)fileBytes
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	dispatch_async(manifestQueue,
+	^{
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:guid create:YES];
+
+		uint32_t now = ManifestNow(); document->lastUse = now; document->packBytes = fileBytes;
+
+		[document->entries setObject:[NSNumber numberWithUnsignedLongLong:ManifestValue((uint32_t)bytes, now)]
+							forKey:[NSNumber numberWithUnsignedLongLong:ManifestKey(page, size)]];
+
+		if ([self currentTotalBytes] > [PDFReaderConfig sharedConfig].thumbDiskCacheSize) [self scheduleEnforce];
+
+		[self scheduleSave];
+	});
+}
+
+- (void)recordTileBytes:(unsigned long long)fileBytes forGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	dispatch_async(manifestQueue,
+	^{
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:guid create:YES];
+
+		document->lastUse = ManifestNow(); document->tileBytes = fileBytes;
+
+		[self evictTilesToByteCapExceptGUID:guid]; // The document being read trims its own pack
+
+		[self scheduleSave];
+	});
+}
+
+- (void)touchGUID:(NSString *)guid page:(NSInteger)page size:(CGSize)size
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	dispatch_async(manifestQueue,
+	^{
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:guid create:NO];
+
+		NSNumber *key = [NSNumber numberWithUnsignedLongLong:ManifestKey(page, size)];
+
+		NSNumber *value = [document->entries objectForKey:key]; uint32_t now = ManifestNow();
+
+		if (document != nil) document->lastUse = now; // Document was used
+
+		if (value != nil) // Update the entry last use
+		{
+			uint32_t bytes = (uint32_t)([value unsignedLongLongValue] >> 32);
+
+			[document->entries setObject:[NSNumber numberWithUnsignedLongLong:ManifestValue(bytes, now)] forKey:key];
+
+			[self scheduleSave];
+		}
+	});
+}
+
+- (void)touchGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	dispatch_async(manifestQueue,
+	^{
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:guid create:NO];
+
+		if (document != nil) { document->lastUse = ManifestNow(); [self scheduleSave]; }
+	});
+}
+
+- (void)releaseLegacyBytes:(unsigned long long)bytes forGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	dispatch_async(manifestQueue,
+	^{
+		PDFReaderThumbManifestDocument *document = [self documentForGUID:guid create:NO];
+
+		if (document != nil) document->legacyBytes -= MIN(bytes, document->legacyBytes);
+	});
+}
+
+- (void)removeGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Must have a document GUID
+
+	dispatch_async(manifestQueue,
+	^{
+		[documents removeObjectForKey:guid]; [self scheduleSave];
+	});
+}
+
+- (void)purgeDocumentsOlderThan:(NSTimeInterval)age
+{
+	dispatch_async(manifestQueue,
+	^{
+		uint32_t now = ManifestNow(); // Right about now
+
+		for (PDFReaderThumbManifestDocument *document in [documents allValues])
+		{
+			if (ManifestAge(now, document->lastUse) > age) // Older than so remove the thumb cache
+			{
+				[PDFReaderThumbCache removeThumbCacheWithGUID:document->guid];
+
+				#ifdef DEBUG
+					NSLog(@"%s purged %@", __FUNCTION__, document->guid);
+				#endif
+			}
+		}
+	});
+}
+
+- (void)enforceByteCap
+{
+	dispatch_async(manifestQueue, ^{ [self scheduleEnforce]; });
+}
+
+- (void)saveManifest
+{
+	dispatch_async(manifestQueue, ^{ [self writeManifest]; });
+}
+
+- (unsigned long long)totalBytes
+{
+	__block unsigned long long total = 0;
+
+	dispatch_sync(manifestQueue, ^{ total = [self currentTotalBytes]; });
+
+	return total;
+}
+
+- (NSUInteger)documentCount
+{
+	__block NSUInteger count = 0;
+
+	dispatch_sync(manifestQueue, ^{ count = documents.count; });
+
+	return count;
+}
+
+- (NSUInteger)evictedPageCount
+{
+	__block NSUInteger count = 0;
+
+	dispatch_sync(manifestQueue, ^{ count = _evictedPageCount; });
+
+	return count;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbManifestDocument class implementation
+//
+
+@implementation PDFReaderThumbManifestDocument
+
+@end
@@ -0,0 +1,95 @@
+//
+//	PDFReaderThumbPack.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ *  `PDFReaderThumbPack` stores all of the thumbs of one document in a single
+ *  pack file (`Caches/<GUID>/thumbs.pack`): a header, a fixed-slot hash index
+ *  keyed by page number and requested thumb size, then page-aligned raw
+ *  32-bit BGRX pixel blobs.
+ *
+ *  Other per-document image caches (page tiles) use their own named pack in
+ *  the same directory and add a 32-bit key level to the slot key. Such a pack
+ *  can be stamped with the document file size and modification date:
+ *  `-matchFileSize:fileDate:` empties it when they no longer match.
+ *
+ *  Images are returned straight from a read-only mapping of the pack. Blobs
+ *  are synced to disk before the index slot that points at them is written,
+ *  so an interrupted append only ever loses that one thumb. The last blob is
+ *  padded so that `fileBytes` is always the size of the pack file on disk.
+ *
+ *  `-appendImage:page:size:level:` skips the per-image sync. Its slots are
+ *  committed by the next `-synchronize` (or compaction, or close), so bulk
+ *  writers pay for one sync per batch.
+ */
+@interface PDFReaderThumbPack : NSObject <NSObject>
+
+@property (nonatomic, strong, readonly) NSString *guid;
+@property (nonatomic, strong, readonly) NSString *name;
+@property (nonatomic, assign, readonly) NSUInteger entryCount;
+@property (nonatomic, assign, readonly) unsigned long long liveBytes;
+@property (nonatomic, assign, readonly) unsigned long long deadBytes;
+@property (nonatomic, assign, readonly) unsigned long long fileBytes;
+
++ (PDFReaderThumbPack *)packWithGUID:(NSString *)guid;
+
++ (PDFReaderThumbPack *)packWithGUID:(NSString *)guid name:(NSString *)name;
+
++ (NSString *)packPathForGUID:(NSString *)guid;
+
++ (NSString *)packPathForGUID:(NSString *)guid name:(NSString *)name;
+
++ (void)closePackWithGUID:(NSString *)guid;
+
++ (void)removePackWithGUID:(NSString *)guid name:(NSString *)name;
+
++ (void)closeAllPacks;
+
+- (CGImageRef)newImageForPage:(NSInteger)page size:(CGSize)size CF_RETURNS_RETAINED;
+
+- (CGImageRef)newImageForPage:(NSInteger)page size:(CGSize)size level:(uint32_t)level CF_RETURNS_RETAINED;
+
+- (BOOL)containsPage:(NSInteger)page size:(CGSize)size;
+
+- (NSUInteger)bytesForPage:(NSInteger)page size:(CGSize)size;
+
+- (BOOL)storeImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size;
+
+- (BOOL)storeImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size level:(uint32_t)level;
+
+- (BOOL)appendImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size level:(uint32_t)level;
+
+- (BOOL)synchronize;
+
+- (NSUInteger)removePage:(NSInteger)page;
+
+- (void)enumerateEntriesUsingBlock:(void (^)(NSInteger page, CGSize size, NSUInteger bytes))block;
+
+- (BOOL)matchFileSize:(uint64_t)fileSize fileDate:(double)fileDate;
+
+- (BOOL)compact;
+
+@end
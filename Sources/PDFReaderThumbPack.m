@@ -0,0 +1,872 @@
+//
+//	PDFReaderThumbPack.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderThumbCache.h"
+#import "PDFReaderCacheFile.h"
+
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import <fcntl.h>
+
+#pragma mark Constants
+
+#define PACK_MAGIC 0x50545250
+#define PACK_VERSION 3
+#define PACK_ALIGNMENT 4096
+#define PACK_HEADER_SIZE 4096
+#define PACK_INITIAL_SLOTS 1024
+#define PACK_MAXIMUM_LOAD 0.75
+#define PACK_COMPACT_MINIMUM 1048576
+#define PACK_FILE_NAME @"thumbs.pack"
+
+#define SLOT_LIVE 0x00000001
+
+typedef struct
+{
+	uint32_t magic; uint32_t version; // Pack identification
+	uint32_t slotCount; uint32_t entryCount; // Index geometry
+	uint64_t dataOffset; uint64_t endOffset; // Blob area
+	uint64_t liveBytes; uint64_t deadBytes; // Fragmentation
+	uint64_t fileSize; double fileDate; // Document file identity (zero when not stamped)
+	uint32_t reserved[3]; uint32_t checksum; // Header checksum
+} PDFReaderThumbPackHeader;
+
+typedef struct
+{
+	uint32_t page; uint16_t keyWidth; uint16_t keyHeight; // Slot key
+	uint16_t width; uint16_t height; uint32_t flags; // Image geometry
+	uint64_t offset; uint32_t length; uint32_t bytesPerRow; // Image blob
+	uint32_t keyLevel; uint32_t checksum; // Slot key level (0 == thumb) and checksum (0 == empty)
+} PDFReaderThumbPackSlot;
+
+#pragma mark -
+
+//
+//	PDFReaderThumbPackMapping class interface
+//
+
+@interface PDFReaderThumbPackMapping : NSObject <NSObject>
+
+@property (nonatomic, assign, readonly) const uint8_t *bytes;
+@property (nonatomic, assign, readonly) size_t length;
+
+- (id)initWithFileDescriptor:(int)fd length:(size_t)length;
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbPack class implementation
+//
+
+@implementation PDFReaderThumbPack
+{
+	NSString *_guid;
+
+	NSString *_name;
+
+	NSString *packPath;
+
+	int packFile;
+
+	PDFReaderThumbPackHeader header;
+
+	PDFReaderThumbPackSlot *slots;
+
+	NSUInteger tombstones;
+
+	NSMutableIndexSet *pendingSlots;
+
+	PDFReaderThumbPackMapping *mapping;
+}
+
+#pragma mark Properties
+
+@synthesize guid = _guid;
+@synthesize name = _name;
+
+#pragma mark PDFReaderThumbPack functions
+
+static inline uint64_t PackAlign(uint64_t value)
+{
+	return ((value + (PACK_ALIGNMENT - 1)) & ~((uint64_t)PACK_ALIGNMENT - 1));
+}
+
+static uint32_t PackChecksum(const void *bytes, size_t length)
+{
+	uint32_t hash = PDFReaderCacheFileChecksum(bytes, length); // Core hash
+
+	return ((hash != 0) ? hash : 1); // Zero is reserved for empty slots
+}
+
+static uint32_t PackSlotHash(uint32_t page, uint16_t w, uint16_t h, uint32_t level)
+{
+	uint64_t key = ((((uint64_t)page << 32) | ((uint64_t)w << 16) | h) ^ (level * 0x9e3779b97f4a7c15ULL));
+
+	key ^= (key >> 33); key *= 0xff51afd7ed558ccdULL; key ^= (key >> 33);
+
+	key *= 0xc4ceb9fe1a85ec53ULL; key ^= (key >> 33); return (uint32_t)key;
+}
+
+static NSInteger PackFindSlot(PDFReaderThumbPackSlot *slots, uint32_t slotCount, uint32_t page, uint16_t w, uint16_t h, uint32_t level, BOOL insert)
+{
+	uint32_t hash = PackSlotHash(page, w, h, level); NSInteger tombstone = -1; // First reusable slot
+
+	for (uint32_t probe = 0; probe < slotCount; probe++) // Linear probing
+	{
+		uint32_t index = ((hash + probe) & (slotCount - 1)); PDFReaderThumbPackSlot *slot = &slots[index];
+
+		if (slot->checksum == 0) // Empty slot ends the probe sequence
+		{
+			return (insert ? ((tombstone >= 0) ? tombstone : index) : -1);
+		}
+
+		if (slot->flags & SLOT_LIVE) // Live slot
+		{
+			if ((slot->page == page) && (slot->keyWidth == w) && (slot->keyHeight == h) && (slot->keyLevel == level)) return index;
+		}
+		else if (tombstone < 0) // Removed slot
+		{
+			tombstone = index;
+		}
+	}
+
+	return (insert ? tombstone : -1);
+}
+
+static BOOL PackWrite(int fd, const void *bytes, size_t length, off_t offset)
+{
+	const uint8_t *data = bytes; // Write everything or fail
+
+	while (length > 0) // Handle short writes
+	{
+		ssize_t written = pwrite(fd, data, length, offset);
+
+		if (written < 0) { if (errno == EINTR) continue; return NO; }
+
+		data += written; length -= written; offset += written;
+	}
+
+	return YES;
+}
+
+static BOOL PackRead(int fd, void *bytes, size_t length, off_t offset)
+{
+	uint8_t *data = bytes; // Read everything or fail
+
+	while (length > 0) // Handle short reads
+	{
+		ssize_t count = pread(fd, data, length, offset);
+
+		if (count < 0) { if (errno == EINTR) continue; return NO; }
+
+		if (count == 0) return NO; // Unexpected end of file
+
+		data += count; length -= count; offset += count;
+	}
+
+	return YES;
+}
+
+static void PackSealSlot(PDFReaderThumbPackSlot *slot)
+{
+	slot->checksum = PackChecksum(slot, offsetof(PDFReaderThumbPackSlot, checksum));
+}
+
+static void PackMappingRelease(void *info, const void *data, size_t size)
+{
+	CFBridgingRelease(info); // Balance the mapping retain from -newImageForPage:size:
+}
+
+static CFDataRef PackCopyPixels(CGImageRef imageRef, size_t *bytesPerRow)
+{
+	CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst); // BGRX
+
+	size_t width = CGImageGetWidth(imageRef); size_t height = CGImageGetHeight(imageRef);
+
+	if ((CGImageGetBitsPerPixel(imageRef) == 32) && (CGImageGetBitmapInfo(imageRef) == bmi))
+	{
+		*bytesPerRow = CGImageGetBytesPerRow(imageRef); // Already in pack format
+
+		return CGDataProviderCopyData(CGImageGetDataProvider(imageRef));
+	}
+
+	CFDataRef pixels = NULL; CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+
+	CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, rgb, bmi);
+
+	if (context != NULL) // Convert the image into pack format
+	{
+		CGContextDrawImage(context, CGRectMake(0.0f, 0.0f, width, height), imageRef);
+
+		*bytesPerRow = CGBitmapContextGetBytesPerRow(context); // Row stride
+
+		pixels = CFDataCreate(NULL, CGBitmapContextGetData(context), (*bytesPerRow * height));
+
+		CGContextRelease(context);
+	}
+
+	CGColorSpaceRelease(rgb); return pixels;
+}
+
+#pragma mark PDFReaderThumbPack class methods
+
++ (NSMutableDictionary *)openPacks
+{
+	static dispatch_once_t predicate = 0;
+
+	static NSMutableDictionary *packs = nil; // Open packs by GUID
+
+	dispatch_once(&predicate, ^{ packs = [NSMutableDictionary new]; });
+
+	return packs;
+}
+
++ (PDFReaderThumbPack *)packWithGUID:(NSString *)guid
+{
+	return [PDFReaderThumbPack packWithGUID:guid name:PACK_FILE_NAME];
+}
+
++ (PDFReaderThumbPack *)packWithGUID:(NSString *)guid name:(NSString *)name
+{
+	if ((guid == nil) || (name == nil)) return nil; // Must have a document GUID
+
+	NSMutableDictionary *packs = [PDFReaderThumbPack openPacks];
+
+	NSString *key = [guid stringByAppendingPathComponent:name]; // Open pack key
+
+	@synchronized(packs) // Mutex lock
+	{
+		PDFReaderThumbPack *pack = [packs objectForKey:key];
+
+		if (pack == nil) // Open (or create) the pack file
+		{
+			pack = [[PDFReaderThumbPack alloc] initWithGUID:guid name:name];
+
+			if (pack != nil) [packs setObject:pack forKey:key];
+		}
+
+		return pack;
+	}
+}
+
++ (NSString *)packPathForGUID:(NSString *)guid
+{
+	return [PDFReaderThumbPack packPathForGUID:guid name:PACK_FILE_NAME];
+}
+
++ (NSString *)packPathForGUID:(NSString *)guid name:(NSString *)name
+{
+	NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:guid]; // Thumb cache path
+
+	return [cachePath stringByAppendingPathComponent:name];
+}
+
++ (void)closePackWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to close
+
+	NSMutableDictionary *packs = [PDFReaderThumbPack openPacks];
+
+	@synchronized(packs) // Mutex lock
+	{
+		for (PDFReaderThumbPack *pack in [packs allValues]) // Every pack of the document
+		{
+			if ([pack.guid isEqualToString:guid] == NO) continue;
+
+			[pack close]; [packs removeObjectForKey:[guid stringByAppendingPathComponent:pack.name]];
+		}
+	}
+}
+
++ (void)removePackWithGUID:(NSString *)guid name:(NSString *)name
+{
+	if ((guid == nil) || (name == nil)) return; // Nothing to remove
+
+	NSMutableDictionary *packs = [PDFReaderThumbPack openPacks];
+
+	NSString *key = [guid stringByAppendingPathComponent:name]; // Open pack key
+
+	@synchronized(packs) // Mutex lock
+	{
+		[[packs objectForKey:key] close]; [packs removeObjectForKey:key];
+
+		unlink([[PDFReaderThumbPack packPathForGUID:guid name:name] fileSystemRepresentation]);
+	}
+}
+
++ (void)closeAllPacks
+{
+	NSMutableDictionary *packs = [PDFReaderThumbPack openPacks];
+
+	@synchronized(packs) // Mutex lock
+	{
+		for (PDFReaderThumbPack *pack in [packs allValues]) [pack close];
+
+		[packs removeAllObjects];
+	}
+}
+
+#pragma mark PDFReaderThumbPack instance methods
+
+- (id)initWithGUID:(NSString *)guid name:(NSString *)name
+{
+	if ((self = [super init])) // Initialize
+	{
+		_guid = [guid copy]; _name = [name copy]; packFile = -1; pendingSlots = [NSMutableIndexSet new];
+
+		NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:guid]; // Thumb cache path
+
+		[[NSFileManager new] createDirectoryAtPath:cachePath withIntermediateDirectories:NO attributes:nil error:NULL];
+
+		packPath = [PDFReaderThumbPack packPathForGUID:guid name:name];
+
+		if ([self openPackFile] == NO) self = nil;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self close];
+}
+
+- (void)close
+{
+	@synchronized(self) // Mutex lock
+	{
+		[self synchronize]; // Commit appended blobs
+
+		if (packFile >= 0) close(packFile), packFile = -1;
+
+		if (slots != NULL) free(slots), slots = NULL;
+
+		mapping = nil; // Outstanding images keep their own mapping reference
+	}
+}
+
+- (void)writeHeader
+{
+	header.checksum = PackChecksum(&header, offsetof(PDFReaderThumbPackHeader, checksum));
+
+	PackWrite(packFile, &header, sizeof(header), 0); // Header goes last
+}
+
+- (BOOL)createPackFile
+{
+	if (ftruncate(packFile, 0) != 0) return NO; // Start over
+
+	if (slots != NULL) free(slots), slots = NULL;
+
+	slots = calloc(PACK_INITIAL_SLOTS, sizeof(PDFReaderThumbPackSlot)); if (slots == NULL) return NO;
+
+	memset(&header, 0x00, sizeof(header)); header.magic = PACK_MAGIC; header.version = PACK_VERSION;
+
+	header.slotCount = PACK_INITIAL_SLOTS; tombstones = 0; // Empty index
+
+	header.dataOffset = PackAlign(PACK_HEADER_SIZE + (PACK_INITIAL_SLOTS * sizeof(PDFReaderThumbPackSlot)));
+
+	header.endOffset = header.dataOffset; // No blobs yet
+
+	if (PackWrite(packFile, slots, (PACK_INITIAL_SLOTS * sizeof(PDFReaderThumbPackSlot)), PACK_HEADER_SIZE) == NO) return NO;
+
+	[self writeHeader]; return (fsync(packFile) == 0);
+}
+
+- (BOOL)openPackFile
+{
+	packFile = open([packPath fileSystemRepresentation], (O_RDWR | O_CREAT), 0644);
+
+	if (packFile < 0) return NO; // Unable to open or create the pack
+
+	struct stat info; if (fstat(packFile, &info) != 0) return NO;
+
+	BOOL valid = NO; // Assume that the pack needs to be created
+
+	if ((info.st_size >= PACK_HEADER_SIZE) && PackRead(packFile, &header, sizeof(header), 0))
+	{
+		uint32_t count = header.slotCount; // Must be a power of two
+
+		valid = ((header.magic == PACK_MAGIC) && (header.version == PACK_VERSION) && (count > 0) && ((count & (count - 1)) == 0));
+
+		if (valid == YES) // Load the slot index
+		{
+			slots = calloc(count, sizeof(PDFReaderThumbPackSlot));
+
+			valid = ((slots != NULL) && PackRead(packFile, slots, (count * sizeof(PDFReaderThumbPackSlot)), PACK_HEADER_SIZE));
+		}
+	}
+
+	if (valid == NO) return [self createPackFile];
+
+	[self validateSlotsWithFileSize:info.st_size]; return YES;
+}
+
+- (void)validateSlotsWithFileSize:(uint64_t)fileSize
+{
+	uint32_t entryCount = 0; uint64_t liveBytes = 0; uint64_t endOffset = header.dataOffset; tombstones = 0;
+
+	for (uint32_t index = 0; index < header.slotCount; index++) // Drop torn or dangling slots
+	{
+		PDFReaderThumbPackSlot *slot = &slots[index]; if (slot->checksum == 0) continue;
+
+		BOOL valid = (slot->checksum == PackChecksum(slot, offsetof(PDFReaderThumbPackSlot, checksum)));
+
+		if ((valid == YES) && (slot->flags & SLOT_LIVE)) // Check the blob bounds
+		{
+			valid = ((slot->offset >= header.dataOffset) && ((slot->offset + slot->length) <= fileSize) &&
+						(slot->length >= ((uint64_t)slot->bytesPerRow * slot->height)));
+		}
+
+		if (valid == NO) // Wipe it - the blob was never committed
+		{
+			memset(slot, 0x00, sizeof(PDFReaderThumbPackSlot));
+
+			PackWrite(packFile, slot, sizeof(PDFReaderThumbPackSlot), (PACK_HEADER_SIZE + (index * sizeof(PDFReaderThumbPackSlot))));
+		}
+		else if (slot->flags & SLOT_LIVE) // Live entry
+		{
+			uint64_t blobEnd = PackAlign(slot->offset + slot->length);
+
+			entryCount++; liveBytes += PackAlign(slot->length); if (blobEnd > endOffset) endOffset = blobEnd;
+		}
+		else // Removed entry
+		{
+			tombstones++;
+		}
+	}
+
+	if ((header.entryCount != entryCount) || (header.liveBytes != liveBytes) || (header.endOffset != endOffset) ||
+		(header.checksum != PackChecksum(&header, offsetof(PDFReaderThumbPackHeader, checksum))))
+	{
+		header.entryCount = entryCount; header.liveBytes = liveBytes; header.endOffset = endOffset;
+
+		header.deadBytes = ((endOffset - header.dataOffset) - liveBytes); [self writeHeader]; // Repair
+	}
+
+	if (fileSize != endOffset) ftruncate(packFile, endOffset); // Drop an interrupted append - file size is the end offset
+}
+
+- (PDFReaderThumbPackMapping *)mappingForLength:(uint64_t)length
+{
+	if ((mapping == nil) || (mapping.length < length)) // Map the pack again
+	{
+		struct stat info; mapping = nil; // Replace the current mapping
+
+		if ((packFile >= 0) && (fstat(packFile, &info) == 0) && ((uint64_t)info.st_size >= length))
+		{
+			mapping = [[PDFReaderThumbPackMapping alloc] initWithFileDescriptor:packFile length:info.st_size];
+		}
+	}
+
+	return mapping;
+}
+
+- (NSUInteger)entryCount
+{
+	@synchronized(self) { return header.entryCount; }
+}
+
+- (unsigned long long)liveBytes
+{
+	@synchronized(self) { return header.liveBytes; }
+}
+
+- (unsigned long long)deadBytes
+{
+	@synchronized(self) { return header.deadBytes; }
+}
+
+- (unsigned long long)fileBytes
+{
+	@synchronized(self) { return header.endOffset; }
+}
+
+- (NSUInteger)removePage:(NSInteger)page
+{
+	NSUInteger bytes = 0; // Bytes released
+
+	@synchronized(self) // Mutex lock
+	{
+		if (slots == NULL) return 0; // Closed
+
+		for (uint32_t index = 0; index < header.slotCount; index++) // Every size of the page
+		{
+			PDFReaderThumbPackSlot *slot = &slots[index];
+
+			if ((slot->flags & SLOT_LIVE) && (slot->page == (uint32_t)page))
+			{
+				uint64_t length = PackAlign(slot->length); slot->flags &= ~SLOT_LIVE; PackSealSlot(slot); // Tombstone
+
+				PackWrite(packFile, slot, sizeof(PDFReaderThumbPackSlot), (PACK_HEADER_SIZE + (index * sizeof(PDFReaderThumbPackSlot))));
+
+				header.liveBytes -= length; header.deadBytes += length; header.entryCount--; tombstones++; bytes += length;
+			}
+		}
+
+		if (bytes > 0) [self writeHeader]; // Header is only a hint
+	}
+
+	return bytes;
+}
+
+- (void)enumerateEntriesUsingBlock:(void (^)(NSInteger page, CGSize size, NSUInteger bytes))block
+{
+	NSMutableData *live = [NSMutableData data]; // Copy of the live slots
+
+	@synchronized(self) // Mutex lock
+	{
+		for (uint32_t index = 0; (slots != NULL) && (index < header.slotCount); index++)
+		{
+			if (slots[index].flags & SLOT_LIVE) [live appendBytes:&slots[index] length:sizeof(PDFReaderThumbPackSlot)];
+		}
+	}
+
+	const PDFReaderThumbPackSlot *slot = live.bytes; NSUInteger count = (live.length / sizeof(PDFReaderThumbPackSlot));
+
+	for (NSUInteger index = 0; index < count; index++, slot++) // Call out without holding the lock
+	{
+		block(slot->page, CGSizeMake(slot->keyWidth, slot->keyHeight), (NSUInteger)PackAlign(slot->length));
+	}
+}
+
+- (BOOL)containsPage:(NSInteger)page size:(CGSize)size
+{
+	@synchronized(self) // Mutex lock
+	{
+		if (slots == NULL) return NO; // Closed
+
+		return (PackFindSlot(slots, header.slotCount, (uint32_t)page, (uint16_t)size.width, (uint16_t)size.height, 0, NO) >= 0);
+	}
+}
+
+- (NSUInteger)bytesForPage:(NSInteger)page size:(CGSize)size
+{
+	@synchronized(self) // Mutex lock
+	{
+		if (slots == NULL) return 0; // Closed
+
+		NSInteger index = PackFindSlot(slots, header.slotCount, (uint32_t)page, (uint16_t)size.width, (uint16_t)size.height, 0, NO);
+
+		return ((index < 0) ? 0 : (NSUInteger)PackAlign(slots[index].length)); // Aligned blob size
+	}
+}
+
+- (CGImageRef)newImageForPage:(NSInteger)page size:(CGSize)size
+{
+	return [self newImageForPage:page size:size level:0];
+}
+
+- (CGImageRef)newImageForPage:(NSInteger)page size:(CGSize)size level:(uint32_t)level
+{
+	CGImageRef imageRef = NULL; // Image backed by the pack mapping
+
+	@synchronized(self) // Mutex lock
+	{
+		if (slots == NULL) return NULL; // Closed
+
+		NSInteger index = PackFindSlot(slots, header.slotCount, (uint32_t)page, (uint16_t)size.width, (uint16_t)size.height, level, NO);
+
+		if (index < 0) return NULL; // Not in the pack
+
+		PDFReaderThumbPackSlot slot = slots[index]; // Slot copy
+
+		PDFReaderThumbPackMapping *map = [self mappingForLength:(slot.offset + slot.length)];
+
+		if (map == nil) return NULL; // Unable to map the pack
+
+		const uint8_t *bytes = (map.bytes + slot.offset); // Image pixels
+
+		CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)map, bytes, slot.length, PackMappingRelease);
+
+		if (provider != NULL) // Wrap the mapped pixels without copying them
+		{
+			CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB(); // RGB color space
+
+			CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+
+			imageRef = CGImageCreate(slot.width, slot.height, 8, 32, slot.bytesPerRow, rgb, bmi, provider, NULL, false, kCGRenderingIntentDefault);
+
+			CGColorSpaceRelease(rgb); CGDataProviderRelease(provider);
+		}
+	}
+
+	return imageRef;
+}
+
+- (BOOL)rewriteWithSlotCount:(uint32_t)slotCount
+{
+	if ([self mappingForLength:header.endOffset] == nil) return NO; // Need the old blobs mapped
+
+	NSString *tempPath = [packPath stringByAppendingPathExtension:@"tmp"]; // Temporary pack file
+
+	int tempFile = open([tempPath fileSystemRepresentation], (O_RDWR | O_CREAT | O_TRUNC), 0644);
+
+	if (tempFile < 0) return NO; // Unable to create the new pack
+
+	PDFReaderThumbPackSlot *newSlots = calloc(slotCount, sizeof(PDFReaderThumbPackSlot));
+
+	PDFReaderThumbPackHeader newHeader = header; newHeader.slotCount = slotCount;
+
+	newHeader.dataOffset = PackAlign(PACK_HEADER_SIZE + (slotCount * sizeof(PDFReaderThumbPackSlot)));
+
+	newHeader.entryCount = 0; newHeader.liveBytes = 0; newHeader.deadBytes = 0;
+
+	uint64_t offset = newHeader.dataOffset; BOOL status = (newSlots != NULL); // Copy live blobs
+
+	for (uint32_t index = 0; (status == YES) && (index < header.slotCount); index++)
+	{
+		PDFReaderThumbPackSlot slot = slots[index]; if (!(slot.flags & SLOT_LIVE)) continue;
+
+		status = PackWrite(tempFile, (mapping.bytes + slot.offset), slot.length, offset);
+
+		NSInteger newIndex = PackFindSlot(newSlots, slotCount, slot.page, slot.keyWidth, slot.keyHeight, slot.keyLevel, YES);
+
+		slot.offset = offset; PackSealSlot(&slot); newSlots[newIndex] = slot; // Relocated slot
+
+		offset += PackAlign(slot.length); newHeader.liveBytes += PackAlign(slot.length); newHeader.entryCount++;
+	}
+
+	newHeader.endOffset = offset; newHeader.checksum = PackChecksum(&newHeader, offsetof(PDFReaderThumbPackHeader, checksum));
+
+	if (status == YES) status = PackWrite(tempFile, newSlots, (slotCount * sizeof(PDFReaderThumbPackSlot)), PACK_HEADER_SIZE);
+
+	if (status == YES) status = (ftruncate(tempFile, offset) == 0); // Pad the last blob
+
+	if (status == YES) status = PackWrite(tempFile, &newHeader, sizeof(newHeader), 0);
+
+	if (status == YES) status = ((fsync(tempFile) == 0) && (rename([tempPath fileSystemRepresentation], [packPath fileSystemRepresentation]) == 0));
+
+	if (status == YES) // Switch over to the new pack file
+	{
+		close(packFile); packFile = tempFile; free(slots); slots = newSlots;
+
+		header = newHeader; tombstones = 0; mapping = nil; [pendingSlots removeAllIndexes]; // All slots written
+	}
+	else // Leave the current pack alone
+	{
+		close(tempFile); unlink([tempPath fileSystemRepresentation]); free(newSlots);
+	}
+
+	return status;
+}
+
+- (BOOL)matchFileSize:(uint64_t)fileSize fileDate:(double)fileDate
+{
+	@synchronized(self) // Mutex lock
+	{
+		if (slots == NULL) return NO; // Closed
+
+		if ((header.fileSize == fileSize) && (header.fileDate == fileDate)) return YES; // Same document file
+
+		unlink([packPath fileSystemRepresentation]); close(packFile); // Outstanding images keep the old file mapped
+
+		packFile = open([packPath fileSystemRepresentation], (O_RDWR | O_CREAT), 0644);
+
+		mapping = nil; [pendingSlots removeAllIndexes]; // Nothing left to commit
+
+		if ((packFile >= 0) && ([self createPackFile] == YES)) // Empty pack for this document file
+		{
+			header.fileSize = fileSize; header.fileDate = fileDate; [self writeHeader];
+		}
+		else // Unable to start over - leave the pack closed
+		{
+			if (packFile >= 0) close(packFile), packFile = -1;
+
+			if (slots != NULL) free(slots), slots = NULL;
+		}
+
+		return NO;
+	}
+}
+
+- (BOOL)compact
+{
+	@synchronized(self) // Mutex lock
+	{
+		if (slots == NULL) return NO; // Closed
+
+		return [self rewriteWithSlotCount:header.slotCount];
+	}
+}
+
+- (BOOL)storeImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size
+{
+	return [self storeImage:imageRef page:page size:size level:0];
+}
+
+- (BOOL)storeImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size level:(uint32_t)level
+{
+	return [self storeImage:imageRef page:page size:size level:level sync:YES];
+}
+
+- (BOOL)appendImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size level:(uint32_t)level
+{
+	return [self storeImage:imageRef page:page size:size level:level sync:NO];
+}
+
+- (BOOL)synchronize
+{
+	@synchronized(self) // Mutex lock
+	{
+		if (pendingSlots.count == 0) return YES; // Nothing appended
+
+		if ((packFile < 0) || (slots == NULL)) { [pendingSlots removeAllIndexes]; return NO; } // Closed
+
+		if (fsync(packFile) != 0) return NO; // Blobs must be durable before their slots
+
+		__block BOOL status = YES; // Commit the slots, then the header
+
+		[pendingSlots enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop)
+		{
+			status = (PackWrite(packFile, &slots[index], sizeof(PDFReaderThumbPackSlot), (PACK_HEADER_SIZE + (index * sizeof(PDFReaderThumbPackSlot)))) && status);
+		}];
+
+		[self writeHeader]; [pendingSlots removeAllIndexes]; return status;
+	}
+}
+
+- (BOOL)storeImage:(CGImageRef)imageRef page:(NSInteger)page size:(CGSize)size level:(uint32_t)level sync:(BOOL)sync
+{
+	if (imageRef == NULL) return NO; // Nothing to store
+
+	size_t width = CGImageGetWidth(imageRef); size_t height = CGImageGetHeight(imageRef);
+
+	if ((width > UINT16_MAX) || (height > UINT16_MAX) || (size.width > UINT16_MAX) || (size.height > UINT16_MAX)) return NO;
+
+	size_t bytesPerRow = 0; CFDataRef pixels = PackCopyPixels(imageRef, &bytesPerRow);
+
+	if (pixels == NULL) return NO; // Unable to get image pixels
+
+	BOOL status = NO; // Store status
+
+	@synchronized(self) // Mutex lock
+	{
+		if (slots != NULL) // Pack is open
+		{
+			if ((header.entryCount + tombstones + 1) > (header.slotCount * PACK_MAXIMUM_LOAD))
+			{
+				[self rewriteWithSlotCount:(header.slotCount * 2)]; // Grow the index
+			}
+
+			uint64_t offset = header.endOffset; uint32_t length = (uint32_t)CFDataGetLength(pixels);
+
+			status = PackWrite(packFile, CFDataGetBytePtr(pixels), length, offset); // Append the blob
+
+			if (status == YES) status = (ftruncate(packFile, PackAlign(offset + length)) == 0); // Pad it so the file ends at the end offset
+
+			if ((status == YES) && (sync == YES)) status = (fsync(packFile) == 0); // Blob must be durable before its slot
+
+			NSInteger index = PackFindSlot(slots, header.slotCount, (uint32_t)page, (uint16_t)size.width, (uint16_t)size.height, level, YES);
+
+			if ((status == YES) && (index >= 0)) // Commit the slot, then the header
+			{
+				PDFReaderThumbPackSlot *slot = &slots[index]; // Target slot
+
+				if (slot->flags & SLOT_LIVE) // Replacing an existing thumb
+				{
+					header.deadBytes += PackAlign(slot->length); header.liveBytes -= PackAlign(slot->length); header.entryCount--;
+				}
+				else if (slot->checksum != 0) // Reusing a removed slot
+				{
+					tombstones--;
+				}
+
+				slot->page = (uint32_t)page; slot->keyWidth = (uint16_t)size.width; slot->keyHeight = (uint16_t)size.height;
+
+				slot->width = (uint16_t)width; slot->height = (uint16_t)height; slot->flags = SLOT_LIVE; slot->keyLevel = level;
+
+				slot->offset = offset; slot->length = length; slot->bytesPerRow = (uint32_t)bytesPerRow; PackSealSlot(slot);
+
+				header.endOffset = PackAlign(offset + length); header.liveBytes += PackAlign(length); header.entryCount++;
+
+				if (sync == YES) // Commit the slot, then the header (a hint - slots are validated on open)
+				{
+					status = PackWrite(packFile, slot, sizeof(PDFReaderThumbPackSlot), (PACK_HEADER_SIZE + (index * sizeof(PDFReaderThumbPackSlot))));
+
+					[self writeHeader];
+				}
+				else // Committed by -synchronize after one sync of all appended blobs
+				{
+					[pendingSlots addIndex:index];
+				}
+
+				if ((header.deadBytes > header.liveBytes) && (header.deadBytes > PACK_COMPACT_MINIMUM)) [self rewriteWithSlotCount:header.slotCount];
+			}
+			else // Failed - the appended bytes are reclaimed on the next store
+			{
+				status = NO;
+			}
+		}
+	}
+
+	CFRelease(pixels); return status;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderThumbPackMapping class implementation
+//
+
+@implementation PDFReaderThumbPackMapping
+{
+	const uint8_t *_bytes;
+
+	size_t _length;
+}
+
+#pragma mark Properties
+
+@synthesize bytes = _bytes;
+@synthesize length = _length;
+
+#pragma mark PDFReaderThumbPackMapping instance methods
+
+- (id)initWithFileDescriptor:(int)fd length:(size_t)length
+{
+	if ((self = [super init])) // Initialize
+	{
+		void *bytes = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+
+		if (bytes == MAP_FAILED) return nil; // Mapping failed
+
+		_bytes = bytes; _length = length;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_bytes != NULL) munmap((void *)_bytes, _length), _bytes = NULL;
+}
+
+@end
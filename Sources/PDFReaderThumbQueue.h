@@ -24,6 +24,34 @@
 
 #import <Foundation/Foundation.h>
 
+typedef NS_ENUM(NSInteger, PDFReaderThumbLane)
+{
+	PDFReaderThumbLaneFetch = 0, // Thumb file I/O
+	PDFReaderThumbLaneRender, // PDF page rendering
+	PDFReaderThumbLaneEncode, // Thumb file encoding
+	PDFReaderThumbLaneCount
+};
+
+typedef NS_ENUM(NSInteger, PDFReaderThumbPriority)
+{
+	PDFReaderThumbPriorityVisible = 0, // Visible grid cell or page
+	PDFReaderThumbPriorityPagebarLarge, // Pagebar page thumb
+	PDFReaderThumbPriorityPagebarSmall, // Pagebar mini thumbs
+	PDFReaderThumbPriorityPrewarm // Background pre-warm
+};
+
+typedef struct
+{
+	NSUInteger queued; // Operations added to the lane
+	NSUInteger completed; // Operations that ran to completion
+	NSUInteger cancelled; // Operations cancelled before or while running
+	double throughput; // Completed operations per busy second
+	double averageWait; // Mean seconds from enqueue to start
+	double maximumWait; // Worst seconds from enqueue to start
+} PDFReaderThumbLaneStatistics;
+
+@class PDFReaderThumbOperation;
+
 @interface PDFReaderThumbQueue : NSObject <NSObject>
 
 + (PDFReaderThumbQueue *)sharedInstance;
@@ -32,10 +60,28 @@
 
 - (void)addWorkOperation:(NSOperation *)operation;
 
+- (void)addEncodeOperation:(NSOperation *)operation;
+
+- (void)addOperation:(PDFReaderThumbOperation *)operation toLane:(PDFReaderThumbLane)lane;
+
+- (BOOL)promoteOperationForKey:(NSString *)key priority:(PDFReaderThumbPriority)priority;
+
+- (BOOL)demoteOperationForKey:(NSString *)key priority:(PDFReaderThumbPriority)priority;
+
 - (void)cancelOperationsWithGUID:(NSString *)guid;
 
+- (void)cancelOperationsWithGUID:(NSString *)guid page:(NSInteger)page;
+
+- (void)cancelOperationsWithTargetTag:(NSUInteger)tag;
+
+- (void)cancelOperationForKey:(NSString *)key;
+
 - (void)cancelAllOperations;
 
+- (PDFReaderThumbLaneStatistics)statisticsForLane:(PDFReaderThumbLane)lane;
+
+- (void)logStatistics;
+
 @end
 
 #pragma mark -
@@ -47,7 +93,16 @@
 @interface PDFReaderThumbOperation : NSOperation
 
 @property (nonatomic, strong, readonly) NSString *guid;
+@property (nonatomic, strong, readonly) NSString *key;
+@property (atomic, assign, readwrite) PDFReaderThumbPriority priorityClass;
+@property (atomic, assign, readwrite) NSInteger page;
+@property (atomic, assign, readwrite) NSUInteger targetTag;
+@property (atomic, assign, readwrite) PDFReaderThumbLane lane;
+@property (atomic, assign, readwrite) CFAbsoluteTime enqueueTime;
+@property (atomic, assign, readonly) CFAbsoluteTime startTime;
 
 - (id)initWithGUID:(NSString *)guid;
 
+- (id)initWithGUID:(NSString *)guid key:(NSString *)key;
+
 @end
@@ -23,12 +23,60 @@
 //
 
 #import "PDFReaderThumbQueue.h"
+#import "PDFReaderTrace.h"
+
+#import "PDFReaderCoreHash.h"
+#import "PDFReaderCoreScheduler.h"
+
+//
+//	PDFReaderThumbOperation class extension
+//
+
+@interface PDFReaderThumbOperation ()
+{
+@public // Owned by PDFReaderThumbQueue
+
+	uint64_t serial; // Scheduler key
+
+	uint64_t groups[PDFReaderCoreSchedulerGroups]; // Document, page and target groups
+}
+
+@end
 
 @implementation PDFReaderThumbQueue
 {
-	NSOperationQueue *loadQueue;
+	NSOperationQueue *lanes[PDFReaderThumbLaneCount];
+
+	PDFReaderCoreSchedulerRef schedulers[PDFReaderThumbLaneCount];
+
+	PDFReaderCoreLaneState laneState[PDFReaderThumbLaneCount];
+
+	NSInteger widths[PDFReaderThumbLaneCount];
+
+	NSInteger running[PDFReaderThumbLaneCount];
+
+	NSMutableDictionary *keyedOperations;
+
+	NSMutableSet *dispatchedOperations;
+
+	uint64_t serial;
+}
+
+#pragma mark PDFReaderThumbQueue functions
+
+static void CollectOperation(uint64_t key, void *value, void *context)
+{
+	(void)key; [(__bridge NSMutableArray *)context addObject:(__bridge_transfer PDFReaderThumbOperation *)value];
+}
 
-	NSOperationQueue *workQueue;
+static inline uint64_t DocumentGroup(NSString *guid)
+{
+	return ((guid != nil) ? PDFReaderCoreHashString([guid UTF8String]) : 0);
+}
+
+static inline uint64_t PageGroup(uint64_t document, NSInteger page)
+{
+	return (document ^ ((uint64_t)page * 0x9E3779B97F4A7C15ULL)); // Spread the page number
 }
 
 #pragma mark PDFReaderThumbQueue class methods
@@ -50,27 +98,54 @@
 {
 	if ((self = [super init])) // Initialize
 	{
-		loadQueue = [NSOperationQueue new];
+		NSInteger cores = [[NSProcessInfo processInfo] activeProcessorCount];
+
+		if (cores < 1) cores = 1; // Always at least one worker per lane
 
-		[loadQueue setName:@"PDFReaderThumbLoadQueue"];
+		NSString *names[PDFReaderThumbLaneCount] = { @"PDFReaderThumbFetchQueue", @"PDFReaderThumbRenderQueue", @"PDFReaderThumbEncodeQueue" };
 
-		[loadQueue setMaxConcurrentOperationCount:1];
+		widths[PDFReaderThumbLaneFetch] = cores; widths[PDFReaderThumbLaneRender] = cores;
 
-		workQueue = [NSOperationQueue new];
+		widths[PDFReaderThumbLaneEncode] = ((cores > 1) ? (cores / 2) : 1);
+
+		for (NSInteger lane = 0; lane < PDFReaderThumbLaneCount; lane++)
+		{
+			lanes[lane] = [NSOperationQueue new];
 
-		[workQueue setName:@"PDFReaderThumbWorkQueue"];
+			[lanes[lane] setName:names[lane]];
+
+			[lanes[lane] setMaxConcurrentOperationCount:widths[lane]];
+
+			schedulers[lane] = PDFReaderCoreSchedulerCreate(64); // Waiting operations
+		}
 
-		[workQueue setMaxConcurrentOperationCount:1];
+		keyedOperations = [NSMutableDictionary new];
+
+		dispatchedOperations = [NSMutableSet new];
 	}
 
 	return self;
 }
 
+- (void)dealloc
+{
+	for (NSInteger lane = 0; lane < PDFReaderThumbLaneCount; lane++)
+	{
+		if (schedulers[lane] == NULL) continue; // Out of memory at init
+
+		void *value = NULL; // Release any still queued operations
+
+		while (PDFReaderCoreSchedulerPop(schedulers[lane], NULL, &value) == 1) CFBridgingRelease(value);
+
+		PDFReaderCoreSchedulerDestroy(schedulers[lane]);
+	}
+}
+
 - (void)addLoadOperation:(NSOperation *)operation
 {
 	if ([operation isKindOfClass:[PDFReaderThumbOperation class]])
 	{
-		[loadQueue addOperation:operation]; // Add to load queue
+		[self addOperation:(PDFReaderThumbOperation *)operation toLane:PDFReaderThumbLaneFetch];
 	}
 }
 
@@ -78,36 +153,283 @@
 {
 	if ([operation isKindOfClass:[PDFReaderThumbOperation class]])
 	{
-		[workQueue addOperation:operation]; // Add to work queue
+		[self addOperation:(PDFReaderThumbOperation *)operation toLane:PDFReaderThumbLaneRender];
 	}
 }
 
-- (void)cancelOperationsWithGUID:(NSString *)guid
+- (void)addEncodeOperation:(NSOperation *)operation
+{
+	if ([operation isKindOfClass:[PDFReaderThumbOperation class]])
+	{
+		[self addOperation:(PDFReaderThumbOperation *)operation toLane:PDFReaderThumbLaneEncode];
+	}
+}
+
+- (void)handOverOperations:(NSArray *)operations toLane:(PDFReaderThumbLane)lane
+{
+	if (operations.count > 0) [lanes[lane] addOperations:operations waitUntilFinished:NO]; // Outside of the lock
+}
+
+- (void)drainLane:(PDFReaderThumbLane)lane
+{
+	NSMutableArray *operations = [NSMutableArray new]; // Handed over outside the lock
+
+	@synchronized(keyedOperations) // Mutex lock
+	{
+		void *value = NULL; // Most urgent waiting operation
+
+		while ((schedulers[lane] != NULL) && (running[lane] < widths[lane]) && (PDFReaderCoreSchedulerPop(schedulers[lane], NULL, &value) == 1))
+		{
+			PDFReaderThumbOperation *operation = (__bridge_transfer PDFReaderThumbOperation *)value;
+
+			[dispatchedOperations addObject:operation]; [operations addObject:operation]; running[lane]++;
+		}
+	}
+
+	[self handOverOperations:operations toLane:lane];
+}
+
+- (void)operation:(PDFReaderThumbOperation *)operation finishedInLane:(PDFReaderThumbLane)lane
+{
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent(); // Right about now
+
+	@synchronized(keyedOperations) // Mutex lock
+	{
+		NSString *key = operation.key; // Promotion key
+
+		if ((key != nil) && ([keyedOperations objectForKey:key] == operation)) [keyedOperations removeObjectForKey:key];
+
+		[dispatchedOperations removeObject:operation]; running[lane]--; // Frees a worker
+
+		CFAbsoluteTime startTime = operation.startTime; // Zero when never started
+
+		PDFReaderCoreLaneFinished(&laneState[lane], operation.enqueueTime, startTime, operation.isCancelled, now);
+	}
+
+	[self drainLane:lane]; // Start the next most urgent operation
+}
+
+- (void)addOperation:(PDFReaderThumbOperation *)operation toLane:(PDFReaderThumbLane)lane
+{
+	if ((lane < 0) || (lane >= PDFReaderThumbLaneCount)) return; // Invalid lane
+
+	__weak PDFReaderThumbQueue *weakSelf = self; __weak PDFReaderThumbOperation *weakOperation = operation;
+
+	[operation setCompletionBlock:^{ [weakSelf operation:weakOperation finishedInLane:lane]; }];
+
+	BOOL queued = NO; // Handed straight over when the scheduler is out of memory
+
+	@synchronized(keyedOperations) // Mutex lock
+	{
+		NSString *key = operation.key; // Promotion key
+
+		if (key != nil) [keyedOperations setObject:operation forKey:key];
+
+		operation.lane = lane; operation.enqueueTime = CFAbsoluteTimeGetCurrent(); // Start the wait clock
+
+		PDFReaderCoreLaneEnqueued(&laneState[lane], operation.enqueueTime); // Count it
+
+		uint64_t document = DocumentGroup(operation.guid); operation->serial = ++serial;
+
+		operation->groups[PDFReaderCoreSchedulerDocument] = document;
+
+		operation->groups[PDFReaderCoreSchedulerPage] = PageGroup(document, operation.page);
+
+		operation->groups[PDFReaderCoreSchedulerTarget] = operation.targetTag;
+
+		if (schedulers[lane] != NULL) // Wait in priority class order for a free worker
+		{
+			void *value = (__bridge_retained void *)operation; // Owned by the scheduler
+
+			if (PDFReaderCoreSchedulerPush(schedulers[lane], operation->serial, operation->groups, operation.priorityClass, value) == 1)
+				queued = YES;
+			else
+				CFBridgingRelease(value);
+		}
+
+		if (queued == NO) { [dispatchedOperations addObject:operation]; running[lane]++; }
+	}
+
+	if (queued == YES) [self drainLane:lane]; else [self handOverOperations:@[operation] toLane:lane];
+}
+
+- (BOOL)promoteOperationForKey:(NSString *)key priority:(PDFReaderThumbPriority)priority
+{
+	if (key == nil) return NO; // Nothing to look up
+
+	@synchronized(keyedOperations) // Mutex lock
+	{
+		PDFReaderThumbOperation *operation = [keyedOperations objectForKey:key];
+
+		if ((operation == nil) || (operation.isCancelled == YES)) return NO;
+
+		if ((operation.isExecuting == NO) && (priority < operation.priorityClass))
+		{
+			PDFReaderCoreSchedulerRef scheduler = schedulers[operation.lane]; // Lane scheduler
+
+			if (scheduler != NULL) PDFReaderCoreSchedulerPromote(scheduler, operation->serial, priority); // When still waiting
+
+			operation.priorityClass = priority; // Reorders it within its lane
+		}
+
+		return YES; // Already queued or running
+	}
+}
+
+- (BOOL)demoteOperationForKey:(NSString *)key priority:(PDFReaderThumbPriority)priority
 {
-	[loadQueue setSuspended:YES]; [workQueue setSuspended:YES];
+	if (key == nil) return NO; // Nothing to look up
 
-	for (PDFReaderThumbOperation *operation in loadQueue.operations)
+	@synchronized(keyedOperations) // Mutex lock
 	{
-		if ([operation isKindOfClass:[PDFReaderThumbOperation class]])
+		PDFReaderThumbOperation *operation = [keyedOperations objectForKey:key];
+
+		if ((operation == nil) || (operation.isCancelled == YES)) return NO;
+
+		if ((operation.isExecuting == NO) && (priority > operation.priorityClass))
 		{
-			if ([operation.guid isEqualToString:guid]) [operation cancel];
+			PDFReaderCoreSchedulerRef scheduler = schedulers[operation.lane]; // Lane scheduler
+
+			if (scheduler != NULL) PDFReaderCoreSchedulerDemote(scheduler, operation->serial, priority); // When still waiting
+
+			operation.priorityClass = priority; // Reorders it within its lane
 		}
+
+		return YES; // Already queued or running
 	}
+}
 
-	for (PDFReaderThumbOperation *operation in workQueue.operations)
+- (void)cancelOperationsInGroup:(uint64_t)group dimension:(PDFReaderCoreSchedulerGroup)dimension
+{
+	BOOL all = (dimension == PDFReaderCoreSchedulerGroups); // Every fetch and render
+
+	NSMutableArray *waiting[PDFReaderThumbLaneEncode]; // Waiting fetches and renders - encodes always run
+
+	NSMutableArray *operations = [NSMutableArray new]; // Cancelled outside the lock
+
+	@synchronized(keyedOperations) // Mutex lock
 	{
-		if ([operation isKindOfClass:[PDFReaderThumbOperation class]])
+		for (NSInteger lane = 0; lane < PDFReaderThumbLaneEncode; lane++)
 		{
-			if ([operation.guid isEqualToString:guid]) [operation cancel];
+			waiting[lane] = [NSMutableArray new]; if (schedulers[lane] == NULL) continue;
+
+			if (all == YES) // Remove every waiting operation
+			{
+				void *value = NULL; // Most urgent first
+
+				while (PDFReaderCoreSchedulerPop(schedulers[lane], NULL, &value) == 1) CollectOperation(0, value, (__bridge void *)waiting[lane]);
+			}
+			else // Only the group's waiting operations
+			{
+				PDFReaderCoreSchedulerCancelGroup(schedulers[lane], dimension, group, CollectOperation, (__bridge void *)waiting[lane]);
+			}
 		}
+
+		for (PDFReaderThumbOperation *operation in dispatchedOperations) // Already handed over
+		{
+			if (operation.lane == PDFReaderThumbLaneEncode) continue;
+
+			if ((all == YES) || (operation->groups[dimension] == group)) [operations addObject:operation];
+		}
+
+		for (NSInteger lane = 0; lane < PDFReaderThumbLaneEncode; lane++) // Handed over to finish at once
+		{
+			[dispatchedOperations addObjectsFromArray:waiting[lane]]; running[lane] += waiting[lane].count;
+
+			[operations addObjectsFromArray:waiting[lane]];
+		}
+	}
+
+	for (PDFReaderThumbOperation *operation in operations) [operation cancel];
+
+	for (NSInteger lane = 0; lane < PDFReaderThumbLaneEncode; lane++) // Completion blocks do the lane accounting
+	{
+		[self handOverOperations:waiting[lane] toLane:lane];
+	}
+}
+
+- (void)cancelOperationsWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to look up
+
+	[self cancelOperationsInGroup:DocumentGroup(guid) dimension:PDFReaderCoreSchedulerDocument];
+}
+
+- (void)cancelOperationsWithGUID:(NSString *)guid page:(NSInteger)page
+{
+	if (guid == nil) return; // Nothing to look up
+
+	[self cancelOperationsInGroup:PageGroup(DocumentGroup(guid), page) dimension:PDFReaderCoreSchedulerPage];
+}
+
+- (void)cancelOperationsWithTargetTag:(NSUInteger)tag
+{
+	if (tag == 0) return; // Untagged target
+
+	[self cancelOperationsInGroup:tag dimension:PDFReaderCoreSchedulerTarget];
+}
+
+- (void)cancelOperationForKey:(NSString *)key
+{
+	if (key == nil) return; // Nothing to look up
+
+	NSMutableArray *waiting = [NSMutableArray new]; // Handed over when it was still queued
+
+	PDFReaderThumbOperation *operation = nil; PDFReaderThumbLane lane = PDFReaderThumbLaneEncode;
+
+	@synchronized(keyedOperations) // Mutex lock
+	{
+		operation = [keyedOperations objectForKey:key]; // Current fetch or render
+
+		if ((operation == nil) || (operation.lane == PDFReaderThumbLaneEncode)) return; // Encodes always run
+
+		lane = operation.lane; PDFReaderCoreSchedulerRef scheduler = schedulers[lane]; // Lane scheduler
+
+		if (scheduler != NULL) PDFReaderCoreSchedulerCancel(scheduler, operation->serial, CollectOperation, (__bridge void *)waiting);
+
+		[dispatchedOperations addObjectsFromArray:waiting]; running[lane] += waiting.count; // Handed over to finish at once
 	}
 
-	[workQueue setSuspended:NO]; [loadQueue setSuspended:NO];
+	[operation cancel]; [self handOverOperations:waiting toLane:lane];
 }
 
 - (void)cancelAllOperations
 {
-	[loadQueue cancelAllOperations]; [workQueue cancelAllOperations];
+	[self cancelOperationsInGroup:0 dimension:PDFReaderCoreSchedulerGroups];
+}
+
+- (PDFReaderThumbLaneStatistics)statisticsForLane:(PDFReaderThumbLane)lane
+{
+	PDFReaderThumbLaneStatistics statistics; memset(&statistics, 0x00, sizeof(statistics));
+
+	if ((lane < 0) || (lane >= PDFReaderThumbLaneCount)) return statistics;
+
+	@synchronized(keyedOperations) // Mutex lock
+	{
+		PDFReaderCoreLaneState *state = &laneState[lane]; // Lane state
+
+		statistics.queued = state->queued; statistics.completed = state->completed; statistics.cancelled = state->cancelled;
+
+		PDFReaderCoreLaneSummary(state, CFAbsoluteTimeGetCurrent(), &statistics.throughput, &statistics.averageWait);
+
+		statistics.maximumWait = state->maximumWait;
+	}
+
+	return statistics;
+}
+
+- (void)logStatistics
+{
+#ifdef DEBUG
+	for (NSInteger lane = 0; lane < PDFReaderThumbLaneCount; lane++)
+	{
+		PDFReaderThumbLaneStatistics statistics = [self statisticsForLane:lane];
+
+		NSLog(@"%s %@ queued %u, completed %u, cancelled %u, %.1f/sec, wait avg %.1fms max %.1fms", __FUNCTION__,
+			lanes[lane].name, (unsigned)statistics.queued, (unsigned)statistics.completed, (unsigned)statistics.cancelled,
+			statistics.throughput, (statistics.averageWait * 1000.0), (statistics.maximumWait * 1000.0));
+	}
+#endif
 }
 
 @end
@@ -121,20 +443,85 @@
 @implementation PDFReaderThumbOperation
 {
 	NSString *_guid;
+
+	NSString *_key;
+
+	PDFReaderThumbPriority _priorityClass;
+
+	NSInteger _page;
+
+	NSUInteger _targetTag;
+
+	PDFReaderThumbLane _lane;
+
+	CFAbsoluteTime _enqueueTime;
+
+	CFAbsoluteTime _startTime;
 }
 
 @synthesize guid = _guid;
+@synthesize key = _key;
+@synthesize page = _page;
+@synthesize targetTag = _targetTag;
+@synthesize lane = _lane;
+@synthesize enqueueTime = _enqueueTime;
+@synthesize startTime = _startTime;
 
 #pragma mark PDFReaderThumbOperation instance methods
 
 - (id)initWithGUID:(NSString *)guid
+{
+	return [self initWithGUID:guid key:nil];
+}
+
+- (id)initWithGUID:(NSString *)guid key:(NSString *)key
 {
 	if ((self = [super init]))
 	{
-		_guid = guid;
+		_guid = guid; _key = [key copy];
+
+		[self setPriorityClass:PDFReaderThumbPriorityPrewarm];
 	}
 
 	return self;
 }
 
+- (PDFReaderThumbPriority)priorityClass
+{
+	@synchronized(self) { return _priorityClass; }
+}
+
+- (void)setPriorityClass:(PDFReaderThumbPriority)priorityClass
+{
+	static NSOperationQueuePriority queuePriorities[] = // By priority class
+	{
+		NSOperationQueuePriorityVeryHigh, NSOperationQueuePriorityHigh, NSOperationQueuePriorityNormal, NSOperationQueuePriorityLow
+	};
+
+	static double threadPriorities[] = { 0.55, 0.50, 0.35, 0.20 }; // By priority class
+
+	if ((priorityClass < PDFReaderThumbPriorityVisible) || (priorityClass > PDFReaderThumbPriorityPrewarm)) return;
+
+	@synchronized(self) { _priorityClass = priorityClass; }
+
+	[self setQueuePriority:queuePriorities[priorityClass]]; [self setThreadPriority:threadPriorities[priorityClass]];
+}
+
+- (void)start
+{
+	_startTime = CFAbsoluteTimeGetCurrent(); // Queue wait ends here
+
+	static PDFReaderCoreTraceStage waitStages[PDFReaderThumbLaneCount] = // By lane
+	{
+		PDFReaderCoreTraceFetchWait, PDFReaderCoreTraceRenderWait, PDFReaderCoreTraceEncodeWait
+	};
+
+	if ((PDFReaderCoreTraceIsEnabled() != 0) && (_enqueueTime > 0.0) && (_lane >= 0) && (_lane < PDFReaderThumbLaneCount)) // Lane set when queued
+	{
+		PDFReaderTraceMarkStage(waitStages[_lane], _key, -1, (_startTime - _enqueueTime));
+	}
+
+	[super start];
+}
+
 @end
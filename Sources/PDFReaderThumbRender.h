@@ -30,6 +30,16 @@
 
 @interface PDFReaderThumbRender : PDFReaderThumbOperation
 
++ (NSUInteger)renderCount;
+
++ (NSUInteger)derivedCount;
+
++ (NSUInteger)cancelledCount;
+
++ (NSUInteger)wastedCount;
+
++ (void)logStatistics;
+
 - (id)initWithRequest:(PDFReaderThumbRequest *)options;
 
 @end
@@ -22,25 +22,129 @@
 //	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#import "PDFReaderConfig.h"
 #import "PDFReaderThumbRender.h"
+#import "PDFReaderThumbEncode.h"
 #import "PDFReaderThumbCache.h"
+#import "PDFReaderThumbPack.h"
 #import "PDFReaderThumbView.h"
-#import "CGPDFDocument.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderPageMetrics.h"
+#import "PDFReaderTrace.h"
 
-#import <ImageIO/ImageIO.h>
+#import <Accelerate/Accelerate.h>
 
 @implementation PDFReaderThumbRender
 {
 	PDFReaderThumbRequest *request;
 }
 
+#pragma mark PDFReaderThumbRender functions
+
+static NSUInteger renderCount = 0;
+
+static NSUInteger derivedCount = 0;
+
+static NSUInteger cancelledCount = 0;
+
+static NSUInteger wastedCount = 0;
+
+static CGSize ThumbPixelSize(CGSize thumbSize, CGFloat page_w, CGFloat page_h, CGFloat screenScale)
+{
+	CGFloat thumb_w = thumbSize.width; // Maximum thumb width
+	CGFloat thumb_h = thumbSize.height; // Maximum thumb height
+
+	CGFloat scale_w = (thumb_w / page_w); // Width scale
+	CGFloat scale_h = (thumb_h / page_h); // Height scale
+
+	CGFloat scale = 0.0f; // Page to target thumb size scale
+
+	if (page_h > page_w)
+		scale = ((thumb_h > thumb_w) ? scale_w : scale_h); // Portrait
+	else
+		scale = ((thumb_h < thumb_w) ? scale_h : scale_w); // Landscape
+
+	NSInteger target_w = (page_w * scale); // Integer target thumb width
+	NSInteger target_h = (page_h * scale); // Integer target thumb height
+
+	if (target_w % 2) target_w--; if (target_h % 2) target_h--; // Even
+
+	target_w *= screenScale; target_h *= screenScale; // Screen scale
+
+	return CGSizeMake(target_w, target_h);
+}
+
+static CGImageRef ThumbCreateDownsampledImage(CGContextRef source, CGSize pixelSize)
+{
+	CGImageRef imageRef = NULL; // Downsampled thumb image
+
+	size_t width = pixelSize.width; size_t height = pixelSize.height;
+
+	if ((width == 0) || (height == 0)) return NULL; // Nothing to derive
+
+	CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB(); // RGB color space
+
+	CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+
+	CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, rgb, bmi);
+
+	if (context != NULL) // Lanczos resample the rendered BGRX pixels (4 x 8-bit channels)
+	{
+		vImage_Buffer src = { CGBitmapContextGetData(source), CGBitmapContextGetHeight(source), CGBitmapContextGetWidth(source), CGBitmapContextGetBytesPerRow(source) };
+
+		vImage_Buffer dst = { CGBitmapContextGetData(context), height, width, CGBitmapContextGetBytesPerRow(context) };
+
+		if (vImageScale_ARGB8888(&src, &dst, NULL, kvImageHighQualityResampling) == kvImageNoError)
+		{
+			imageRef = CGBitmapContextCreateImage(context);
+		}
+
+		CGContextRelease(context);
+	}
+
+	CGColorSpaceRelease(rgb); return imageRef;
+}
+
+#pragma mark PDFReaderThumbRender class methods
+
++ (NSUInteger)renderCount
+{
+	@synchronized(self) { return renderCount; }
+}
+
++ (NSUInteger)derivedCount
+{
+	@synchronized(self) { return derivedCount; }
+}
+
++ (NSUInteger)cancelledCount
+{
+	@synchronized(self) { return cancelledCount; }
+}
+
++ (NSUInteger)wastedCount
+{
+	@synchronized(self) { return wastedCount; }
+}
+
++ (void)logStatistics
+{
+#ifdef DEBUG
+	@synchronized(self) // Mutex lock
+	{
+		NSLog(@"%s rendered %u, derived %u, cancelled %u, wasted %u", __FUNCTION__,
+			(unsigned)renderCount, (unsigned)derivedCount, (unsigned)cancelledCount, (unsigned)wastedCount);
+	}
+#endif
+}
+
 #pragma mark PDFReaderThumbRender instance methods
 
 - (id)initWithRequest:(PDFReaderThumbRequest *)options
 {
-	if ((self = [super initWithGUID:options.guid]))
+	if ((self = [super initWithGUID:options.guid key:options.cacheKey]))
 	{
-		request = options;
+		request = options; self.page = options.thumbPage; self.targetTag = options.targetTag; // Registry keys
 	}
 
 	return self;
@@ -57,146 +161,151 @@
 	[[PDFReaderThumbCache sharedInstance] removeNullForKey:request.cacheKey];
 }
 
-- (NSURL *)thumbFileURL
+- (NSArray *)mipChainSizes
+{
+	if ([PDFReaderConfig sharedConfig].thumbMipChainEnabled == NO) return nil;
+
+	NSArray *sizes = [PDFReaderThumbCache thumbSizesForGUID:request.guid]; // Largest first
+
+	BOOL active = [sizes containsObject:[NSValue valueWithCGSize:request.thumbSize]];
+
+	return (((active == YES) && (sizes.count > 1)) ? sizes : nil);
+}
+
+- (void)finishThumbSize:(CGSize)size image:(CGImageRef)imageRef
 {
-	NSFileManager *fileManager = [NSFileManager new]; // File manager instance
+	UIImage *image = [UIImage imageWithCGImage:imageRef scale:request.scale orientation:UIImageOrientationUp];
 
-	NSString *cachePath = [PDFReaderThumbCache thumbCachePathForGUID:request.guid]; // Thumb cache path
+	NSString *cacheKey = [PDFReaderThumbRequest cacheKeyForPage:request.thumbPage size:size guid:request.guid];
 
-	[fileManager createDirectoryAtPath:cachePath withIntermediateDirectories:NO attributes:nil error:NULL];
+	[[PDFReaderThumbCache sharedInstance] setObject:image forKey:cacheKey]; // Update cache and show it to all waiters
 
-	NSString *fileName = [NSString stringWithFormat:@"%@.png", request.thumbName]; // Thumb file name
+	PDFReaderThumbEncode *thumbEncode = [[PDFReaderThumbEncode alloc] initWithGUID:request.guid page:request.thumbPage size:size image:imageRef];
 
-	return [NSURL fileURLWithPath:[cachePath stringByAppendingPathComponent:fileName]]; // File URL
+	[[PDFReaderThumbQueue sharedInstance] addEncodeOperation:thumbEncode]; // Write the thumb on the encode lane
 }
 
 - (void)main
 {
-	NSInteger page = request.thumbPage; NSString *password = request.password;
+	PDFReaderThumbCache *thumbCache = [PDFReaderThumbCache sharedInstance]; // Memory cache
 
-	CGImageRef imageRef = NULL; CFURLRef fileURL = (__bridge CFURLRef)request.fileURL;
+	UIImage *derived = [thumbCache imageForKey:request.cacheKey]; // Produced by a mip-chain render
 
-	CGPDFDocumentRef thePDFDocRef = CGPDFDocumentCreateX(fileURL, password);
+	if (derived != nil) { [thumbCache setObject:derived forKey:request.cacheKey]; request.thumbView.operation = nil; return; }
 
-	if (thePDFDocRef != NULL) // Check for non-NULL CGPDFDocumentRef
-	{
-		CGPDFPageRef thePDFPageRef = CGPDFDocumentGetPage(thePDFDocRef, page);
+	NSArray *chainSizes = [self mipChainSizes]; // Active thumb sizes when rendering a mip-chain
 
-		if (thePDFPageRef != NULL) // Check for non-NULL CGPDFPageRef
-		{
-			CGFloat thumb_w = request.thumbSize.width; // Maximum thumb width
-			CGFloat thumb_h = request.thumbSize.height; // Maximum thumb height
+	CGSize renderSize = ((chainSizes != nil) ? [[chainSizes objectAtIndex:0] CGSizeValue] : request.thumbSize);
 
-			CGRect cropBoxRect = CGPDFPageGetBoxRect(thePDFPageRef, kCGPDFCropBox);
-			CGRect mediaBoxRect = CGPDFPageGetBoxRect(thePDFPageRef, kCGPDFMediaBox);
-			CGRect effectiveRect = CGRectIntersection(cropBoxRect, mediaBoxRect);
+	NSInteger page = request.thumbPage; NSString *password = request.password; BOOL rendered = NO;
 
-			NSInteger pageRotate = CGPDFPageGetRotationAngle(thePDFPageRef); // Angle
+	uint64_t traceStart = PDFReaderTraceBegin(PDFReaderCoreTraceRender, request.cacheKey, page);
 
-			CGFloat page_w = 0.0f; CGFloat page_h = 0.0f; // Rotated page size
+	PDFReaderDocumentPool *documentPool = [PDFReaderDocumentPool sharedInstance];
 
-			switch (pageRotate) // Page rotation (in degrees)
-			{
-				default: // Default case
-				case 0: case 180: // 0 and 180 degrees
-				{
-					page_w = effectiveRect.size.width;
-					page_h = effectiveRect.size.height;
-					break;
-				}
+	uint64_t traceOpen = PDFReaderTraceBegin(PDFReaderCoreTraceRenderOpen, request.cacheKey, page);
 
-				case 90: case 270: // 90 and 270 degrees
-				{
-					page_h = effectiveRect.size.width;
-					page_w = effectiveRect.size.height;
-					break;
-				}
-			}
+	CGPDFPageRef thePDFPageRef = [documentPool retainPage:page withURL:request.fileURL password:password guid:request.guid];
+
+	PDFReaderTraceEnd(PDFReaderCoreTraceRenderOpen, request.cacheKey, page, traceOpen, 0);
+
+	if (thePDFPageRef != NULL) // Check for non-NULL CGPDFPageRef
+	{
+		PDFReaderPageGeometry geometry; // Rotated page size from the document metrics table (or the page)
 
-			CGFloat scale_w = (thumb_w / page_w); // Width scale
-			CGFloat scale_h = (thumb_h / page_h); // Height scale
+		if ([[PDFReaderPageMetrics metricsWithGUID:request.guid] getGeometry:&geometry forPage:page] == NO)
+		{
+			geometry = [PDFReaderContentPage geometryForPage:thePDFPageRef];
+		}
+
+		CGFloat page_w = geometry.width; CGFloat page_h = geometry.height; // Rotated page size
 
-			CGFloat scale = 0.0f; // Page to target thumb size scale
+		CGSize pixelSize = ThumbPixelSize(renderSize, page_w, page_h, request.scale); // Render size
 
-			if (page_h > page_w)
-				scale = ((thumb_h > thumb_w) ? scale_w : scale_h); // Portrait
-			else
-				scale = ((thumb_h < thumb_w) ? scale_h : scale_w); // Landscape
+		NSInteger target_w = pixelSize.width; NSInteger target_h = pixelSize.height; // Integer pixel size
 
-			NSInteger target_w = (page_w * scale); // Integer target thumb width
-			NSInteger target_h = (page_h * scale); // Integer target thumb height
+		CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB(); // RGB color space
 
-			if (target_w % 2) target_w--; if (target_h % 2) target_h--; // Even
+		CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
 
-			target_w *= request.scale; target_h *= request.scale; // Screen scale
+		CGContextRef context = NULL; // The page draw itself cannot be interrupted - so check before it starts
 
-			CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB(); // RGB color space
+		if (self.isCancelled == NO) // Not cancelled while opening the page
+			context = CGBitmapContextCreate(NULL, target_w, target_h, 8, 0, rgb, bmi);
+		else
+			@synchronized([PDFReaderThumbRender class]) { cancelledCount++; } // Draw skipped
 
-			CGBitmapInfo bmi = (kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+		if (context != NULL) // Must have a valid custom CGBitmap context to draw into
+		{
+			CGRect thumbRect = CGRectMake(0.0f, 0.0f, target_w, target_h); // Target thumb rect
 
-			CGContextRef context = CGBitmapContextCreate(NULL, target_w, target_h, 8, 0, rgb, bmi);
+			CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); CGContextFillRect(context, thumbRect); // White fill
 
-			if (context != NULL) // Must have a valid custom CGBitmap context to draw into
-			{
-				CGRect thumbRect = CGRectMake(0.0f, 0.0f, target_w, target_h); // Target thumb rect
+			CGContextConcatCTM(context, CGPDFPageGetDrawingTransform(thePDFPageRef, kCGPDFCropBox, thumbRect, 0, true)); // Fit rect
 
-				CGContextSetRGBFillColor(context, 1.0f, 1.0f, 1.0f, 1.0f); CGContextFillRect(context, thumbRect); // White fill
+			//CGContextSetRenderingIntent(context, kCGRenderingIntentDefault); CGContextSetInterpolationQuality(context, kCGInterpolationDefault);
 
-				CGContextConcatCTM(context, CGPDFPageGetDrawingTransform(thePDFPageRef, kCGPDFCropBox, thumbRect, 0, true)); // Fit rect
+			uint64_t traceDraw = PDFReaderTraceBegin(PDFReaderCoreTraceRenderDraw, request.cacheKey, page);
 
-				//CGContextSetRenderingIntent(context, kCGRenderingIntentDefault); CGContextSetInterpolationQuality(context, kCGInterpolationDefault);
+			CGContextDrawPDFPage(context, thePDFPageRef); // Render the PDF page into the custom CGBitmap context
 
-				CGContextDrawPDFPage(context, thePDFPageRef); // Render the PDF page into the custom CGBitmap context
+			PDFReaderTraceEnd(PDFReaderCoreTraceRenderDraw, request.cacheKey, page, traceDraw, 0);
 
-				imageRef = CGBitmapContextCreateImage(context); // Create CGImage from custom CGBitmap context
+			@synchronized([PDFReaderThumbRender class]) { renderCount++; } // One page render
 
-				CGContextRelease(context); // Release custom CGBitmap context reference
+			if (self.isCancelled == YES) // Cancelled while drawing - cached and encoded but never shown
+			{
+				@synchronized([PDFReaderThumbRender class]) { wastedCount++; } // One wasted render
 			}
 
-			CGColorSpaceRelease(rgb); // Release device RGB color space reference
-		}
+			CGImageRef imageRef = CGBitmapContextCreateImage(context); // Create CGImage from custom CGBitmap context
 
-		CGPDFDocumentRelease(thePDFDocRef); // Release CGPDFDocumentRef reference
-	}
+			if (imageRef != NULL) // Cache, show and encode the rendered size
+			{
+				[self finishThumbSize:renderSize image:imageRef]; CGImageRelease(imageRef);
 
-	if (imageRef != NULL) // Create UIImage from CGImage and show it, then save thumb as PNG
-	{
-		UIImage *image = [UIImage imageWithCGImage:imageRef scale:request.scale orientation:UIImageOrientationUp];
+				rendered = CGSizeEqualToSize(renderSize, request.thumbSize);
+			}
 
-		[[PDFReaderThumbCache sharedInstance] setObject:image forKey:request.cacheKey]; // Update cache
+			PDFReaderThumbPack *thumbPack = [PDFReaderThumbPack packWithGUID:request.guid]; // Document thumb pack
 
-		if (self.isCancelled == NO) // Show the image in the target thumb view on the main thread
-		{
-			PDFReaderThumbView *thumbView = request.thumbView; // Target thumb view for image show
+			for (NSValue *value in chainSizes) // Derive every smaller active size from the one render
+			{
+				CGSize size = [value CGSizeValue]; if (CGSizeEqualToSize(size, renderSize) == YES) continue;
 
-			NSUInteger targetTag = request.targetTag; // Target reference tag for image show
+				BOOL requested = CGSizeEqualToSize(size, request.thumbSize); // Must always be delivered
 
-			dispatch_async(dispatch_get_main_queue(), // Queue image show on main thread
-			^{
-				if (thumbView.targetTag == targetTag) [thumbView showImage:image];
-			});
-		}
+				NSString *cacheKey = [PDFReaderThumbRequest cacheKeyForPage:page size:size guid:request.guid];
 
-		CFURLRef thumbURL = (__bridge CFURLRef)[self thumbFileURL]; // Thumb cache path with PNG file name URL
+				if ((requested == NO) && (([thumbCache imageForKey:cacheKey] != nil) || [thumbPack containsPage:page size:size])) continue;
 
-		CGImageDestinationRef thumbRef = CGImageDestinationCreateWithURL(thumbURL, (CFStringRef)@"public.png", 1, NULL);
+				CGImageRef derivedRef = ThumbCreateDownsampledImage(context, ThumbPixelSize(size, page_w, page_h, request.scale));
 
-		if (thumbRef != NULL) // Write the thumb image file out to the thumb cache directory
-		{
-			CGImageDestinationAddImage(thumbRef, imageRef, NULL); // Add the image
+				if (derivedRef != NULL) // Cache, show and encode the derived size
+				{
+					[self finishThumbSize:size image:derivedRef]; CGImageRelease(derivedRef);
 
-			CGImageDestinationFinalize(thumbRef); // Finalize the image file
+					@synchronized([PDFReaderThumbRender class]) { derivedCount++; } // One render saved
 
-			CFRelease(thumbRef); // Release CGImageDestination reference
+					if (requested == YES) rendered = YES;
+				}
+			}
+
+			CGContextRelease(context); // Release custom CGBitmap context reference
 		}
 
-		CGImageRelease(imageRef); // Release CGImage reference
+		CGColorSpaceRelease(rgb); // Release device RGB color space reference
+
+		[documentPool releasePage:thePDFPageRef]; // Release pooled CGPDFPageRef reference
 	}
-	else // No image - so remove the placeholder object from the cache
+
+	if (rendered == NO) // No image - so remove the placeholder object from the cache
 	{
-		[[PDFReaderThumbCache sharedInstance] removeNullForKey:request.cacheKey];
+		[thumbCache removeNullForKey:request.cacheKey];
 	}
 
+	PDFReaderTraceEnd(PDFReaderCoreTraceRender, request.cacheKey, page, traceStart, 0);
+
 	request.thumbView.operation = nil; // Break retain loop
 }
 
@@ -39,6 +39,10 @@
 @property (nonatomic, assign, readonly) CGSize thumbSize;
 @property (nonatomic, assign, readonly) CGFloat scale;
 
++ (NSString *)thumbNameForPage:(NSInteger)page size:(CGSize)size;
+
++ (NSString *)cacheKeyForPage:(NSInteger)page size:(CGSize)size guid:(NSString *)guid;
+
 + (id)newForView:(PDFReaderThumbView *)view fileURL:(NSURL *)url password:(NSString *)phrase guid:(NSString *)guid page:(NSInteger)page size:(CGSize)size;
 
 - (id)initWithView:(PDFReaderThumbView *)view fileURL:(NSURL *)url password:(NSString *)phrase guid:(NSString *)guid page:(NSInteger)page size:(CGSize)size;
@@ -25,6 +25,8 @@
 #import "PDFReaderThumbRequest.h"
 #import "PDFReaderThumbView.h"
 
+#import "PDFReaderCoreHash.h"
+
 @implementation PDFReaderThumbRequest
 {
 	NSURL *_fileURL;
@@ -63,6 +65,27 @@
 
 #pragma mark PDFReaderThumbRequest class methods
 
++ (NSString *)thumbNameForPage:(NSInteger)page size:(CGSize)size
+{
+	NSInteger w = size.width; NSInteger h = size.height; char name[64]; // Integer thumb size
+
+	PDFReaderCoreThumbName(name, sizeof(name), page, w, h); // "0000001-0160x0200"
+
+	return [[NSString alloc] initWithUTF8String:name];
+}
+
++ (NSString *)cacheKeyForPage:(NSInteger)page size:(CGSize)size guid:(NSString *)guid
+{
+	NSInteger w = size.width; NSInteger h = size.height; char key[128]; // Integer thumb size
+
+	if (PDFReaderCoreThumbCacheKey(key, sizeof(key), page, w, h, [guid UTF8String]) >= (int)sizeof(key)) // Very long GUID
+	{
+		return [[NSString alloc] initWithFormat:@"%@+%@", [PDFReaderThumbRequest thumbNameForPage:page size:size], guid];
+	}
+
+	return [[NSString alloc] initWithUTF8String:key];
+}
+
 + (id)newForView:(PDFReaderThumbView *)view fileURL:(NSURL *)url password:(NSString *)phrase guid:(NSString *)guid page:(NSInteger)page size:(CGSize)size
 {
 	return [[PDFReaderThumbRequest alloc] initWithView:view fileURL:url password:phrase guid:guid page:page size:size];
@@ -74,15 +97,13 @@
 {
 	if ((self = [super init])) // Initialize object
 	{
-		NSInteger w = size.width; NSInteger h = size.height;
-
 		_thumbView = view; _thumbPage = page; _thumbSize = size;
 
 		_fileURL = [url copy]; _password = [phrase copy]; _guid = [guid copy];
 
-		_thumbName = [[NSString alloc] initWithFormat:@"%07d-%04dx%04d", page, w, h];
+		_thumbName = [PDFReaderThumbRequest thumbNameForPage:page size:size];
 
-		_cacheKey = [[NSString alloc] initWithFormat:@"%@+%@", _thumbName, _guid];
+		_cacheKey = [PDFReaderThumbRequest cacheKeyForPage:page size:size guid:_guid];
 
 		_targetTag = [_cacheKey hash]; _thumbView.targetTag = _targetTag;
 
@@ -23,6 +23,7 @@
 //
 
 #import "PDFReaderThumbView.h"
+#import "PDFReaderThumbCache.h"
 
 @implementation PDFReaderThumbView
 {
@@ -73,18 +74,18 @@
 
 - (void)removeFromSuperview
 {
-	_targetTag = 0; // Clear target tag
+	NSUInteger tag = _targetTag; _targetTag = 0; // Clear target tag
 
-	[self.operation cancel]; // Cancel operation
+	[[PDFReaderThumbCache sharedInstance] cancelRequestForView:self tag:tag]; // Cancels when no other view waits
 
 	[super removeFromSuperview]; // Remove view
 }
 
 - (void)reuse
 {
-	_targetTag = 0; // Clear target tag
+	NSUInteger tag = _targetTag; _targetTag = 0; // Clear target tag
 
-	[self.operation cancel]; // Cancel operation
+	[[PDFReaderThumbCache sharedInstance] cancelRequestForView:self tag:tag]; // Cancels when no other view waits
 
 	imageView.image = nil; // Release image
 }
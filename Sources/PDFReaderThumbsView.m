@@ -24,6 +24,8 @@
 
 #import "PDFReaderThumbsView.h"
 
+#import "PDFReaderCoreGrid.h"
+
 @interface PDFReaderThumbsView () <UIScrollViewDelegate, UIGestureRecognizerDelegate>
 
 @end
@@ -38,7 +40,7 @@
 
 	NSMutableArray *thumbCellsVisible;
 
-	NSInteger _thumbsX, _thumbsY, _thumbX;
+	PDFReaderCoreGrid _grid;
 
 	CGSize _thumbSize, _lastViewSize;
 
@@ -137,20 +139,12 @@
 
 - (NSMutableIndexSet *)visibleIndexSetForContentOffset
 {
-	CGFloat minY = self.contentOffset.y; // Content offset
-	CGFloat maxY = (minY + self.bounds.size.height - 1.0f);
-
-	NSInteger startRow = (minY / _thumbSize.height); // Start row
-	NSInteger finalRow = (maxY / _thumbSize.height); // Final row
-
-	NSInteger startIndex = (startRow * _thumbsX); // Start index
-	NSInteger finalIndex = (finalRow * _thumbsX); // Final index
+	long startIndex = 0; long finalIndex = 0; // Visible rows index range
 
-	finalIndex += (_thumbsX - 1); // Last index value in last row
-
-	NSInteger maximumIndex = (_thumbCount - 1); // Maximum index value
-
-	if (finalIndex > maximumIndex) finalIndex = maximumIndex; // Limit it
+	if (PDFReaderCoreGridVisibleRange(&_grid, _thumbCount, self.contentOffset.y, self.bounds.size.height, &startIndex, &finalIndex) == 0)
+	{
+		return [NSMutableIndexSet indexSet]; // Nothing visible
+	}
 
 	NSRange indexRange = NSMakeRange(startIndex, (finalIndex - startIndex + 1));
 
@@ -174,49 +168,20 @@
 
 - (CGRect)thumbCellFrameForIndex:(NSInteger)index
 {
-	CGRect thumbRect; thumbRect.size = _thumbSize;
-
-	NSInteger thumbY = ((index / _thumbsX) * _thumbSize.height); // X, Y
-
-	NSInteger thumbX = (((index % _thumbsX) * _thumbSize.width) + _thumbX);
+	PDFReaderCoreRect thumbRect = PDFReaderCoreGridCellFrame(&_grid, index); // X, Y
 
-	thumbRect.origin.x = thumbX; thumbRect.origin.y = thumbY;
-
-	return thumbRect;
+	return CGRectMake(thumbRect.x, thumbRect.y, thumbRect.width, thumbRect.height);
 }
 
 - (void)updateContentSize:(NSUInteger)thumbCount
 {
 	canUpdate = NO; // Disable updates
 
-	if (thumbCount > 0) // Have some thumbs
-	{
-		CGFloat bw = self.bounds.size.width;
-
-		_thumbsX = (bw / _thumbSize.width);
-
-		if (_thumbsX < 1) _thumbsX = 1;
-
-		_thumbsY = (thumbCount / _thumbsX);
-
-		if ((_thumbsX * _thumbsY) < thumbCount) _thumbsY++;
-
-		CGFloat tw = (_thumbsX * _thumbSize.width);
-		CGFloat th = (_thumbsY * _thumbSize.height);
+	CGFloat bw = self.bounds.size.width; // Grid layout width
 
-		if (tw < bw)
-			_thumbX = ((bw - tw) / 2.0f);
-		else
-			_thumbX = 0; // Reset
+	_grid = PDFReaderCoreGridMake(thumbCount, bw, _thumbSize.width, _thumbSize.height);
 
-		if (tw < bw) tw = bw; // Limit
-
-		[self setContentSize:CGSizeMake(tw, th)];
-	}
-	else // Zero (0) thumbs
-	{
-		[self setContentSize:CGSizeZero];
-	}
+	[self setContentSize:CGSizeMake(_grid.contentWidth, _grid.contentHeight)]; // Zero with no thumbs
 
 	canUpdate = YES; // Enable updates
 }
@@ -318,7 +283,7 @@
 
 		if (index < 0) index = 0; else if (index > thumbCount) index = (thumbCount - 1);
 
-		NSInteger thumbY = ((index / _thumbsX) * _thumbSize.height); // Thumb Y
+		NSInteger thumbY = [self thumbCellFrameForIndex:index].origin.y; // Thumb Y
 
 		NSInteger offsetY = (thumbY - (boundsHeight / 2) + (_thumbSize.height / 2));
 
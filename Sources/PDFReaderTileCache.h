@@ -0,0 +1,83 @@
+//
+//	PDFReaderTileCache.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <UIKit/UIKit.h>
+
+typedef struct
+{
+	NSInteger page; // Page number
+	uint32_t level; // Level of detail (tile scale bits)
+	uint16_t x; uint16_t y; // Tile column and row
+} PDFReaderTileKey;
+
+typedef struct
+{
+	NSUInteger memoryHits; // Tiles drawn from memory
+	NSUInteger diskHits; // Tiles drawn from the tile pack
+	NSUInteger misses; // Tiles that had to be rendered
+	NSUInteger evictions; // Tiles dropped to stay within budget
+	NSUInteger entries; // Tiles resident
+	NSUInteger bytesResident; // Decoded bytes resident
+	NSUInteger byteBudget; // Memory budget
+	double renderTime; // Seconds spent rendering missed tiles
+	double renderTimeSaved; // Seconds of rendering avoided by hits
+} PDFReaderTileCacheStatistics;
+
+/**
+ *  `PDFReaderTileCache` keeps rendered `PDFReaderContentPage` tiles keyed by
+ *  document GUID, page, level of detail and tile column and row. The memory
+ *  tier is a byte-budget LRU (`PDFReaderConfig.tileCacheSize`). The disk tier
+ *  is a per-document `tiles.pack` next to the thumb pack, used once
+ *  `-openTilePackWithGUID:fileURL:` has checked it against the document file
+ *  size and modification date (a pack for another version of the file is
+ *  emptied). Tiles are appended without a sync and committed once per burst. `PDFReaderConfig.tileDiskCacheSize`
+ *  caps all tile packs together: a pack over the cap loses its least recently
+ *  drawn pages, and the thumb manifest removes the tile packs of the least
+ *  recently used other documents.
+ */
+@interface PDFReaderTileCache : NSObject <NSObject>
+
++ (PDFReaderTileCache *)sharedInstance;
+
++ (NSString *)tilePackPathForGUID:(NSString *)guid;
+
++ (BOOL)tileKey:(PDFReaderTileKey *)key forPage:(NSInteger)page clipRect:(CGRect)clipRect scale:(CGFloat)scale tileSize:(CGSize)tileSize;
+
+- (void)openTilePackWithGUID:(NSString *)guid fileURL:(NSURL *)fileURL;
+
+- (CGImageRef)newTileForGUID:(NSString *)guid key:(PDFReaderTileKey)key CF_RETURNS_RETAINED;
+
+- (void)storeTile:(CGImageRef)imageRef forGUID:(NSString *)guid key:(PDFReaderTileKey)key renderTime:(CFTimeInterval)renderTime;
+
+- (void)removeTilesWithGUID:(NSString *)guid;
+
+- (void)removeTilePackWithGUID:(NSString *)guid;
+
+- (void)removeAllTiles;
+
+- (PDFReaderTileCacheStatistics)statistics;
+
+- (void)logStatistics;
+
+@end
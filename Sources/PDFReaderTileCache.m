@@ -0,0 +1,522 @@
+//
+//	PDFReaderTileCache.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderConfig.h"
+#import "PDFReaderTileCache.h"
+#import "PDFReaderThumbPack.h"
+#import "PDFReaderThumbManifest.h"
+#import "PDFReaderCacheFile.h"
+
+#import <pthread.h>
+
+#pragma mark Constants
+
+#define TILE_PACK_NAME @"tiles.pack"
+
+#define TILE_DISK_LOW_WATER 0.75
+
+#define TILE_SYNC_DELAY 2.0
+
+#pragma mark -
+
+//
+//	PDFReaderTileCacheEntry class interface
+//
+
+@interface PDFReaderTileCacheEntry : NSObject <NSObject>
+{
+@public // Instance variables
+
+	NSString *key;
+
+	CGImageRef image;
+
+	NSUInteger cost;
+
+	CFTimeInterval renderTime;
+
+	__unsafe_unretained PDFReaderTileCacheEntry *prev;
+
+	__unsafe_unretained PDFReaderTileCacheEntry *next;
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTileCache class implementation
+//
+
+@implementation PDFReaderTileCache
+{
+	pthread_mutex_t lock;
+
+	NSMutableDictionary *entries;
+
+	__unsafe_unretained PDFReaderTileCacheEntry *head;
+
+	__unsafe_unretained PDFReaderTileCacheEntry *tail;
+
+	NSUInteger bytes;
+
+	NSUInteger byteBudget;
+
+	PDFReaderTileCacheStatistics counters;
+
+	NSUInteger renderCount;
+
+	dispatch_queue_t diskQueue;
+
+	NSMutableSet *openPacks; // GUIDs whose tile pack matches the document file
+
+	NSMutableDictionary *pageUses; // Disk queue only
+
+	NSMutableSet *dirtyPacks; // Disk queue only
+
+	BOOL syncScheduled; // Disk queue only
+}
+
+#pragma mark PDFReaderTileCache functions
+
+static inline NSString *TileCacheKey(NSString *guid, PDFReaderTileKey key)
+{
+	return [NSString stringWithFormat:@"%@/%07i-%08x-%05i-%05i", guid, (int)key.page, key.level, key.x, key.y];
+}
+
+#pragma mark PDFReaderTileCache class methods
+
++ (PDFReaderTileCache *)sharedInstance
+{
+	static dispatch_once_t predicate = 0;
+
+	static PDFReaderTileCache *object = nil; // Object
+
+	dispatch_once(&predicate, ^{ object = [self new]; });
+
+	return object; // PDFReaderTileCache singleton
+}
+
++ (BOOL)tileKey:(PDFReaderTileKey *)key forPage:(NSInteger)page clipRect:(CGRect)clipRect scale:(CGFloat)scale tileSize:(CGSize)tileSize
+{
+	if ([PDFReaderConfig sharedConfig].tileCacheSize == 0) return NO; // Disabled
+
+	if ((scale <= 0.0f) || (tileSize.width <= 0.0f) || (tileSize.height <= 0.0f)) return NO;
+
+	CGFloat x = ((clipRect.origin.x * scale) / tileSize.width); CGFloat y = ((clipRect.origin.y * scale) / tileSize.height);
+
+	long column = lround(x); long row = lround(y); // Tile column and row
+
+	if ((fabs(x - column) > 0.01) || (fabs(y - row) > 0.01)) return NO; // Not a whole tile
+
+	if ((column < 0) || (row < 0) || (column > UINT16_MAX) || (row > UINT16_MAX)) return NO;
+
+	float levelScale = scale; uint32_t level = 0; memcpy(&level, &levelScale, sizeof(level));
+
+	key->page = page; key->level = level; key->x = (uint16_t)column; key->y = (uint16_t)row;
+
+	return YES;
+}
+
++ (NSString *)tilePackPathForGUID:(NSString *)guid
+{
+	return [PDFReaderThumbPack packPathForGUID:guid name:TILE_PACK_NAME];
+}
+
+#pragma mark PDFReaderTileCache instance methods
+
+- (id)init
+{
+	if ((self = [super init])) // Initialize
+	{
+		pthread_mutex_init(&lock, NULL); entries = [NSMutableDictionary new]; openPacks = [NSMutableSet new];
+
+		byteBudget = [PDFReaderConfig sharedConfig].tileCacheSize; // Memory budget
+
+		diskQueue = dispatch_queue_create("PDFReaderTileCacheDiskQueue", DISPATCH_QUEUE_SERIAL);
+
+		dispatch_set_target_queue(diskQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+
+		pageUses = [NSMutableDictionary new]; // Page last draw times by GUID
+
+		dirtyPacks = [NSMutableSet new]; // Tile packs with uncommitted appends
+
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(removeAllTiles)
+			name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(synchronizeTiles)
+			name:UIApplicationDidEnterBackgroundNotification object:nil];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	pthread_mutex_destroy(&lock);
+}
+
+- (void)unlinkEntry:(PDFReaderTileCacheEntry *)entry
+{
+	if (entry->prev != nil) entry->prev->next = entry->next; else head = entry->next;
+
+	if (entry->next != nil) entry->next->prev = entry->prev; else tail = entry->prev;
+
+	entry->prev = nil; entry->next = nil;
+}
+
+- (void)linkEntry:(PDFReaderTileCacheEntry *)entry
+{
+	entry->next = head; entry->prev = nil; // Most recently used
+
+	if (head != nil) head->prev = entry; else tail = entry;
+
+	head = entry;
+}
+
+- (void)removeEntryForKey:(NSString *)key
+{
+	PDFReaderTileCacheEntry *entry = [entries objectForKey:key];
+
+	if (entry != nil) // Unlink it before the dictionary releases it
+	{
+		[self unlinkEntry:entry]; bytes -= entry->cost; [entries removeObjectForKey:key];
+	}
+}
+
+- (void)addImage:(CGImageRef)imageRef forKey:(NSString *)key renderTime:(CFTimeInterval)renderTime
+{
+	NSUInteger cost = (CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef));
+
+	if (cost > byteBudget) return; // Bigger than the whole budget
+
+	[self removeEntryForKey:key]; // Replace any existing tile
+
+	PDFReaderTileCacheEntry *entry = [PDFReaderTileCacheEntry new]; entry->key = key;
+
+	entry->image = CGImageRetain(imageRef); entry->cost = cost; entry->renderTime = renderTime;
+
+	[entries setObject:entry forKey:key]; [self linkEntry:entry]; bytes += cost;
+
+	while ((bytes > byteBudget) && (tail != nil)) // Evict least recently used tiles
+	{
+		NSString *victim = tail->key; [self removeEntryForKey:victim]; counters.evictions++;
+	}
+}
+
+- (double)averageRenderTime
+{
+	return ((renderCount > 0) ? (counters.renderTime / renderCount) : 0.0); // Lock held
+}
+
+- (void)openTilePackWithGUID:(NSString *)guid fileURL:(NSURL *)fileURL
+{
+	if ((guid == nil) || (fileURL == nil)) return; // Nothing to open
+
+	if ([PDFReaderConfig sharedConfig].tileDiskCacheSize == 0) return; // Memory only
+
+	dispatch_async(diskQueue, // Before any tile of the document is written
+	^{
+		uint64_t fileSize = 0; double fileDate = 0.0; // Document file identity
+
+		if (PDFReaderCacheFileIdentity(fileURL, &fileSize, &fileDate) == NO) return; // Disk tier stays off
+
+		PDFReaderThumbPack *tilePack = [PDFReaderThumbPack packWithGUID:guid name:TILE_PACK_NAME];
+
+		if ([tilePack matchFileSize:fileSize fileDate:fileDate] == NO) // Tiles of another version of the file
+		{
+			[self removeEntriesWithGUID:guid]; [dirtyPacks removeObject:tilePack]; [pageUses removeObjectForKey:guid];
+
+			[[PDFReaderThumbManifest sharedInstance] recordTileBytes:tilePack.fileBytes forGUID:guid];
+		}
+
+		pthread_mutex_lock(&lock); [openPacks addObject:guid]; pthread_mutex_unlock(&lock);
+	});
+}
+
+- (BOOL)isTilePackOpenForGUID:(NSString *)guid
+{
+	pthread_mutex_lock(&lock); BOOL opened = [openPacks containsObject:guid]; pthread_mutex_unlock(&lock);
+
+	return opened;
+}
+
+- (CGImageRef)newTileForGUID:(NSString *)guid key:(PDFReaderTileKey)key
+{
+	if (guid == nil) return NULL; // Must have a document GUID
+
+	NSString *cacheKey = TileCacheKey(guid, key); CGImageRef imageRef = NULL;
+
+	pthread_mutex_lock(&lock); // Memory tier
+
+	BOOL packed = [openPacks containsObject:guid]; // Disk tier checked against the document file
+
+	PDFReaderTileCacheEntry *entry = [entries objectForKey:cacheKey];
+
+	if (entry != nil) // Memory hit
+	{
+		if (head != entry) { [self unlinkEntry:entry]; [self linkEntry:entry]; }
+
+		imageRef = CGImageRetain(entry->image); counters.memoryHits++; counters.renderTimeSaved += entry->renderTime;
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	if ((imageRef == NULL) && (packed == YES)) // Disk tier
+	{
+		PDFReaderThumbPack *tilePack = [PDFReaderThumbPack packWithGUID:guid name:TILE_PACK_NAME];
+
+		imageRef = [tilePack newImageForPage:key.page size:CGSizeMake(key.x, key.y) level:key.level];
+
+		if (imageRef != NULL) // Disk hit - keep it in memory too
+		{
+			pthread_mutex_lock(&lock); double renderTime = [self averageRenderTime]; // Estimated
+
+			counters.diskHits++; counters.renderTimeSaved += renderTime;
+
+			[self addImage:imageRef forKey:cacheKey renderTime:renderTime];
+
+			pthread_mutex_unlock(&lock);
+		}
+	}
+
+	if (imageRef != NULL) // Most recently drawn page
+	{
+		NSInteger page = key.page; dispatch_async(diskQueue, ^{ [self touchPage:page guid:guid]; });
+	}
+	else // Miss
+	{
+		pthread_mutex_lock(&lock); counters.misses++; pthread_mutex_unlock(&lock);
+	}
+
+	return imageRef;
+}
+
+- (void)storeTile:(CGImageRef)imageRef forGUID:(NSString *)guid key:(PDFReaderTileKey)key renderTime:(CFTimeInterval)renderTime
+{
+	if ((guid == nil) || (imageRef == NULL)) return; // Nothing to store
+
+	pthread_mutex_lock(&lock); // Memory tier
+
+	counters.renderTime += renderTime; renderCount++;
+
+	[self addImage:imageRef forKey:TileCacheKey(guid, key) renderTime:renderTime];
+
+	pthread_mutex_unlock(&lock);
+
+	if ([PDFReaderConfig sharedConfig].tileDiskCacheSize == 0) return; // Memory only
+
+	CGImageRetain(imageRef); // Released after the disk write
+
+	dispatch_async(diskQueue,
+	^{
+		PDFReaderThumbPack *tilePack = nil; // Only a pack stamped for the document file
+
+		if ([self isTilePackOpenForGUID:guid] == YES) tilePack = [PDFReaderThumbPack packWithGUID:guid name:TILE_PACK_NAME];
+
+		if ([tilePack appendImage:imageRef page:key.page size:CGSizeMake(key.x, key.y) level:key.level] == YES)
+		{
+			[dirtyPacks addObject:tilePack]; [self scheduleSync]; // Committed with the rest of the burst
+		}
+
+		CGImageRelease(imageRef); [self touchPage:key.page guid:guid];
+	});
+}
+
+- (void)scheduleSync
+{
+	if (syncScheduled == NO) // Coalesce tile pack syncs
+	{
+		syncScheduled = YES; // Sync once after a burst of tiles
+
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(TILE_SYNC_DELAY * NSEC_PER_SEC)), diskQueue,
+		^{
+			[self syncDirtyPacks];
+		});
+	}
+}
+
+- (void)syncDirtyPacks
+{
+	syncScheduled = NO; unsigned long long cap = [PDFReaderConfig sharedConfig].tileDiskCacheSize;
+
+	for (PDFReaderThumbPack *tilePack in dirtyPacks) // One sync per pack (and trim)
+	{
+		[tilePack synchronize]; if (tilePack.fileBytes > cap) [self trimTilePack:tilePack];
+
+		[[PDFReaderThumbManifest sharedInstance] recordTileBytes:tilePack.fileBytes forGUID:tilePack.guid]; // Global cap
+	}
+
+	[dirtyPacks removeAllObjects];
+}
+
+- (void)synchronizeTiles
+{
+	dispatch_async(diskQueue, ^{ [self syncDirtyPacks]; });
+}
+
+- (void)removeTilePackWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to remove
+
+	dispatch_async(diskQueue,
+	^{
+		for (PDFReaderThumbPack *tilePack in [dirtyPacks allObjects]) // Nothing left to commit
+		{
+			if ([tilePack.guid isEqualToString:guid]) [dirtyPacks removeObject:tilePack];
+		}
+
+		[pageUses removeObjectForKey:guid]; [PDFReaderThumbPack removePackWithGUID:guid name:TILE_PACK_NAME];
+	});
+}
+
+- (void)touchPage:(NSInteger)page guid:(NSString *)guid
+{
+	NSMutableDictionary *uses = [pageUses objectForKey:guid]; // Disk queue only
+
+	if (uses == nil) { uses = [NSMutableDictionary new]; [pageUses setObject:uses forKey:guid]; }
+
+	[uses setObject:[NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent()] forKey:[NSNumber numberWithInteger:page]];
+}
+
+- (void)trimTilePack:(PDFReaderThumbPack *)tilePack
+{
+	NSDictionary *uses = [pageUses objectForKey:tilePack.guid]; // Pages drawn this session
+
+	NSMutableDictionary *pageBytes = [NSMutableDictionary dictionary]; // Bytes on disk by page
+
+	[tilePack enumerateEntriesUsingBlock:^(NSInteger page, CGSize size, NSUInteger blobBytes)
+	{
+		NSNumber *key = [NSNumber numberWithInteger:page]; // Page key
+
+		NSUInteger total = ([[pageBytes objectForKey:key] unsignedIntegerValue] + blobBytes);
+
+		[pageBytes setObject:[NSNumber numberWithUnsignedInteger:total] forKey:key];
+	}];
+
+	NSArray *pages = [[pageBytes allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSNumber *page1, NSNumber *page2)
+	{
+		double use1 = [[uses objectForKey:page1] doubleValue]; double use2 = [[uses objectForKey:page2] doubleValue];
+
+		return ((use1 < use2) ? NSOrderedAscending : ((use1 > use2) ? NSOrderedDescending : NSOrderedSame));
+	}];
+
+	unsigned long long target = ([PDFReaderConfig sharedConfig].tileDiskCacheSize * TILE_DISK_LOW_WATER);
+
+	unsigned long long live = tilePack.liveBytes; // Least recently drawn pages go first
+
+	for (NSNumber *page in pages)
+	{
+		if (live <= target) break; // Back under the cap
+
+		live -= [tilePack removePage:[page integerValue]];
+	}
+
+	[tilePack compact]; // Give the space back
+}
+
+- (void)removeEntriesWithGUID:(NSString *)guid
+{
+	NSString *prefix = [guid stringByAppendingString:@"/"]; // Key prefix
+
+	pthread_mutex_lock(&lock); // Memory tier
+
+	for (NSString *key in [entries allKeys]) // Every tile of the document
+	{
+		if ([key hasPrefix:prefix]) [self removeEntryForKey:key];
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+- (void)removeTilesWithGUID:(NSString *)guid
+{
+	if (guid == nil) return; // Nothing to remove
+
+	[self removeEntriesWithGUID:guid]; // Memory tier
+
+	dispatch_async(diskQueue, // After the tiles still being written - checked again on the next open
+	^{
+		pthread_mutex_lock(&lock); [openPacks removeObject:guid]; pthread_mutex_unlock(&lock);
+	});
+}
+
+- (void)removeAllTiles
+{
+	pthread_mutex_lock(&lock); // Memory tier
+
+	head = nil; tail = nil; bytes = 0; // Entries are released with the dictionary contents
+
+	[entries removeAllObjects];
+
+	pthread_mutex_unlock(&lock);
+}
+
+- (PDFReaderTileCacheStatistics)statistics
+{
+	pthread_mutex_lock(&lock); // Memory tier
+
+	PDFReaderTileCacheStatistics statistics = counters;
+
+	statistics.entries = entries.count; statistics.bytesResident = bytes; statistics.byteBudget = byteBudget;
+
+	pthread_mutex_unlock(&lock);
+
+	return statistics;
+}
+
+- (void)logStatistics
+{
+#ifdef DEBUG
+	PDFReaderTileCacheStatistics statistics = [self statistics];
+
+	NSUInteger lookups = (statistics.memoryHits + statistics.diskHits + statistics.misses);
+
+	double hitRate = ((lookups > 0) ? ((statistics.memoryHits + statistics.diskHits) * 100.0 / lookups) : 0.0);
+
+	NSLog(@"%s memory hits %u, disk hits %u, misses %u (%.1f%% hit rate), evictions %u, entries %u, bytes %u of %u, render %.2fs, saved %.2fs",
+		__FUNCTION__, (unsigned)statistics.memoryHits, (unsigned)statistics.diskHits, (unsigned)statistics.misses, hitRate,
+		(unsigned)statistics.evictions, (unsigned)statistics.entries, (unsigned)statistics.bytesResident,
+		(unsigned)statistics.byteBudget, statistics.renderTime, statistics.renderTimeSaved);
+#endif
+}
+
+@end
+
+#pragma mark -
+
+//
+//	PDFReaderTileCacheEntry class implementation
+//
+
+@implementation PDFReaderTileCacheEntry
+
+- (void)dealloc
+{
+	CGImageRelease(image), image = NULL;
+}
+
+@end
@@ -0,0 +1,83 @@
+//
+//	PDFReaderTrace.h
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "PDFReaderCoreTrace.h"
+
+/**
+ *  `PDFReaderTrace` controls the thumb and page pipeline trace recorded by
+ *  the PDFReaderCoreTrace ring buffer: thumb cache hits and misses, lane
+ *  queue waits, thumb fetch, render (page open and draw), encode (bytes
+ *  written), the main thread image show dispatch and page tile draws.
+ *
+ *  Recording is off until enabled; while it is off every trace point is a
+ *  single load and branch. Recorded events can be written to a trace file
+ *  for Bench/PDFReaderTrace.c (`make -C Bench summary TRACE=<file>`), and
+ *  with signposts enabled each stage is also emitted as a kdebug signpost
+ *  (Instruments Points of Interest, iOS 10 and later) with the stage as the
+ *  code and the cache key hash and page as the first two arguments.
+ */
+@interface PDFReaderTrace : NSObject <NSObject>
+
++ (void)setEnabled:(BOOL)enabled;
+
++ (BOOL)isEnabled;
+
++ (void)setSignpostsEnabled:(BOOL)enabled;
+
++ (BOOL)signpostsEnabled;
+
++ (BOOL)writeTraceToURL:(NSURL *)fileURL;
+
++ (void)reset;
+
++ (void)logStatistics;
+
+@end
+
+uint64_t PDFReaderTraceBeginStage(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page);
+
+void PDFReaderTraceEndStage(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page, uint64_t start, NSUInteger bytes);
+
+void PDFReaderTraceMarkStage(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page, NSTimeInterval duration);
+
+/*
+ *  Trace points - begin returns 0 when not recording and end does nothing
+ *  for a 0 start. Mark records a stage that ends now and lasted duration.
+ */
+static inline uint64_t PDFReaderTraceBegin(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page)
+{
+	return ((PDFReaderCoreTraceIsEnabled() != 0) ? PDFReaderTraceBeginStage(stage, key, page) : 0);
+}
+
+static inline void PDFReaderTraceEnd(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page, uint64_t start, NSUInteger bytes)
+{
+	if (start != 0) PDFReaderTraceEndStage(stage, key, page, start, bytes);
+}
+
+static inline void PDFReaderTraceMark(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page, NSTimeInterval duration)
+{
+	if (PDFReaderCoreTraceIsEnabled() != 0) PDFReaderTraceMarkStage(stage, key, page, duration);
+}
@@ -0,0 +1,139 @@
+//
+//	PDFReaderTrace.m
+//
+//  Copyright (C) 2011-2013 Julius Oklamcak. All rights reserved.
+//  Portions (C) 2014 Mark Eissler. All rights reserved.
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights to
+//	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//	of the Software, and to permit persons to whom the Software is furnished to
+//	do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in all
+//	copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#import "PDFReaderTrace.h"
+
+#import "PDFReaderCoreHash.h"
+
+#if defined(__IPHONE_10_0) && (__IPHONE_OS_VERSION_MAX_ALLOWED >= __IPHONE_10_0)
+#import <sys/kdebug_signpost.h> // Weak linked below iOS 10
+#define PDFREADER_SIGNPOSTS 1
+#endif
+
+@implementation PDFReaderTrace
+
+#pragma mark PDFReaderTrace functions
+
+static BOOL signpostsEnabled = NO;
+
+static uint32_t TraceIdentifier(NSString *key)
+{
+	return ((key != nil) ? (uint32_t)PDFReaderCoreHashString([key UTF8String]) : 0);
+}
+
+uint64_t PDFReaderTraceBeginStage(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page)
+{
+#ifdef PDFREADER_SIGNPOSTS
+	if ((signpostsEnabled == YES) && (kdebug_signpost_start != NULL)) kdebug_signpost_start(stage, TraceIdentifier(key), page, 0, 0);
+#endif
+
+	uint64_t now = PDFReaderCoreTraceNow(); return ((now != 0) ? now : 1); // Never 0 (not recording)
+}
+
+void PDFReaderTraceEndStage(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page, uint64_t start, NSUInteger bytes)
+{
+	uint64_t now = PDFReaderCoreTraceNow(); uint32_t identifier = TraceIdentifier(key);
+
+	PDFReaderCoreTraceRecord(stage, identifier, page, start, ((now > start) ? (now - start) : 0), (uint32_t)MIN(bytes, UINT32_MAX));
+
+#ifdef PDFREADER_SIGNPOSTS
+	if ((signpostsEnabled == YES) && (kdebug_signpost_end != NULL)) kdebug_signpost_end(stage, identifier, page, bytes, 0);
+#endif
+}
+
+void PDFReaderTraceMarkStage(PDFReaderCoreTraceStage stage, NSString *key, NSInteger page, NSTimeInterval duration)
+{
+	uint64_t now = PDFReaderCoreTraceNow(); uint32_t identifier = TraceIdentifier(key);
+
+	uint64_t nanoseconds = ((duration > 0.0) ? (uint64_t)(duration * 1000000000.0) : 0); // Ended now
+
+	PDFReaderCoreTraceRecord(stage, identifier, page, ((now > nanoseconds) ? (now - nanoseconds) : 0), nanoseconds, 0);
+
+#ifdef PDFREADER_SIGNPOSTS
+	if ((signpostsEnabled == YES) && (kdebug_signpost != NULL)) kdebug_signpost(stage, identifier, page, (uintptr_t)(nanoseconds / 1000), 0);
+#endif
+}
+
+#pragma mark PDFReaderTrace class methods
+
++ (void)setEnabled:(BOOL)enabled
+{
+	if (enabled == YES) PDFReaderCoreTraceEnable(0); else PDFReaderCoreTraceDisable();
+}
+
++ (BOOL)isEnabled
+{
+	return (PDFReaderCoreTraceIsEnabled() != 0);
+}
+
++ (void)setSignpostsEnabled:(BOOL)enabled
+{
+	signpostsEnabled = enabled;
+}
+
++ (BOOL)signpostsEnabled
+{
+	return signpostsEnabled;
+}
+
++ (BOOL)writeTraceToURL:(NSURL *)fileURL
+{
+	if ([fileURL isFileURL] == NO) return NO; // Local files only
+
+	return (PDFReaderCoreTraceWriteFile([[fileURL path] fileSystemRepresentation]) == 0);
+}
+
++ (void)reset
+{
+	PDFReaderCoreTraceReset();
+}
+
++ (void)logStatistics
+{
+#ifdef DEBUG
+	PDFReaderCoreTraceHistogram histogram; uint64_t bytes = 0; NSMutableString *summary = [NSMutableString string];
+
+	for (NSInteger stage = PDFReaderCoreTraceFetchWait; stage < PDFReaderCoreTraceStages; stage++) // Timed stages
+	{
+		PDFReaderCoreTraceGetHistogram((PDFReaderCoreTraceStage)stage, &histogram, &bytes); if (histogram.count == 0) continue;
+
+		[summary appendFormat:@" %s n %u p50 %.2fms p99 %.2fms", PDFReaderCoreTraceStageName((PDFReaderCoreTraceStage)stage), (unsigned)histogram.count,
+			(PDFReaderCoreTraceHistogramQuantile(&histogram, 0.50) / 1000000.0), (PDFReaderCoreTraceHistogramQuantile(&histogram, 0.99) / 1000000.0)];
+
+		if (bytes > 0) [summary appendFormat:@" bytes %llu", (unsigned long long)bytes];
+
+		[summary appendString:@","];
+	}
+
+	PDFReaderCoreTraceGetHistogram(PDFReaderCoreTraceThumbHit, &histogram, NULL); uint64_t hits = histogram.count;
+
+	PDFReaderCoreTraceGetHistogram(PDFReaderCoreTraceThumbMiss, &histogram, NULL); uint64_t misses = histogram.count;
+
+	double ratio = (((hits + misses) > 0) ? ((hits * 100.0) / (hits + misses)) : 0.0); // Thumb cache hit ratio
+
+	NSLog(@"%s%@ thumb hit ratio %.1f%%", __FUNCTION__, summary, ratio);
+#endif
+}
+
+@end
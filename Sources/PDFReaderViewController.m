@@ -30,6 +30,13 @@
 #import "PDFReaderContentView.h"
 #import "PDFReaderThumbCache.h"
 #import "PDFReaderThumbQueue.h"
+#import "PDFReaderDocumentPool.h"
+#import "PDFReaderLinkIndex.h"
+#import "PDFReaderTextIndex.h"
+#import "PDFReaderPageMetrics.h"
+#import "PDFReaderOpenTimer.h"
+#import "PDFReaderPagePrefetch.h"
+#import "PDFReaderTileCache.h"
 
 #import <MessageUI/MessageUI.h>
 
@@ -54,6 +61,8 @@
 
   NSMutableDictionary *contentViews;
 
+  PDFReaderPagePrefetch *pagePrefetch;
+
   UIPrintInteractionController *printInteraction;
 
   NSInteger currentPage;
@@ -154,6 +163,21 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
 	[mainToolbar setBookmarkState:bookmarked];
 }
 
+- (void)showPagePreview:(PDFReaderContentView *)contentView page:(NSInteger)page
+{
+  if ([contentView needsPreviewRender] == NO)
+    return;
+
+  // Screen resolution render to show until the tiles arrive
+  __weak PDFReaderContentView *weakView = contentView;
+  [pagePrefetch renderPreviewForPage:page
+                            viewSize:theScrollView.bounds.size
+                          completion:^(UIImage *image)
+  {
+    [weakView showPreviewImage:image];
+  }];
+}
+
 - (void)showDocumentPage:(NSInteger)page
 {
   if (page == currentPage)
@@ -198,11 +222,18 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
       // view and add it.
       NSURL *fileURL = document.fileURL;
       NSString *phrase = document.password;
+      NSString *guid = document.guid;
+
+      // Time-to-first-pixel starts now, use the warmed page if there is one
+      [PDFReaderPagePrefetch markPageTurnForPage:number];
+      PDFReaderPagePrefetchEntry *entry = [pagePrefetch takeEntryForPage:number];
 
       contentView = [[PDFReaderContentView alloc] initWithFrame:viewRect
                                                         fileURL:fileURL
                                                            page:number
-                                                       password:phrase];
+                                                       password:phrase
+                                                           guid:guid
+                                                       prefetch:entry];
 
       [theScrollView addSubview:contentView];
       [contentViews setObject:contentView forKey:key];
@@ -225,6 +256,7 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
   [unusedViews enumerateKeysAndObjectsUsingBlock:^(id key, id object, BOOL* stop)
   {
     [contentViews removeObjectForKey:key];
+    [pagePrefetch cancelPreviewForPage:[key integerValue]];
 
     PDFReaderContentView* contentView = object;
 
@@ -244,6 +276,11 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
     theScrollView.contentOffset = contentOffset;
   }
 
+  // Warm the pages ahead of the scroll direction
+  [pagePrefetch showPage:page
+                  window:NSMakeRange(minValue, (maxValue - minValue + 1))
+                viewSize:theScrollView.bounds.size];
+
   // Update document page number if different from page
   if ([document.pageNumber integerValue] != page) {
     document.pageNumber = [NSNumber numberWithInteger:page];
@@ -260,6 +297,7 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
     PDFReaderContentView* targetView = [contentViews objectForKey:key];
 
     [targetView showPageThumb:fileURL page:page password:phrase guid:guid];
+    [self showPagePreview:targetView page:page];
 
     // Remove visible page from set
     [newPageSet removeIndex:page];
@@ -274,6 +312,7 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
     PDFReaderContentView *targetView = [contentViews objectForKey:key];
 
     [targetView showPageThumb:fileURL page:number password:phrase guid:guid];
+    [self showPagePreview:targetView page:number];
   };
   [newPageSet enumerateIndexesWithOptions:NSEnumerationReverse
                                usingBlock:pageSetEnumeratorBlock];
@@ -308,6 +347,11 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
 
   [self showDocumentPage:[document.pageNumber integerValue]];
 
+  [PDFReaderOpenTimer markPhase:@"first page"];
+
+  // The first page views now hold the pooled document handle
+  [document releaseOpenHandle];
+
   document.lastOpen = [NSDate date];
 
   isVisible = YES;
@@ -466,7 +510,31 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
   [singleTapOne requireGestureRecognizerToFail:doubleTapOne];
 
   contentViews = [NSMutableDictionary new];
+  pagePrefetch = [[PDFReaderPagePrefetch alloc]
+      initWithURL:document.fileURL
+         password:document.password
+             guid:document.guid
+        pageCount:[document.pageCount integerValue]];
+
+  // Load (or compute in the background) the page metrics table
+  [document pageMetrics];
+
+  // Check the rendered tile pack against the document file before using it
+  [[PDFReaderTileCache sharedInstance] openTilePackWithGUID:document.guid
+                                                    fileURL:document.fileURL];
+
+  // Index every link in the document off the main thread
+  [[PDFReaderLinkIndex linkIndexWithGUID:document.guid]
+      buildWithURL:document.fileURL
+          password:document.password];
+
+  // Extract (or resume extracting) the document text for search
+  [[PDFReaderTextIndex textIndexWithGUID:document.guid]
+      buildWithURL:document.fileURL
+          password:document.password];
   lastHideTime = [NSDate date];
+
+  [PDFReaderOpenTimer markPhase:@"view load"];
 }
 
 - (void)viewWillAppear:(BOOL)animated
@@ -527,6 +595,8 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
 
   theScrollView = nil;
   contentViews = nil;
+  [pagePrefetch cancelAllPrefetch];
+  pagePrefetch = nil;
   lastHideTime = nil;
 
   lastAppearSize = CGSizeZero;
@@ -602,6 +672,12 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
 
 #pragma mark UIScrollViewDelegate methods
 
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView
+{
+  if (scrollView == theScrollView)
+    [pagePrefetch scrollViewDidScroll:scrollView];
+}
+
 - (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView
 {
   __block NSInteger page = 0;
@@ -879,6 +955,23 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
     // Empty the thumb cache
     [[PDFReaderThumbCache sharedInstance] removeAllObjects];
 
+    // Drop the in-memory rendered tiles (the tile pack stays on disk)
+    [[PDFReaderTileCache sharedInstance] logStatistics];
+    [[PDFReaderTileCache sharedInstance] removeTilesWithGUID:document.guid];
+
+    // Drop warmed pages so their pooled page handles are released
+    [pagePrefetch logStatistics];
+    [PDFReaderPagePrefetch logFirstPixelStatistics];
+    [pagePrefetch cancelAllPrefetch];
+
+    // Drop the in-memory link, metrics and text indexes (their files stay on disk)
+    [PDFReaderLinkIndex closeLinkIndexWithGUID:document.guid];
+    [PDFReaderPageMetrics closeMetricsWithGUID:document.guid];
+    [PDFReaderTextIndex closeTextIndexWithGUID:document.guid];
+
+    // Close pooled document handles once outstanding pages are released
+    [[PDFReaderDocumentPool sharedInstance] closeDocumentsWithGUID:document.guid];
+
     if (printInteraction != nil)
       [printInteraction dismissAnimated:NO];
 
@@ -1030,6 +1123,8 @@ const CGFloat kPDFReaderDefaultTapAreaSize = 48.0f;
     [mainToolbar setBookmarkState:YES];
     [document.bookmarks addIndex:page];
   }
+
+  [document saveReaderDocument]; // Coalesced by the store
 }
 
 #pragma mark MFMailComposeViewControllerDelegate methods
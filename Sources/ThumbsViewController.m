@@ -49,6 +49,8 @@
 
 	BOOL updateBookmarked;
 	BOOL showBookmarked;
+
+	CGSize activeThumbSize;
 }
 
 #pragma mark Constants
@@ -157,6 +159,10 @@
 - (void)viewWillDisappear:(BOOL)animated
 {
 	[super viewWillDisappear:animated];
+
+	[PDFReaderThumbCache unregisterThumbSize:activeThumbSize forGUID:document.guid]; // Grid is going away
+
+	activeThumbSize = CGSizeZero;
 }
 
 - (void)viewDidDisappear:(BOOL)animated
@@ -279,6 +285,13 @@
 {
 	CGSize size = [thumbCell maximumContentSize]; // Get the cell's maximum content size
 
+	if (CGSizeEqualToSize(size, activeThumbSize) == NO) // Grid thumb size is part of the mip-chain
+	{
+		if (CGSizeEqualToSize(activeThumbSize, CGSizeZero) == NO) [PDFReaderThumbCache unregisterThumbSize:activeThumbSize forGUID:document.guid];
+
+		[PDFReaderThumbCache registerThumbSize:size forGUID:document.guid]; activeThumbSize = size;
+	}
+
 	NSInteger page = (showBookmarked ? [[bookmarked objectAtIndex:index] integerValue] : (index + 1));
 
 	[thumbCell showText:[NSString stringWithFormat:@"%i", page]]; // Page number place holder
@@ -289,7 +302,7 @@
 
 	PDFReaderThumbRequest *thumbRequest = [PDFReaderThumbRequest newForView:thumbCell fileURL:fileURL password:phrase guid:guid page:page size:size];
 
-	UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:thumbRequest priority:YES]; // Request the thumbnail
+	UIImage *image = [[PDFReaderThumbCache sharedInstance] thumbRequest:thumbRequest priorityClass:PDFReaderThumbPriorityVisible]; // Request the thumbnail
 
 	if ([image isKindOfClass:[UIImage class]]) [thumbCell showImage:image]; // Show image from cache
 }
@@ -316,6 +329,8 @@
 
 	if ([document.bookmarks containsIndex:page]) [document.bookmarks removeIndex:page]; else [document.bookmarks addIndex:page];
 
+	[document saveReaderDocument]; // Coalesced by the store
+
 	updateBookmarked = YES; [thumbsView refreshThumbWithIndex:index]; // Refresh page thumb
 }
 